@@ -0,0 +1,354 @@
+/*********************                                                        */
+/*! \file cddense_map.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Context-dependent insert only map indexed by small integers
+ **
+ ** Context-dependent map that only allows for one insertion per
+ ** element, like CDFlatHashMap, for keys that map to distinct small
+ ** integers (node ids, SAT literals): the elements are stored in a
+ ** paged table indexed by the key's index, so a lookup is a page
+ ** lookup and an index, with no hashing or probing.  Pages are
+ ** allocated on the first insertion into them, so sparse indices only
+ ** cost the pages they touch.  The table is restored on a pop from a
+ ** trail of the indices in insertion order, as in CDFlatHashMap.
+ **
+ ** See also:
+ **  CDFlatHashMap : The same interface, for arbitrary keys.
+ **
+ ** Notes:
+ ** - IndexFcn must map distinct keys to distinct indices, and an
+ **   element's index mustn't change while it's in the map.  The node
+ **   and SAT literal hash functions qualify (a Node key holds a
+ **   reference, so its id can't be reused).
+ ** - Lookups take any type that IndexFcn takes and that compares with
+ **   Key, e.g., TNode for Node keys (with TNodeHashFunction), saving
+ **   the reference count updates of a Node.
+ ** - Iteration (const_iterator) is in insertion order.
+ ** - operator[] is only supported as a const derefence (must succeed).
+ ** - insert(k) must always work.
+ ** - Use insert_safe if you want to check if the element has been inserted
+ **   and only insert if it has not yet been.
+ ** - Supports insertAtContextLevelZero() if the element is not in the map.
+ **/
+
+#include "cvc4_private.h"
+
+#ifndef __CVC4__CONTEXT__CDDENSE_MAP_H
+#define __CVC4__CONTEXT__CDDENSE_MAP_H
+
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "context/context.h"
+#include "util/cvc4_assert.h"
+
+namespace CVC4 {
+namespace context {
+
+template <class Key, class Data, class IndexFcn>
+class CDDenseMap : public ContextObj {
+public:
+  typedef std::pair<Key, Data> value_type;
+
+private:
+
+  static const size_t PAGE_BITS = 8;
+  static const size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+  /**
+   * A page of the table: PAGE_SIZE slots, of which only those marked
+   * present are constructed.
+   */
+  struct Page {
+    value_type* d_slots;
+    uint64_t d_present[PAGE_SIZE / 64];
+
+    Page() :
+      d_slots(static_cast<value_type*>(::operator new(PAGE_SIZE * sizeof(value_type)))) {
+      std::memset(d_present, 0, sizeof(d_present));
+    }
+
+    ~Page() {
+      ::operator delete(d_slots);
+    }
+
+    bool present(size_t i) const {
+      return (d_present[i >> 6] >> (i & 63)) & 1;
+    }
+  };/* struct CDDenseMap<>::Page */
+
+  /** The pages of the table, NULL until something is inserted in them */
+  std::vector<Page*> d_pages;
+
+  /**
+   * The indices of the elements in insertion order: those inserted at
+   * context level zero first, then the rest, which are removed from
+   * the back on a pop.
+   */
+  std::vector<size_t> d_order;
+
+  /** The number of elements inserted at context level zero. */
+  size_t d_levelZero;
+
+  /** The level at which d_order was last logged on the undo trail. */
+  int d_trailLevel;
+
+  IndexFcn d_index;
+
+  // Nothing to save or restore; insertions are logged on the undo trail
+  virtual ContextObj* save(ContextMemoryManager* pCMM) {
+    Unreachable();
+  }
+
+  virtual void restore(ContextObj* data) {
+    Unreachable();
+  }
+
+  // no copy or assignment
+  CDDenseMap(const CDDenseMap&) CVC4_UNDEFINED;
+  CDDenseMap& operator=(const CDDenseMap&) CVC4_UNDEFINED;
+
+  /** The slot of the element with index i, which must be present */
+  value_type& slot(size_t i) const {
+    return d_pages[i >> PAGE_BITS]->d_slots[i & (PAGE_SIZE - 1)];
+  }
+
+  /** The slot holding k, or NULL if it isn't in the map. */
+  template <class K>
+  value_type* lookup(const K& k) const {
+    size_t i = d_index(k);
+    size_t page = i >> PAGE_BITS;
+    if(page >= d_pages.size() || d_pages[page] == NULL ||
+       !d_pages[page]->present(i & (PAGE_SIZE - 1))) {
+      return NULL;
+    }
+    value_type* elt = &slot(i);
+    Assert(elt->first == k, "CDDenseMap: keys with the same index");
+    return elt;
+  }
+
+  /**
+   * Constructs (k, d) in the slot for k, which mustn't be in the map,
+   * and returns its index.
+   */
+  size_t place(const Key& k, const Data& d) {
+    size_t i = d_index(k);
+    size_t page = i >> PAGE_BITS;
+    if(page >= d_pages.size()) {
+      d_pages.resize(page + 1, NULL);
+    }
+    if(d_pages[page] == NULL) {
+      d_pages[page] = new Page();
+    }
+    size_t j = i & (PAGE_SIZE - 1);
+    Assert(!d_pages[page]->present(j));
+    new(&d_pages[page]->d_slots[j]) value_type(k, d);
+    d_pages[page]->d_present[j >> 6] |= uint64_t(1) << (j & 63);
+    return i;
+  }
+
+  /** Removes the element with index i. */
+  void remove(size_t i) {
+    Page* page = d_pages[i >> PAGE_BITS];
+    size_t j = i & (PAGE_SIZE - 1);
+    Assert(page->present(j));
+    page->d_slots[j].~value_type();
+    page->d_present[j >> 6] &= ~(uint64_t(1) << (j & 63));
+  }
+
+  /**
+   * Undo function for the insertions in a scope: data is the number of
+   * elements (not counting those inserted at context level zero) to
+   * restore the map to.
+   */
+  static void undoInserts(void* map, void* data, bool restore) {
+    if(restore) {
+      CDDenseMap* m = static_cast<CDDenseMap*>(map);
+      size_t size = m->d_levelZero + reinterpret_cast<size_t>(data);
+      Assert(size <= m->d_order.size());
+      while(m->d_order.size() > size) {
+        m->remove(m->d_order.back());
+        m->d_order.pop_back();
+      }
+    }
+  }
+
+public:
+
+  /**
+   * Main constructor: the table starts out empty, and its pages are
+   * allocated as they're needed
+   */
+  CDDenseMap(Context* context, const IndexFcn& index = IndexFcn()) :
+    ContextObj(context),
+    d_pages(),
+    d_order(),
+    d_levelZero(0),
+    d_trailLevel(0),
+    d_index(index) {
+  }
+
+  /**
+   * Destructor: destroy the elements and free the pages
+   */
+  ~CDDenseMap() throw(AssertionException) {
+    if(d_trailLevel > 0) {
+      untrail(this, sizeof(*this), d_trailLevel);
+    }
+    this->destroy();
+    for(std::vector<size_t>::const_iterator i = d_order.begin();
+        i != d_order.end();
+        ++i) {
+      slot(*i).~value_type();
+    }
+    for(typename std::vector<Page*>::const_iterator i = d_pages.begin();
+        i != d_pages.end();
+        ++i) {
+      delete *i;
+    }
+  }
+
+  /**
+   * An iterator over the elements, in insertion order (those inserted
+   * at context level zero first).
+   */
+  class const_iterator {
+    const CDDenseMap* d_map;
+    std::vector<size_t>::const_iterator d_it;
+
+    friend class CDDenseMap;
+
+    const_iterator(const CDDenseMap* map,
+                   std::vector<size_t>::const_iterator it) :
+      d_map(map),
+      d_it(it) {
+    }
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename CDDenseMap::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+
+    const_iterator() : d_map(NULL), d_it() {}
+
+    bool operator==(const const_iterator& i) const {
+      return d_it == i.d_it;
+    }
+    bool operator!=(const const_iterator& i) const {
+      return d_it != i.d_it;
+    }
+
+    const value_type& operator*() const {
+      return d_map->slot(*d_it);
+    }
+    const value_type* operator->() const {
+      return &d_map->slot(*d_it);
+    }
+
+    const_iterator& operator++() {
+      ++d_it;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator i = *this;
+      ++d_it;
+      return i;
+    }
+  };/* class CDDenseMap<>::const_iterator */
+
+  /** Returns true if the map is empty in the current context. */
+  bool empty() const {
+    return d_order.empty();
+  }
+
+  /** Returns the size of the map in the current context. */
+  size_t size() const {
+    return d_order.size();
+  }
+
+  /**
+   * Inserts an element into the map.
+   * The key inserted must be not be currently mapped.
+   */
+  void insert(const Key& k, const Data& d) {
+    Assert(!contains(k));
+    if(makeCurrentOnTrail(d_trailLevel)) {
+      trail(&undoInserts, this,
+            reinterpret_cast<void*>(d_order.size() - d_levelZero));
+    }
+    d_order.push_back(place(k, d));
+  }
+
+  /**
+   * Checks if the key k is mapped already.
+   * If it is, this returns false.
+   * Otherwise it is inserted and this returns true.
+   */
+  bool insert_safe(const Key& k, const Data& d) {
+    if(contains(k)) {
+      return false;
+    } else {
+      insert(k, d);
+      return true;
+    }
+  }
+
+  /**
+   * Version of insert() that inserts data value d at context level
+   * zero: the element is never removed on a pop.
+   *
+   * It is an error to insertAtContextLevelZero()
+   * a key that already is in the map.
+   */
+  void insertAtContextLevelZero(const Key& k, const Data& d) {
+    Assert(!contains(k));
+    d_order.insert(d_order.begin() + d_levelZero, place(k, d));
+    ++d_levelZero;
+  }
+
+  /** Returns true if k is a mapped key in the context. */
+  template <class K>
+  bool contains(const K& k) const {
+    return lookup(k) != NULL;
+  }
+
+  /**
+   * Returns a reference the data mapped by k.
+   * k must be in the map in this context.
+   */
+  template <class K>
+  const Data& operator[](const K& k) const {
+    value_type* elt = lookup(k);
+    Assert(elt != NULL);
+    return elt->second;
+  }
+
+  /** Returns an iterator to the beginning of the map. */
+  const_iterator begin() const {
+    return const_iterator(this, d_order.begin());
+  }
+
+  /** Returns an iterator to the end of the map. */
+  const_iterator end() const {
+    return const_iterator(this, d_order.end());
+  }
+};/* class CDDenseMap<> */
+
+}/* CVC4::context namespace */
+}/* CVC4 namespace */
+
+#endif /* __CVC4__CONTEXT__CDDENSE_MAP_H */
@@ -0,0 +1,474 @@
+/*********************                                                        */
+/*! \file cdflat_hashmap.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Context-dependent insert only hashmap with open addressing
+ **
+ ** Context-dependent hashmap that only allows for one insertion per
+ ** element, like CDInsertHashMap, but with the keys and data stored
+ ** inline in a flat, open-addressing (linear probing) table rather
+ ** than in separately allocated nodes.  The table is restored on a pop
+ ** from a trail of the slots in insertion order, which also serves to
+ ** iterate over the keys in insertion order.
+ **
+ ** See also:
+ **  CDInsertHashMap : The same interface, built on <ext/hash_map>.
+ **  CDHashMap : A fully featured CD hash map. (The closest to <ext/hash_map>)
+ **
+ ** Notes:
+ ** - To iterate over the elements in insertion order use the key_iterators.
+ **   (const_iterators visit the elements in table order.)
+ ** - operator[] is only supported as a const derefence (must succeed).
+ ** - insert(k) must always work.
+ ** - Use insert_safe if you want to check if the element has been inserted
+ **   and only insert if it has not yet been.
+ ** - Supports insertAtContextLevelZero() if the element is not in the map.
+ **/
+
+#include "cvc4_private.h"
+
+#ifndef __CVC4__CONTEXT__CDFLAT_HASHMAP_H
+#define __CVC4__CONTEXT__CDFLAT_HASHMAP_H
+
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+#include <ext/hash_map>
+#include <stdint.h>
+
+#include "context/context.h"
+#include "util/cvc4_assert.h"
+
+namespace CVC4 {
+namespace context {
+
+template <class Key, class Data, class HashFcn = __gnu_cxx::hash<Key> >
+class CDFlatHashMap : public ContextObj {
+public:
+  typedef std::pair<Key, Data> value_type;
+
+private:
+
+  /** The state of a slot in the table. */
+  enum {
+    SLOT_EMPTY = 0,
+    SLOT_FULL,
+    /** A removed element, which lookups must probe past */
+    SLOT_DELETED
+  };
+
+  static const size_t INITIAL_CAPACITY = 16;
+
+  /** The slots of the table; only the SLOT_FULL ones are constructed. */
+  value_type* d_slots;
+
+  /** The state of each slot. */
+  uint8_t* d_states;
+
+  /** The number of slots (a power of 2). */
+  size_t d_capacity;
+
+  /** The number of slots that aren't SLOT_EMPTY. */
+  size_t d_used;
+
+  /**
+   * The slots of the elements in insertion order: those inserted at
+   * context level zero first, then the rest, which are removed from
+   * the back on a pop.
+   */
+  std::vector<uint32_t> d_order;
+
+  /** The number of elements inserted at context level zero. */
+  size_t d_levelZero;
+
+  /** The level at which d_order was last logged on the undo trail. */
+  int d_trailLevel;
+
+  HashFcn d_hash;
+
+  // Nothing to save or restore; insertions are logged on the undo trail
+  virtual ContextObj* save(ContextMemoryManager* pCMM) {
+    Unreachable();
+  }
+
+  virtual void restore(ContextObj* data) {
+    Unreachable();
+  }
+
+  // no copy or assignment
+  CDFlatHashMap(const CDFlatHashMap&) CVC4_UNDEFINED;
+  CDFlatHashMap& operator=(const CDFlatHashMap&) CVC4_UNDEFINED;
+
+  /**
+   * The first slot to probe for k.  Hash functions in CVC4 are often
+   * node ids, so the hash is mixed (multiplicatively) before it's
+   * reduced to the table size.
+   */
+  size_t home(const Key& k) const {
+    uint64_t h = uint64_t(d_hash(k)) * 0x9e3779b97f4a7c15ull;
+    return size_t(h >> 32) & (d_capacity - 1);
+  }
+
+  /** The slot holding k, or d_capacity if it isn't in the map. */
+  size_t lookup(const Key& k) const {
+    if(d_capacity == 0) {
+      return d_capacity;
+    }
+    for(size_t i = home(k);; i = (i + 1) & (d_capacity - 1)) {
+      if(d_states[i] == SLOT_EMPTY) {
+        return d_capacity;
+      }
+      if(d_states[i] == SLOT_FULL && d_slots[i].first == k) {
+        return i;
+      }
+    }
+  }
+
+  /**
+   * Constructs (k, d) in a free slot for k, which mustn't be in the
+   * map, and returns the slot.
+   */
+  size_t place(const Key& k, const Data& d) {
+    size_t i = home(k);
+    while(d_states[i] == SLOT_FULL) {
+      i = (i + 1) & (d_capacity - 1);
+    }
+    if(d_states[i] == SLOT_EMPTY) {
+      ++d_used;
+    }
+    new(&d_slots[i]) value_type(k, d);
+    d_states[i] = SLOT_FULL;
+    return i;
+  }
+
+  /** Makes room for one more element, rehashing if necessary. */
+  void reserveOne() {
+    if((d_used + 1) * 4 <= d_capacity * 3) {
+      return;
+    }
+    // grow if the live elements alone would fill half the table;
+    // otherwise rehashing clears out the deleted slots
+    size_t capacity = d_capacity == 0 ? INITIAL_CAPACITY : d_capacity;
+    while((d_order.size() + 1) * 2 > capacity) {
+      capacity *= 2;
+    }
+    rehash(capacity);
+  }
+
+  /**
+   * Moves the elements to a new table of the given capacity,
+   * inserting them in insertion order so that d_order stays valid.
+   */
+  void rehash(size_t capacity) {
+    value_type* oldSlots = d_slots;
+    uint8_t* oldStates = d_states;
+    size_t oldCapacity = d_capacity;
+
+    d_slots = static_cast<value_type*>(::operator new(capacity * sizeof(value_type)));
+    d_states = new uint8_t[capacity];
+    std::fill(d_states, d_states + capacity, uint8_t(SLOT_EMPTY));
+    d_capacity = capacity;
+    d_used = 0;
+
+    for(std::vector<uint32_t>::iterator i = d_order.begin();
+        i != d_order.end();
+        ++i) {
+      value_type& elt = oldSlots[*i];
+      *i = place(elt.first, elt.second);
+      elt.~value_type();
+    }
+
+    Debug("cdflat_hashmap") << "rehash " << this << " from " << oldCapacity
+                            << " to " << d_capacity << " slots, "
+                            << d_order.size() << " elements" << std::endl;
+    ::operator delete(oldSlots);
+    delete [] oldStates;
+  }
+
+  /**
+   * Removes the element in slot i.  The slot can be emptied (rather
+   * than marked deleted) if no probe sequence runs past it, and then
+   * so can the deleted slots just before it.
+   */
+  void remove(size_t i) {
+    Assert(d_states[i] == SLOT_FULL);
+    d_slots[i].~value_type();
+    if(d_states[(i + 1) & (d_capacity - 1)] != SLOT_EMPTY) {
+      d_states[i] = SLOT_DELETED;
+      return;
+    }
+    do {
+      d_states[i] = SLOT_EMPTY;
+      --d_used;
+      i = (i - 1) & (d_capacity - 1);
+    } while(d_states[i] == SLOT_DELETED);
+  }
+
+  /**
+   * Undo function for the insertions in a scope: data is the number of
+   * elements (not counting those inserted at context level zero) to
+   * restore the map to.
+   */
+  static void undoInserts(void* map, void* data, bool restore) {
+    if(restore) {
+      CDFlatHashMap* m = static_cast<CDFlatHashMap*>(map);
+      size_t size = m->d_levelZero + reinterpret_cast<size_t>(data);
+      Assert(size <= m->d_order.size());
+      while(m->d_order.size() > size) {
+        m->remove(m->d_order.back());
+        m->d_order.pop_back();
+      }
+    }
+  }
+
+public:
+
+  /**
+   * Main constructor: the table starts out empty, and is allocated on
+   * the first insertion
+   */
+  CDFlatHashMap(Context* context, const HashFcn& hash = HashFcn()) :
+    ContextObj(context),
+    d_slots(NULL),
+    d_states(NULL),
+    d_capacity(0),
+    d_used(0),
+    d_order(),
+    d_levelZero(0),
+    d_trailLevel(0),
+    d_hash(hash) {
+  }
+
+  /**
+   * Destructor: destroy the elements and free the table
+   */
+  ~CDFlatHashMap() throw(AssertionException) {
+    if(d_trailLevel > 0) {
+      untrail(this, sizeof(*this), d_trailLevel);
+    }
+    this->destroy();
+    for(std::vector<uint32_t>::const_iterator i = d_order.begin();
+        i != d_order.end();
+        ++i) {
+      d_slots[*i].~value_type();
+    }
+    ::operator delete(d_slots);
+    delete [] d_states;
+  }
+
+  /**
+   * An iterator over the elements, in table order.
+   */
+  class const_iterator {
+    const CDFlatHashMap* d_map;
+    size_t d_slot;
+
+    void skipFree() {
+      while(d_slot < d_map->d_capacity &&
+            d_map->d_states[d_slot] != SLOT_FULL) {
+        ++d_slot;
+      }
+    }
+
+    friend class CDFlatHashMap;
+
+    const_iterator(const CDFlatHashMap* map, size_t slot) :
+      d_map(map),
+      d_slot(slot) {
+      skipFree();
+    }
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename CDFlatHashMap::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+
+    const_iterator() : d_map(NULL), d_slot(0) {}
+
+    bool operator==(const const_iterator& i) const {
+      return d_slot == i.d_slot;
+    }
+    bool operator!=(const const_iterator& i) const {
+      return d_slot != i.d_slot;
+    }
+
+    const value_type& operator*() const {
+      return d_map->d_slots[d_slot];
+    }
+    const value_type* operator->() const {
+      return &d_map->d_slots[d_slot];
+    }
+
+    const_iterator& operator++() {
+      ++d_slot;
+      skipFree();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator i = *this;
+      ++(*this);
+      return i;
+    }
+  };/* class CDFlatHashMap<>::const_iterator */
+
+  /**
+   * An iterator over the keys, in insertion order (those inserted at
+   * context level zero first).
+   */
+  class key_iterator {
+    const CDFlatHashMap* d_map;
+    std::vector<uint32_t>::const_iterator d_it;
+
+    friend class CDFlatHashMap;
+
+    key_iterator(const CDFlatHashMap* map,
+                 std::vector<uint32_t>::const_iterator it) :
+      d_map(map),
+      d_it(it) {
+    }
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Key value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Key* pointer;
+    typedef const Key& reference;
+
+    key_iterator() : d_map(NULL), d_it() {}
+
+    bool operator==(const key_iterator& i) const {
+      return d_it == i.d_it;
+    }
+    bool operator!=(const key_iterator& i) const {
+      return d_it != i.d_it;
+    }
+
+    const Key& operator*() const {
+      return d_map->d_slots[*d_it].first;
+    }
+    const Key* operator->() const {
+      return &d_map->d_slots[*d_it].first;
+    }
+
+    key_iterator& operator++() {
+      ++d_it;
+      return *this;
+    }
+    key_iterator operator++(int) {
+      key_iterator i = *this;
+      ++d_it;
+      return i;
+    }
+  };/* class CDFlatHashMap<>::key_iterator */
+
+  /** Returns true if the map is empty in the current context. */
+  bool empty() const {
+    return d_order.empty();
+  }
+
+  /** Returns the size of the map in the current context. */
+  size_t size() const {
+    return d_order.size();
+  }
+
+  /**
+   * Inserts an element into the map.
+   * The key inserted must be not be currently mapped.
+   */
+  void insert(const Key& k, const Data& d) {
+    Assert(!contains(k));
+    if(makeCurrentOnTrail(d_trailLevel)) {
+      trail(&undoInserts, this,
+            reinterpret_cast<void*>(d_order.size() - d_levelZero));
+    }
+    reserveOne();
+    d_order.push_back(place(k, d));
+  }
+
+  /**
+   * Checks if the key k is mapped already.
+   * If it is, this returns false.
+   * Otherwise it is inserted and this returns true.
+   */
+  bool insert_safe(const Key& k, const Data& d) {
+    if(contains(k)) {
+      return false;
+    } else {
+      insert(k, d);
+      return true;
+    }
+  }
+
+  /**
+   * Version of insert() that inserts data value d at context level
+   * zero: the element is never removed on a pop.
+   *
+   * It is an error to insertAtContextLevelZero()
+   * a key that already is in the map.
+   */
+  void insertAtContextLevelZero(const Key& k, const Data& d) {
+    Assert(!contains(k));
+    reserveOne();
+    d_order.insert(d_order.begin() + d_levelZero, place(k, d));
+    ++d_levelZero;
+  }
+
+  /** Returns true if k is a mapped key in the context. */
+  bool contains(const Key& k) const {
+    return lookup(k) != d_capacity;
+  }
+
+  /**
+   * Returns a reference the data mapped by k.
+   * k must be in the map in this context.
+   */
+  const Data& operator[](const Key& k) const {
+    size_t i = lookup(k);
+    Assert(i != d_capacity);
+    return d_slots[i].second;
+  }
+
+  /**
+   * Returns a const_iterator to the value_type if k is a mapped key in
+   * the context, and end() otherwise.
+   */
+  const_iterator find(const Key& k) const {
+    return const_iterator(this, lookup(k));
+  }
+
+  /** Returns an iterator to the beginning of the map. */
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  /** Returns an iterator to the end of the map. */
+  const_iterator end() const {
+    return const_iterator(this, d_capacity);
+  }
+
+  /** Returns an iterator to the start of the set of keys. */
+  key_iterator key_begin() const {
+    return key_iterator(this, d_order.begin());
+  }
+
+  /** Returns an iterator to the end of the set of keys. */
+  key_iterator key_end() const {
+    return key_iterator(this, d_order.end());
+  }
+};/* class CDFlatHashMap<> */
+
+}/* CVC4::context namespace */
+}/* CVC4 namespace */
+
+#endif /* __CVC4__CONTEXT__CDFLAT_HASHMAP_H */
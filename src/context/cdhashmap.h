@@ -33,39 +33,36 @@
  **
  **     You insert some (key,value) pairs.  Each allocates a CDOhash_map<>
  **     and goes on a doubly-linked list headed by map.d_first and
- **     threaded via CDOhash_map.{d_prev,d_next}.  CDOhash_maps are constructed
- **     with a NULL d_map pointer, but then immediately call
- **     makeCurrent() and set the d_map pointer back to the map.  At
- **     context level 0, this doesn't lead to anything special.  In
- **     higher context levels, this stores away a CDOhash_map with a NULL
- **     map pointer at level 0, and a non-NULL map pointer in the
- **     current context level.  (Remember that for later.)
+ **     threaded via CDOhash_map.{d_prev,d_next}.  CDOhash_maps don't
+ **     save() and restore() themselves; they backtrack through the
+ **     Context's undo trail (see ContextObj::makeCurrentOnTrail()).
+ **     At context level 0, insertion doesn't lead to anything
+ **     special.  In higher context levels, the CDOhash_map logs its
+ **     insertion on the trail.  (Remember that for later.)
  **
  **     When a key is associated to a new value in a CDHashMap, its
- **     associated CDOhash_map calls makeCurrent(), then sets the new
- **     value.  The save object is also a CDOhash_map (allocated in context
- **     memory).
+ **     associated CDOhash_map logs the old value on the trail (the
+ **     first time it changes in the current scope), then sets the new
+ **     value.  Values are copied into the trail entry, or into
+ **     context memory.
  **
  **     Now, CDOhash_maps disappear in a variety of ways.
  **
  **     First, you might pop beyond a "modification of the value"
  **     scope level, requiring a re-association of the key to an old
- **     value.  This is easy.  CDOhash_map::restore() does the work, and
- **     the context memory of the save object is reclaimed as usual.
+ **     value.  This is easy.  The trail does the work, and the context
+ **     memory of the saved value is reclaimed as usual.
  **
  **     Second, you might pop beyond a "insert the key" scope level,
  **     requiring that the key be completely removed from the map and
- **     its CDOhash_map object memory freed.  Here, the CDOhash_map is restored
- **     to a "NULL-map" state (see above), signaling it to remove
- **     itself from the map completely and put itself on a "trash
+ **     its CDOhash_map object memory freed.  Here, the logged
+ **     insertion is undone by CDOhash_map::removeFromMap(), which
+ **     removes it from the map completely and puts it on a "trash
  **     list" for the map.
  **
- **     Third, you might obliterate() the key.  This calls the CDOhash_map
- **     destructor, which calls destroy(), which does a successive
- **     restore() until level 0.  If the key was in the map since
- **     level 0, the restore() won't remove it, so in that case
- **     obliterate() removes it from the map and frees the CDOhash_map's
- **     memory.
+ **     Third, you might obliterate() the key.  This removes it from
+ **     the map and calls the CDOhash_map destructor, which discards
+ **     its entries on the trail, and frees its memory.
  **
  **     Fourth, you might delete the cdhashmap(calling CDHashMap::~CDHashMap()).
  **     This first calls destroy(), as per ContextObj contract, but
@@ -73,9 +70,9 @@
  **     CDHashMap-level.  Then it empties the trash.  Then, for each
  **     element in the map, it marks it as being "part of a complete
  **     map destruction", which essentially short-circuits
- **     CDOhash_map::restore() (see CDOhash_map::restore()), then deallocates
- **     it.  Finally it asserts that the trash is empty (which it
- **     should be, since restore() was short-circuited).
+ **     CDOhash_map::removeFromMap(), then deallocates it (discarding
+ **     its entries on the trail).  Finally it asserts that the trash
+ **     is empty.
  **
  **     Fifth, you might clear() the CDHashMap.  This does exactly the
  **     same as CDHashMap::~CDHashMap(), except that it doesn't call destroy()
@@ -84,10 +81,8 @@
  **     CDHashMap::emptyTrash() simply goes through and calls
  **     ->deleteSelf() on all elements in the trash.
  **     ContextObj::deleteSelf() calls the CDOhash_map destructor, then
- **     frees the memory associated to the CDOhash_map.  CDOhash_map::~CDOhash_map()
- **     calls destroy(), which restores as much as possible.  (Note,
- **     though, that since objects placed on the trash have already
- **     restored to the fullest extent possible, it does nothing.)
+ **     frees the memory associated to the CDOhash_map.  (Elements on
+ **     the trash have no entries left on the trail.)
  **/
 
 #include "cvc4_private.h"
@@ -106,7 +101,8 @@
 namespace CVC4 {
 namespace context {
 
-// Auxiliary class: almost the same as CDO (see cdo.h)
+// Auxiliary class: almost the same as CDO (see cdo.h), but also logs
+// its insertion on the undo trail
 
 template <class Key, class Data, class HashFcn = __gnu_cxx::hash<Key> >
 class CDOhash_map : public ContextObj {
@@ -123,59 +119,66 @@ class CDOhash_map : public ContextObj {
   CDOhash_map* d_prev;
   CDOhash_map* d_next;
 
+  /**
+   * The level at which d_data was last logged on the undo trail.
+   */
+  int d_trailLevel;
+
+  // Nothing to save or restore; changes are logged on the undo trail
   virtual ContextObj* save(ContextMemoryManager* pCMM) {
-    return new(pCMM) CDOhash_map(*this);
+    Unreachable();
   }
 
   virtual void restore(ContextObj* data) {
+    Unreachable();
+  }
+
+  /**
+   * Undo function for an insertion: the element is removed from the
+   * map (popped beyond the first level in which it was).
+   */
+  static void undoInsert(void* elt, void* data, bool restore) {
+    if(restore) {
+      static_cast<CDOhash_map*>(elt)->removeFromMap();
+    }
+  }
+
+  void removeFromMap() {
+    // the trail has restored everything else; nothing is logged for
+    // us anymore
+    d_trailLevel = 0;
     if(d_map != NULL) {
-      CDOhash_map* p = static_cast<CDOhash_map*>(data);
-      if(p->d_map == NULL) {
-        Assert(d_map->d_map.find(d_key) != d_map->d_map.end() &&
-               (*d_map->d_map.find(d_key)).second == this);
-        // no longer in map (popped beyond first level in which it was)
-        d_map->d_map.erase(d_key);
-        // If we call deleteSelf() here, it re-enters restore().  So,
-        // put it on a "trash heap" instead, for later deletion.
-        //
-        // FIXME multithreading
-        if(d_map->d_first == this) {
-          Debug("gc") << "remove first-elem " << this << " from map " << d_map << " with next-elem " << d_next << std::endl;
-          if(d_next == this) {
-            Assert(d_prev == this);
-            d_map->d_first = NULL;
-          } else {
-            d_map->d_first = d_next;
-          }
-        } else {
-          Debug("gc") << "remove nonfirst-elem " << this << " from map " << d_map << std::endl;
-        }
-        d_next->d_prev = d_prev;
-        d_prev->d_next = d_next;
-        if(d_noTrash) {
-          Debug("gc") << "CDHashMap<> no-trash " << this << std::endl;
+      Assert(d_map->d_map.find(d_key) != d_map->d_map.end() &&
+             (*d_map->d_map.find(d_key)).second == this);
+      d_map->d_map.erase(d_key);
+      // If we call deleteSelf() here, we're freeing memory in the
+      // middle of a pop.  So, put it on a "trash heap" instead, for
+      // later deletion.
+      //
+      // FIXME multithreading
+      if(d_map->d_first == this) {
+        Debug("gc") << "remove first-elem " << this << " from map " << d_map << " with next-elem " << d_next << std::endl;
+        if(d_next == this) {
+          Assert(d_prev == this);
+          d_map->d_first = NULL;
         } else {
-          Debug("gc") << "CDHashMap<> trash push_back " << this << std::endl;
-          //this->deleteSelf();
-          d_map->d_trash.push_back(this);
+          d_map->d_first = d_next;
         }
       } else {
-        d_data = p->d_data;
+        Debug("gc") << "remove nonfirst-elem " << this << " from map " << d_map << std::endl;
+      }
+      d_next->d_prev = d_prev;
+      d_prev->d_next = d_next;
+      if(d_noTrash) {
+        Debug("gc") << "CDHashMap<> no-trash " << this << std::endl;
+      } else {
+        Debug("gc") << "CDHashMap<> trash push_back " << this << std::endl;
+        d_map->d_trash.push_back(this);
       }
     }
   }
 
-  /** ensure copy ctor is only called by us */
-  CDOhash_map(const CDOhash_map& other) :
-    ContextObj(other),
-    // don't need to save the key---and if we do we can get
-    // refcounts for Node keys messed up and leak memory
-    d_key(),
-    d_data(other.d_data),
-    d_map(other.d_map),
-    d_prev(NULL),
-    d_next(NULL) {
-  }
+  CDOhash_map(const CDOhash_map& other) CVC4_UNDEFINED;
   CDOhash_map& operator=(const CDOhash_map&) CVC4_UNDEFINED;
 
 public:
@@ -188,35 +191,31 @@ public:
          bool allocatedInCMM = false) :
     ContextObj(allocatedInCMM, context),
     d_key(key),
-    d_map(NULL),
-    d_noTrash(allocatedInCMM) {
+    d_map(map),
+    d_noTrash(allocatedInCMM),
+    d_trailLevel(0) {
 
     // untested, probably unsafe.
     Assert(!(atLevelZero && allocatedInCMM));
 
-    if(atLevelZero) {
+    int level = context->getLevel();
+    if(atLevelZero || level == 0) {
       // "Initializing" map insertion: this entry will never be
       // removed from the map, it's inserted at level 0 as an
       // "initializing" element.  See
-      // CDHashMap<>::insertAtContextLevelZero().
+      // CDHashMap<>::insertAtContextLevelZero().  (Insertions at
+      // level 0 are never removed either.)
       d_data = data;
     } else {
-      // Normal map insertion: first makeCurrent(), then set the data
-      // and then, later, the map.  Order is important; we can't
-      // initialize d_map in the constructor init list above, because
-      // we want the restore of d_map to NULL to signal us to remove
-      // the element from the map.
-
-      if(allocatedInCMM) {
-        // Force a save/restore point, even though the object is
-        // allocated here.  This is so that we can detect when the
-        // object falls out of the map (otherwise we wouldn't get it).
-        makeSaveRestorePoint();
-      }
-
-      set(data);
+      // Normal map insertion: log the insertion on the undo trail, so
+      // that the element is removed from the map on a pop.  (Even if
+      // the object is allocated in context memory at this level, so
+      // that it doesn't linger in the map.)  The data needn't be
+      // logged at this level, since it disappears with the element.
+      trail(&undoInsert, this, NULL);
+      d_trailLevel = level;
+      d_data = data;
     }
-    d_map = map;
 
     CDOhash_map*& first = d_map->d_first;
     if(first == NULL) {
@@ -232,11 +231,16 @@ public:
   }
 
   ~CDOhash_map() throw(AssertionException) {
+    if(d_trailLevel > 0) {
+      untrail(this, sizeof(*this), d_trailLevel);
+    }
     destroy();
   }
 
   void set(const Data& data) {
-    makeCurrent();
+    if(makeCurrentOnTrail(d_trailLevel)) {
+      trail(d_data);
+    }
     d_data = data;
   }
 
@@ -297,6 +301,25 @@ class CDHashMap : public ContextObj {
     Unreachable();
   }
 
+  /**
+   * The contents of a CDHashMap<>, frozen for a ContextSnapshot, in
+   * iteration order.
+   */
+  class Frozen : public ContextSnapshot::State {
+  public:
+    std::vector< std::pair<Key, Data> > d_elements;
+  };/* class CDHashMap<>::Frozen */
+
+  // Freeze a copy of the contents, for a ContextSnapshot
+  virtual ContextSnapshot::State* freeze() const {
+    Frozen* frozen = new Frozen();
+    frozen->d_elements.reserve(d_map.size());
+    for(iterator i = begin(); i != end(); ++i) {
+      frozen->d_elements.push_back(*i);
+    }
+    return frozen;
+  }
+
   void emptyTrash() {
     //FIXME multithreading
     for(typename std::vector<Element*>::iterator i = d_trash.begin();
@@ -322,6 +345,29 @@ public:
     d_trash() {
   }
 
+  /**
+   * Fork constructor: creates a CDHashMap<> in context (typically,
+   * one of another thread) with the contents original had when
+   * snapshot was taken of its Context, inserted at context level
+   * zero.  (Unlike a CDList<>, a map can't share its elements with
+   * the snapshot, so they're copied.)
+   */
+  CDHashMap(Context* context, const ContextSnapshot& snapshot,
+            const CDHashMap& original) :
+    ContextObj(context),
+    d_map(),
+    d_first(NULL),
+    d_context(context),
+    d_trash() {
+    const Frozen& frozen = snapshot.getState<Frozen>(&original);
+    for(typename std::vector< std::pair<Key, Data> >::const_iterator i =
+          frozen.d_elements.begin();
+        i != frozen.d_elements.end();
+        ++i) {
+      insertAtContextLevelZero((*i).first, (*i).second);
+    }
+  }
+
   ~CDHashMap() throw(AssertionException) {
     Debug("gc") << "cdhashmap" << this
                 << " disappearing, destroying..." << std::endl;
@@ -473,38 +519,28 @@ public:
     typename table_type::iterator i = d_map.find(k);
     if(i != d_map.end()) {
       Debug("gc") << "key " << k << " obliterated" << std::endl;
-      // We can't call ->deleteSelf() here, because it calls the
-      // ContextObj destructor, which calls CDOhash_map::destroy(), which
-      // restore()'s, which puts the CDOhash_map on the trash, which causes
-      // a double-delete.
-      (*i).second->~Element();
-      // Writing ...->~CDOhash_map() in the above is legal (?) but breaks
-      // g++ 4.1, though later versions have no problem.
-
-      typename table_type::iterator j = d_map.find(k);
-      // This if() succeeds for objects inserted when in the
-      // zero-scope: they were never save()'d there, so restore()
-      // never gets a NULL map and so they leak.
-      if(j != d_map.end()) {
-        Element* elt = (*j).second;
-        if(d_first == elt) {
-          if(elt->d_next == elt) {
-            Assert(elt->d_prev == elt);
-            d_first = NULL;
-          } else {
-            d_first = elt->d_next;
-          }
+      Element* elt = (*i).second;
+      if(d_first == elt) {
+        if(elt->d_next == elt) {
+          Assert(elt->d_prev == elt);
+          d_first = NULL;
         } else {
-          elt->d_prev->d_next = elt->d_next;
-          elt->d_next->d_prev = elt->d_prev;
-        }
-        d_map.erase(j);//FIXME multithreading
-        Debug("gc") << "key " << k << " obliterated zero-scope: " << elt << std::endl;
-        // was already destructed, so don't call ->deleteSelf()
-        if(!elt->d_noTrash) {
-          ::operator delete(elt);
+          d_first = elt->d_next;
         }
       }
+      elt->d_prev->d_next = elt->d_next;
+      elt->d_next->d_prev = elt->d_prev;
+      d_map.erase(i);//FIXME multithreading
+      // The destructor discards the element's entries on the undo
+      // trail, including the one that would remove it from the map on
+      // a pop.
+      if(elt->d_noTrash) {
+        elt->~Element();
+        // Writing ...->~CDOhash_map() in the above is legal (?) but breaks
+        // g++ 4.1, though later versions have no problem.
+      } else {
+        elt->deleteSelf();
+      }
     }
   }
 
@@ -20,15 +20,15 @@
 #define __CVC4__CONTEXT__CDHASHSET_H
 
 #include "context/context.h"
-#include "context/cdinsert_hashmap.h"
+#include "context/cdflat_hashmap.h"
 #include "util/cvc4_assert.h"
 
 namespace CVC4 {
 namespace context {
 
 template <class V, class HashFcn>
-class CDHashSet : protected CDInsertHashMap<V, bool, HashFcn> {
-  typedef CDInsertHashMap<V, bool, HashFcn> super;
+class CDHashSet : protected CDFlatHashMap<V, bool, HashFcn> {
+  typedef CDFlatHashMap<V, bool, HashFcn> super;
 
   // no copy or assignment
   CDHashSet(const CDHashSet&) CVC4_UNDEFINED;
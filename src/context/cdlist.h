@@ -20,6 +20,7 @@
 #ifndef __CVC4__CONTEXT__CDLIST_H
 #define __CVC4__CONTEXT__CDLIST_H
 
+#include <algorithm>
 #include <iterator>
 #include <memory>
 #include <string>
@@ -36,8 +37,11 @@ namespace CVC4 {
 namespace context {
 
 /**
- * Generic context-dependent dynamic array.  Note that for efficiency,
- * this implementation makes the following assumptions:
+ * Generic context-dependent dynamic array.  The list backtracks through
+ * the Context's undo trail: the first push_back() in a Scope logs the
+ * size of the list, and a pop truncates the list back to it.  Note
+ * that for efficiency, this implementation makes the following
+ * assumptions:
  *
  * 1. Over time, objects are only added to the list.  Objects are only
  *    removed when a pop restores the list to a previous state.
@@ -87,6 +91,17 @@ private:
    */
   size_t d_sizeAlloc;
 
+  /**
+   * Whether the list backtracks through the undo trail (rather than
+   * through save() and restore(), as derived classes may need to).
+   */
+  bool d_trailed;
+
+  /**
+   * The level at which the size was last logged on the undo trail.
+   */
+  int d_trailLevel;
+
   /**
    * The CleanUp functor.
    */
@@ -97,6 +112,36 @@ private:
    */
   Allocator d_allocator;
 
+  /**
+   * The elements of a CDList<>, frozen for a ContextSnapshot.
+   */
+  class Frozen : public ContextSnapshot::State {
+    std::allocator<T> d_allocator;
+  public:
+    T* const d_list;
+    const size_t d_size;
+
+    Frozen(const T* list, size_t size) :
+      d_list(d_allocator.allocate(size)),
+      d_size(size) {
+      std::uninitialized_copy(list, list + size, d_list);
+    }
+
+    ~Frozen() {
+      for(size_t i = 0; i < d_size; ++i) {
+        d_allocator.destroy(&d_list[i]);
+      }
+      d_allocator.deallocate(d_list, d_size);
+    }
+  };/* class CDList<>::Frozen */
+
+  /**
+   * If this list was forked from a ContextSnapshot and hasn't changed
+   * since, the frozen elements it shares with the snapshot (d_list
+   * points to them, and d_sizeAlloc is their number); otherwise NULL.
+   */
+  const Frozen* d_shared;
+
 protected:
   /**
    * Private copy constructor used only by save().  d_list and
@@ -109,8 +154,11 @@ protected:
     d_size(l.d_size),
     d_callDestructor(false),
     d_sizeAlloc(0),
+    d_trailed(false),
+    d_trailLevel(0),
     d_cleanUp(l.d_cleanUp),
-    d_allocator(l.d_allocator) {
+    d_allocator(l.d_allocator),
+    d_shared(NULL) {
     Debug("cdlist") << "copy ctor: " << this
                     << " from " << &l
                     << " size " << d_size << std::endl;
@@ -123,7 +171,9 @@ private:
    * Throws bad_alloc if memory allocation fails.
    */
   void grow() {
-    if(d_list == NULL) {
+    if(d_shared != NULL) {
+      unshare();
+    } else if(d_list == NULL) {
       // Allocate an initial list if one does not yet exist
       d_sizeAlloc = INITIAL_SIZE;
       Debug("cdlist") << "initial grow of cdlist " << this
@@ -160,6 +210,38 @@ private:
     }
   }
 
+  /**
+   * Give the list an array of its own, with copies of the elements it
+   * shares with a ContextSnapshot and room for more.
+   */
+  void unshare() {
+    size_t newSize = std::max(size_t(INITIAL_SIZE), GROWTH_FACTOR * d_size);
+    T* newList = d_allocator.allocate(newSize);
+    Debug("cdlist") << "unshare cdlist " << this
+                    << " level " << getContext()->getLevel()
+                    << " to " << newSize << std::endl;
+    if(newList == NULL) {
+      throw std::bad_alloc();
+    }
+    for(size_t i = 0; i < d_size; ++i) {
+      d_allocator.construct(&newList[i], d_list[i]);
+    }
+    d_shared->unref();
+    d_shared = NULL;
+    d_list = newList;
+    d_sizeAlloc = newSize;
+  }
+
+  /**
+   * Undo function for a logged size, when the list calls destructors:
+   * truncate the list back to it.
+   */
+  static void undoPushBack(void* list, void* size, bool restore) {
+    if(restore) {
+      static_cast<CDList*>(list)->truncateList(reinterpret_cast<size_t>(size));
+    }
+  }
+
   /**
    * Implementation of mandatory ContextObj method save: simply copies
    * the current size to a copy using the copy constructor (the
@@ -197,6 +279,21 @@ protected:
                     << " sizeAlloc at " << this->d_sizeAlloc << std::endl;
   }
 
+  /**
+   * Freeze the elements, for a ContextSnapshot.  If they're still
+   * those this list was forked with, they're shared again.  (Lists
+   * that backtrack through save() and restore() don't take part in
+   * snapshots.)
+   */
+  virtual ContextSnapshot::State* freeze() const {
+    if(!d_trailed) {
+      return NULL;
+    } else if(d_shared != NULL && d_size == d_shared->d_size) {
+      return const_cast<Frozen*>(d_shared);
+    }
+    return new Frozen(d_list, d_size);
+  }
+
   /**
    * Given a size parameter smaller than d_size, truncateList()
    * removes the elements from the end of the list until d_size equals size.
@@ -208,7 +305,7 @@ protected:
    */
   void truncateList(const size_t size){
     Assert(size <= d_size);
-    if(d_callDestructor) {
+    if(d_callDestructor && d_shared == NULL) {
       while(d_size != size) {
         --d_size;
         d_cleanUp(&d_list[d_size]);
@@ -220,6 +317,29 @@ protected:
   }
 
 
+public:
+
+  /**
+   * Constructor for derived classes that backtrack through save() and
+   * restore() (trailed == false), rather than the undo trail.
+   */
+  CDList(Context* context,
+         bool callDestructor,
+         const CleanUp& cleanup,
+         const Allocator& alloc,
+         bool trailed) :
+    ContextObj(context),
+    d_list(NULL),
+    d_size(0),
+    d_callDestructor(callDestructor),
+    d_sizeAlloc(0),
+    d_trailed(trailed),
+    d_trailLevel(0),
+    d_cleanUp(cleanup),
+    d_allocator(alloc),
+    d_shared(NULL) {
+  }
+
 public:
 
   /**
@@ -234,8 +354,11 @@ public:
     d_size(0),
     d_callDestructor(callDestructor),
     d_sizeAlloc(0),
+    d_trailed(true),
+    d_trailLevel(0),
     d_cleanUp(cleanup),
-    d_allocator(alloc) {
+    d_allocator(alloc),
+    d_shared(NULL) {
   }
 
   /**
@@ -251,21 +374,60 @@ public:
     d_size(0),
     d_callDestructor(callDestructor),
     d_sizeAlloc(0),
+    d_trailed(true),
+    d_trailLevel(allocatedInCMM ? context->getLevel() : 0),
+    d_cleanUp(cleanup),
+    d_allocator(alloc),
+    d_shared(NULL) {
+  }
+
+  /**
+   * Fork constructor: creates a CDList<> in context (typically, one
+   * of another thread) with the elements original had when snapshot
+   * was taken of its Context, as level-zero elements.  They're shared
+   * with the snapshot until the list first changes; only then are
+   * they copied.  Elements removed from this list are cleaned up with
+   * cleanup (not with original's CleanUp), unless they're still
+   * shared.
+   */
+  CDList(Context* context,
+         const ContextSnapshot& snapshot,
+         const CDList& original,
+         const CleanUp& cleanup = CleanUp(),
+         const Allocator& alloc = Allocator()) :
+    ContextObj(context),
+    d_list(NULL),
+    d_size(0),
+    d_callDestructor(original.d_callDestructor),
+    d_sizeAlloc(0),
+    d_trailed(true),
+    d_trailLevel(0),
     d_cleanUp(cleanup),
-    d_allocator(alloc) {
+    d_allocator(alloc),
+    d_shared(&snapshot.getState<Frozen>(&original)) {
+    d_shared->ref();
+    d_list = d_shared->d_list;
+    d_size = d_sizeAlloc = d_shared->d_size;
   }
 
   /**
    * Destructor: delete the list
    */
   ~CDList() throw(AssertionException) {
+    if(this->d_trailLevel > 0) {
+      this->untrail(this, sizeof(*this), this->d_trailLevel);
+    }
     this->destroy();
 
     if(this->d_callDestructor) {
       truncateList(0);
     }
 
-    this->d_allocator.deallocate(this->d_list, this->d_sizeAlloc);
+    if(this->d_shared != NULL) {
+      this->d_shared->unref();
+    } else {
+      this->d_allocator.deallocate(this->d_list, this->d_sizeAlloc);
+    }
   }
 
   /**
@@ -291,7 +453,15 @@ public:
                     << " " << getContext()->getLevel()
                     << ": make-current, "
                     << "d_list == " << d_list << std::endl;
-    makeCurrent();
+    if(!d_trailed) {
+      makeCurrent();
+    } else if(makeCurrentOnTrail(d_trailLevel)) {
+      if(d_callDestructor) {
+        trail(&undoPushBack, this, reinterpret_cast<void*>(d_size));
+      } else {
+        trail(d_size);
+      }
+    }
 
     Debug("cdlist") << "push_back " << this
                     << " " << getContext()->getLevel()
@@ -26,9 +26,11 @@ namespace CVC4 {
 namespace context {
 
 /**
- * Most basic template for context-dependent objects.  Simply makes a copy
- * (using the copy constructor) of class T when saving, and copies it back
- * (using operator=) during restore.
+ * Most basic template for context-dependent objects.  Backtracks
+ * through the Context's undo trail: the first change to the data in a
+ * Scope logs a copy of it (made with the copy constructor for T), which
+ * is copied back (using operator=) when the Scope is popped.  If T is a
+ * POD type, the copies are made bitwise.
  */
 template <class T>
 class CDO : public ContextObj {
@@ -38,39 +40,47 @@ class CDO : public ContextObj {
    */
   T d_data;
 
-protected:
+  /**
+   * The level at which d_data was last logged on the undo trail.
+   */
+  int d_trailLevel;
 
   /**
-   * Copy constructor - it's private to ensure it is only used by save().
-   * Basic CDO objects, cannot be copied-they have to be unique.
+   * The data of a CDO<>, frozen for a ContextSnapshot.
    */
-  CDO(const CDO<T>& cdo) : ContextObj(cdo), d_data(cdo.d_data) {}
+  class Frozen : public ContextSnapshot::State {
+  public:
+    const T d_data;
+    Frozen(const T& data) : d_data(data) {}
+  };/* class CDO<T>::Frozen */
+
+protected:
 
   /**
-   * operator= for CDO is private to ensure CDO object is not copied.
+   * Basic CDO objects cannot be copied---they have to be unique.
    */
+  CDO(const CDO<T>& cdo) CVC4_UNDEFINED;
   CDO<T>& operator=(const CDO<T>& cdo) CVC4_UNDEFINED;
 
   /**
-   * Implementation of mandatory ContextObj method save: simply copies the
-   * current data to a copy using the copy constructor.  Memory is allocated
-   * using the ContextMemoryManager.
+   * Nothing to save; changes are logged on the undo trail.
    */
   virtual ContextObj* save(ContextMemoryManager* pCMM) {
-    Debug("context") << "save cdo " << this;
-    ContextObj* p = new(pCMM) CDO<T>(*this);
-    Debug("context") << " to " << p << std::endl;
-    return p;
+    Unreachable();
   }
 
   /**
-   * Implementation of mandatory ContextObj method restore: simply copies the
-   * saved data back from the saved copy using operator= for T.
+   * Similarly, nothing to restore.
    */
   virtual void restore(ContextObj* pContextObj) {
-    //Debug("context") << "restore cdo " << this;
-    d_data = ((CDO<T>*) pContextObj)->d_data;
-    //Debug("context") << " to " << get() << std::endl;
+    Unreachable();
+  }
+
+  /**
+   * Freeze a copy of the data, for a ContextSnapshot.
+   */
+  virtual ContextSnapshot::State* freeze() const {
+    return new Frozen(d_data);
   }
 
 public:
@@ -81,7 +91,8 @@ public:
    */
   CDO(Context* context) :
     ContextObj(context),
-    d_data(T()) {
+    d_data(T()),
+    d_trailLevel(0) {
   }
 
   /**
@@ -97,7 +108,8 @@ public:
    */
   CDO(bool allocatedInCMM, Context* context) :
     ContextObj(allocatedInCMM, context),
-    d_data(T()) {
+    d_data(T()),
+    d_trailLevel(allocatedInCMM ? context->getLevel() : 0) {
   }
 
   /**
@@ -108,9 +120,9 @@ public:
    */
   CDO(Context* context, const T& data) :
     ContextObj(context),
-    d_data(T()) {
-    makeCurrent();
-    d_data = data;
+    d_data(T()),
+    d_trailLevel(0) {
+    set(data);
   }
 
   /**
@@ -128,21 +140,42 @@ public:
    */
   CDO(bool allocatedInCMM, Context* context, const T& data) :
     ContextObj(allocatedInCMM, context),
-    d_data(T()) {
-    makeCurrent();
-    d_data = data;
+    d_data(T()),
+    d_trailLevel(allocatedInCMM ? context->getLevel() : 0) {
+    set(data);
   }
 
   /**
-   * Destructor - call destroy() method
+   * Fork constructor: creates a CDO<> in context (typically, one of
+   * another thread) with the data original had when snapshot was taken
+   * of its Context.  The data is a level-zero value in context.
    */
-  ~CDO() throw(AssertionException) { destroy(); }
+  CDO(Context* context, const ContextSnapshot& snapshot,
+      const CDO<T>& original) :
+    ContextObj(context),
+    d_data(snapshot.getState<Frozen>(&original).d_data),
+    d_trailLevel(0) {
+  }
+
+  /**
+   * Destructor - discard our entries on the undo trail, if any, and
+   * call destroy() method
+   */
+  ~CDO() throw(AssertionException) {
+    if(d_trailLevel > 0) {
+      untrail(this, sizeof(*this), d_trailLevel);
+    }
+    destroy();
+  }
 
   /**
-   * Set the data in the CDO.  First call makeCurrent.
+   * Set the data in the CDO.  First log the old data on the undo trail,
+   * if this is the first change in the current Scope.
    */
   void set(const T& data) {
-    makeCurrent();
+    if(makeCurrentOnTrail(d_trailLevel)) {
+      trail(d_data);
+    }
     d_data = data;
   }
 
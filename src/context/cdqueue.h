@@ -96,7 +96,8 @@ public:
           bool callDestructor = true,
           const CleanUp& cleanup = CleanUp(),
           const Allocator& alloc = Allocator())
-    : ParentType(context, callDestructor, cleanup, alloc),
+    : ParentType(context, callDestructor, cleanup, alloc,
+                 false /* save and restore d_iter and d_lastsave */),
       d_iter(0),
       d_lastsave(0)
   {}
@@ -25,12 +25,15 @@ namespace CVC4 {
 namespace context {
 
 
-Context::Context() : d_pCNOpre(NULL), d_pCNOpost(NULL) {
+Context::Context() :
+  d_pCNOpre(NULL),
+  d_pCNOpost(NULL),
+  d_profiler(NULL) {
   // Create new memory manager
   d_pCMM = new ContextMemoryManager();
 
   // Create initial Scope
-  d_scopeList.push_back(new(d_pCMM) Scope(this, d_pCMM, 0));
+  d_scopeList.push_back(new(d_pCMM) Scope(this, d_pCMM, 0, 0));
 }
 
 
@@ -41,6 +44,8 @@ Context::~Context() throw(AssertionException) {
   // Delete the memory manager
   delete d_pCMM;
 
+  delete d_profiler;
+
   // Clear ContextNotifyObj lists so there are no dangling pointers
   ContextNotifyObj* pCNO;
   while(d_pCNOpre != NULL) {
@@ -66,13 +71,18 @@ void Context::push() {
   d_pCMM->push();
 
   // Create a new top Scope
-  d_scopeList.push_back(new(d_pCMM) Scope(this, d_pCMM, getLevel()+1));
+  d_scopeList.push_back(new(d_pCMM) Scope(this, d_pCMM, getLevel()+1,
+                                          d_trail.size()));
 }
 
 
 void Context::pop() {
   Assert(getLevel() > 0, "Cannot pop below level 0");
 
+  if(d_profiler != NULL) {
+    d_profiler->beginPop();
+  }
+
   // Notify the (pre-pop) ContextNotifyObj objects
   ContextNotifyObj* pCNO = d_pCNOpre;
   while(pCNO != NULL) {
@@ -85,6 +95,9 @@ void Context::pop() {
   // Grab the top Scope
   Scope* pScope = d_scopeList.back();
 
+  // Undo the changes logged on the trail in the top Scope
+  d_trail.unwind(pScope->getTrailMark());
+
   // Restore the previous Scope
   d_scopeList.pop_back();
 
@@ -103,6 +116,10 @@ void Context::pop() {
     pCNO = next;
   }
 
+  if(d_profiler != NULL) {
+    d_profiler->endPop(getLevel() + 1);
+  }
+
   Trace("pushpop") << std::string(2 * getLevel(), ' ') << "} Pop [to "
                    << getLevel() << "] " << this << std::endl;
 }
@@ -115,6 +132,14 @@ void Context::popto(int toLevel) {
 }
 
 
+ContextProfiler* Context::startProfiling() {
+  if(d_profiler == NULL) {
+    d_profiler = new ContextProfiler();
+  }
+  return d_profiler;
+}
+
+
 void Context::addNotifyObjPre(ContextNotifyObj* pCNO) {
   // Insert pCNO at *front* of list
   if(d_pCNOpre != NULL)
@@ -135,13 +160,114 @@ void Context::addNotifyObjPost(ContextNotifyObj* pCNO) {
 }
 
 
+ContextSnapshot::ContextSnapshot(const Context* context) :
+  d_states(),
+  d_level(context->getLevel()) {
+  // every object is on the list of one Scope; so are the copies
+  // saved by objects that backtrack through save() and restore(),
+  // but those don't take part
+  for(std::vector<Scope*>::const_iterator i = context->d_scopeList.begin();
+      i != context->d_scopeList.end();
+      ++i) {
+    for(ContextObj* pContextObj = (*i)->d_pContextObjList;
+        pContextObj != NULL;
+        pContextObj = pContextObj->d_pContextObjNext) {
+      const State* state = pContextObj->freeze();
+      if(state != NULL) {
+        state->ref();
+        d_states[pContextObj] = state;
+      }
+    }
+  }
+}
+
+
+ContextSnapshot::~ContextSnapshot() throw() {
+  for(StateMap::const_iterator i = d_states.begin();
+      i != d_states.end();
+      ++i) {
+    (*i).second->unref();
+  }
+}
+
+
+void UndoTrail::unwind(size_t mark) throw(AssertionException) {
+  Assert(mark <= d_entries.size(), "undo trail is shorter than its mark");
+  for(size_t i = d_entries.size(); i > mark;) {
+    Entry& e = d_entries[--i];
+    if(e.d_undo == NULL) {
+      std::memcpy(e.d_location,
+                  e.d_size <= sizeof(uint64_t) ? &e.d_bits : e.d_data,
+                  e.d_size);
+    } else {
+      e.d_undo(e.d_location, e.d_data, true);
+    }
+  }
+  d_entries.resize(mark);
+}
+
+
+int UndoTrail::discard(size_t first, size_t last,
+                       const void* begin, size_t size, const int* lastLevel) {
+  Assert(first <= last && last <= d_entries.size());
+  const char* lo = static_cast<const char*>(begin);
+  const char* hi = lo + size;
+  int previous = 0;
+  for(size_t i = first; i < last; ++i) {
+    Entry& e = d_entries[i];
+    const char* location = static_cast<const char*>(e.d_location);
+    if(location >= lo && location < hi) {
+      if(e.d_undo == NULL) {
+        if(e.d_location == lastLevel) {
+          std::memcpy(&previous, &e.d_bits, sizeof(int));
+        }
+      } else if(e.d_undo != &undoNothing) {
+        e.d_undo(e.d_location, e.d_data, false);
+      } else {
+        // discarded already, for an earlier object at this address
+        continue;
+      }
+      e.d_undo = &undoNothing;
+    }
+  }
+  return previous;
+}
+
+
+void Context::untrail(const void* begin, size_t size, const int& lastLevel) {
+  Assert(lastLevel <= getLevel(), "undo trail level is ahead of the context");
+  // The object logged lastLevel each time it first changed in a
+  // scope, so its entries lie only in the scopes reached by following
+  // the logged values down from its current one.
+  for(int level = lastLevel; level > 0;) {
+    size_t first = d_scopeList[level]->getTrailMark();
+    size_t last = (level == getLevel()) ?
+      d_trail.size() : d_scopeList[level + 1]->getTrailMark();
+    int previous = d_trail.discard(first, last, begin, size, &lastLevel);
+    Assert(previous < level);
+    level = previous;
+  }
+}
+
+
 void ContextObj::update() throw(AssertionException) {
   Debug("context") << "before update(" << this << "):" << std::endl
                    << "context is " << getContext() << std::endl
                    << *getContext() << std::endl;
 
   // Call save() to save the information in the current object
-  ContextObj* pContextObjSaved = save(d_pScope->getCMM());
+  ContextProfiler* profiler = getContext()->getProfiler();
+  ContextObj* pContextObjSaved;
+  if(profiler == NULL) {
+    pContextObjSaved = save(d_pScope->getCMM());
+  } else {
+    const ContextMemoryManager::Statistics& cmm =
+      d_pScope->getCMM()->getStatistics();
+    uint64_t bytesBefore = cmm.d_bytesInUse;
+    pContextObjSaved = save(d_pScope->getCMM());
+    profiler->save(getContext()->getLevel(), typeid(*this),
+                   cmm.d_bytesInUse - bytesBefore);
+  }
 
   Debug("context") << "in update(" << this << ") with restore "
                    << pContextObjSaved << ": waypoint 1" << std::endl
@@ -211,6 +337,11 @@ ContextObj* ContextObj::restoreAndContinue() throw(AssertionException) {
 
     // Nothing else to do
   } else {
+    ContextProfiler* profiler = getContext()->getProfiler();
+    if(profiler != NULL) {
+      profiler->restore(getLevel(), typeid(*this));
+    }
+
     // Call restore to update the subclass data
     restore(d_pContextObjRestore);
 
@@ -235,6 +366,20 @@ ContextObj* ContextObj::restoreAndContinue() throw(AssertionException) {
 }
 
 
+void ContextObj::profileSaveOnTrail(int level) {
+  ContextProfiler* profiler = getContext()->getProfiler();
+  profiler->saveOnTrail(level, typeid(*this));
+  profiler->trailEntry(level, typeid(*this), 0);
+}
+
+
+void ContextObj::profileTrailEntry(uint64_t bytes) {
+  Context* pContext = getContext();
+  pContext->getProfiler()->trailEntry(pContext->getLevel(), typeid(*this),
+                                      bytes);
+}
+
+
 void ContextObj::destroy() throw(AssertionException) {
   /* Context can be big and complicated, so we only want to process this output
    * if we're really going to use it. (Same goes below.) */
@@ -22,11 +22,16 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <map>
 #include <vector>
 #include <new>
 #include <typeinfo>
+#include <stdint.h>
+
+#include <boost/type_traits/is_pod.hpp>
 
 #include "context/context_mm.h"
+#include "context/context_profiler.h"
 #include "util/cvc4_assert.h"
 
 namespace CVC4 {
@@ -45,6 +50,227 @@ operator<<(std::ostream&, const Context&) throw(AssertionException);
 std::ostream&
 operator<<(std::ostream&, const Scope&) throw(AssertionException);
 
+/**
+ * The undo trail of a Context: a log of (location, old value) entries
+ * written by the context-dependent objects that backtrack through it
+ * rather than through ContextObj::save() and restore() (see
+ * ContextObj::makeCurrentOnTrail()).  On a pop, the entries logged
+ * since the matching push are undone, newest first, in one pass.
+ *
+ * Values of POD type are copied bitwise into the entry itself (or, if
+ * they're larger than eight bytes, into context memory) and copied
+ * back with memcpy().  Values of other types are copy-constructed in
+ * context memory and assigned back.  An entry can also carry its own
+ * undo function, for changes that aren't undone by restoring a value.
+ * Anything kept in context memory is released with the scope, after
+ * the trail is unwound.
+ */
+class UndoTrail {
+public:
+
+  /**
+   * An undo function, called with the location and data given when
+   * its entry was logged: with restore true to undo the change, or
+   * with restore false if the entry is discarded instead (in which
+   * case it only needs to release what data holds).  Undo functions
+   * may not log anything themselves.
+   */
+  typedef void (*UndoFunction)(void* location, void* data, bool restore);
+
+private:
+
+  struct Entry {
+    void* d_location;
+    /** NULL for a bitwise copy of d_size bytes */
+    UndoFunction d_undo;
+    size_t d_size;
+    union {
+      /** The old value, for bitwise copies of at most eight bytes */
+      uint64_t d_bits;
+      /** The old value, or the undo function's data, otherwise */
+      void* d_data;
+    };
+  };/* struct UndoTrail::Entry */
+
+  std::vector<Entry> d_entries;
+
+  /** Undo function for values of non-POD type T */
+  template <class T>
+  static void undoValue(void* location, void* data, bool restore) {
+    T* saved = static_cast<T*>(data);
+    if(restore) {
+      *static_cast<T*>(location) = *saved;
+    }
+    saved->~T();
+  }
+
+  /** Undo function for discarded entries */
+  static void undoNothing(void* location, void* data, bool restore) {}
+
+  void logBits(void* location, size_t size, ContextMemoryManager* pCMM) {
+    Entry e;
+    e.d_location = location;
+    e.d_undo = NULL;
+    e.d_size = size;
+    if(size <= sizeof(uint64_t)) {
+      std::memcpy(&e.d_bits, location, size);
+    } else {
+      e.d_data = pCMM->newData(size);
+      std::memcpy(e.d_data, location, size);
+    }
+    d_entries.push_back(e);
+  }
+
+public:
+
+  /** The number of entries on the trail */
+  size_t size() const { return d_entries.size(); }
+
+  /**
+   * Log the current value of location, so that it can be restored.
+   * If a copy is needed, it's allocated from pCMM.
+   */
+  template <class T>
+  void log(T& location, ContextMemoryManager* pCMM) {
+    if(boost::is_pod<T>::value) {
+      logBits(&location, sizeof(T), pCMM);
+    } else {
+      log(&undoValue<T>, &location, new(pCMM->newData(sizeof(T))) T(location));
+    }
+  }
+
+  /** Log an entry that is undone by calling undo(location, data, true) */
+  void log(UndoFunction undo, void* location, void* data) {
+    Entry e;
+    e.d_location = location;
+    e.d_undo = undo;
+    e.d_size = 0;
+    e.d_data = data;
+    d_entries.push_back(e);
+  }
+
+  /** Undo (and remove) all entries beyond the first mark */
+  void unwind(size_t mark) throw(AssertionException);
+
+  /**
+   * Discard, without undoing them, the entries in [first, last) for
+   * locations in the size bytes starting at begin (the storage of an
+   * object that's going away).  Returns the value logged there for
+   * the object's lastLevel (see ContextObj::makeCurrentOnTrail()),
+   * or 0 if there's no such entry.
+   */
+  int discard(size_t first, size_t last,
+              const void* begin, size_t size, const int* lastLevel);
+
+};/* class UndoTrail */
+
+/**
+ * An immutable snapshot of the context-dependent objects in a Context
+ * (those that take part: CDO<>, CDList<> and CDHashMap<>), taken at
+ * its current level.  From it, another thread can fork private copies
+ * of those objects, in a Context of its own, and push and pop them
+ * without affecting the originals, or being affected by them.  For
+ * instance, to explore a branch of the search in a worker thread:
+ *
+ *   ContextSnapshot snapshot(context);    // in the owning thread
+ *   ...
+ *   Context workerContext;                 // in the worker
+ *   CDList<int> workerList(&workerContext, snapshot, list);
+ *
+ * A snapshot keeps a frozen copy of the state of each object, made
+ * when it's taken, since the owning thread goes on changing the
+ * objects in place.  Forks share the frozen state copy-on-write, where
+ * the structure allows it: a forked CDList<> copies its elements only
+ * when it first changes.  The frozen states are reference-counted
+ * (atomically), so a snapshot can be destroyed while forks still
+ * share them, and any number of threads can read one snapshot.
+ *
+ * Taking a snapshot visits every object in the Context, so it's meant
+ * for occasional use.  The values in it are copied with their own copy
+ * constructors; values that can't be shared between threads (like
+ * Nodes, which belong to the NodeManager of one thread) shouldn't be
+ * forked in another.
+ */
+class ContextSnapshot {
+public:
+
+  /**
+   * The frozen state of one object, shared by the snapshot and its
+   * forks, and deleted when the last of them releases it.
+   */
+  class State {
+    mutable unsigned d_refCount;
+
+    // disable copy, assignment
+    State(const State&) CVC4_UNDEFINED;
+    State& operator=(const State&) CVC4_UNDEFINED;
+
+  protected:
+    State() : d_refCount(0) {}
+
+  public:
+    virtual ~State() {}
+
+    void ref() const {
+      __sync_add_and_fetch(&d_refCount, 1);
+    }
+
+    void unref() const {
+      if(__sync_sub_and_fetch(&d_refCount, 1) == 0) {
+        delete this;
+      }
+    }
+  };/* class ContextSnapshot::State */
+
+private:
+
+  typedef std::map<const ContextObj*, const State*> StateMap;
+
+  /** The frozen states, by object */
+  StateMap d_states;
+
+  /** The level of the Context when the snapshot was taken */
+  int d_level;
+
+  // disable copy, assignment
+  ContextSnapshot(const ContextSnapshot&) CVC4_UNDEFINED;
+  ContextSnapshot& operator=(const ContextSnapshot&) CVC4_UNDEFINED;
+
+public:
+
+  /**
+   * Take a snapshot of the objects in context.  This must be done in
+   * the thread that owns context.
+   */
+  ContextSnapshot(const Context* context);
+
+  ~ContextSnapshot() throw();
+
+  /** Get the level of the Context when the snapshot was taken */
+  int getLevel() const { return d_level; }
+
+  /** Get the number of objects in the snapshot */
+  size_t size() const { return d_states.size(); }
+
+  /** Return true iff obj is in the snapshot */
+  bool contains(const ContextObj* obj) const {
+    return d_states.find(obj) != d_states.end();
+  }
+
+  /**
+   * Get the frozen state of obj, which must be in the snapshot, as a
+   * state of type S.  (For the fork constructors of the objects.)
+   */
+  template <class S>
+  const S& getState(const ContextObj* obj) const {
+    StateMap::const_iterator i = d_states.find(obj);
+    AlwaysAssert(i != d_states.end(),
+                 "forking an object that isn't in the snapshot");
+    return *static_cast<const S*>((*i).second);
+  }
+
+};/* class ContextSnapshot */
+
 /**
  * A Context encapsulates all of the dynamic state of the system.  Its main
  * methods are push() and pop().  A call to push() saves the current state,
@@ -90,9 +316,23 @@ class Context {
    */
   ContextNotifyObj* d_pCNOpost;
 
+  /**
+   * The undo trail, for the ContextObj objects that backtrack through
+   * it.  Each Scope records where its part of the trail begins.
+   */
+  UndoTrail d_trail;
+
+  /**
+   * The profiler for this Context, or NULL if it isn't being profiled
+   * (see startProfiling()).
+   */
+  ContextProfiler* d_profiler;
+
   friend std::ostream&
   operator<<(std::ostream&, const Context&) throw(AssertionException);
 
+  friend class ContextSnapshot;
+
   // disable copy, assignment
   Context(const Context&) CVC4_UNDEFINED;
   Context& operator=(const Context&) CVC4_UNDEFINED;
@@ -187,6 +427,47 @@ public:
    */
   void popto(int toLevel);
 
+  /**
+   * Log the current value of location on the undo trail: it is
+   * restored when the current Scope is popped.
+   */
+  template <class T>
+  void trail(T& location) { d_trail.log(location, d_pCMM); }
+
+  /**
+   * Log a call to undo(location, data, true) on the undo trail, to be
+   * made when the current Scope is popped.
+   */
+  void trail(UndoTrail::UndoFunction undo, void* location, void* data) {
+    d_trail.log(undo, location, data);
+  }
+
+  /**
+   * Discard the entries on the undo trail for locations in the size
+   * bytes starting at begin, without undoing them.  lastLevel is the
+   * owning object's (see ContextObj::makeCurrentOnTrail()); only the
+   * scopes it leads through are searched.
+   */
+  void untrail(const void* begin, size_t size, const int& lastLevel);
+
+  /**
+   * Return the number of entries on the undo trail.
+   */
+  size_t getTrailSize() const { return d_trail.size(); }
+
+  /**
+   * Start profiling the saves and restores of the objects in this
+   * Context, and its pops, from now on (see ContextProfiler).  Returns
+   * the profiler, which belongs to the Context.
+   */
+  ContextProfiler* startProfiling();
+
+  /**
+   * Return the profiler for this Context, or NULL if it isn't being
+   * profiled.
+   */
+  ContextProfiler* getProfiler() const { return d_profiler; }
+
   /**
    * Add pCNO to the list of objects notified before every pop
    */
@@ -255,20 +536,30 @@ class Scope {
    */
   ContextObj* d_pContextObjList;
 
+  /**
+   * Size of the Context's undo trail when this Scope was created: the
+   * entries beyond it are undone when the scope is popped.
+   */
+  size_t d_trailMark;
+
   friend std::ostream&
   operator<<(std::ostream&, const Scope&) throw(AssertionException);
 
+  friend class ContextSnapshot;
+
 public:
 
   /**
    * Constructor: Create a new Scope; set the level and the previous Scope
    * if any.
    */
-  Scope(Context* pContext, ContextMemoryManager* pCMM, int level) throw() :
+  Scope(Context* pContext, ContextMemoryManager* pCMM, int level,
+        size_t trailMark) throw() :
     d_pContext(pContext),
     d_pCMM(pCMM),
     d_level(level),
-    d_pContextObjList(NULL) {
+    d_pContextObjList(NULL),
+    d_trailMark(trailMark) {
   }
 
   /**
@@ -292,6 +583,11 @@ public:
    */
   int getLevel() const throw() { return d_level; }
 
+  /**
+   * Get the size of the undo trail when this Scope was created
+   */
+  size_t getTrailMark() const throw() { return d_trailMark; }
+
   /**
    * Return true iff this Scope is the current top Scope
    */
@@ -371,6 +667,15 @@ public:
  *    subclass-specific restore() method in order to properly clean up saved
  *    copies.
  *
+ * Alternatively, a subclass can backtrack through the Context's undo
+ * trail, which is how CDO<>, CDList<> and CDHashMap<> work.  Instead of
+ * calling makeCurrent() and copying the whole object in save(), it
+ * calls makeCurrentOnTrail() before a change and, if that returns true,
+ * logs the old values of the fields it changes with trail().  A pop
+ * then restores those fields directly, without virtual calls; save()
+ * and restore() are never called, and the destructor calls untrail()
+ * as well as destroy().
+ *
  * GOTCHAS WHEN ALLOCATING CONTEXTUAL OBJECTS WITH NON-STANDARD ALLOCATORS
  *
  * Be careful if you intend to allocate ContextObj in (for example)
@@ -446,6 +751,7 @@ class ContextObj {
   // Scope our friend so it is the only one that can use them.
 
   friend class Scope;
+  friend class ContextSnapshot;
 
   friend std::ostream&
   operator<<(std::ostream&, const Scope&) throw(AssertionException);
@@ -469,6 +775,18 @@ class ContextObj {
    */
   ContextObj* restoreAndContinue() throw(AssertionException);
 
+  /**
+   * Report a save of this object on the undo trail at level (and the
+   * entry for it) to the Context's profiler.
+   */
+  void profileSaveOnTrail(int level);
+
+  /**
+   * Report an entry logged on the undo trail by this object, taking
+   * bytes of context memory, to the Context's profiler.
+   */
+  void profileTrailEntry(uint64_t bytes);
+
 protected:
 
   /**
@@ -483,6 +801,15 @@ protected:
    */
   virtual void restore(ContextObj* pContextObjRestore) = 0;
 
+  /**
+   * Return a frozen copy of the state of this object, for a
+   * ContextSnapshot, or NULL (the default) if objects of this class
+   * don't take part in snapshots.  A class that does also provides a
+   * fork constructor, which builds a copy of an object from the
+   * snapshot (see CDO<> for an example).
+   */
+  virtual ContextSnapshot::State* freeze() const { return NULL; }
+
   /**
    * This method checks if the object has been modified in this Scope
    * yet.  If not, it calls update().
@@ -498,6 +825,61 @@ protected:
    */
   inline void makeSaveRestorePoint() throw(AssertionException);
 
+  /**
+   * The counterpart of makeCurrent() for subclasses that backtrack
+   * through the Context's undo trail instead of save() and restore()
+   * (see CDO<> for an example).  Such a subclass keeps the level at
+   * which it last logged its state in lastLevel (initially 0).  If
+   * that's the current level, this returns false.  Otherwise, it logs
+   * lastLevel itself on the trail, sets it to the current level and
+   * returns true: the caller should then log the fields it's about to
+   * change with trail().  Since lastLevel is restored on a pop along
+   * with everything else, it's nonzero iff the object has entries on
+   * the trail; if it's nonzero in the subclass destructor, that should
+   * call untrail().
+   */
+  inline bool makeCurrentOnTrail(int& lastLevel) throw(AssertionException);
+
+  /**
+   * Log the current value of location (a field of this object) on the
+   * undo trail.
+   */
+  template <class T>
+  void trail(T& location) {
+    Context* pContext = getContext();
+    if(__builtin_expect(pContext->getProfiler() != NULL, false)) {
+      const ContextMemoryManager::Statistics& cmm =
+        pContext->getCMM()->getStatistics();
+      uint64_t bytesBefore = cmm.d_bytesInUse;
+      pContext->trail(location);
+      profileTrailEntry(cmm.d_bytesInUse - bytesBefore);
+    } else {
+      pContext->trail(location);
+    }
+  }
+
+  /**
+   * Log a call to undo(location, data, true) on the undo trail, to be
+   * made when the current Scope is popped.
+   */
+  void trail(UndoTrail::UndoFunction undo, void* location, void* data) {
+    Context* pContext = getContext();
+    pContext->trail(undo, location, data);
+    if(__builtin_expect(pContext->getProfiler() != NULL, false)) {
+      // data was allocated by the caller, so isn't accounted here
+      profileTrailEntry(0);
+    }
+  }
+
+  /**
+   * Discard the entries on the undo trail for locations in this
+   * object, which is size bytes long starting at begin; lastLevel is
+   * the one it passes to makeCurrentOnTrail().
+   */
+  void untrail(const void* begin, size_t size, const int& lastLevel) {
+    getContext()->untrail(begin, size, lastLevel);
+  }
+
   /**
    * Should be called from sub-class destructor: calls restore until restored
    * to initial version (version at context level 0).  Also removes object from
@@ -723,6 +1105,22 @@ inline void ContextObj::makeSaveRestorePoint() throw(AssertionException) {
   update();
 }
 
+inline bool ContextObj::makeCurrentOnTrail(int& lastLevel)
+  throw(AssertionException) {
+  Context* pContext = getContext();
+  int level = pContext->getLevel();
+  if(lastLevel == level) {
+    return false;
+  }
+  Assert(lastLevel < level, "undo trail level is ahead of the context");
+  pContext->trail(lastLevel);
+  lastLevel = level;
+  if(__builtin_expect(pContext->getProfiler() != NULL, false)) {
+    profileSaveOnTrail(level);
+  }
+  return true;
+}
+
 inline Scope::~Scope() throw(AssertionException) {
   // Call restore() method on each ContextObj object in the list.
   // Note that it is the responsibility of restore() to return the
@@ -19,13 +19,88 @@
 #include <vector>
 #include <deque>
 #include <new>
+#include <sys/mman.h>
 #include "context/context_mm.h"
 #include "util/cvc4_assert.h"
 #include "util/output.h"
+#include "util/statistics_registry.h"
 
 namespace CVC4 {
 namespace context {
 
+ContextMemoryManager::Statistics::Statistics() :
+  d_bytesInUse(0),
+  d_peakBytes(0),
+  d_chunksAllocated(0),
+  d_chunksRecycled(0),
+  d_oversizeAllocations(0),
+  d_levelsPopped(0),
+  d_maxBytesPerLevel(0),
+  d_avgBytesPerLevel(0.0) {
+}
+
+class ContextMemoryManager::RegisteredStatistics {
+  ReferenceStat<uint64_t> d_peakBytes;
+  ReferenceStat<uint64_t> d_chunksAllocated;
+  ReferenceStat<uint64_t> d_chunksRecycled;
+  ReferenceStat<uint64_t> d_oversizeAllocations;
+  ReferenceStat<uint64_t> d_levelsPopped;
+  ReferenceStat<uint64_t> d_maxBytesPerLevel;
+  ReferenceStat<double> d_avgBytesPerLevel;
+
+public:
+  RegisteredStatistics(const std::string& prefix, const Statistics& s) :
+    d_peakBytes(prefix + "peakBytes", s.d_peakBytes),
+    d_chunksAllocated(prefix + "chunksAllocated", s.d_chunksAllocated),
+    d_chunksRecycled(prefix + "chunksRecycled", s.d_chunksRecycled),
+    d_oversizeAllocations(prefix + "oversizeAllocations", s.d_oversizeAllocations),
+    d_levelsPopped(prefix + "levelsPopped", s.d_levelsPopped),
+    d_maxBytesPerLevel(prefix + "maxBytesPerLevel", s.d_maxBytesPerLevel),
+    d_avgBytesPerLevel(prefix + "avgBytesPerLevel", s.d_avgBytesPerLevel) {
+    StatisticsRegistry::registerStat(&d_peakBytes);
+    StatisticsRegistry::registerStat(&d_chunksAllocated);
+    StatisticsRegistry::registerStat(&d_chunksRecycled);
+    StatisticsRegistry::registerStat(&d_oversizeAllocations);
+    StatisticsRegistry::registerStat(&d_levelsPopped);
+    StatisticsRegistry::registerStat(&d_maxBytesPerLevel);
+    StatisticsRegistry::registerStat(&d_avgBytesPerLevel);
+  }
+
+  ~RegisteredStatistics() {
+    StatisticsRegistry::unregisterStat(&d_peakBytes);
+    StatisticsRegistry::unregisterStat(&d_chunksAllocated);
+    StatisticsRegistry::unregisterStat(&d_chunksRecycled);
+    StatisticsRegistry::unregisterStat(&d_oversizeAllocations);
+    StatisticsRegistry::unregisterStat(&d_levelsPopped);
+    StatisticsRegistry::unregisterStat(&d_maxBytesPerLevel);
+    StatisticsRegistry::unregisterStat(&d_avgBytesPerLevel);
+  }
+};/* class ContextMemoryManager::RegisteredStatistics */
+
+
+char* ContextMemoryManager::allocateChunk(size_t size) {
+  char* chunk;
+  if(d_hugePages) {
+    void* p;
+    if(posix_memalign(&p, hugePageBytes, size) != 0) {
+      throw std::bad_alloc();
+    }
+    chunk = static_cast<char*>(p);
+#ifdef MADV_HUGEPAGE
+    // only advice; if the kernel can't oblige, we get normal pages
+    madvise(chunk, size, MADV_HUGEPAGE);
+#endif /* MADV_HUGEPAGE */
+  } else {
+    chunk = (char*)malloc(size);
+    if(chunk == NULL) {
+      throw std::bad_alloc();
+    }
+  }
+  ++d_statistics.d_chunksAllocated;
+  return chunk;
+}
+
+
 void ContextMemoryManager::newChunk() {
 
   // Increment index to chunk list
@@ -35,37 +110,53 @@ void ContextMemoryManager::newChunk() {
 
   // Create new chunk if no free chunk available
   if(d_freeChunks.empty()) {
-    d_chunkList.push_back((char*)malloc(chunkSizeBytes));
-    if(d_chunkList.back() == NULL) {
-      throw std::bad_alloc();
-    }
+    d_chunkList.push_back(Chunk(allocateChunk(d_chunkSize), d_chunkSize));
   }
   // If there is a free chunk, use that
   else {
-    d_chunkList.push_back(d_freeChunks.back());
+    d_chunkList.push_back(Chunk(d_freeChunks.back(), d_chunkSize));
     d_freeChunks.pop_back();
+    ++d_statistics.d_chunksRecycled;
   }
   // Set up the current chunk pointers
-  d_nextFree = d_chunkList.back();
-  d_endChunk = d_nextFree + chunkSizeBytes;
+  d_nextFree = d_chunkList.back().d_data;
+  d_endChunk = d_nextFree + d_chunkSize;
 }
 
 
-ContextMemoryManager::ContextMemoryManager() : d_indexChunkList(0) {
+void* ContextMemoryManager::newOversizeData(size_t size) {
+  // The oversize chunk becomes the current chunk, full, so that the
+  // next allocation starts a fresh one; what's left of the previous
+  // chunk is wasted, but oversize allocations are rare.
+  ++d_indexChunkList;
+  Assert(d_chunkList.size() == d_indexChunkList,
+         "Index should be at the end of the list");
+  d_chunkList.push_back(Chunk(allocateChunk(size), size));
+  ++d_statistics.d_oversizeAllocations;
+  d_nextFree = d_endChunk = d_chunkList.back().d_data + size;
+  return d_chunkList.back().d_data;
+}
+
+
+ContextMemoryManager::ContextMemoryManager() :
+  d_chunkSize(chunkSizeBytes),
+  d_maxFreeChunks(maxFreeChunks),
+  d_hugePages(false),
+  d_indexChunkList(0),
+  d_registeredStatistics(NULL) {
   // Create initial chunk
-  d_chunkList.push_back((char*)malloc(chunkSizeBytes));
-  d_nextFree = d_chunkList.back();
-  if(d_nextFree == NULL) {
-    throw std::bad_alloc();
-  }
-  d_endChunk = d_nextFree + chunkSizeBytes;
+  d_chunkList.push_back(Chunk(allocateChunk(d_chunkSize), d_chunkSize));
+  d_nextFree = d_chunkList.back().d_data;
+  d_endChunk = d_nextFree + d_chunkSize;
 }
 
 
 ContextMemoryManager::~ContextMemoryManager() throw() {
+  delete d_registeredStatistics;
+
   // Delete all chunks
   while(!d_chunkList.empty()) {
-    free(d_chunkList.back());
+    free(d_chunkList.back().d_data);
     d_chunkList.pop_back();
   }
   while(!d_freeChunks.empty()) {
@@ -81,11 +172,17 @@ void* ContextMemoryManager::newData(size_t size) {
   d_nextFree += size;
   // Check if the request is too big for the chunk
   if(d_nextFree > d_endChunk) {
-    newChunk();
-    res = (void*)d_nextFree;
-    d_nextFree += size;
-    AlwaysAssert(d_nextFree <= d_endChunk,
-                 "Request is bigger than memory chunk size");
+    if(size > d_chunkSize) {
+      res = newOversizeData(size);
+    } else {
+      newChunk();
+      res = (void*)d_nextFree;
+      d_nextFree += size;
+    }
+  }
+  d_statistics.d_bytesInUse += size;
+  if(d_statistics.d_bytesInUse > d_statistics.d_peakBytes) {
+    d_statistics.d_peakBytes = d_statistics.d_bytesInUse;
   }
   Debug("context") << "ContextMemoryManager::newData(" << size
                    << ") returning " << res << " at level "
@@ -99,6 +196,7 @@ void ContextMemoryManager::push() {
   d_nextFreeStack.push_back(d_nextFree);
   d_endChunkStack.push_back(d_endChunk);
   d_indexChunkListStack.push_back(d_indexChunkList);
+  d_bytesInUseStack.push_back(d_statistics.d_bytesInUse);
 }
 
 
@@ -109,19 +207,87 @@ void ContextMemoryManager::pop() {
   d_endChunk = d_endChunkStack.back();
   d_endChunkStack.pop_back();
 
-  // Free all the new chunks since the last push
+  // Free all the new chunks since the last push; chunks of another
+  // size (oversize ones, or from before a change of chunk size)
+  // aren't kept
   while(d_indexChunkList > d_indexChunkListStack.back()) {
-    d_freeChunks.push_back(d_chunkList.back());
+    const Chunk& chunk = d_chunkList.back();
+    if(chunk.d_size == d_chunkSize) {
+      d_freeChunks.push_back(chunk.d_data);
+    } else {
+      free(chunk.d_data);
+    }
     d_chunkList.pop_back();
     --d_indexChunkList;
   }
   d_indexChunkListStack.pop_back();
 
   // Delete excess free chunks
-  while(d_freeChunks.size() > maxFreeChunks) {
+  while(d_freeChunks.size() > d_maxFreeChunks) {
     free(d_freeChunks.front());
     d_freeChunks.pop_front();
   }
+
+  // Account for the region
+  uint64_t levelBytes = d_statistics.d_bytesInUse - d_bytesInUseStack.back();
+  d_statistics.d_bytesInUse = d_bytesInUseStack.back();
+  d_bytesInUseStack.pop_back();
+  uint64_t n = ++d_statistics.d_levelsPopped;
+  if(levelBytes > d_statistics.d_maxBytesPerLevel) {
+    d_statistics.d_maxBytesPerLevel = levelBytes;
+  }
+  d_statistics.d_avgBytesPerLevel +=
+    (levelBytes - d_statistics.d_avgBytesPerLevel) / n;
+}
+
+
+void ContextMemoryManager::setChunkSize(size_t bytes) {
+  AlwaysAssert(bytes > 0, "chunk size must be positive");
+  if(d_hugePages) {
+    bytes = (bytes + hugePageBytes - 1) / hugePageBytes * hugePageBytes;
+  }
+  if(bytes != d_chunkSize) {
+    // free chunks are all of the old size
+    while(!d_freeChunks.empty()) {
+      free(d_freeChunks.back());
+      d_freeChunks.pop_back();
+    }
+    d_chunkSize = bytes;
+  }
+}
+
+
+void ContextMemoryManager::setMaxFreeChunks(unsigned n) {
+  d_maxFreeChunks = n;
+  while(d_freeChunks.size() > d_maxFreeChunks) {
+    free(d_freeChunks.front());
+    d_freeChunks.pop_front();
+  }
+}
+
+
+void ContextMemoryManager::setHugePages(bool hugePages) {
+  if(hugePages != d_hugePages) {
+    // free chunks were allocated under the old policy
+    while(!d_freeChunks.empty()) {
+      free(d_freeChunks.back());
+      d_freeChunks.pop_back();
+    }
+    d_hugePages = hugePages;
+    setChunkSize(d_chunkSize);
+  }
+}
+
+
+void ContextMemoryManager::registerStatistics(const std::string& prefix) {
+  Assert(d_registeredStatistics == NULL);
+  d_registeredStatistics = new RegisteredStatistics(prefix, d_statistics);
+}
+
+
+void ContextMemoryManager::unregisterStatistics() {
+  delete d_registeredStatistics;
+  d_registeredStatistics = NULL;
 }
 
 
@@ -22,6 +22,8 @@
 
 #include <vector>
 #include <deque>
+#include <string>
+#include <stdint.h>
 
 namespace CVC4 {
 namespace context {
@@ -34,31 +36,51 @@ namespace context {
  * If push is called, the current region is deactivated and pushed on a
  * stack, and a new current region is created.  A subsequent call to pop
  * releases the new region and restores the top region from the stack.
- *
  */
 class ContextMemoryManager {
 
   /**
-   * Memory in regions is allocated in chunks.  This is the chunk size
+   * Memory in regions is allocated in chunks.  This is the default
+   * chunk size; see setChunkSize().
    */
   static const unsigned chunkSizeBytes = 16384;
 
   /**
-   * A list of free chunks is maintained.  This is the maximum number of
-   * free chunks.
+   * A list of free chunks is maintained.  This is the default maximum
+   * number of free chunks; see setMaxFreeChunks().
    */
   static const unsigned maxFreeChunks = 100;
 
+  /** Huge pages are assumed to be this size (as on x86-64) */
+  static const size_t hugePageBytes = 2 * 1024 * 1024;
+
+  /** A chunk of region memory, and its size */
+  struct Chunk {
+    char* d_data;
+    size_t d_size;
+    Chunk(char* data, size_t size) : d_data(data), d_size(size) {}
+  };/* struct ContextMemoryManager::Chunk */
+
   /**
    * List of all chunks that are currently active
    */
-  std::vector<char*> d_chunkList;
+  std::vector<Chunk> d_chunkList;
 
   /**
-   * Queue of free chunks (for best cache performance, LIFO order is used)
+   * Queue of free chunks, all of the current chunk size (for best
+   * cache performance, LIFO order is used)
    */
   std::deque<char*> d_freeChunks;
 
+  /** The size of newly-allocated chunks */
+  size_t d_chunkSize;
+
+  /** The maximum size of d_freeChunks */
+  unsigned d_maxFreeChunks;
+
+  /** Whether to back chunks with transparent huge pages */
+  bool d_hugePages;
+
   /**
    * Pointer to the beginning of available memory in the current chunk in
    * the current region.
@@ -94,6 +116,47 @@ class ContextMemoryManager {
    */
   std::vector<unsigned> d_indexChunkListStack;
 
+  /**
+   * Part of the stack of saved regions.  This vector stores the saved
+   * value of d_statistics.d_bytesInUse.
+   */
+  std::vector<uint64_t> d_bytesInUseStack;
+
+public:
+
+  /**
+   * Statistics kept by a ContextMemoryManager.  They're plain
+   * counters, so a manager costs nothing extra whether or not they're
+   * reported; see registerStatistics().
+   */
+  struct Statistics {
+    /** Bytes handed out by newData() and live in some region */
+    uint64_t d_bytesInUse;
+    /** High-water mark of d_bytesInUse */
+    uint64_t d_peakBytes;
+    /** Chunks obtained from the system */
+    uint64_t d_chunksAllocated;
+    /** Chunks reused from the free chunk list */
+    uint64_t d_chunksRecycled;
+    /** Allocations too big for a chunk, given a chunk of their own */
+    uint64_t d_oversizeAllocations;
+    /** Number of pops */
+    uint64_t d_levelsPopped;
+    /** The most bytes allocated in a single popped region */
+    uint64_t d_maxBytesPerLevel;
+    /** The mean number of bytes allocated in a popped region */
+    double d_avgBytesPerLevel;
+    Statistics();
+  };/* struct ContextMemoryManager::Statistics */
+
+private:
+
+  Statistics d_statistics;
+
+  /** Statistics registered by registerStatistics(), if any */
+  class RegisteredStatistics;
+  RegisteredStatistics* d_registeredStatistics;
+
   /**
    * Private method to grab a new chunk for the current region.  Uses chunk
    * from d_freeChunks if available.  Creates a new one otherwise.  Sets the
@@ -101,10 +164,20 @@ class ContextMemoryManager {
    */
   void newChunk();
 
+  /**
+   * Give an allocation of size bytes (more than a chunk) a chunk of
+   * its own, in the current region.
+   */
+  void* newOversizeData(size_t size);
+
+  /** Get memory for a chunk of size bytes from the system */
+  char* allocateChunk(size_t size);
+
 public:
 
   /**
-   * Get the maximum allocation size for this memory manager.
+   * Get the maximum allocation size for this memory manager.  (Bigger
+   * allocations are possible, but each takes a chunk of its own.)
    */
   static unsigned getMaxAllocationSize() {
     return chunkSizeBytes;
@@ -136,6 +209,39 @@ public:
    */
   void pop();
 
+  /**
+   * Set the size of chunks allocated from now on (chunks already in
+   * use keep their size).  With huge pages, it's rounded up to a
+   * multiple of the huge page size.
+   */
+  void setChunkSize(size_t bytes);
+
+  /** Set the number of free chunks kept for reuse after a pop */
+  void setMaxFreeChunks(unsigned n);
+
+  /**
+   * Back chunks allocated from now on with transparent huge pages
+   * (madvise(MADV_HUGEPAGE)), where the platform supports it.  This
+   * rounds the chunk size up to a multiple of the huge page size, so
+   * is meant for contexts that are pushed very deep.
+   */
+  void setHugePages(bool hugePages);
+
+  /** Get the chunk size currently in effect */
+  size_t getChunkSize() const { return d_chunkSize; }
+
+  /** Get this memory manager's statistics */
+  const Statistics& getStatistics() const { return d_statistics; }
+
+  /**
+   * Register this memory manager's statistics with the current
+   * statistics registry, with names starting with prefix.
+   */
+  void registerStatistics(const std::string& prefix);
+
+  /** Undo registerStatistics() */
+  void unregisterStatistics();
+
 };/* class ContextMemoryManager */
 
 /**
@@ -0,0 +1,245 @@
+/*********************                                                        */
+/*! \file context_profiler.cpp
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A profiler for the backtracking done by a Context
+ **
+ ** A profiler for the backtracking done by a Context.
+ **/
+
+#include <cstdlib>
+#include <cxxabi.h>
+
+#include "context/context_profiler.h"
+#include "util/cvc4_assert.h"
+#include "util/statistics_registry.h"
+
+namespace CVC4 {
+namespace context {
+
+ContextProfiler::Counts::Counts() :
+  d_saves(0),
+  d_restores(0),
+  d_trailEntries(0),
+  d_bytes(0),
+  d_pending(0) {
+}
+
+ContextProfiler::Counts&
+ContextProfiler::Counts::operator+=(const Counts& c) {
+  d_saves += c.d_saves;
+  d_restores += c.d_restores;
+  d_trailEntries += c.d_trailEntries;
+  d_bytes += c.d_bytes;
+  d_pending += c.d_pending;
+  return *this;
+}
+
+ContextProfiler::Level::Level() :
+  d_types(),
+  d_pops(0) {
+  d_popTime.tv_sec = d_popTime.tv_nsec = 0;
+}
+
+/** A profile, by type or by level, as a statistic */
+class ContextProfiler::Statistic : public Stat {
+  const ContextProfiler& d_profiler;
+  bool d_byLevel;
+
+public:
+  Statistic(const std::string& name, const ContextProfiler& profiler,
+            bool byLevel) :
+    Stat(name),
+    d_profiler(profiler),
+    d_byLevel(byLevel) {
+  }
+
+  void flushInformation(std::ostream& out) const {
+    if(d_byLevel) {
+      d_profiler.printLevels(out);
+    } else {
+      d_profiler.printTypes(out);
+    }
+  }
+};/* class ContextProfiler::Statistic */
+
+/** The demangled name of a type, if it can be demangled */
+static std::string typeName(const std::type_info& type) {
+  int status;
+  char* name = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+  if(name == NULL) {
+    return type.name();
+  }
+  std::string s(name);
+  free(name);
+  return s;
+}
+
+static std::ostream& operator<<(std::ostream& out,
+                                const ContextProfiler::Counts& c) {
+  return out << "saves " << c.d_saves
+             << " restores " << c.d_restores
+             << " trailEntries " << c.d_trailEntries
+             << " bytes " << c.d_bytes;
+}
+
+ContextProfiler::ContextProfiler() :
+  d_levels(),
+  d_typesStatistic(NULL),
+  d_levelsStatistic(NULL) {
+  d_popStart.tv_sec = d_popStart.tv_nsec = 0;
+}
+
+ContextProfiler::~ContextProfiler() throw() {
+  unregisterStatistics();
+}
+
+ContextProfiler::Counts&
+ContextProfiler::counts(int level, const std::type_info& type) {
+  Assert(level >= 0);
+  if(size_t(level) >= d_levels.size()) {
+    d_levels.resize(level + 1);
+  }
+  return d_levels[level].d_types[&type];
+}
+
+void ContextProfiler::beginPop() {
+  clock_gettime(CLOCK_MONOTONIC, &d_popStart);
+}
+
+void ContextProfiler::endPop(int level) {
+  timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if(size_t(level) >= d_levels.size()) {
+    d_levels.resize(level + 1);
+  }
+  Level& l = d_levels[level];
+  ++l.d_pops;
+  l.d_popTime += end - d_popStart;
+  // the saves on the undo trail at this level have been undone
+  for(TypeMap::iterator i = l.d_types.begin(); i != l.d_types.end(); ++i) {
+    Counts& c = (*i).second;
+    c.d_restores += c.d_pending;
+    c.d_pending = 0;
+  }
+}
+
+ContextProfiler::Counts ContextProfiler::getTotals() const {
+  Counts totals;
+  for(std::vector<Level>::const_iterator i = d_levels.begin();
+      i != d_levels.end();
+      ++i) {
+    for(TypeMap::const_iterator j = (*i).d_types.begin();
+        j != (*i).d_types.end();
+        ++j) {
+      totals += (*j).second;
+    }
+  }
+  return totals;
+}
+
+ContextProfiler::Counts
+ContextProfiler::getTotals(const std::type_info& type) const {
+  Counts totals;
+  for(std::vector<Level>::const_iterator i = d_levels.begin();
+      i != d_levels.end();
+      ++i) {
+    TypeMap::const_iterator j = (*i).d_types.find(&type);
+    if(j != (*i).d_types.end()) {
+      totals += (*j).second;
+    }
+  }
+  return totals;
+}
+
+uint64_t ContextProfiler::getPops(int level) const {
+  return size_t(level) < d_levels.size() ? d_levels[level].d_pops : 0;
+}
+
+void ContextProfiler::printTypes(std::ostream& out) const {
+  TypeMap totals;
+  for(std::vector<Level>::const_iterator i = d_levels.begin();
+      i != d_levels.end();
+      ++i) {
+    for(TypeMap::const_iterator j = (*i).d_types.begin();
+        j != (*i).d_types.end();
+        ++j) {
+      totals[(*j).first] += (*j).second;
+    }
+  }
+  out << "[";
+  for(TypeMap::const_iterator i = totals.begin(); i != totals.end(); ++i) {
+    out << (i == totals.begin() ? "(" : ", (")
+        << typeName(*(*i).first) << " : " << (*i).second << ")";
+  }
+  out << "]";
+}
+
+void ContextProfiler::printLevels(std::ostream& out) const {
+  out << "[";
+  bool first = true;
+  for(size_t level = 0; level < d_levels.size(); ++level) {
+    const Level& l = d_levels[level];
+    if(l.d_pops == 0) {
+      continue;
+    }
+    Counts totals;
+    for(TypeMap::const_iterator i = l.d_types.begin();
+        i != l.d_types.end();
+        ++i) {
+      totals += (*i).second;
+    }
+    out << (first ? "(" : ", (") << level << " : pops " << l.d_pops
+        << " time " << l.d_popTime << " " << totals << ")";
+    first = false;
+  }
+  out << "]";
+}
+
+void ContextProfiler::dumpFolded(std::ostream& out,
+                                 const std::string& name) const {
+  for(size_t level = 0; level < d_levels.size(); ++level) {
+    const TypeMap& types = d_levels[level].d_types;
+    for(TypeMap::const_iterator i = types.begin(); i != types.end(); ++i) {
+      const Counts& c = (*i).second;
+      std::string type = typeName(*(*i).first);
+      if(c.d_saves > 0) {
+        out << name << ";level " << level << ";" << type
+            << ";save " << c.d_saves << std::endl;
+      }
+      if(c.d_restores > 0) {
+        out << name << ";level " << level << ";" << type
+            << ";restore " << c.d_restores << std::endl;
+      }
+    }
+  }
+}
+
+void ContextProfiler::registerStatistics(const std::string& prefix) {
+  Assert(d_typesStatistic == NULL);
+  d_typesStatistic = new Statistic(prefix + "profileByType", *this, false);
+  d_levelsStatistic = new Statistic(prefix + "profileByLevel", *this, true);
+  StatisticsRegistry::registerStat(d_typesStatistic);
+  StatisticsRegistry::registerStat(d_levelsStatistic);
+}
+
+void ContextProfiler::unregisterStatistics() {
+  if(d_typesStatistic != NULL) {
+    StatisticsRegistry::unregisterStat(d_typesStatistic);
+    StatisticsRegistry::unregisterStat(d_levelsStatistic);
+    delete d_typesStatistic;
+    delete d_levelsStatistic;
+    d_typesStatistic = NULL;
+    d_levelsStatistic = NULL;
+  }
+}
+
+}/* CVC4::context namespace */
+}/* CVC4 namespace */
@@ -0,0 +1,201 @@
+/*********************                                                        */
+/*! \file context_profiler.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A profiler for the backtracking done by a Context
+ **
+ ** A profiler for the backtracking done by a Context: it accounts the
+ ** saves and restores of context-dependent objects, and the context
+ ** memory they take, by scope level and by the objects' dynamic type,
+ ** and times each pop.
+ **/
+
+#include "cvc4_private.h"
+
+#ifndef __CVC4__CONTEXT__CONTEXT_PROFILER_H
+#define __CVC4__CONTEXT__CONTEXT_PROFILER_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include <stdint.h>
+
+#include "lib/clock_gettime.h"
+
+namespace CVC4 {
+namespace context {
+
+/**
+ * A profiler for a Context, enabled with Context::startProfiling().
+ * The Context and its ContextObj objects report to it:
+ *
+ * - a save each time an object is copied by save() or, for objects
+ *   that backtrack through the undo trail, the first time it logs its
+ *   state in a scope (see ContextObj::makeCurrentOnTrail());
+ *
+ * - each entry an object logs on the undo trail;
+ *
+ * - the context memory taken by each save and trail entry;
+ *
+ * - a restore each time restore() is called and, for objects on the
+ *   undo trail, for each of their saves in a scope that's popped
+ *   (entries discarded by untrail() are still counted);
+ *
+ * - the time each pop() takes, from the pre-pop notifications to the
+ *   post-pop ones.
+ *
+ * Saves and restores are accounted to the level of the scope they
+ * belong to: the one that's current when the object is saved, and
+ * that's popped when it's restored.  The totals are reported through
+ * the statistics registry (see registerStatistics()), and the whole
+ * profile can be written in the "folded" format that flame graph
+ * tools read (see dumpFolded()).
+ */
+class ContextProfiler {
+public:
+
+  /** The counts kept for one type of object at one level */
+  struct Counts {
+    uint64_t d_saves;
+    uint64_t d_restores;
+    uint64_t d_trailEntries;
+    uint64_t d_bytes;
+    /** Saves on the undo trail not yet restored by a pop */
+    uint64_t d_pending;
+    Counts();
+    Counts& operator+=(const Counts& c);
+  };/* struct ContextProfiler::Counts */
+
+private:
+
+  /** Orders types for the maps below */
+  struct TypeLess {
+    bool operator()(const std::type_info* a, const std::type_info* b) const {
+      return a->before(*b);
+    }
+  };/* struct ContextProfiler::TypeLess */
+
+  typedef std::map<const std::type_info*, Counts, TypeLess> TypeMap;
+
+  /** What's kept for one scope level */
+  struct Level {
+    TypeMap d_types;
+    uint64_t d_pops;
+    /** Total time spent popping this level */
+    timespec d_popTime;
+    Level();
+  };/* struct ContextProfiler::Level */
+
+  /** The profile, by scope level */
+  std::vector<Level> d_levels;
+
+  /** Start of the pop in progress */
+  timespec d_popStart;
+
+  /** The statistics registered by registerStatistics(), if any */
+  class Statistic;
+  Statistic* d_typesStatistic;
+  Statistic* d_levelsStatistic;
+
+  Counts& counts(int level, const std::type_info& type);
+
+  // disable copy, assignment
+  ContextProfiler(const ContextProfiler&) CVC4_UNDEFINED;
+  ContextProfiler& operator=(const ContextProfiler&) CVC4_UNDEFINED;
+
+public:
+
+  ContextProfiler();
+  ~ContextProfiler() throw();
+
+  /**
+   * Record that an object of the given type was saved at level, taking
+   * bytes of context memory.
+   */
+  void save(int level, const std::type_info& type, uint64_t bytes) {
+    Counts& c = counts(level, type);
+    ++c.d_saves;
+    c.d_bytes += bytes;
+  }
+
+  /**
+   * Record that an object of the given type was saved on the undo
+   * trail at level: it's restored when that level is popped.
+   */
+  void saveOnTrail(int level, const std::type_info& type) {
+    Counts& c = counts(level, type);
+    ++c.d_saves;
+    ++c.d_pending;
+  }
+
+  /**
+   * Record that an object of the given type logged an entry on the
+   * undo trail at level, taking bytes of context memory.
+   */
+  void trailEntry(int level, const std::type_info& type, uint64_t bytes) {
+    Counts& c = counts(level, type);
+    ++c.d_trailEntries;
+    c.d_bytes += bytes;
+  }
+
+  /**
+   * Record that an object of the given type, saved at level, was
+   * restored.
+   */
+  void restore(int level, const std::type_info& type) {
+    ++counts(level, type).d_restores;
+  }
+
+  /** Record the beginning of a pop */
+  void beginPop();
+
+  /** Record the end of a pop of level */
+  void endPop(int level);
+
+  /** Get the totals over all levels and types */
+  Counts getTotals() const;
+
+  /** Get the totals for objects of a type, over all levels */
+  Counts getTotals(const std::type_info& type) const;
+
+  /** Get the number of times level was popped */
+  uint64_t getPops(int level) const;
+
+  /** Print the totals for each type of object (over all levels) on out */
+  void printTypes(std::ostream& out) const;
+
+  /** Print the pops, pop time and totals of each level popped on out */
+  void printLevels(std::ostream& out) const;
+
+  /**
+   * Write the saves and restores in the profile, as stacks of
+   * name;level N;type;{save,restore} (with type names demangled),
+   * to out in folded format, one stack and its count per line.
+   */
+  void dumpFolded(std::ostream& out, const std::string& name) const;
+
+  /**
+   * Register this profile with the current statistics registry, as
+   * the statistics prefix + "profileByType" and prefix +
+   * "profileByLevel" (see printTypes() and printLevels()).
+   */
+  void registerStatistics(const std::string& prefix);
+
+  /** Undo registerStatistics() */
+  void unregisterStatistics();
+
+};/* class ContextProfiler */
+
+}/* CVC4::context namespace */
+}/* CVC4 namespace */
+
+#endif /* __CVC4__CONTEXT__CONTEXT_PROFILER_H */
@@ -23,6 +23,7 @@
 #include "expr/kind.h"
 #include "theory/rewriter.h"
 #include "decision/options.h"
+#include "prop/options.h"
 #include "util/ite_removal.h"
 
 
@@ -540,7 +541,10 @@ JustificationHeuristic::findSplitterRec(TNode node, SatValue desiredVal)
   }
 
   if(ret == NO_SPLITTER) {
-    Assert( litPresent == false || litVal ==  desiredVal,
+    // (with the polarity-aware CNF, a literal only implies its formula,
+    // so it needn't follow its justified value)
+    Assert( litPresent == false || litVal ==  desiredVal ||
+            options::cnfPolarity(),
            "Output should be justified");
     setJustified(node);
   }
@@ -27,6 +27,8 @@ namespace CVC4 {
 namespace expr {
 namespace attr {
 
+const bool DenseAttrTable<bool>::s_values[2] = { false, true };
+
 SmtAttributes::SmtAttributes(context::Context* ctxt) :
   d_cdbools(ctxt),
   d_cdints(ctxt),
@@ -70,6 +72,12 @@ void AttributeManager::deleteAllAttributes(NodeValue* nv) {
   deleteFromTable(d_types, nv);
   deleteFromTable(d_strings, nv);
   deleteFromTable(d_ptrs, nv);
+  d_denseBools.erase(nv);
+  d_denseInts.erase(nv);
+  d_denseTNodes.erase(nv);
+  d_denseNodes.erase(nv);
+  d_denseTypes.erase(nv);
+  d_densePtrs.erase(nv);
 }
 
 void SmtAttributes::deleteAllAttributes(TNode n) {
@@ -91,6 +99,20 @@ void AttributeManager::deleteAllAttributes() {
   deleteAllFromTable(d_types);
   deleteAllFromTable(d_strings);
   deleteAllFromTable(d_ptrs);
+  d_denseBools.clear();
+  d_denseInts.clear();
+  d_denseTNodes.clear();
+  d_denseNodes.clear();
+  d_denseTypes.clear();
+  d_densePtrs.clear();
+}
+
+template <class T>
+static void eraseDenseAttributes(DenseAttrTable<T>& table,
+                                 const std::vector<uint64_t>& ids) {
+  for(std::vector<uint64_t>::const_iterator i = ids.begin(); i != ids.end(); ++i) {
+    table.eraseAttribute(*i);
+  }
 }
 
 void AttributeManager::deleteAttributes(const AttrIdVec& atids) {
@@ -132,6 +154,25 @@ void AttributeManager::deleteAttributes(const AttrIdVec& atids) {
       deleteAttributesFromTable(d_ptrs, ids);
       break;
 
+    case AttrTableDenseBool:
+      eraseDenseAttributes(d_denseBools, ids);
+      break;
+    case AttrTableDenseUInt64:
+      eraseDenseAttributes(d_denseInts, ids);
+      break;
+    case AttrTableDenseTNode:
+      eraseDenseAttributes(d_denseTNodes, ids);
+      break;
+    case AttrTableDenseNode:
+      eraseDenseAttributes(d_denseNodes, ids);
+      break;
+    case AttrTableDenseTypeNode:
+      eraseDenseAttributes(d_denseTypes, ids);
+      break;
+    case AttrTableDensePointer:
+      eraseDenseAttributes(d_densePtrs, ids);
+      break;
+
     case AttrTableCDBool:
     case AttrTableCDUInt64:
     case AttrTableCDTNode:
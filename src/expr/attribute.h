@@ -129,6 +129,19 @@ public:
   /** Underlying hash table for pointer-valued attributes */
   AttrHash<void*> d_ptrs;
 
+  /** Underlying dense table for boolean-valued dense attributes */
+  DenseAttrTable<bool> d_denseBools;
+  /** Underlying dense table for integral-valued dense attributes */
+  DenseAttrTable<uint64_t> d_denseInts;
+  /** Underlying dense table for node-valued dense attributes */
+  DenseAttrTable<TNode> d_denseTNodes;
+  /** Underlying dense table for node-valued dense attributes */
+  DenseAttrTable<Node> d_denseNodes;
+  /** Underlying dense table for type-valued dense attributes */
+  DenseAttrTable<TypeNode> d_denseTypes;
+  /** Underlying dense table for pointer-valued dense attributes */
+  DenseAttrTable<void*> d_densePtrs;
+
   /**
    * Get a particular attribute on a particular node.
    *
@@ -429,32 +442,104 @@ struct getTable<const T*, true> {
   }
 };
 
-}/* CVC4::expr::attr namespace */
 
-// ATTRIBUTE MANAGER IMPLEMENTATIONS ===========================================
+/**
+ * The getDenseTable<> template provides (static) access to the
+ * AttributeManager field holding the dense table for DenseAttribute<>
+ * kinds.
+ */
+template <class T>
+struct getDenseTable;
 
-namespace attr {
+/** Access the "d_denseBools" member of AttributeManager. */
+template <>
+struct getDenseTable<bool> {
+  static const AttrTableId id = AttrTableDenseBool;
+  typedef DenseAttrTable<bool> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseBools;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseBools;
+  }
+};
 
-// implementation for AttributeManager::getAttribute()
-template <class AttrKind>
-typename AttrKind::value_type
-AttributeManager::getAttribute(NodeValue* nv, const AttrKind&) const {
-  typedef typename AttrKind::value_type value_type;
-  typedef KindValueToTableValueMapping<value_type> mapping;
-  typedef typename getTable<value_type, AttrKind::context_dependent>::
-            table_type table_type;
+/** Access the "d_denseInts" member of AttributeManager. */
+template <>
+struct getDenseTable<uint64_t> {
+  static const AttrTableId id = AttrTableDenseUInt64;
+  typedef DenseAttrTable<uint64_t> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseInts;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseInts;
+  }
+};
+
+/** Access the "d_denseTNodes" member of AttributeManager. */
+template <>
+struct getDenseTable<TNode> {
+  static const AttrTableId id = AttrTableDenseTNode;
+  typedef DenseAttrTable<TNode> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseTNodes;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseTNodes;
+  }
+};
+
+/** Access the "d_denseNodes" member of AttributeManager. */
+template <>
+struct getDenseTable<Node> {
+  static const AttrTableId id = AttrTableDenseNode;
+  typedef DenseAttrTable<Node> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseNodes;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseNodes;
+  }
+};
 
-  const table_type& ah =
-    getTable<value_type, AttrKind::context_dependent>::get(*this, smt::s_smtEngine_current);
-  typename table_type::const_iterator i =
-    ah.find(std::make_pair(AttrKind::getId(), nv));
+/** Access the "d_denseTypes" member of AttributeManager. */
+template <>
+struct getDenseTable<TypeNode> {
+  static const AttrTableId id = AttrTableDenseTypeNode;
+  typedef DenseAttrTable<TypeNode> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_denseTypes;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_denseTypes;
+  }
+};
 
-  if(i == ah.end()) {
-    return typename AttrKind::value_type();
+/** Access the "d_densePtrs" member of AttributeManager. */
+template <>
+struct getDenseTable<void*> {
+  static const AttrTableId id = AttrTableDensePointer;
+  typedef DenseAttrTable<void*> table_type;
+  static inline table_type& get(AttributeManager& am) {
+    return am.d_densePtrs;
+  }
+  static inline const table_type& get(const AttributeManager& am) {
+    return am.d_densePtrs;
   }
+};
 
-  return mapping::convertBack((*i).second);
-}
+}/* CVC4::expr::attr namespace */
+
+// ATTRIBUTE MANAGER IMPLEMENTATIONS ===========================================
+
+namespace attr {
+
+/* Helper template class for the AttributeManager's accessors,
+ * specialized based on whether AttrKind is kept in the hash tables
+ * or in a dense table. */
+template <class AttrKind, bool dense = AttrKind::dense>
+struct AttributeAccess;
 
 /* Helper template class for hasAttribute(), specialized based on
  * whether AttrKind has a "default value" that all Nodes implicitly
@@ -550,19 +635,113 @@ struct HasAttribute<false, AttrKind> {
   }
 };
 
+/**
+ * Specialization of AttributeAccess<> for attribute kinds kept in
+ * the (possibly context-dependent) hash tables.
+ */
+template <class AttrKind>
+struct AttributeAccess<AttrKind, false> {
+  typedef typename AttrKind::value_type value_type;
+  typedef KindValueToTableValueMapping<value_type> mapping;
+  typedef getTable<value_type, AttrKind::context_dependent> table_getter;
+  typedef typename table_getter::table_type table_type;
+
+  static const AttrTableId table_id = table_getter::id;
+
+  static inline value_type getAttribute(const AttributeManager* am,
+                                        NodeValue* nv) {
+    const table_type& ah = table_getter::get(*am, smt::s_smtEngine_current);
+    typename table_type::const_iterator i =
+      ah.find(std::make_pair(AttrKind::getId(), nv));
+
+    if(i == ah.end()) {
+      return value_type();
+    }
+
+    return mapping::convertBack((*i).second);
+  }
+
+  static inline bool hasAttribute(const AttributeManager* am,
+                                  NodeValue* nv) {
+    return HasAttribute<AttrKind::has_default_value, AttrKind>::
+             hasAttribute(am, nv);
+  }
+
+  static inline bool getAttribute(const AttributeManager* am,
+                                  NodeValue* nv,
+                                  value_type& ret) {
+    return HasAttribute<AttrKind::has_default_value, AttrKind>::
+             getAttribute(am, nv, ret);
+  }
+
+  static inline void setAttribute(AttributeManager* am,
+                                  NodeValue* nv,
+                                  const value_type& value) {
+    table_type& ah = table_getter::get(*am, smt::s_smtEngine_current);
+    ah[std::make_pair(AttrKind::getId(), nv)] = mapping::convert(value);
+  }
+};
+
+/**
+ * Specialization of AttributeAccess<> for DenseAttribute<> kinds.
+ */
+template <class AttrKind>
+struct AttributeAccess<AttrKind, true> {
+  typedef typename AttrKind::value_type value_type;
+  typedef KindValueToTableValueMapping<value_type> mapping;
+  typedef typename mapping::table_value_type table_value_type;
+  typedef getDenseTable<table_value_type> table_getter;
+
+  static const AttrTableId table_id = table_getter::id;
+
+  static inline value_type getAttribute(const AttributeManager* am,
+                                        NodeValue* nv) {
+    const table_value_type* v =
+      table_getter::get(*am).find(AttrKind::getId(), nv);
+    return v == NULL ? value_type() : mapping::convertBack(*v);
+  }
+
+  static inline bool hasAttribute(const AttributeManager* am,
+                                  NodeValue* nv) {
+    return table_getter::get(*am).find(AttrKind::getId(), nv) != NULL;
+  }
+
+  static inline bool getAttribute(const AttributeManager* am,
+                                  NodeValue* nv,
+                                  value_type& ret) {
+    const table_value_type* v =
+      table_getter::get(*am).find(AttrKind::getId(), nv);
+    if(v == NULL) {
+      return false;
+    }
+    ret = mapping::convertBack(*v);
+    return true;
+  }
+
+  static inline void setAttribute(AttributeManager* am,
+                                  NodeValue* nv,
+                                  const value_type& value) {
+    table_getter::get(*am).set(AttrKind::getId(), nv, mapping::convert(value));
+  }
+};
+
+template <class AttrKind>
+typename AttrKind::value_type
+AttributeManager::getAttribute(NodeValue* nv, const AttrKind&) const {
+  return AttributeAccess<AttrKind>::getAttribute(this, nv);
+}
+
 template <class AttrKind>
 bool AttributeManager::hasAttribute(NodeValue* nv,
                                     const AttrKind&) const {
-  return HasAttribute<AttrKind::has_default_value, AttrKind>::
-           hasAttribute(this, nv);
+  return AttributeAccess<AttrKind>::hasAttribute(this, nv);
 }
 
 template <class AttrKind>
 bool AttributeManager::getAttribute(NodeValue* nv,
                                     const AttrKind&,
                                     typename AttrKind::value_type& ret) const {
-  return HasAttribute<AttrKind::has_default_value, AttrKind>::
-           getAttribute(this, nv, ret);
+  return AttributeAccess<AttrKind>::getAttribute(this, nv, ret);
 }
 
 template <class AttrKind>
@@ -570,14 +749,7 @@ inline void
 AttributeManager::setAttribute(NodeValue* nv,
                                const AttrKind&,
                                const typename AttrKind::value_type& value) {
-  typedef typename AttrKind::value_type value_type;
-  typedef KindValueToTableValueMapping<value_type> mapping;
-  typedef typename getTable<value_type, AttrKind::context_dependent>::
-            table_type table_type;
-
-  table_type& ah =
-    getTable<value_type, AttrKind::context_dependent>::get(*this, smt::s_smtEngine_current);
-  ah[std::make_pair(AttrKind::getId(), nv)] = mapping::convert(value);
+  AttributeAccess<AttrKind>::setAttribute(this, nv, value);
 }
 
 /**
@@ -658,9 +830,7 @@ inline void AttributeManager::deleteAllFromTable(AttrHash<T>& table) {
 
 template <class AttrKind>
 AttributeUniqueId AttributeManager::getAttributeId(const AttrKind& attr){
-  typedef typename AttrKind::value_type value_type;
-  AttrTableId tableId = getTable<value_type,
-                                 AttrKind::context_dependent>::id;
+  AttrTableId tableId = AttributeAccess<AttrKind>::table_id;
   return AttributeUniqueId(tableId, attr.getId());
 }
 
@@ -716,12 +886,14 @@ void AttributeManager::reconstructTable(AttrHash<T>& table){
 template <class AttrKind>
 inline typename AttrKind::value_type
 NodeManager::getAttribute(expr::NodeValue* nv, const AttrKind&) const {
+  AttributeGuard g(this);
   return d_attrManager->getAttribute(nv, AttrKind());
 }
 
 template <class AttrKind>
 inline bool NodeManager::hasAttribute(expr::NodeValue* nv,
                                       const AttrKind&) const {
+  AttributeGuard g(this);
   return d_attrManager->hasAttribute(nv, AttrKind());
 }
 
@@ -729,6 +901,7 @@ template <class AttrKind>
 inline bool
 NodeManager::getAttribute(expr::NodeValue* nv, const AttrKind&,
                           typename AttrKind::value_type& ret) const {
+  AttributeGuard g(this);
   return d_attrManager->getAttribute(nv, AttrKind(), ret);
 }
 
@@ -736,18 +909,21 @@ template <class AttrKind>
 inline void
 NodeManager::setAttribute(expr::NodeValue* nv, const AttrKind&,
                           const typename AttrKind::value_type& value) {
+  AttributeGuard g(this);
   d_attrManager->setAttribute(nv, AttrKind(), value);
 }
 
 template <class AttrKind>
 inline typename AttrKind::value_type
 NodeManager::getAttribute(TNode n, const AttrKind&) const {
+  AttributeGuard g(this);
   return d_attrManager->getAttribute(n.d_nv, AttrKind());
 }
 
 template <class AttrKind>
 inline bool
 NodeManager::hasAttribute(TNode n, const AttrKind&) const {
+  AttributeGuard g(this);
   return d_attrManager->hasAttribute(n.d_nv, AttrKind());
 }
 
@@ -755,6 +931,7 @@ template <class AttrKind>
 inline bool
 NodeManager::getAttribute(TNode n, const AttrKind&,
                           typename AttrKind::value_type& ret) const {
+  AttributeGuard g(this);
   return d_attrManager->getAttribute(n.d_nv, AttrKind(), ret);
 }
 
@@ -762,18 +939,21 @@ template <class AttrKind>
 inline void
 NodeManager::setAttribute(TNode n, const AttrKind&,
                           const typename AttrKind::value_type& value) {
+  AttributeGuard g(this);
   d_attrManager->setAttribute(n.d_nv, AttrKind(), value);
 }
 
 template <class AttrKind>
 inline typename AttrKind::value_type
 NodeManager::getAttribute(TypeNode n, const AttrKind&) const {
+  AttributeGuard g(this);
   return d_attrManager->getAttribute(n.d_nv, AttrKind());
 }
 
 template <class AttrKind>
 inline bool
 NodeManager::hasAttribute(TypeNode n, const AttrKind&) const {
+  AttributeGuard g(this);
   return d_attrManager->hasAttribute(n.d_nv, AttrKind());
 }
 
@@ -781,6 +961,7 @@ template <class AttrKind>
 inline bool
 NodeManager::getAttribute(TypeNode n, const AttrKind&,
                           typename AttrKind::value_type& ret) const {
+  AttributeGuard g(this);
   return d_attrManager->getAttribute(n.d_nv, AttrKind(), ret);
 }
 
@@ -788,6 +969,7 @@ template <class AttrKind>
 inline void
 NodeManager::setAttribute(TypeNode n, const AttrKind&,
                           const typename AttrKind::value_type& value) {
+  AttributeGuard g(this);
   d_attrManager->setAttribute(n.d_nv, AttrKind(), value);
 }
 
@@ -23,6 +23,8 @@
 #ifndef __CVC4__EXPR__ATTRIBUTE_INTERNALS_H
 #define __CVC4__EXPR__ATTRIBUTE_INTERNALS_H
 
+#include <algorithm>
+#include <vector>
 #include <ext/hash_map>
 
 #include "context/cdhashmap.h"
@@ -581,6 +583,275 @@ public:
 
 }/* CVC4::expr::attr namespace */
 
+// DENSE ATTRIBUTE TABLES ======================================================
+
+namespace attr {
+
+/**
+ * A "DenseAttrTable<value_type>"---the table underlying
+ * DenseAttribute<> kinds---stores, for each attribute id, a column of
+ * values indexed directly by NodeValue id.  Columns are split into
+ * pages that are allocated on first use and freed when they empty
+ * out again, so an attribute set on few nodes costs little even
+ * though node ids grow without bound.  A lookup is two loads and a
+ * bit test, with no hashing.
+ */
+template <class value_type>
+class DenseAttrTable {
+public:
+  /** log2 of the number of entries per page */
+  static const unsigned PAGE_BITS = 9;
+  static const size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+private:
+  struct Page {
+    value_type d_values[PAGE_SIZE];
+    uint64_t d_present[PAGE_SIZE / 64];
+    size_t d_count;
+    Page() : d_count(0) {
+      std::fill(d_present, d_present + PAGE_SIZE / 64, uint64_t(0));
+    }
+  };/* struct DenseAttrTable<>::Page */
+
+  typedef std::vector<Page*> Column;
+
+  /** The columns, indexed by attribute id */
+  std::vector<Column> d_columns;
+
+  inline const Page* getPage(uint64_t attr, uint64_t id) const {
+    if(attr >= d_columns.size()) {
+      return NULL;
+    }
+    const Column& c = d_columns[attr];
+    size_t p = id >> PAGE_BITS;
+    return p < c.size() ? c[p] : NULL;
+  }
+
+  static inline bool isPresent(const Page* pg, size_t i) {
+    return (pg->d_present[i >> 6] >> (i & 63)) & 1;
+  }
+
+  /** Clear entry i of page p of column c, freeing the page if it empties. */
+  static void eraseEntry(Column& c, size_t p, size_t i) {
+    Page* pg = c[p];
+    pg->d_present[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    pg->d_values[i] = value_type();
+    if(--pg->d_count == 0) {
+      delete pg;
+      c[p] = NULL;
+    }
+  }
+
+  static void clearColumn(Column& c) {
+    for(typename Column::iterator i = c.begin(); i != c.end(); ++i) {
+      delete *i;
+    }
+    c.clear();
+  }
+
+  // disallow copy
+  DenseAttrTable(const DenseAttrTable&) CVC4_UNDEFINED;
+  DenseAttrTable& operator=(const DenseAttrTable&) CVC4_UNDEFINED;
+
+public:
+
+  DenseAttrTable() {}
+
+  ~DenseAttrTable() {
+    clear();
+  }
+
+  /** The value of attribute attr on nv, or NULL if it has none. */
+  const value_type* find(uint64_t attr, const NodeValue* nv) const {
+    const Page* pg = getPage(attr, nv->getId());
+    if(pg == NULL) {
+      return NULL;
+    }
+    size_t i = nv->getId() & (PAGE_SIZE - 1);
+    return isPresent(pg, i) ? &pg->d_values[i] : NULL;
+  }
+
+  void set(uint64_t attr, const NodeValue* nv, const value_type& value) {
+    if(attr >= d_columns.size()) {
+      d_columns.resize(attr + 1);
+    }
+    Column& c = d_columns[attr];
+    size_t p = nv->getId() >> PAGE_BITS;
+    if(p >= c.size()) {
+      c.resize(p + 1, NULL);
+    }
+    if(c[p] == NULL) {
+      c[p] = new Page();
+    }
+    Page* pg = c[p];
+    size_t i = nv->getId() & (PAGE_SIZE - 1);
+    if(!isPresent(pg, i)) {
+      pg->d_present[i >> 6] |= uint64_t(1) << (i & 63);
+      ++pg->d_count;
+    }
+    pg->d_values[i] = value;
+  }
+
+  /** Remove all attributes of nv (called when nv is reclaimed). */
+  void erase(const NodeValue* nv) {
+    size_t p = nv->getId() >> PAGE_BITS;
+    size_t i = nv->getId() & (PAGE_SIZE - 1);
+    for(typename std::vector<Column>::iterator c = d_columns.begin();
+        c != d_columns.end();
+        ++c) {
+      if(p < (*c).size() && (*c)[p] != NULL && isPresent((*c)[p], i)) {
+        eraseEntry(*c, p, i);
+      }
+    }
+  }
+
+  /** Remove attribute attr from all nodes. */
+  void eraseAttribute(uint64_t attr) {
+    if(attr < d_columns.size()) {
+      clearColumn(d_columns[attr]);
+    }
+  }
+
+  /** Remove everything. */
+  void clear() {
+    for(typename std::vector<Column>::iterator c = d_columns.begin();
+        c != d_columns.end();
+        ++c) {
+      clearColumn(*c);
+    }
+  }
+
+};/* class DenseAttrTable<> */
+
+/**
+ * Boolean-valued dense attributes ("flags") need no presence bits;
+ * every node has the flag, false by default, so a page is just the
+ * bits themselves.
+ */
+template <>
+class DenseAttrTable<bool> {
+public:
+  static const unsigned PAGE_BITS = 12;
+  static const size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+private:
+  struct Page {
+    uint64_t d_bits[PAGE_SIZE / 64];
+    size_t d_count;
+    Page() : d_count(0) {
+      std::fill(d_bits, d_bits + PAGE_SIZE / 64, uint64_t(0));
+    }
+  };/* struct DenseAttrTable<bool>::Page */
+
+  typedef std::vector<Page*> Column;
+
+  std::vector<Column> d_columns;
+
+  /** Storage for the results of find() */
+  static const bool s_values[2];
+
+  static void clearColumn(Column& c) {
+    for(Column::iterator i = c.begin(); i != c.end(); ++i) {
+      delete *i;
+    }
+    c.clear();
+  }
+
+  /** Clear bit i of page p of column c, freeing the page if it empties. */
+  static void clearBit(Column& c, size_t p, size_t i) {
+    Page* pg = c[p];
+    uint64_t mask = uint64_t(1) << (i & 63);
+    if(pg->d_bits[i >> 6] & mask) {
+      pg->d_bits[i >> 6] &= ~mask;
+      if(--pg->d_count == 0) {
+        delete pg;
+        c[p] = NULL;
+      }
+    }
+  }
+
+  // disallow copy
+  DenseAttrTable(const DenseAttrTable&) CVC4_UNDEFINED;
+  DenseAttrTable& operator=(const DenseAttrTable&) CVC4_UNDEFINED;
+
+public:
+
+  DenseAttrTable() {}
+
+  ~DenseAttrTable() {
+    clear();
+  }
+
+  /** The value of flag attr on nv; never NULL. */
+  const bool* find(uint64_t attr, const NodeValue* nv) const {
+    if(attr < d_columns.size()) {
+      const Column& c = d_columns[attr];
+      size_t p = nv->getId() >> PAGE_BITS;
+      if(p < c.size() && c[p] != NULL) {
+        size_t i = nv->getId() & (PAGE_SIZE - 1);
+        return &s_values[(c[p]->d_bits[i >> 6] >> (i & 63)) & 1];
+      }
+    }
+    return &s_values[0];
+  }
+
+  void set(uint64_t attr, const NodeValue* nv, bool value) {
+    size_t p = nv->getId() >> PAGE_BITS;
+    size_t i = nv->getId() & (PAGE_SIZE - 1);
+    if(!value) {
+      if(attr < d_columns.size() && p < d_columns[attr].size() &&
+         d_columns[attr][p] != NULL) {
+        clearBit(d_columns[attr], p, i);
+      }
+      return;
+    }
+    if(attr >= d_columns.size()) {
+      d_columns.resize(attr + 1);
+    }
+    Column& c = d_columns[attr];
+    if(p >= c.size()) {
+      c.resize(p + 1, NULL);
+    }
+    if(c[p] == NULL) {
+      c[p] = new Page();
+    }
+    uint64_t mask = uint64_t(1) << (i & 63);
+    if(!(c[p]->d_bits[i >> 6] & mask)) {
+      c[p]->d_bits[i >> 6] |= mask;
+      ++c[p]->d_count;
+    }
+  }
+
+  void erase(const NodeValue* nv) {
+    size_t p = nv->getId() >> PAGE_BITS;
+    size_t i = nv->getId() & (PAGE_SIZE - 1);
+    for(std::vector<Column>::iterator c = d_columns.begin();
+        c != d_columns.end();
+        ++c) {
+      if(p < (*c).size() && (*c)[p] != NULL) {
+        clearBit(*c, p, i);
+      }
+    }
+  }
+
+  void eraseAttribute(uint64_t attr) {
+    if(attr < d_columns.size()) {
+      clearColumn(d_columns[attr]);
+    }
+  }
+
+  void clear() {
+    for(std::vector<Column>::iterator c = d_columns.begin();
+        c != d_columns.end();
+        ++c) {
+      clearColumn(*c);
+    }
+  }
+
+};/* class DenseAttrTable<bool> */
+
+}/* CVC4::expr::attr namespace */
+
 // ATTRIBUTE CLEANUP FUNCTIONS =================================================
 
 namespace attr {
@@ -704,6 +975,18 @@ struct LastAttributeId {
   }
 };
 
+/**
+ * The last-attribute-assigner for DenseAttribute<> kinds, which get
+ * their own columns in a DenseAttrTable<T>.
+ */
+template <class T>
+struct LastDenseAttributeId {
+  static uint64_t& getId() {
+    static uint64_t s_id = 0;
+    return s_id;
+  }
+};
+
 }/* CVC4::expr::attr namespace */
 
 // ATTRIBUTE TRAITS ============================================================
@@ -773,6 +1056,9 @@ public:
    */
   static const bool context_dependent = context_dep;
 
+  /** Values are kept in the hash tables (see DenseAttribute<>). */
+  static const bool dense = false;
+
   /**
    * Register this attribute kind and check that the ID is a valid ID
    * for bool-valued attributes.  Fail an assert if not.  Otherwise
@@ -838,6 +1124,9 @@ public:
    */
   static const bool context_dependent = context_dep;
 
+  /** Values are kept in the hash tables (see DenseAttribute<>). */
+  static const bool dense = false;
+
   /**
    * Register this attribute kind and check that the ID is a valid ID
    * for bool-valued attributes.  Fail an assert if not.  Otherwise
@@ -881,6 +1170,73 @@ template <class T,
 struct ManagedAttribute :
     public Attribute<T, value_type, CleanupStrategy, false> {};
 
+/**
+ * A dense attribute kind.  It behaves like Attribute<T, value_t>, but
+ * its values are stored in a DenseAttrTable<> indexed by NodeValue id
+ * rather than in a hash table, which makes lookups considerably
+ * cheaper.  This is meant for the handful of attributes that are
+ * consulted on nearly every node (types, rewrite caches); since
+ * memory is allocated in pages of consecutive node ids, an attribute
+ * set on only a few scattered nodes is better off as an Attribute<>.
+ * Dense attributes cannot be context-dependent or have a cleanup
+ * function, and can only have bool, uint64_t, TNode, Node, TypeNode
+ * or pointer values.
+ */
+template <class T, class value_t>
+class DenseAttribute {
+  /** The unique ID (column) associated to this attribute. */
+  static const uint64_t s_id;
+
+public:
+
+  /** The value type for this attribute. */
+  typedef value_t value_type;
+
+  /** Get the unique ID associated to this attribute. */
+  static inline uint64_t getId() { return s_id; }
+
+  /** As for Attribute<>. */
+  static const bool has_default_value = false;
+
+  static const bool context_dependent = false;
+
+  /** Values are kept in a DenseAttrTable<>. */
+  static const bool dense = true;
+
+  static inline uint64_t registerAttribute() {
+    typedef typename attr::KindValueToTableValueMapping<value_t>::
+                     table_value_type table_value_type;
+    return attr::LastDenseAttributeId<table_value_type>::getId()++;
+  }
+};/* class DenseAttribute<> */
+
+/**
+ * A dense attribute kind for boolean flags; like the flags of
+ * Attribute<T, bool>, these are false for all nodes on entry.
+ */
+template <class T>
+class DenseAttribute<T, bool> {
+  static const uint64_t s_id;
+
+public:
+
+  typedef bool value_type;
+
+  static inline uint64_t getId() { return s_id; }
+
+  static const bool has_default_value = true;
+
+  static const bool default_value = false;
+
+  static const bool context_dependent = false;
+
+  static const bool dense = true;
+
+  static inline uint64_t registerAttribute() {
+    return attr::LastDenseAttributeId<bool>::getId()++;
+  }
+};/* class DenseAttribute<..., bool> */
+
 // ATTRIBUTE IDENTIFIER ASSIGNMENT =============================================
 
 /** Assign unique IDs to attributes at load time. */
@@ -904,6 +1260,16 @@ const uint64_t Attribute<T,
   Attribute<T, bool, attr::NullCleanupStrategy, context_dep>::
     registerAttribute();
 
+/** Assign unique IDs to dense attributes at load time. */
+template <class T, class value_t>
+const uint64_t DenseAttribute<T, value_t>::s_id =
+  DenseAttribute<T, value_t>::registerAttribute();
+
+/** Assign unique IDs to dense attributes at load time. */
+template <class T>
+const uint64_t DenseAttribute<T, bool>::s_id =
+  DenseAttribute<T, bool>::registerAttribute();
+
 }/* CVC4::expr namespace */
 }/* CVC4 namespace */
 
@@ -42,6 +42,12 @@ enum AttrTableId {
   AttrTableCDNode,
   AttrTableCDString,
   AttrTableCDPointer,
+  AttrTableDenseBool,
+  AttrTableDenseUInt64,
+  AttrTableDenseTNode,
+  AttrTableDenseNode,
+  AttrTableDenseTypeNode,
+  AttrTableDensePointer,
   LastAttrTable
 };
 
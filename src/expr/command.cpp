@@ -202,6 +202,10 @@ Expr AssertCommand::getExpr() const throw() {
   return d_expr;
 }
 
+bool AssertCommand::inUnsatCore() const throw() {
+  return d_inUnsatCore;
+}
+
 void AssertCommand::invoke(SmtEngine* smtEngine) throw() {
   try {
     smtEngine->assertFormula(d_expr, d_inUnsatCore);
@@ -289,6 +293,10 @@ Expr CheckSatCommand::getExpr() const throw() {
   return d_expr;
 }
 
+bool CheckSatCommand::inUnsatCore() const throw() {
+  return d_inUnsatCore;
+}
+
 void CheckSatCommand::invoke(SmtEngine* smtEngine) throw() {
   try {
     d_result = smtEngine->checkSat(d_expr);
@@ -326,6 +334,57 @@ std::string CheckSatCommand::getCommandName() const throw() {
   return "check-sat";
 }
 
+/* class CheckSatAssumingCommand */
+
+CheckSatAssumingCommand::CheckSatAssumingCommand(const std::vector<Expr>& assumptions) throw() :
+  d_assumptions(assumptions) {
+}
+
+const std::vector<Expr>& CheckSatAssumingCommand::getAssumptions() const throw() {
+  return d_assumptions;
+}
+
+void CheckSatAssumingCommand::invoke(SmtEngine* smtEngine) throw() {
+  try {
+    d_result = smtEngine->checkSatAssuming(d_assumptions);
+    d_commandStatus = CommandSuccess::instance();
+  } catch(exception& e) {
+    d_commandStatus = new CommandFailure(e.what());
+  }
+}
+
+Result CheckSatAssumingCommand::getResult() const throw() {
+  return d_result;
+}
+
+void CheckSatAssumingCommand::printResult(std::ostream& out, uint32_t verbosity) const throw() {
+  if(! ok()) {
+    this->Command::printResult(out, verbosity);
+  } else {
+    out << d_result << endl;
+  }
+}
+
+Command* CheckSatAssumingCommand::exportTo(ExprManager* exprManager, ExprManagerMapCollection& variableMap) {
+  vector<Expr> exportedAssumptions;
+  for(std::vector<Expr>::const_iterator i = d_assumptions.begin(); i != d_assumptions.end(); ++i) {
+    exportedAssumptions.push_back((*i).exportTo(exprManager, variableMap));
+  }
+  CheckSatAssumingCommand* c = new CheckSatAssumingCommand(exportedAssumptions);
+  c->d_result = d_result;
+  return c;
+}
+
+Command* CheckSatAssumingCommand::clone() const {
+  CheckSatAssumingCommand* c = new CheckSatAssumingCommand(d_assumptions);
+  c->d_result = d_result;
+  return c;
+}
+
+std::string CheckSatAssumingCommand::getCommandName() const throw() {
+  return "check-sat-assuming";
+}
+
 /* class QueryCommand */
 
 QueryCommand::QueryCommand(const Expr& e, bool inUnsatCore) throw() :
@@ -336,6 +395,10 @@ Expr QueryCommand::getExpr() const throw() {
   return d_expr;
 }
 
+bool QueryCommand::inUnsatCore() const throw() {
+  return d_inUnsatCore;
+}
+
 void QueryCommand::invoke(SmtEngine* smtEngine) throw() {
   try {
     d_result = smtEngine->query(d_expr);
@@ -484,8 +547,55 @@ void CommandSequence::clear() throw() {
   d_commandSequence.clear();
 }
 
+/**
+ * Type check the assertions among commands[from...] as a batch, so
+ * that terms they share are checked once, bottom-up.  Returns the
+ * index of the first ill-typed assertion, with the error it would
+ * fail with in failure, or commands.size() if they're all well-typed.
+ */
+static size_t checkAssertionTypes(SmtEngine* smtEngine,
+                                  const vector<Command*>& commands,
+                                  size_t from, std::string& failure) {
+  smt::SmtScope scope(smtEngine);
+  if(!options::typeChecking()) {
+    return commands.size();
+  }
+  vector<Expr> assertions;
+  vector<size_t> indices;
+  for(size_t i = from; i < commands.size(); ++i) {
+    AssertCommand* c = dynamic_cast<AssertCommand*>(commands[i]);
+    if(c != NULL) {
+      assertions.push_back(c->getExpr());
+      indices.push_back(i);
+    }
+  }
+  if(assertions.size() > 1) {
+    try {
+      assertions[0].getExprManager()->checkTypes(assertions);
+    } catch(TypeCheckingException&) {
+      // the batch doesn't say which assertion is at fault
+      for(size_t i = 0; i < assertions.size(); ++i) {
+        try {
+          assertions[i].getType(true);
+        } catch(TypeCheckingException& e) {
+          failure = e.what();
+          return indices[i];
+        }
+      }
+    }
+  }
+  return commands.size();
+}
+
 void CommandSequence::invoke(SmtEngine* smtEngine) throw() {
+  std::string failure;
+  size_t illTyped = checkAssertionTypes(smtEngine, d_commandSequence, d_index, failure);
   for(; d_index < d_commandSequence.size(); ++d_index) {
+    if(d_index == illTyped) {
+      // abort execution, as the assertion would
+      d_commandStatus = new CommandFailure(failure);
+      return;
+    }
     d_commandSequence[d_index]->invoke(smtEngine);
     if(! d_commandSequence[d_index]->ok()) {
       // abort execution
@@ -500,7 +610,15 @@ void CommandSequence::invoke(SmtEngine* smtEngine) throw() {
 }
 
 void CommandSequence::invoke(SmtEngine* smtEngine, std::ostream& out) throw() {
+  std::string failure;
+  size_t illTyped = checkAssertionTypes(smtEngine, d_commandSequence, d_index, failure);
   for(; d_index < d_commandSequence.size(); ++d_index) {
+    if(d_index == illTyped) {
+      // abort execution, reporting the failure as the assertion would
+      d_commandStatus = new CommandFailure(failure);
+      printResult(out, smtEngine->getOption("command-verbosity:" + d_commandSequence[d_index]->getCommandName()).getIntegerValue().toUnsignedInt());
+      return;
+    }
     d_commandSequence[d_index]->invoke(smtEngine, out);
     if(! d_commandSequence[d_index]->ok()) {
       // abort execution
@@ -1217,6 +1335,10 @@ const UnsatCore& GetUnsatCoreCommand::getUnsatCore() const throw() {
   return d_result;
 }
 
+const std::map<Expr, std::string>& GetUnsatCoreCommand::getNames() const throw() {
+  return d_names;
+}
+
 Command* GetUnsatCoreCommand::exportTo(ExprManager* exprManager, ExprManagerMapCollection& variableMap) {
   GetUnsatCoreCommand* c = new GetUnsatCoreCommand(d_names);
   c->d_result = d_result;
@@ -1233,6 +1355,59 @@ std::string GetUnsatCoreCommand::getCommandName() const throw() {
   return "get-unsat-core";
 }
 
+/* class GetUnsatAssumptionsCommand */
+
+GetUnsatAssumptionsCommand::GetUnsatAssumptionsCommand() throw() {
+}
+
+void GetUnsatAssumptionsCommand::invoke(SmtEngine* smtEngine) throw() {
+  try {
+    d_result = smtEngine->getUnsatAssumptions();
+    d_commandStatus = CommandSuccess::instance();
+  } catch(exception& e) {
+    d_commandStatus = new CommandFailure(e.what());
+  }
+}
+
+const std::vector<Expr>& GetUnsatAssumptionsCommand::getResult() const throw() {
+  // of course, this will be empty if the command hasn't been invoked yet
+  return d_result;
+}
+
+void GetUnsatAssumptionsCommand::printResult(std::ostream& out, uint32_t verbosity) const throw() {
+  if(! ok()) {
+    this->Command::printResult(out, verbosity);
+  } else {
+    Expr::dag::Scope scope(out, false);
+    out << "(";
+    for(std::vector<Expr>::const_iterator i = d_result.begin(); i != d_result.end(); ++i) {
+      if(i != d_result.begin()) {
+        out << " ";
+      }
+      out << *i;
+    }
+    out << ")" << endl;
+  }
+}
+
+Command* GetUnsatAssumptionsCommand::exportTo(ExprManager* exprManager, ExprManagerMapCollection& variableMap) {
+  GetUnsatAssumptionsCommand* c = new GetUnsatAssumptionsCommand();
+  for(std::vector<Expr>::const_iterator i = d_result.begin(); i != d_result.end(); ++i) {
+    c->d_result.push_back((*i).exportTo(exprManager, variableMap));
+  }
+  return c;
+}
+
+Command* GetUnsatAssumptionsCommand::clone() const {
+  GetUnsatAssumptionsCommand* c = new GetUnsatAssumptionsCommand();
+  c->d_result = d_result;
+  return c;
+}
+
+std::string GetUnsatAssumptionsCommand::getCommandName() const throw() {
+  return "get-unsat-assumptions";
+}
+
 /* class GetAssertionsCommand */
 
 GetAssertionsCommand::GetAssertionsCommand() throw() {
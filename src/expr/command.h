@@ -327,6 +327,7 @@ public:
   AssertCommand(const Expr& e, bool inUnsatCore = true) throw();
   ~AssertCommand() throw() {}
   Expr getExpr() const throw();
+  bool inUnsatCore() const throw();
   void invoke(SmtEngine* smtEngine) throw();
   Command* exportTo(ExprManager* exprManager, ExprManagerMapCollection& variableMap);
   Command* clone() const;
@@ -476,6 +477,7 @@ public:
   CheckSatCommand(const Expr& expr, bool inUnsatCore = true) throw();
   ~CheckSatCommand() throw() {}
   Expr getExpr() const throw();
+  bool inUnsatCore() const throw();
   void invoke(SmtEngine* smtEngine) throw();
   Result getResult() const throw();
   void printResult(std::ostream& out, uint32_t verbosity = 2) const throw();
@@ -484,6 +486,22 @@ public:
   std::string getCommandName() const throw();
 };/* class CheckSatCommand */
 
+class CVC4_PUBLIC CheckSatAssumingCommand : public Command {
+protected:
+  std::vector<Expr> d_assumptions;
+  Result d_result;
+public:
+  CheckSatAssumingCommand(const std::vector<Expr>& assumptions) throw();
+  ~CheckSatAssumingCommand() throw() {}
+  const std::vector<Expr>& getAssumptions() const throw();
+  void invoke(SmtEngine* smtEngine) throw();
+  Result getResult() const throw();
+  void printResult(std::ostream& out, uint32_t verbosity = 2) const throw();
+  Command* exportTo(ExprManager* exprManager, ExprManagerMapCollection& variableMap);
+  Command* clone() const;
+  std::string getCommandName() const throw();
+};/* class CheckSatAssumingCommand */
+
 class CVC4_PUBLIC QueryCommand : public Command {
 protected:
   Expr d_expr;
@@ -493,6 +511,7 @@ public:
   QueryCommand(const Expr& e, bool inUnsatCore = true) throw();
   ~QueryCommand() throw() {}
   Expr getExpr() const throw();
+  bool inUnsatCore() const throw();
   void invoke(SmtEngine* smtEngine) throw();
   Result getResult() const throw();
   void printResult(std::ostream& out, uint32_t verbosity = 2) const throw();
@@ -621,11 +640,26 @@ public:
   void invoke(SmtEngine* smtEngine) throw();
   void printResult(std::ostream& out, uint32_t verbosity = 2) const throw();
   const UnsatCore& getUnsatCore() const throw();
+  const std::map<Expr, std::string>& getNames() const throw();
   Command* exportTo(ExprManager* exprManager, ExprManagerMapCollection& variableMap);
   Command* clone() const;
   std::string getCommandName() const throw();
 };/* class GetUnsatCoreCommand */
 
+class CVC4_PUBLIC GetUnsatAssumptionsCommand : public Command {
+protected:
+  std::vector<Expr> d_result;
+public:
+  GetUnsatAssumptionsCommand() throw();
+  ~GetUnsatAssumptionsCommand() throw() {}
+  void invoke(SmtEngine* smtEngine) throw();
+  const std::vector<Expr>& getResult() const throw();
+  void printResult(std::ostream& out, uint32_t verbosity = 2) const throw();
+  Command* exportTo(ExprManager* exprManager, ExprManagerMapCollection& variableMap);
+  Command* clone() const;
+  std::string getCommandName() const throw();
+};/* class GetUnsatAssumptionsCommand */
+
 class CVC4_PUBLIC GetAssertionsCommand : public Command {
 protected:
   std::string d_result;
@@ -852,6 +852,21 @@ Type ExprManager::getType(Expr e, bool check) throw (TypeCheckingException) {
   return t;
 }
 
+void ExprManager::checkTypes(const std::vector<Expr>& exprs)
+  throw(TypeCheckingException) {
+  NodeManagerScope nms(d_nodeManager);
+  std::vector<Node> nodes;
+  nodes.reserve(exprs.size());
+  for(std::vector<Expr>::const_iterator i = exprs.begin(); i != exprs.end(); ++i) {
+    nodes.push_back(i->getNode());
+  }
+  try {
+    d_nodeManager->checkTypes(nodes);
+  } catch (const TypeCheckingExceptionPrivate& e) {
+    throw TypeCheckingException(this, &e);
+  }
+}
+
 Expr ExprManager::mkVar(const std::string& name, Type type, uint32_t flags) {
   Assert(NodeManager::currentNM() == NULL, "ExprManager::mkVar() should only be called externally, not from within CVC4 code.  Please use mkSkolem().");
   NodeManagerScope nms(d_nodeManager);
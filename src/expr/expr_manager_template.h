@@ -468,6 +468,13 @@ public:
   Type getType(Expr e, bool check = false)
     throw(TypeCheckingException);
 
+  /**
+   * Type check a batch of expressions at once (for instance, a run of
+   * assertions), checking each shared subexpression only once.
+   */
+  void checkTypes(const std::vector<Expr>& exprs)
+    throw(TypeCheckingException);
+
   /** Bits for use in mkVar() flags. */
   enum {
     VAR_FLAG_NONE = 0,
@@ -862,38 +862,52 @@ void NodeBuilder<nchild_thresh>::decrRefCounts() {
 
 template <unsigned nchild_thresh>
 TypeNode NodeBuilder<nchild_thresh>::constructTypeNode() {
-  return TypeNode(constructNV());
+  expr::NodeValue* nv = constructNV();
+  TypeNode n(nv);
+  d_nm->unpin(nv);
+  return n;
 }
 
 template <unsigned nchild_thresh>
 TypeNode NodeBuilder<nchild_thresh>::constructTypeNode() const {
-  return TypeNode(constructNV());
+  expr::NodeValue* nv = constructNV();
+  TypeNode n(nv);
+  d_nm->unpin(nv);
+  return n;
 }
 
 template <unsigned nchild_thresh>
 Node NodeBuilder<nchild_thresh>::constructNode() {
-  Node n = Node(constructNV());
+  expr::NodeValue* nv = constructNV();
+  Node n(nv);
+  d_nm->unpin(nv);
   maybeCheckType(n);
   return n;
 }
 
 template <unsigned nchild_thresh>
 Node NodeBuilder<nchild_thresh>::constructNode() const {
-  Node n = Node(constructNV());
+  expr::NodeValue* nv = constructNV();
+  Node n(nv);
+  d_nm->unpin(nv);
   maybeCheckType(n);
   return n;
 }
 
 template <unsigned nchild_thresh>
 Node* NodeBuilder<nchild_thresh>::constructNodePtr() {
-  Node *np = new Node(constructNV());
+  expr::NodeValue* nv = constructNV();
+  Node *np = new Node(nv);
+  d_nm->unpin(nv);
   maybeCheckType(*np);
   return np;
 }
 
 template <unsigned nchild_thresh>
 Node* NodeBuilder<nchild_thresh>::constructNodePtr() const {
-  Node *np = new Node(constructNV());
+  expr::NodeValue* nv = constructNV();
+  Node *np = new Node(nv);
+  d_nm->unpin(nv);
   maybeCheckType(*np);
   return np;
 }
@@ -943,17 +957,13 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
             "no children permitted" );
 
     // we have to copy the inline NodeValue out
-    expr::NodeValue* nv = (expr::NodeValue*)
-      std::malloc(sizeof(expr::NodeValue));
-    if(nv == NULL) {
-      throw std::bad_alloc();
-    }
+    expr::NodeValue* nv = d_nm->d_nvAllocator.allocate(0);
     // there are no children, so we don't have to worry about
     // reference counts in this case.
     nv->d_nchildren = 0;
     nv->d_kind = d_nv->d_kind;
-    nv->d_id = d_nm->next_id++;// FIXME multithreading
-    nv->d_rc = 0;
+    nv->d_id = d_nm->newNodeId();
+    nv->d_rc = d_nm->initialRefCount();
     setUsed();
     if(Debug.isOn("gc")) {
       Debug("gc") << "creating node value " << nv
@@ -1031,16 +1041,12 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
        * reference count. */
 
       // create the canonical expression value for this node
-      expr::NodeValue* nv = (expr::NodeValue*)
-        std::malloc(sizeof(expr::NodeValue) +
-                    ( sizeof(expr::NodeValue*) * d_inlineNv.d_nchildren ));
-      if(nv == NULL) {
-        throw std::bad_alloc();
-      }
+      expr::NodeValue* nv =
+        d_nm->d_nvAllocator.allocate(d_inlineNv.d_nchildren);
       nv->d_nchildren = d_inlineNv.d_nchildren;
       nv->d_kind = d_inlineNv.d_kind;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
-      nv->d_rc = 0;
+      nv->d_id = d_nm->newNodeId();
+      nv->d_rc = d_nm->initialRefCount();
 
       std::copy(d_inlineNv.d_children,
                 d_inlineNv.d_children + d_inlineNv.d_nchildren,
@@ -1050,7 +1056,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
       setUsed();
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      nv = d_nm->poolInsert(nv);
       if(Debug.isOn("gc")) {
         Debug("gc") << "creating node value " << nv
                     << " [" << nv->d_id << "]: ";
@@ -1084,22 +1090,38 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() {
       /* Subcase (b) The Node under construction is NOT already in the
        * NodeManager's pool. */
 
-      /* 2(b). The heap-allocated d_nv is "cropped" to the correct
-       * size (based on the number of children it _actually_ has).
-       * d_nv is repointed to d_inlineNv so that destruction of the
-       * NodeBuilder doesn't cause any problems, and the (old) value
-       * it had is placed into the NodeManager's pool and returned in
-       * a Node wrapper. */
-
-      crop();
-      expr::NodeValue* nv = d_nv;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
+      /* 2(b). If the node is small enough for the NodeManager's
+       * slab allocator, its header and children are moved into a
+       * slab block and the heap-allocated d_nv is freed.  Otherwise
+       * the heap-allocated d_nv is "cropped" to the correct size
+       * (based on the number of children it _actually_ has).  Either
+       * way, d_nv is repointed to d_inlineNv so that destruction of
+       * the NodeBuilder doesn't cause any problems, and the resulting
+       * value is placed into the NodeManager's pool and returned in a
+       * Node wrapper. */
+
+      expr::NodeValue* nv;
+      if(d_nv->d_nchildren <= expr::NodeValueAllocator::MAX_SLAB_CHILDREN) {
+        nv = d_nm->d_nvAllocator.allocate(d_nv->d_nchildren);
+        nv->d_nchildren = d_nv->d_nchildren;
+        nv->d_kind = d_nv->d_kind;
+        std::copy(d_nv->d_children,
+                  d_nv->d_children + d_nv->d_nchildren,
+                  nv->d_children);
+        free(d_nv);
+      } else {
+        crop();
+        nv = d_nv;
+        d_nm->d_nvAllocator.adopt(nv);
+      }
+      nv->d_id = d_nm->newNodeId();
+      nv->d_rc = d_nm->initialRefCount();
       d_nv = &d_inlineNv;
       d_nvMaxChildren = nchild_thresh;
       setUsed();
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      nv = d_nm->poolInsert(nv);
       Debug("gc") << "creating node value " << nv
                   << " [" << nv->d_id << "]: " << *nv << "\n";
       return nv;
@@ -1133,17 +1155,13 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
             "no children permitted" );
 
     // we have to copy the inline NodeValue out
-    expr::NodeValue* nv = (expr::NodeValue*)
-      std::malloc(sizeof(expr::NodeValue));
-    if(nv == NULL) {
-      throw std::bad_alloc();
-    }
+    expr::NodeValue* nv = d_nm->d_nvAllocator.allocate(0);
     // there are no children, so we don't have to worry about
     // reference counts in this case.
     nv->d_nchildren = 0;
     nv->d_kind = d_nv->d_kind;
-    nv->d_id = d_nm->next_id++;// FIXME multithreading
-    nv->d_rc = 0;
+    nv->d_id = d_nm->newNodeId();
+    nv->d_rc = d_nm->initialRefCount();
     Debug("gc") << "creating node value " << nv
                 << " [" << nv->d_id << "]: " << *nv << "\n";
     return nv;
@@ -1210,16 +1228,12 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
        * count. */
 
       // create the canonical expression value for this node
-      expr::NodeValue* nv = (expr::NodeValue*)
-        std::malloc(sizeof(expr::NodeValue) +
-                    ( sizeof(expr::NodeValue*) * d_inlineNv.d_nchildren ));
-      if(nv == NULL) {
-        throw std::bad_alloc();
-      }
+      expr::NodeValue* nv =
+        d_nm->d_nvAllocator.allocate(d_inlineNv.d_nchildren);
       nv->d_nchildren = d_inlineNv.d_nchildren;
       nv->d_kind = d_inlineNv.d_kind;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
-      nv->d_rc = 0;
+      nv->d_id = d_nm->newNodeId();
+      nv->d_rc = d_nm->initialRefCount();
 
       std::copy(d_inlineNv.d_children,
                 d_inlineNv.d_children + d_inlineNv.d_nchildren,
@@ -1232,7 +1246,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
       }
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      nv = d_nm->poolInsert(nv);
       Debug("gc") << "creating node value " << nv
                   << " [" << nv->d_id << "]: " << *nv << "\n";
       return nv;
@@ -1264,16 +1278,12 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
        * decremented to match at NodeBuilder destruction time. */
 
       // create the canonical expression value for this node
-      expr::NodeValue* nv = (expr::NodeValue*)
-        std::malloc(sizeof(expr::NodeValue) +
-                    ( sizeof(expr::NodeValue*) * d_nv->d_nchildren ));
-      if(nv == NULL) {
-        throw std::bad_alloc();
-      }
+      expr::NodeValue* nv =
+        d_nm->d_nvAllocator.allocate(d_nv->d_nchildren);
       nv->d_nchildren = d_nv->d_nchildren;
       nv->d_kind = d_nv->d_kind;
-      nv->d_id = d_nm->next_id++;// FIXME multithreading
-      nv->d_rc = 0;
+      nv->d_id = d_nm->newNodeId();
+      nv->d_rc = d_nm->initialRefCount();
 
       std::copy(d_nv->d_children,
                 d_nv->d_children + d_nv->d_nchildren,
@@ -1286,7 +1296,7 @@ expr::NodeValue* NodeBuilder<nchild_thresh>::constructNV() const {
       }
 
       //poolNv = nv;
-      d_nm->poolInsert(nv);
+      nv = d_nm->poolInsert(nv);
       Debug("gc") << "creating node value " << nv
                   << " [" << nv->d_id << "]: " << *nv << "\n";
       return nv;
@@ -22,15 +22,16 @@
 #include "expr/attribute.h"
 #include "util/cvc4_assert.h"
 #include "options/options.h"
+#include "expr/options.h"
 #include "smt/options.h"
 #include "util/statistics_registry.h"
 #include "util/resource_manager.h"
 #include "util/tls.h"
+#include "util/node_visitor.h"
 
 #include "expr/type_checker.h"
 
 #include <algorithm>
-#include <stack>
 #include <utility>
 #include <ext/hash_set>
 
@@ -82,6 +83,37 @@ struct NVReclaim {
   }
 };
 
+/**
+ * Releases a spin lock (if any) on scope exit, e.g. on exceptional
+ * exit from NodeManager::reclaimZombies().
+ */
+struct SpinLockRelease {
+  PoolSpinLock* d_lock;
+
+  SpinLockRelease(PoolSpinLock* lock) :
+    d_lock(lock) {
+  }
+
+  ~SpinLockRelease() {
+    if(d_lock != NULL) {
+      d_lock->unlock();
+    }
+  }
+};
+
+/**
+ * Prints a NodeValue still in the pool at NodeManager destruction
+ * time (on the "gc:leaks" debug tag).
+ */
+struct PrintLeakedNodeValue {
+  void operator()(const NodeValue* nv) {
+    Debug("gc:leaks") << "  " << nv
+                      << " id=" << nv->getId()
+                      << " rc=" << nv->getRefCount()
+                      << " " << *nv << endl;
+  }
+};
+
 NodeManager::NodeManager(ExprManager* exprManager) :
   d_options(new Options()),
   d_statisticsRegistry(new StatisticsRegistry()),
@@ -91,6 +123,9 @@ NodeManager::NodeManager(ExprManager* exprManager) :
   d_exprManager(exprManager),
   d_nodeUnderDeletion(NULL),
   d_inReclaimZombies(false),
+  d_zombieThreshold(0),
+  d_zombieDeferrals(0),
+  d_markTablesInUse(0),
   d_abstractValueCount(0),
   d_skolemCounter(0) {
   init();
@@ -106,12 +141,19 @@ NodeManager::NodeManager(ExprManager* exprManager,
   d_exprManager(exprManager),
   d_nodeUnderDeletion(NULL),
   d_inReclaimZombies(false),
+  d_zombieThreshold(0),
+  d_zombieDeferrals(0),
+  d_markTablesInUse(0),
   d_abstractValueCount(0),
   d_skolemCounter(0) {
   init();
 }
 
 void NodeManager::init() {
+  setConcurrent((*d_options)[options::threadSafeNodeManager]);
+  d_nvAllocator.registerStatistics(d_statisticsRegistry);
+  d_gcStatistics.registerWith(d_statisticsRegistry);
+  d_zombieThreshold = (*d_options)[options::zombieThreshold];
   poolInsert( &expr::NodeValue::s_null );
 
   for(unsigned i = 0; i < unsigned(kind::LAST_KIND); ++i) {
@@ -145,6 +187,9 @@ NodeManager::~NodeManager() {
 
   NodeManagerScope nms(this);
 
+  // no other thread may be using us anymore
+  setConcurrent(false);
+
   {
     ScopedBool dontGC(d_inReclaimZombies);
     // hopefully by this point all SmtEngines have been deleted
@@ -158,6 +203,13 @@ NodeManager::~NodeManager() {
 
   d_tupleAndRecordTypes.clear();
 
+  Assert(d_markTablesInUse == 0);
+  for(std::vector<NodeMarkTable*>::iterator i = d_markTables.begin();
+      i != d_markTables.end();
+      ++i) {
+    delete *i;
+  }
+
   Assert(!d_attrManager->inGarbageCollection() );
   while(!d_zombies.empty()) {
     reclaimZombies();
@@ -167,18 +219,14 @@ NodeManager::~NodeManager() {
 
   if(Debug.isOn("gc:leaks")) {
     Debug("gc:leaks") << "still in pool:" << endl;
-    for(NodeValuePool::const_iterator i = d_nodeValuePool.begin(),
-          iend = d_nodeValuePool.end();
-        i != iend;
-        ++i) {
-      Debug("gc:leaks") << "  " << *i
-                        << " id=" << (*i)->d_id
-                        << " rc=" << (*i)->d_rc
-                        << " " << **i << endl;
-    }
+    PrintLeakedNodeValue printLeak;
+    d_nodeValuePool.forEach(printLeak);
     Debug("gc:leaks") << ":end:" << endl;
   }
 
+  d_gcStatistics.unregisterWith(d_statisticsRegistry);
+  d_nvAllocator.unregisterStatistics(d_statisticsRegistry);
+
   // defensive coding, in case destruction-order issues pop up (they often do)
   delete d_statisticsRegistry;
   d_statisticsRegistry = NULL;
@@ -190,11 +238,92 @@ NodeManager::~NodeManager() {
   d_options = NULL;
 }
 
-void NodeManager::reclaimZombies() {
-  // FIXME multithreading
+NodeManager::GCStatistics::GCStatistics() :
+  d_reclaimTime("expr::NodeManager::gc::reclaimTime"),
+  d_passes("expr::NodeManager::gc::passes", 0),
+  d_nodesFreed("expr::NodeManager::gc::nodesFreed", 0),
+  d_nodesFreedPerPass("expr::NodeManager::gc::nodesFreedPerPass"),
+  d_maxZombies("expr::NodeManager::gc::maxZombies", 0) {
+}
+
+void NodeManager::GCStatistics::registerWith(StatisticsRegistry* reg) {
+  reg->registerStat_(&d_reclaimTime);
+  reg->registerStat_(&d_passes);
+  reg->registerStat_(&d_nodesFreed);
+  reg->registerStat_(&d_nodesFreedPerPass);
+  reg->registerStat_(&d_maxZombies);
+}
+
+void NodeManager::GCStatistics::unregisterWith(StatisticsRegistry* reg) {
+  reg->unregisterStat_(&d_reclaimTime);
+  reg->unregisterStat_(&d_passes);
+  reg->unregisterStat_(&d_nodesFreed);
+  reg->unregisterStat_(&d_nodesFreedPerPass);
+  reg->unregisterStat_(&d_maxZombies);
+}
+
+void NodeManager::setConcurrent(bool concurrent) {
+  if(concurrent == d_nodeValuePool.isConcurrent()) {
+    return;
+  }
+  d_nodeValuePool.setConcurrent(concurrent);
+  d_nvAllocator.setConcurrent(concurrent);
+  if(concurrent) {
+    __sync_fetch_and_add(&expr::NodeValue::s_concurrentManagers, 1);
+  } else {
+    __sync_fetch_and_sub(&expr::NodeValue::s_concurrentManagers, 1);
+  }
+}
+
+void NodeManager::discardNodeValue(expr::NodeValue* nv) {
+  Debug("gc") << "discarding node value " << nv
+              << " [" << nv->d_id << "]: another thread pooled it first\n";
+  if(nv->getMetaKind() == kind::metakind::CONSTANT) {
+    kind::metakind::deleteNodeValueConstant(nv);
+    free(nv);
+  } else {
+    nv->decrRefCounts();
+    d_nvAllocator.deallocate(nv);
+  }
+}
+
+void NodeManager::maybeReclaimZombies() {
+  double ratio = (*d_options)[options::zombieRatio];
+  if(ratio > 0.0 && zombieCount() <= ratio * poolSize()) {
+    return;
+  }
+  reclaimZombies((*d_options)[options::zombieReclaimBudget]);
+}
+
+void NodeManager::deferZombieReclamation() {
+  if(d_zombieDeferrals++ == 0) {
+    d_zombieThreshold = (*d_options)[options::zombieDeferLimit];
+  }
+}
+
+void NodeManager::resumeZombieReclamation() {
+  Assert(d_zombieDeferrals > 0);
+  if(--d_zombieDeferrals == 0) {
+    d_zombieThreshold = (*d_options)[options::zombieThreshold];
+  }
+}
+
+void NodeManager::reclaimZombies(size_t budget) {
+  // In concurrent mode one thread reclaims at a time; another one
+  // finding zombies to reclaim leaves them to it.
+  bool concurrent = d_nodeValuePool.isConcurrent();
+  if(concurrent && !d_reclaimLock.tryLock()) {
+    return;
+  }
+  SpinLockRelease reclaimLock(concurrent ? &d_reclaimLock : NULL);
+
   Assert(!d_attrManager->inGarbageCollection());
 
-  Debug("gc") << "reclaiming " << d_zombies.size() << " zombie(s)!\n";
+  Debug("gc") << "reclaiming " << zombieCount() << " zombie(s)";
+  if(budget != 0) {
+    Debug("gc") << " (at most " << budget << ")";
+  }
+  Debug("gc") << "!\n";
 
   // during reclamation, reclaimZombies() is never supposed to be called
   Assert(! d_inReclaimZombies, "NodeManager::reclaimZombies() not re-entrant!");
@@ -216,13 +345,43 @@ void NodeManager::reclaimZombies() {
   // may be invisible to us (B is leaked) or even invalidate our
   // iterator, causing a crash.  So we need to copy the set away.
 
+  //
+  // In concurrent mode, other threads may be zombifying nodes while
+  // we copy; d_zombieLock makes the copy-and-clear atomic.
+  //
+  // With a budget, only part of the set is taken; the rest stays
+  // behind for the next pass.  Resurrected entries (nonzero RC) are
+  // dropped either way.
+
+  TimerStat::CodeTimer codeTimer(d_gcStatistics.d_reclaimTime);
+
   vector<NodeValue*> zombies;
-  zombies.reserve(d_zombies.size());
-  remove_copy_if(d_zombies.begin(),
-                 d_zombies.end(),
-                 back_inserter(zombies),
-                 NodeValueReferenceCountNonZero());
-  d_zombies.clear();
+  if(concurrent) {
+    d_zombieLock.lock();
+  }
+  d_gcStatistics.d_maxZombies.maxAssign(d_zombies.size());
+  if(budget == 0 || d_zombies.size() <= budget) {
+    zombies.reserve(d_zombies.size());
+    remove_copy_if(d_zombies.begin(),
+                   d_zombies.end(),
+                   back_inserter(zombies),
+                   NodeValueReferenceCountNonZero());
+    d_zombies.clear();
+  } else {
+    zombies.reserve(budget);
+    ZombieSet::iterator i = d_zombies.begin();
+    while(i != d_zombies.end() && zombies.size() < budget) {
+      if((*i)->d_rc == 0) {
+        zombies.push_back(*i);
+      }
+      d_zombies.erase(i++);
+    }
+  }
+  if(concurrent) {
+    d_zombieLock.unlock();
+  }
+
+  size_t freed = 0;
 
 #ifdef _LIBCPP_VERSION
   NodeValue* last = NULL;
@@ -241,7 +400,27 @@ void NodeManager::reclaimZombies() {
 #endif
 
     // collect ONLY IF still zero
-    if(nv->d_rc == 0) {
+    if(nv->isUnreferenced()) {
+      // remove from the pool; in concurrent mode, checking the count
+      // again under the pool's lock, as a lookup may have revived nv
+      kind::MetaKind mk = nv->getMetaKind();
+      if(mk != kind::metakind::VARIABLE) {
+        if(concurrent) {
+          if(!d_nodeValuePool.removeIfUnreferenced(nv)) {
+            continue;
+          }
+        } else {
+          poolRemove(nv);
+        }
+      }
+      if(concurrent) {
+        // nv may have been revived and zombified again since we
+        // took it from d_zombies; nobody can revive it anymore
+        d_zombieLock.lock();
+        d_zombies.erase(nv);
+        d_zombieLock.unlock();
+      }
+
       if(Debug.isOn("gc")) {
         Debug("gc") << "deleting node value " << nv
                     << " [" << nv->d_id << "]: ";
@@ -249,12 +428,6 @@ void NodeManager::reclaimZombies() {
         Debug("gc") << endl;
       }
 
-      // remove from the pool
-      kind::MetaKind mk = nv->getMetaKind();
-      if(mk != kind::metakind::VARIABLE) {
-        poolRemove(nv);
-      }
-
       // whether exit is normal or exceptional, the NVReclaim dtor is
       // called and ensures that d_nodeUnderDeletion is set back to
       // NULL.
@@ -274,7 +447,10 @@ void NodeManager::reclaimZombies() {
         Assert(nv->d_rc == 1);
       }
       nv->d_rc = 0;
-      d_attrManager->deleteAllAttributes(nv);
+      {
+        AttributeGuard g(this);
+        d_attrManager->deleteAllAttributes(nv);
+      }
 
       // decr ref counts of children
       nv->decrRefCounts();
@@ -287,10 +463,17 @@ void NodeManager::reclaimZombies() {
         // constant, but then, you should probably use a smart-pointer
         // type for a constant payload.)
         kind::metakind::deleteNodeValueConstant(nv);
+        free(nv);
+      } else {
+        d_nvAllocator.deallocate(nv);
       }
-      free(nv);
+      ++freed;
     }
   }
+
+  ++d_gcStatistics.d_passes;
+  d_gcStatistics.d_nodesFreed += freed;
+  d_gcStatistics.d_nodesFreedPerPass.addEntry(freed);
 }/* NodeManager::reclaimZombies() */
 
 TypeNode NodeManager::getType(TNode n, bool check)
@@ -312,36 +495,11 @@ TypeNode NodeManager::getType(TNode n, bool check)
   Debug("getType") << "getting type for " << n << endl;
 
   if(needsCheck && !(*d_options)[options::earlyTypeChecking]) {
-    /* Iterate and compute the children bottom up. This avoids stack
-       overflows in computeType() when the Node graph is really deep,
-       which should only affect us when we're type checking lazily. */
-    stack<TNode> worklist;
-    worklist.push(n);
-
-    while( !worklist.empty() ) {
-      TNode m = worklist.top();
-
-      bool readyToCompute = true;
-
-      for( TNode::iterator it = m.begin(), end = m.end();
-           it != end;
-           ++it ) {
-        if( !hasAttribute(*it, TypeAttr())
-            || (check && !getAttribute(*it, TypeCheckedAttr())) ) {
-          readyToCompute = false;
-          worklist.push(*it);
-        }
-      }
-
-      if( readyToCompute ) {
-        /* All the children have types, time to compute */
-        typeNode = TypeChecker::computeType(this, m, check);
-        worklist.pop();
-      }
-    } // end while
-
-    /* Last type computed in loop should be the type of n */
-    Assert( typeNode == getAttribute(n, TypeAttr()) );
+    /* Compute the children bottom up. This avoids stack overflows
+       in computeType() when the Node graph is really deep, which
+       should only affect us when we're type checking lazily. */
+    checkTypesBottomUp(&n, &n + 1);
+    typeNode = getAttribute(n, TypeAttr());
   } else if( !hasType || needsCheck ) {
     /* We can compute the type top-down, without worrying about
        deep recursion. */
@@ -357,13 +515,92 @@ TypeNode NodeManager::getType(TNode n, bool check)
   return typeNode;
 }
 
+void NodeManager::checkTypes(const std::vector<Node>& roots)
+  throw(TypeCheckingExceptionPrivate, AssertionException) {
+  NodeManagerScope nms(this);
+  checkTypesBottomUp(roots.begin(), roots.end());
+}
+
+namespace {
+
+/** Marks for checkTypesBottomUp() local to one call, as NodeMarks are not */
+class LocalNodeMarks {
+  hash_set<TNode, TNodeHashFunction> d_marked;
+public:
+  /** Mark n; returns false if it was already marked. */
+  bool mark(TNode n) {
+    return d_marked.insert(n).second;
+  }
+};/* class LocalNodeMarks */
+
+}/* anonymous namespace */
+
+template <class Iterator>
+void NodeManager::checkTypesBottomUp(Iterator begin, Iterator end)
+  throw(TypeCheckingExceptionPrivate, AssertionException) {
+  if(__builtin_expect( d_nodeValuePool.isConcurrent(), false )) {
+    // the NodeMarks tables are shared by all the threads
+    LocalNodeMarks expanded;
+    checkTypesBottomUp(begin, end, expanded);
+  } else {
+    NodeMarks expanded(this);
+    checkTypesBottomUp(begin, end, expanded);
+  }
+}
+
+template <class Iterator, class Marks>
+void NodeManager::checkTypesBottomUp(Iterator begin, Iterator end, Marks& expanded)
+  throw(TypeCheckingExceptionPrivate, AssertionException) {
+
+  /* An explicit stack of (node, children pushed?) pairs.  A node is
+     marked when its children are pushed, not when it is; a node
+     shared by two parents can thus be on the stack twice, but it is
+     expanded (and checked) only the first time it reaches the top,
+     and that is always before either parent is checked.  Subgraphs
+     checked by an earlier call are pruned. */
+  std::vector< std::pair<TNode, bool> > worklist;
+  unsigned checked = 0;
+
+  for(; begin != end; ++begin) {
+    TNode root = *begin;
+    if(getAttribute(root, TypeCheckedAttr())) {
+      continue;
+    }
+    worklist.push_back(std::make_pair(root, false));
+
+    while(!worklist.empty()) {
+      std::pair<TNode, bool>& top = worklist.back();
+      TNode m = top.first;
+      if(top.second) {
+        /* All the children have types, time to compute */
+        TypeChecker::computeType(this, m, true);
+        ++checked;
+        worklist.pop_back();
+      } else if(!expanded.mark(m)) {
+        /* a duplicate, already checked by the time it's on top */
+        Assert(getAttribute(m, TypeCheckedAttr()));
+        worklist.pop_back();
+      } else {
+        top.second = true;
+        for(TNode::iterator i = m.begin(), i_end = m.end(); i != i_end; ++i) {
+          if(!getAttribute(*i, TypeCheckedAttr())) {
+            worklist.push_back(std::make_pair(*i, false));
+          }
+        }
+      }
+    }
+  }
+
+  Debug("getType") << "checked types of " << checked << " nodes" << endl;
+}
+
 Node NodeManager::mkSkolem(const std::string& prefix, const TypeNode& type, const std::string& comment, int flags) {
   Node n = NodeBuilder<0>(this, kind::SKOLEM);
   setAttribute(n, TypeAttr(), type);
   setAttribute(n, TypeCheckedAttr(), true);
   if((flags & SKOLEM_EXACT_NAME) == 0) {
     stringstream name;
-    name << prefix << '_' << ++d_skolemCounter;
+    name << prefix << '_' << nextCount(d_skolemCounter);
     setAttribute(n, expr::VarNameAttr(), name.str());
   } else {
     setAttribute(n, expr::VarNameAttr(), prefix);
@@ -487,6 +724,7 @@ TypeNode NodeManager::getDatatypeForTupleRecord(TypeNode t) {
   }
 
   // if the type doesn't have an associated datatype, then make one for it
+  AttributeGuard g(this);
   TypeNode& dtt = d_tupleAndRecordTypes[t];
   if(dtt.isNull()) {
     if(t.isTuple()) {
@@ -525,7 +763,7 @@ void NodeManager::reclaimAllZombies(){
 /** Reclaim zombies while there are more than k nodes in the pool (if possible).*/
 void NodeManager::reclaimZombiesUntil(uint32_t k){
   if(safeToReclaimZombies()){
-    while(poolSize() >= k && !d_zombies.empty()){
+    while(poolSize() >= k && zombieCount() > 0){
       reclaimZombies();
     }
   }
@@ -680,7 +918,7 @@ Node NodeManager::mkInstConstant(const TypeNode& type) {
 }
 
 Node NodeManager::mkAbstractValue(const TypeNode& type) {
-  Node n = mkConst(AbstractValue(++d_abstractValueCount));
+  Node n = mkConst(AbstractValue(nextCount(d_abstractValueCount)));
   n.setAttribute(TypeAttr(), type);
   n.setAttribute(TypeCheckedAttr(), true);
   return n;
@@ -692,6 +930,7 @@ bool NodeManager::safeToReclaimZombies() const{
 }
 
 void NodeManager::deleteAttributes(const std::vector<const expr::attr::AttributeUniqueId*>& ids){
+  AttributeGuard g(this);
   d_attrManager->deleteAttributes(ids);
 }
 
@@ -35,7 +35,10 @@
 #include "expr/kind.h"
 #include "expr/metakind.h"
 #include "expr/node_value.h"
+#include "expr/node_value_pool.h"
+#include "expr/node_value_allocator.h"
 #include "util/subrange_bound.h"
+#include "util/statistics_registry.h"
 #include "util/tls.h"
 #include "options/options.h"
 
@@ -43,6 +46,8 @@ namespace CVC4 {
 
 class StatisticsRegistry;
 class ResourceManager;
+class NodeMarks;
+class NodeMarkTable;
 
 namespace expr {
   namespace attr {
@@ -78,6 +83,7 @@ class NodeManager {
   friend class NodeManagerScope;
   friend class expr::NodeValue;
   friend class expr::TypeChecker;
+  friend class NodeMarks;
 
   // friends so they can access mkVar() here, which is private
   friend Expr ExprManager::mkVar(const std::string&, Type, uint32_t flags);
@@ -91,9 +97,6 @@ class NodeManager {
     bool operator()(expr::NodeValue* nv) { return nv->d_rc > 0; }
   };
 
-  typedef __gnu_cxx::hash_set<expr::NodeValue*,
-                              expr::NodeValuePoolHashFunction,
-                              expr::NodeValuePoolEq> NodeValuePool;
   typedef __gnu_cxx::hash_set<expr::NodeValue*,
                               expr::NodeValueIDHashFunction,
                               expr::NodeValueEq> ZombieSet;
@@ -104,10 +107,54 @@ class NodeManager {
   StatisticsRegistry* d_statisticsRegistry;
   ResourceManager* d_resourceManager;
 
-  NodeValuePool d_nodeValuePool;
+  expr::NodeValuePool d_nodeValuePool;
+
+  /**
+   * Storage for all non-constant NodeValues created by this
+   * NodeManager (constants are still malloc()'ed, since their size
+   * depends on the payload type).
+   */
+  expr::NodeValueAllocator d_nvAllocator;
 
   size_t next_id;
 
+  /**
+   * Guards d_zombies when the NodeManager is in concurrent mode (see
+   * --thread-safe-node-manager).  Unused otherwise.
+   */
+  expr::PoolSpinLock d_zombieLock;
+
+  /**
+   * Held by the thread reclaiming zombies in concurrent mode; other
+   * threads leave their zombies to it rather than wait.
+   */
+  expr::PoolSpinLock d_reclaimLock;
+
+  /**
+   * Guards the attribute tables (and d_tupleAndRecordTypes) in
+   * concurrent mode.  It is recursive because setting an attribute
+   * can drop the last reference to a node, and reclaiming that node
+   * deletes its attributes.
+   */
+  mutable expr::RecursiveSpinLock d_attrLock;
+
+  /** RAII guard taking d_attrLock only in concurrent mode. */
+  class AttributeGuard {
+    expr::RecursiveSpinLock* d_lock;
+  public:
+    AttributeGuard(const NodeManager* nm) :
+      d_lock(nm->d_nodeValuePool.isConcurrent() ? &nm->d_attrLock : NULL) {
+      if(d_lock != NULL) {
+        d_lock->lock();
+      }
+    }
+    ~AttributeGuard() {
+      if(d_lock != NULL) {
+        d_lock->unlock();
+      }
+    }
+  };/* class NodeManager::AttributeGuard */
+
   expr::attr::AttributeManager* d_attrManager;
 
   /** The associated ExprManager */
@@ -141,6 +188,38 @@ class NodeManager {
    */
   ZombieSet d_zombies;
 
+  /**
+   * markForDeletion() considers a reclamation pass once d_zombies
+   * holds more than this many NodeValues: --gc-zombie-threshold
+   * normally, --gc-defer-limit while reclamation is deferred.
+   */
+  size_t d_zombieThreshold;
+
+  /** Nesting depth of deferZombieReclamation() calls */
+  unsigned d_zombieDeferrals;
+
+  struct GCStatistics {
+    TimerStat d_reclaimTime;
+    IntStat d_passes;
+    IntStat d_nodesFreed;
+    AverageStat d_nodesFreedPerPass;
+    IntStat d_maxZombies;
+    GCStatistics();
+    void registerWith(StatisticsRegistry* reg);
+    void unregisterWith(StatisticsRegistry* reg);
+  };/* struct NodeManager::GCStatistics */
+
+  GCStatistics d_gcStatistics;
+
+  /**
+   * Visited marks for DAG traversals, indexed by node id: one table
+   * per level of nesting of live NodeMarks (see util/node_visitor.h).
+   */
+  std::vector<NodeMarkTable*> d_markTables;
+
+  /** The number of d_markTables currently in use */
+  unsigned d_markTablesInUse;
+
   /**
    * A set of operator singletons (w.r.t.  to this NodeManager
    * instance) for operators.  Conceptually, Nodes with kind, say,
@@ -178,6 +257,14 @@ class NodeManager {
    */
   unsigned d_skolemCounter;
 
+  /** Increment one of the counters above (atomically if concurrent). */
+  inline unsigned nextCount(unsigned& counter) {
+    if(__builtin_expect( d_nodeValuePool.isConcurrent(), false )) {
+      return __sync_add_and_fetch(&counter, 1);
+    }
+    return ++counter;
+  }
+
   /**
    * Look up a NodeValue in the pool associated to this NodeManager.
    * The NodeValue argument need not be a "completely-constructed"
@@ -201,16 +288,54 @@ class NodeManager {
    * NULL, the caller should fully construct an equivalent one before
    * calling poolInsert().  NON-FULLY-CONSTRUCTED NODEVALUES are not
    * permitted in the pool!
+   *
+   * In concurrent mode the NodeValue returned is pinned: the caller
+   * must unpin() it once it holds a reference of its own.
    */
   inline expr::NodeValue* poolLookup(expr::NodeValue* nv) const;
 
   /**
-   * Insert a NodeValue into the NodeManager's pool.
+   * Insert a fully-constructed NodeValue into the NodeManager's pool,
+   * and return the pooled one.  That's nv, unless another thread
+   * inserted an equal NodeValue since our poolLookup(): then nv is
+   * discarded (see discardNodeValue()) and the other one returned.
    *
-   * It is an error to insert a NodeValue already in the pool.
-   * Enquire first with poolLookup().
+   * In concurrent mode the NodeValue returned is pinned, as with
+   * poolLookup().
+   */
+  inline expr::NodeValue* poolInsert(expr::NodeValue* nv);
+
+  /**
+   * Free a NodeValue that lost the race to the pool, releasing its
+   * children (or its constant payload).
+   */
+  void discardNodeValue(expr::NodeValue* nv);
+
+  /**
+   * Drop the extra reference poolLookup() and poolInsert() take in
+   * concurrent mode (a no-op otherwise).  The caller must hold a
+   * reference of its own by then.
+   */
+  inline void unpin(expr::NodeValue* nv) {
+    if(__builtin_expect( d_nodeValuePool.isConcurrent(), false )) {
+      nv->dec();
+    }
+  }
+
+  /**
+   * The reference count a NodeValue just built by this NodeManager
+   * starts with: 1 (its pin) in concurrent mode, 0 otherwise.
+   */
+  inline unsigned initialRefCount() const {
+    return d_nodeValuePool.isConcurrent() ? 1 : 0;
+  }
+
+  /**
+   * Turn concurrent mode on or off (see --thread-safe-node-manager).
+   * This must only be called while no other thread uses this
+   * NodeManager, and with no pinned NodeValue outstanding.
    */
-  inline void poolInsert(expr::NodeValue* nv);
+  void setConcurrent(bool concurrent);
 
   /**
    * Remove a NodeValue from the NodeManager's pool.
@@ -220,6 +345,17 @@ class NodeManager {
    */
   inline void poolRemove(expr::NodeValue* nv);
 
+  /**
+   * Allocate a fresh NodeValue id.  In concurrent mode this is an
+   * atomic increment, so that ids stay unique across threads.
+   */
+  inline size_t newNodeId() {
+    if(__builtin_expect( d_nodeValuePool.isConcurrent(), false )) {
+      return __sync_fetch_and_add(&next_id, 1);
+    }
+    return next_id++;
+  }
+
   /**
    * Determine if nv is currently being deleted by the NodeManager.
    */
@@ -232,7 +368,16 @@ class NodeManager {
    */
   inline void markForDeletion(expr::NodeValue* nv) {
     Assert(nv->d_rc == 0);
+    zombify(nv);
+    considerReclaimingZombies();
+  }
 
+  /**
+   * Add a NodeValue to the zombie set.  In concurrent mode this is
+   * called with nv's reference count locked (see
+   * NodeValue::decLocked()).
+   */
+  inline void zombify(expr::NodeValue* nv) {
     // if d_reclaiming is set, make sure we don't call
     // reclaimZombies(), because it's already running.
     if(Debug.isOn("gc")) {
@@ -242,19 +387,45 @@ class NodeManager {
       Debug("gc") << (d_inReclaimZombies ? " [CURRENTLY-RECLAIMING]" : "")
                   << std::endl;
     }
-    d_zombies.insert(nv);// FIXME multithreading
+    if(__builtin_expect( d_nodeValuePool.isConcurrent(), false )) {
+      d_zombieLock.lock();
+      d_zombies.insert(nv);
+      d_zombieLock.unlock();
+    } else {
+      d_zombies.insert(nv);
+    }
+  }
 
-    if(safeToReclaimZombies()) {
-      if(d_zombies.size() > 5000) {
-        reclaimZombies();
-      }
+  /** The number of zombies (a snapshot if concurrent). */
+  inline size_t zombieCount() {
+    if(__builtin_expect( d_nodeValuePool.isConcurrent(), false )) {
+      d_zombieLock.lock();
+      size_t n = d_zombies.size();
+      d_zombieLock.unlock();
+      return n;
     }
+    return d_zombies.size();
   }
 
+  /** Reclaim zombies if the GC policy says it's time. */
+  inline void considerReclaimingZombies() {
+    if(zombieCount() > d_zombieThreshold && safeToReclaimZombies()) {
+      maybeReclaimZombies();
+    }
+  }
+
+  /**
+   * Called when d_zombies has outgrown d_zombieThreshold; applies the
+   * rest of the GC policy (--gc-zombie-ratio, --gc-reclaim-budget).
+   */
+  void maybeReclaimZombies();
+
   /**
-   * Reclaim all zombies.
+   * Reclaim zombies: all of them if budget is 0, otherwise at most
+   * budget of them.  Zombies created by freeing these (their
+   * children, say) are left for a later pass.
    */
-  void reclaimZombies();
+  void reclaimZombies(size_t budget = 0);
 
   /**
    * It is safe to collect zombies.
@@ -297,6 +468,20 @@ class NodeManager {
 
   void init();
 
+  /**
+   * Type check the DAG under the roots [begin, end) bottom-up; the
+   * workhorse of checkTypes() and of lazy getType(n, true).  The
+   * nodes expanded are kept in NodeMarks, or in concurrent mode,
+   * where those aren't safe, in a set of the call's own.
+   */
+  template <class Iterator>
+  void checkTypesBottomUp(Iterator begin, Iterator end)
+    throw(TypeCheckingExceptionPrivate, AssertionException);
+
+  template <class Iterator, class Marks>
+  void checkTypesBottomUp(Iterator begin, Iterator end, Marks& expanded)
+    throw(TypeCheckingExceptionPrivate, AssertionException);
+
   /**
    * Create a variable with the given name and type.  NOTE that no
    * lookup is done on the name.  If you mkVar("a", type) and then
@@ -855,6 +1040,19 @@ public:
   TypeNode getType(TNode n, bool check = false)
     throw(TypeCheckingExceptionPrivate, AssertionException);
 
+  /**
+   * Type check a batch of nodes, e.g. a run of freshly-parsed
+   * assertions.  Types are computed bottom-up over the DAG of the
+   * whole batch, so each node not already checked is checked exactly
+   * once, children before parents, however many roots share it; and
+   * deep nodes don't overflow the stack.  On return (without
+   * exception) every root, and everything below it, is type checked.
+   *
+   * @param roots the nodes to type check
+   */
+  void checkTypes(const std::vector<Node>& roots)
+    throw(TypeCheckingExceptionPrivate, AssertionException);
+
   /**
    * Convert a node to an expression.  Uses the ExprManager
    * associated to this NodeManager.
@@ -892,6 +1090,16 @@ public:
   /** Reclaims all zombies (if possible).*/
   void reclaimAllZombies();
 
+  /**
+   * Hold off reclaiming zombies (until --gc-defer-limit of them are
+   * pending) until the matching resumeZombieReclamation().  Calls
+   * nest.  See ZombieReclamationDeferral.
+   */
+  void deferZombieReclamation();
+
+  /** Undo one deferZombieReclamation(). */
+  void resumeZombieReclamation();
+
   /** Size of the node pool. */
   size_t poolSize() const;
 
@@ -955,6 +1163,31 @@ public:
   }
 };/* class NodeManagerScope */
 
+/**
+ * Defers zombie reclamation in a NodeManager for the lifetime of this
+ * object, if so requested.  Used around the SAT search (see
+ * --gc-defer-during-search), where a reclamation pass would stall
+ * propagation.
+ */
+class ZombieReclamationDeferral {
+  NodeManager* d_nm;
+
+public:
+
+  ZombieReclamationDeferral(NodeManager* nm, bool defer = true) :
+    d_nm(defer ? nm : NULL) {
+    if(d_nm != NULL) {
+      d_nm->deferZombieReclamation();
+    }
+  }
+
+  ~ZombieReclamationDeferral() {
+    if(d_nm != NULL) {
+      d_nm->resumeZombieReclamation();
+    }
+  }
+};/* class ZombieReclamationDeferral */
+
 /** Get the (singleton) type for booleans. */
 inline TypeNode NodeManager::booleanType() {
   return TypeNode(mkTypeConst<TypeConstant>(BOOLEAN_TYPE));
@@ -1105,25 +1338,20 @@ inline TypeNode NodeManager::mkTesterType(TypeNode domain) {
 }
 
 inline expr::NodeValue* NodeManager::poolLookup(expr::NodeValue* nv) const {
-  NodeValuePool::const_iterator find = d_nodeValuePool.find(nv);
-  if(find == d_nodeValuePool.end()) {
-    return NULL;
-  } else {
-    return *find;
-  }
+  return d_nodeValuePool.lookup(nv);
 }
 
-inline void NodeManager::poolInsert(expr::NodeValue* nv) {
-  Assert(d_nodeValuePool.find(nv) == d_nodeValuePool.end(),
-         "NodeValue already in the pool!");
-  d_nodeValuePool.insert(nv);// FIXME multithreading
+inline expr::NodeValue* NodeManager::poolInsert(expr::NodeValue* nv) {
+  expr::NodeValue* pooled = d_nodeValuePool.insert(nv);
+  if(__builtin_expect( ( pooled != nv ), false )) {
+    Assert(d_nodeValuePool.isConcurrent(), "NodeValue already in the pool!");
+    discardNodeValue(nv);
+  }
+  return pooled;
 }
 
 inline void NodeManager::poolRemove(expr::NodeValue* nv) {
-  Assert(d_nodeValuePool.find(nv) != d_nodeValuePool.end(),
-         "NodeValue is not in the pool!");
-
-  d_nodeValuePool.erase(nv);// FIXME multithreading
+  d_nodeValuePool.remove(nv);
 }
 
 inline Expr NodeManager::toExpr(TNode n) {
@@ -1465,7 +1693,9 @@ NodeClass NodeManager::mkConstInternal(const T& val) {
 #endif
 
   if(nv != NULL) {
-    return NodeClass(nv);
+    NodeClass n(nv);
+    unpin(nv);
+    return n;
   }
 
   nv = (expr::NodeValue*)
@@ -1476,13 +1706,13 @@ NodeClass NodeManager::mkConstInternal(const T& val) {
 
   nv->d_nchildren = 0;
   nv->d_kind = kind::metakind::ConstantMap<T>::kind;
-  nv->d_id = next_id++;// FIXME multithreading
-  nv->d_rc = 0;
+  nv->d_id = newNodeId();
+  nv->d_rc = initialRefCount();
 
   //OwningTheory::mkConst(val);
   new (&nv->d_children) T(val);
 
-  poolInsert(nv);
+  nv = poolInsert(nv);
   if(Debug.isOn("gc")) {
     Debug("gc") << "creating node value " << nv
                 << " [" << nv->d_id << "]: ";
@@ -1490,7 +1720,9 @@ NodeClass NodeManager::mkConstInternal(const T& val) {
     Debug("gc") << std::endl;
   }
 
-  return NodeClass(nv);
+  NodeClass n(nv);
+  unpin(nv);
+  return n;
 }
 
 }/* CVC4 namespace */
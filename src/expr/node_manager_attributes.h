@@ -41,8 +41,9 @@ typedef Attribute<attr::SortArityTag, uint64_t> SortArityAttr;
 typedef expr::Attribute<expr::attr::DatatypeTupleTag, TypeNode> DatatypeTupleAttr;
 /** Attribute true for datatype types that are replacements for record types */
 typedef expr::Attribute<expr::attr::DatatypeRecordTag, TypeNode> DatatypeRecordAttr;
-typedef expr::Attribute<expr::attr::TypeTag, TypeNode> TypeAttr;
-typedef expr::Attribute<expr::attr::TypeCheckedTag, bool> TypeCheckedAttr;
+/* looked up on nearly every node, so kept dense */
+typedef expr::DenseAttribute<expr::attr::TypeTag, TypeNode> TypeAttr;
+typedef expr::DenseAttribute<expr::attr::TypeCheckedTag, bool> TypeCheckedAttr;
 
 }/* CVC4::expr namespace */
 }/* CVC4 namespace */
@@ -19,6 +19,7 @@
  **/
 
 #include "expr/node_value.h"
+#include "expr/node_value_pool.h"
 #include "expr/node.h"
 #include "expr/kind.h"
 #include "expr/metakind.h"
@@ -34,6 +35,61 @@ namespace expr {
 
 NodeValue NodeValue::s_null(0);
 
+unsigned NodeValue::s_concurrentManagers = 0;
+
+/**
+ * The locks guarding reference counts in concurrent mode, striped by
+ * NodeValue address.
+ */
+static const unsigned NUM_REFCOUNT_LOCKS = 64;
+static PoolSpinLock s_refCountLocks[NUM_REFCOUNT_LOCKS];
+
+static inline PoolSpinLock& refCountLock(const NodeValue* nv) {
+  return s_refCountLocks[(reinterpret_cast<uintptr_t>(nv) >> 4) & (NUM_REFCOUNT_LOCKS - 1)];
+}
+
+void NodeValue::incLocked() {
+  PoolSpinLock& lock = refCountLock(this);
+  lock.lock();
+  if(__builtin_expect( ( d_rc < MAX_RC ), true )) {
+    ++d_rc;
+  }
+  lock.unlock();
+}
+
+void NodeValue::decLocked() {
+  PoolSpinLock& lock = refCountLock(this);
+  bool zombie = false;
+  lock.lock();
+  if(__builtin_expect( ( d_rc < MAX_RC ), true )) {
+    --d_rc;
+    if(__builtin_expect( ( d_rc == 0 ), false )) {
+      Assert(NodeManager::currentNM() != NULL,
+             "No current NodeManager on destruction of NodeValue: "
+             "maybe a public CVC4 interface function is missing a NodeManagerScope ?");
+      // registered while the count is locked, so that whoever sees
+      // it at zero (see isUnreferenced()) also sees the zombie
+      NodeManager::currentNM()->zombify(this);
+      zombie = true;
+    }
+  }
+  lock.unlock();
+  if(zombie) {
+    NodeManager::currentNM()->considerReclaimingZombies();
+  }
+}
+
+bool NodeValue::isUnreferenced() {
+  if(__builtin_expect( ( s_concurrentManagers > 0 ), false )) {
+    PoolSpinLock& lock = refCountLock(this);
+    lock.lock();
+    bool unreferenced = d_rc == 0;
+    lock.unlock();
+    return unreferenced;
+  }
+  return d_rc == 0;
+}
+
 string NodeValue::toString() const {
   stringstream ss;
 
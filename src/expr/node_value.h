@@ -46,6 +46,7 @@ class NodeManager;
 
 namespace expr {
   class NodeValue;
+  class NodeValueAllocator;
 }
 
 namespace kind {
@@ -112,6 +113,8 @@ class NodeValue {
   friend class ::CVC4::TypeNode;
   template <unsigned nchild_thresh> friend class ::CVC4::NodeBuilder;
   friend class ::CVC4::NodeManager;
+  friend class NodeValueAllocator;
+  friend class NodeValuePool;
 
   template <Kind k, bool pool>
   friend struct ::CVC4::kind::metakind::NodeValueConstCompare;
@@ -121,9 +124,27 @@ class NodeValue {
 
   friend void ::CVC4::kind::metakind::deleteNodeValueConstant(NodeValue* nv);
 
+  /**
+   * The number of NodeManagers in concurrent mode (see
+   * --thread-safe-node-manager).  While there are any, reference
+   * counts are updated under locks.
+   */
+  static unsigned s_concurrentManagers;
+
   void inc();
   void dec();
 
+  /** inc() and dec() in concurrent mode */
+  void incLocked();
+  void decLocked();
+
+  /**
+   * Whether nothing references this NodeValue.  In concurrent mode
+   * the count is read under its lock, so a NodeValue dropping to
+   * zero has already been registered as a zombie when this is true.
+   */
+  bool isUnreferenced();
+
   /**
    * Uninitializing constructor for NodeBuilder's use.
    */
@@ -401,14 +422,20 @@ inline void NodeValue::inc() {
   Assert(!isBeingDeleted(),
          "NodeValue is currently being deleted "
          "and increment is being called on it. Don't Do That!");
-  // FIXME multithreading
+  if(__builtin_expect( ( s_concurrentManagers > 0 ), false )) {
+    incLocked();
+    return;
+  }
   if(__builtin_expect( ( d_rc < MAX_RC ), true )) {
     ++d_rc;
   }
 }
 
 inline void NodeValue::dec() {
-  // FIXME multithreading
+  if(__builtin_expect( ( s_concurrentManagers > 0 ), false )) {
+    decLocked();
+    return;
+  }
   if(__builtin_expect( ( d_rc < MAX_RC ), true )) {
     --d_rc;
     if(__builtin_expect( ( d_rc == 0 ), false )) {
@@ -0,0 +1,113 @@
+/*********************                                                        */
+/*! \file node_value_allocator.cpp
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A size-class slab allocator for NodeValues
+ **
+ ** A size-class slab allocator for NodeValues.
+ **/
+
+#include "expr/node_value_allocator.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace CVC4 {
+namespace expr {
+
+NodeValueAllocator::NodeValueAllocator() :
+  d_slabs(),
+  d_concurrent(false),
+  d_slabBytes(0),
+  d_largeLive(0),
+  d_statistics(*this) {
+
+  static const size_t maxChildren[NUM_CLASSES] = { 0, 1, 2, 3, MAX_SLAB_CHILDREN };
+  for(unsigned i = 0; i < NUM_CLASSES; ++i) {
+    SizeClass& c = d_classes[i];
+    c.d_blockSize = sizeof(NodeValue) + sizeof(NodeValue*) * maxChildren[i];
+    c.d_free = NULL;
+    c.d_bump = c.d_bumpEnd = NULL;
+    c.d_live = 0;
+    c.d_capacity = 0;
+  }
+}
+
+NodeValueAllocator::~NodeValueAllocator() {
+  for(vector<void*>::iterator i = d_slabs.begin(); i != d_slabs.end(); ++i) {
+    std::free(*i);
+  }
+}
+
+void* NodeValueAllocator::refill(SizeClass& c) {
+  char* slab = (char*) std::malloc(SLAB_BYTES);
+  if(slab == NULL) {
+    if(d_concurrent) {
+      c.d_lock.unlock();
+    }
+    throw std::bad_alloc();
+  }
+  if(d_concurrent) {
+    d_slabLock.lock();
+  }
+  d_slabs.push_back(slab);
+  d_slabBytes += SLAB_BYTES;
+  if(d_concurrent) {
+    d_slabLock.unlock();
+  }
+
+  // the tail of the slab that doesn't fit a whole block is wasted
+  c.d_bump = slab + c.d_blockSize;
+  c.d_bumpEnd = slab + (SLAB_BYTES / c.d_blockSize) * c.d_blockSize;
+  ++c.d_capacity;
+  return slab;
+}
+
+NodeValueAllocator::Statistics::Statistics(NodeValueAllocator& a) :
+  d_slabBytes("expr::NodeValueAllocator::slabBytes", a.d_slabBytes),
+  d_largeLive("expr::NodeValueAllocator::largeNodeValues", a.d_largeLive) {
+  static const char* const names[NUM_CLASSES] = { "0", "1", "2", "3", "4-8" };
+  for(unsigned i = 0; i < NUM_CLASSES; ++i) {
+    stringstream live, capacity;
+    live << "expr::NodeValueAllocator::liveBlocks[" << names[i] << "]";
+    capacity << "expr::NodeValueAllocator::slabBlocks[" << names[i] << "]";
+    d_live[i] = new ReferenceStat<uint64_t>(live.str(), a.d_classes[i].d_live);
+    d_capacity[i] = new ReferenceStat<uint64_t>(capacity.str(), a.d_classes[i].d_capacity);
+  }
+}
+
+NodeValueAllocator::Statistics::~Statistics() {
+  for(unsigned i = 0; i < NUM_CLASSES; ++i) {
+    delete d_live[i];
+    delete d_capacity[i];
+  }
+}
+
+void NodeValueAllocator::Statistics::registerWith(StatisticsRegistry* reg) {
+  reg->registerStat_(&d_slabBytes);
+  reg->registerStat_(&d_largeLive);
+  for(unsigned i = 0; i < NUM_CLASSES; ++i) {
+    reg->registerStat_(d_live[i]);
+    reg->registerStat_(d_capacity[i]);
+  }
+}
+
+void NodeValueAllocator::Statistics::unregisterWith(StatisticsRegistry* reg) {
+  reg->unregisterStat_(&d_slabBytes);
+  reg->unregisterStat_(&d_largeLive);
+  for(unsigned i = 0; i < NUM_CLASSES; ++i) {
+    reg->unregisterStat_(d_live[i]);
+    reg->unregisterStat_(d_capacity[i]);
+  }
+}
+
+}/* CVC4::expr namespace */
+}/* CVC4 namespace */
@@ -0,0 +1,225 @@
+/*********************                                                        */
+/*! \file node_value_allocator.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A size-class slab allocator for NodeValues
+ **
+ ** A size-class slab allocator for NodeValues.  Nearly all NodeValues
+ ** have a handful of children; rather than going through malloc() and
+ ** free() for each of them, the NodeManager carves them out of large
+ ** slabs, one set of slabs per size class, and recycles freed blocks
+ ** through a per-class free list.  The size classes are keyed on the
+ ** number of children: 0, 1, 2, 3, and 4 to 8.  NodeValues with more
+ ** children (and constants, whose payload size depends on the constant
+ ** type) are still allocated with malloc().
+ **/
+
+#include "cvc4_private.h"
+
+// circular dependency
+#include "expr/node_value.h"
+
+#ifndef __CVC4__EXPR__NODE_VALUE_ALLOCATOR_H
+#define __CVC4__EXPR__NODE_VALUE_ALLOCATOR_H
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "expr/node_value_pool.h"
+#include "util/statistics_registry.h"
+
+namespace CVC4 {
+namespace expr {
+
+class NodeValueAllocator {
+public:
+  /** The largest number of children served from the slabs. */
+  static const unsigned MAX_SLAB_CHILDREN = 8;
+
+  /** The number of size classes (0, 1, 2, 3, 4-8 children). */
+  static const unsigned NUM_CLASSES = 5;
+
+  /** The size of each slab, in bytes. */
+  static const size_t SLAB_BYTES = 64 * 1024;
+
+private:
+
+  /** A freed block, threaded onto its size class's free list. */
+  struct FreeBlock {
+    FreeBlock* d_next;
+  };/* struct NodeValueAllocator::FreeBlock */
+
+  struct SizeClass {
+    /** Size of every block in this class, in bytes */
+    size_t d_blockSize;
+    /** Recycled blocks */
+    FreeBlock* d_free;
+    /** Bump-allocation window in the newest slab */
+    char* d_bump;
+    char* d_bumpEnd;
+    /** Blocks currently handed out */
+    uint64_t d_live;
+    /** Blocks carved out of slabs so far (live or on the free list) */
+    uint64_t d_capacity;
+    /** Protects the above in concurrent mode */
+    PoolSpinLock d_lock;
+  };/* struct NodeValueAllocator::SizeClass */
+
+  SizeClass d_classes[NUM_CLASSES];
+
+  /** All slabs, so they can be released on destruction */
+  std::vector<void*> d_slabs;
+
+  /** Whether the locks are taken */
+  bool d_concurrent;
+
+  /** Bytes held in slabs */
+  uint64_t d_slabBytes;
+
+  /**
+   * Protects d_slabs and d_slabBytes, which all size classes share,
+   * in concurrent mode
+   */
+  PoolSpinLock d_slabLock;
+
+  /**
+   * NodeValues too large for the slabs that are currently live
+   * (always updated atomically, as no lock covers them)
+   */
+  uint64_t d_largeLive;
+
+  struct Statistics {
+    ReferenceStat<uint64_t> d_slabBytes;
+    ReferenceStat<uint64_t> d_largeLive;
+    ReferenceStat<uint64_t>* d_live[NUM_CLASSES];
+    ReferenceStat<uint64_t>* d_capacity[NUM_CLASSES];
+    Statistics(NodeValueAllocator& a);
+    ~Statistics();
+    void registerWith(StatisticsRegistry* reg);
+    void unregisterWith(StatisticsRegistry* reg);
+  };/* struct NodeValueAllocator::Statistics */
+
+  Statistics d_statistics;
+
+  static inline unsigned classOf(size_t nchildren) {
+    return nchildren < 4 ? unsigned(nchildren) : NUM_CLASSES - 1;
+  }
+
+  /** Carve a new slab for class c and bump-allocate one block from it. */
+  void* refill(SizeClass& c);
+
+  // disallow copy
+  NodeValueAllocator(const NodeValueAllocator&) CVC4_UNDEFINED;
+  NodeValueAllocator& operator=(const NodeValueAllocator&) CVC4_UNDEFINED;
+
+public:
+
+  NodeValueAllocator();
+  ~NodeValueAllocator();
+
+  /**
+   * Turn per-class locking on or off.  This must only be called
+   * while no other thread is allocating.
+   */
+  void setConcurrent(bool concurrent) { d_concurrent = concurrent; }
+
+  /** Register (or unregister) the occupancy statistics. */
+  void registerStatistics(StatisticsRegistry* reg) {
+    d_statistics.registerWith(reg);
+  }
+  void unregisterStatistics(StatisticsRegistry* reg) {
+    d_statistics.unregisterWith(reg);
+  }
+
+  /**
+   * Allocate (uninitialized) storage for a NodeValue with nchildren
+   * child slots.
+   *
+   * @throws bad_alloc if memory is exhausted
+   */
+  inline NodeValue* allocate(size_t nchildren);
+
+  /**
+   * Take ownership of a malloc()'ed NodeValue with more than
+   * MAX_SLAB_CHILDREN children (a cropped NodeBuilder buffer), so
+   * that it can later be released with deallocate().
+   */
+  inline void adopt(NodeValue* nv) {
+    Assert(nv->d_nchildren > MAX_SLAB_CHILDREN);
+    __sync_fetch_and_add(&d_largeLive, 1);
+  }
+
+  /**
+   * Release a NodeValue obtained from allocate() or adopt().  Its
+   * d_nchildren must still hold the value it was allocated with.
+   */
+  inline void deallocate(NodeValue* nv);
+
+};/* class NodeValueAllocator */
+
+inline NodeValue* NodeValueAllocator::allocate(size_t nchildren) {
+  if(__builtin_expect( ( nchildren > MAX_SLAB_CHILDREN ), false )) {
+    NodeValue* nv = (NodeValue*)
+      std::malloc(sizeof(NodeValue) + sizeof(NodeValue*) * nchildren);
+    if(nv == NULL) {
+      throw std::bad_alloc();
+    }
+    __sync_fetch_and_add(&d_largeLive, 1);
+    return nv;
+  }
+
+  SizeClass& c = d_classes[classOf(nchildren)];
+  if(__builtin_expect( d_concurrent, false )) {
+    c.d_lock.lock();
+  }
+  void* block;
+  if(c.d_free != NULL) {
+    block = c.d_free;
+    c.d_free = c.d_free->d_next;
+  } else if(c.d_bump != c.d_bumpEnd) {
+    block = c.d_bump;
+    c.d_bump += c.d_blockSize;
+    ++c.d_capacity;
+  } else {
+    block = refill(c);
+  }
+  ++c.d_live;
+  if(__builtin_expect( d_concurrent, false )) {
+    c.d_lock.unlock();
+  }
+  return static_cast<NodeValue*>(block);
+}
+
+inline void NodeValueAllocator::deallocate(NodeValue* nv) {
+  size_t nchildren = nv->d_nchildren;
+  if(__builtin_expect( ( nchildren > MAX_SLAB_CHILDREN ), false )) {
+    std::free(nv);
+    __sync_fetch_and_sub(&d_largeLive, 1);
+    return;
+  }
+
+  SizeClass& c = d_classes[classOf(nchildren)];
+  if(__builtin_expect( d_concurrent, false )) {
+    c.d_lock.lock();
+  }
+  FreeBlock* block = reinterpret_cast<FreeBlock*>(nv);
+  block->d_next = c.d_free;
+  c.d_free = block;
+  --c.d_live;
+  if(__builtin_expect( d_concurrent, false )) {
+    c.d_lock.unlock();
+  }
+}
+
+}/* CVC4::expr namespace */
+}/* CVC4 namespace */
+
+#endif /* __CVC4__EXPR__NODE_VALUE_ALLOCATOR_H */
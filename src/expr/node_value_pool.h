@@ -0,0 +1,504 @@
+/*********************                                                        */
+/*! \file node_value_pool.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief The hash-consing pool of NodeValues kept by the NodeManager
+ **
+ ** The hash-consing pool of NodeValues kept by the NodeManager.  The
+ ** pool is split into a fixed number of shards, selected by the pool
+ ** hash of the NodeValue, and each shard is guarded by its own lock.
+ ** Locking is only performed when the pool has been put into
+ ** concurrent mode (see NodeManager and --thread-safe-node-manager);
+ ** in the default single-threaded mode the pool behaves exactly as a
+ ** single hash set would.
+ **
+ ** Each shard is a flat, open-addressing (linear probing) table that
+ ** keeps the hash of each NodeValue next to the pointer, so that a
+ ** probe only dereferences a NodeValue when the full hashes match.
+ ** Tables grow incrementally: when a table gets too full a table of
+ ** twice the size is allocated and the entries of the old table are
+ ** moved over a few slots at a time on subsequent insertions and
+ ** removals, so no single mkNode() pays for rehashing a huge shard.
+ **/
+
+#include "cvc4_private.h"
+
+// circular dependency
+#include "expr/metakind.h"
+
+#ifndef __CVC4__EXPR__NODE_VALUE_POOL_H
+#define __CVC4__EXPR__NODE_VALUE_POOL_H
+
+#include <cstdlib>
+#include <new>
+#include <pthread.h>
+
+#include "expr/node_value.h"
+#include "util/cvc4_assert.h"
+
+namespace CVC4 {
+namespace expr {
+
+/**
+ * A minimal test-and-test-and-set spin lock.  The critical sections
+ * it protects in the NodeValue pool are a handful of instructions
+ * long, so spinning is cheaper than parking a thread.
+ */
+class PoolSpinLock {
+  volatile int d_locked;
+
+public:
+  PoolSpinLock() : d_locked(0) {}
+
+  void lock() {
+    while(__builtin_expect( __sync_lock_test_and_set(&d_locked, 1), false )) {
+      while(d_locked) {
+        // spin on a plain read to keep the cache line shared
+      }
+    }
+  }
+
+  /** Take the lock if it is free; returns whether it was taken. */
+  bool tryLock() {
+    return !__sync_lock_test_and_set(&d_locked, 1);
+  }
+
+  void unlock() {
+    __sync_lock_release(&d_locked);
+  }
+};/* class PoolSpinLock */
+
+/**
+ * A spin lock that the thread holding it may take again (it must
+ * then release it as many times).
+ */
+class RecursiveSpinLock {
+  PoolSpinLock d_lock;
+  volatile pthread_t d_owner;
+  volatile unsigned d_depth;
+
+public:
+  RecursiveSpinLock() : d_depth(0) {}
+
+  void lock() {
+    pthread_t self = pthread_self();
+    if(d_depth > 0) {
+      // d_owner is written before d_depth, so if it's us, it's
+      // really us
+      __sync_synchronize();
+      if(pthread_equal(d_owner, self)) {
+        ++d_depth;
+        return;
+      }
+    }
+    d_lock.lock();
+    d_owner = self;
+    __sync_synchronize();
+    d_depth = 1;
+  }
+
+  void unlock() {
+    Assert(d_depth > 0);
+    if(--d_depth == 0) {
+      d_lock.unlock();
+    }
+  }
+};/* class RecursiveSpinLock */
+
+/**
+ * An open-addressing hash set of NodeValue pointers, compared with
+ * NodeValuePoolEq.  This is one shard of the NodeValuePool.
+ */
+class NodeValueTable {
+public:
+  /** Initial number of slots; must be a power of two. */
+  static const size_t INITIAL_CAPACITY = 64;
+
+  /** Number of old-table slots migrated per mutating operation. */
+  static const size_t MIGRATE_STEP = 16;
+
+private:
+  struct Slot {
+    size_t d_hash;
+    NodeValue* d_nv;
+  };/* struct NodeValueTable::Slot */
+
+  /** Marks a slot of the old table that has been vacated. */
+  static inline NodeValue* tombstone() {
+    return reinterpret_cast<NodeValue*>(1);
+  }
+
+  /** The current table */
+  Slot* d_slots;
+  size_t d_mask;
+  size_t d_size;
+
+  /**
+   * The table being migrated into d_slots, or NULL.  Vacated slots
+   * here hold tombstone() so that probe sequences stay intact.
+   */
+  Slot* d_old;
+  size_t d_oldMask;
+  size_t d_oldSize;
+  size_t d_migrated;
+
+  /**
+   * Finalize the pool hash.  NodeValue::poolHash() has poor low bits
+   * for some kinds (constants especially), and we index with a mask.
+   */
+  static inline size_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static Slot* allocSlots(size_t n) {
+    Slot* s = static_cast<Slot*>(std::calloc(n, sizeof(Slot)));
+    if(s == NULL) {
+      throw std::bad_alloc();
+    }
+    return s;
+  }
+
+  /** Place nv (known absent) into the current table. */
+  inline void place(size_t h, NodeValue* nv) {
+    size_t i = h & d_mask;
+    while(d_slots[i].d_nv != NULL) {
+      i = (i + 1) & d_mask;
+    }
+    d_slots[i].d_hash = h;
+    d_slots[i].d_nv = nv;
+    ++d_size;
+  }
+
+  NodeValue* find(size_t h, const NodeValue* nv) const {
+    NodeValuePoolEq eq;
+    for(size_t i = h & d_mask; d_slots[i].d_nv != NULL; i = (i + 1) & d_mask) {
+      if(d_slots[i].d_hash == h && eq(d_slots[i].d_nv, nv)) {
+        return d_slots[i].d_nv;
+      }
+    }
+    if(__builtin_expect( ( d_old != NULL ), false )) {
+      for(size_t i = h & d_oldMask; d_old[i].d_nv != NULL; i = (i + 1) & d_oldMask) {
+        if(d_old[i].d_hash == h && d_old[i].d_nv != tombstone() &&
+           eq(d_old[i].d_nv, nv)) {
+          return d_old[i].d_nv;
+        }
+      }
+    }
+    return NULL;
+  }
+
+  /** Move up to n slots of the old table into the current one. */
+  void migrate(size_t n) {
+    size_t oldCapacity = d_oldMask + 1;
+    while(n-- > 0 && d_migrated < oldCapacity) {
+      Slot& s = d_old[d_migrated++];
+      if(s.d_nv != NULL && s.d_nv != tombstone()) {
+        place(s.d_hash, s.d_nv);
+        s.d_nv = tombstone();
+        --d_oldSize;
+      }
+    }
+    if(d_migrated == oldCapacity) {
+      Assert(d_oldSize == 0);
+      std::free(d_old);
+      d_old = NULL;
+    }
+  }
+
+  /** Start migrating to a table twice the size. */
+  void grow() {
+    if(d_old != NULL) {
+      migrate(d_oldMask + 1);
+    }
+    d_old = d_slots;
+    d_oldMask = d_mask;
+    d_oldSize = d_size;
+    d_migrated = 0;
+    d_mask = 2 * d_mask + 1;
+    d_slots = allocSlots(d_mask + 1);
+    d_size = 0;
+  }
+
+  /** Remove slot i of the current table, shifting its cluster back. */
+  void eraseAt(size_t i) {
+    size_t j = i;
+    for(;;) {
+      j = (j + 1) & d_mask;
+      if(d_slots[j].d_nv == NULL) {
+        break;
+      }
+      size_t home = d_slots[j].d_hash & d_mask;
+      // move slot j into the hole at i unless its home lies
+      // cyclically in (i, j]
+      if(( i <= j ) ? ( i < home && home <= j ) : ( i < home || home <= j )) {
+        continue;
+      }
+      d_slots[i] = d_slots[j];
+      i = j;
+    }
+    d_slots[i].d_nv = NULL;
+    --d_size;
+  }
+
+  // disallow copy
+  NodeValueTable(const NodeValueTable&) CVC4_UNDEFINED;
+  NodeValueTable& operator=(const NodeValueTable&) CVC4_UNDEFINED;
+
+public:
+
+  NodeValueTable() :
+    d_slots(allocSlots(INITIAL_CAPACITY)),
+    d_mask(INITIAL_CAPACITY - 1),
+    d_size(0),
+    d_old(NULL),
+    d_oldMask(0),
+    d_oldSize(0),
+    d_migrated(0) {
+  }
+
+  ~NodeValueTable() {
+    std::free(d_slots);
+    std::free(d_old);
+  }
+
+  /** The (mixed) hash under which nv is filed. */
+  static inline size_t hashOf(const NodeValue* nv) {
+    return mix(nv->poolHash());
+  }
+
+  size_t size() const { return d_size + d_oldSize; }
+
+  NodeValue* lookup(size_t h, const NodeValue* nv) const {
+    return find(h, nv);
+  }
+
+  /** Hint that nv (with hash h) is about to be looked up. */
+  void prefetch(size_t h) const {
+    __builtin_prefetch(&d_slots[h & d_mask]);
+  }
+
+  NodeValue* insert(size_t h, NodeValue* nv) {
+    NodeValue* existing = find(h, nv);
+    if(existing != NULL) {
+      return existing;
+    }
+    // keep the load factor under 5/8
+    if(__builtin_expect( ( 8 * (d_size + 1) > 5 * (d_mask + 1) ), false )) {
+      grow();
+    }
+    place(h, nv);
+    if(__builtin_expect( ( d_old != NULL ), false )) {
+      migrate(MIGRATE_STEP);
+    }
+    return nv;
+  }
+
+  /** Remove exactly the NodeValue nv; returns false if absent. */
+  bool remove(size_t h, NodeValue* nv) {
+    for(size_t i = h & d_mask; d_slots[i].d_nv != NULL; i = (i + 1) & d_mask) {
+      if(d_slots[i].d_nv == nv) {
+        eraseAt(i);
+        if(__builtin_expect( ( d_old != NULL ), false )) {
+          migrate(MIGRATE_STEP);
+        }
+        return true;
+      }
+    }
+    if(d_old != NULL) {
+      for(size_t i = h & d_oldMask; d_old[i].d_nv != NULL; i = (i + 1) & d_oldMask) {
+        if(d_old[i].d_nv == nv) {
+          d_old[i].d_nv = tombstone();
+          --d_oldSize;
+          migrate(MIGRATE_STEP);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  template <class F>
+  void forEach(F& f) const {
+    for(size_t i = 0; i <= d_mask; ++i) {
+      if(d_slots[i].d_nv != NULL) {
+        f(d_slots[i].d_nv);
+      }
+    }
+    if(d_old != NULL) {
+      for(size_t i = 0; i <= d_oldMask; ++i) {
+        if(d_old[i].d_nv != NULL && d_old[i].d_nv != tombstone()) {
+          f(d_old[i].d_nv);
+        }
+      }
+    }
+  }
+
+};/* class NodeValueTable */
+
+class NodeValuePool {
+public:
+  /** Number of shards; must be a power of two. */
+  static const unsigned NUM_SHARDS = 16;
+
+private:
+  NodeValueTable d_shards[NUM_SHARDS];
+  mutable PoolSpinLock d_locks[NUM_SHARDS];
+
+  /** Whether the shard locks are taken on access. */
+  bool d_concurrent;
+
+  /**
+   * Select the shard for a (mixed) hash.  The low bits pick the slot
+   * inside the shard, so we use the high bits here.
+   */
+  static inline unsigned shardOf(size_t h) {
+    return unsigned(h >> (8 * sizeof(size_t) - 4)) & (NUM_SHARDS - 1);
+  }
+
+  /** RAII guard that locks a shard only in concurrent mode. */
+  class ShardGuard {
+    PoolSpinLock* d_lock;
+  public:
+    ShardGuard(const NodeValuePool& pool, unsigned shard) :
+      d_lock(pool.d_concurrent ? &pool.d_locks[shard] : NULL) {
+      if(d_lock != NULL) {
+        d_lock->lock();
+      }
+    }
+    ~ShardGuard() {
+      if(d_lock != NULL) {
+        d_lock->unlock();
+      }
+    }
+  };/* class NodeValuePool::ShardGuard */
+
+  // disallow copy
+  NodeValuePool(const NodeValuePool&) CVC4_UNDEFINED;
+  NodeValuePool& operator=(const NodeValuePool&) CVC4_UNDEFINED;
+
+public:
+
+  NodeValuePool() : d_concurrent(false) {}
+
+  /**
+   * Turn shard locking on or off.  This must only be called while no
+   * other thread is accessing the pool.
+   */
+  void setConcurrent(bool concurrent) { d_concurrent = concurrent; }
+  bool isConcurrent() const { return d_concurrent; }
+
+  /**
+   * Find the pooled NodeValue equal to nv, or NULL if there is none.
+   * See NodeManager::poolLookup() for what "equal" means for
+   * incompletely-constructed constants.
+   *
+   * In concurrent mode, the NodeValue found is returned with an
+   * extra reference (taken under the shard lock, so a zombie can't
+   * be reclaimed between the lookup and the caller's use of it);
+   * the caller must drop it.
+   */
+  NodeValue* lookup(NodeValue* nv) const {
+    size_t h = NodeValueTable::hashOf(nv);
+    unsigned s = shardOf(h);
+    ShardGuard g(*this, s);
+    NodeValue* found = d_shards[s].lookup(h, nv);
+    if(__builtin_expect( ( d_concurrent && found != NULL ), false )) {
+      found->inc();
+    }
+    return found;
+  }
+
+  /**
+   * Hint that nv will be looked up soon, so that the cache line of
+   * its home slot can be fetched while the caller builds other
+   * NodeValues.  nv's children must already be in place.
+   */
+  void prefetch(const NodeValue* nv) const {
+    size_t h = NodeValueTable::hashOf(nv);
+    d_shards[shardOf(h)].prefetch(h);
+  }
+
+  /**
+   * Insert nv into the pool unless an equal NodeValue is already
+   * present.  Returns the pooled NodeValue: nv itself if it was
+   * inserted, or the existing one if another thread won the race.
+   * In the latter case, in concurrent mode, the existing one is
+   * returned with an extra reference, as with lookup().
+   */
+  NodeValue* insert(NodeValue* nv) {
+    size_t h = NodeValueTable::hashOf(nv);
+    unsigned s = shardOf(h);
+    ShardGuard g(*this, s);
+    NodeValue* pooled = d_shards[s].insert(h, nv);
+    if(__builtin_expect( ( d_concurrent && pooled != nv ), false )) {
+      pooled->inc();
+    }
+    return pooled;
+  }
+
+  /** Remove nv from the pool; it must be present. */
+  void remove(NodeValue* nv) {
+    size_t h = NodeValueTable::hashOf(nv);
+    unsigned s = shardOf(h);
+    ShardGuard g(*this, s);
+    CVC4_UNUSED bool removed = d_shards[s].remove(h, nv);
+    Assert(removed, "NodeValue is not in the pool!");
+  }
+
+  /**
+   * Remove nv from the pool, which it must be in, unless something
+   * references it.  Returns whether it was removed.  In concurrent
+   * mode this is atomic with respect to lookup() and insert(), so
+   * once it returns true no thread can get hold of nv anymore.
+   */
+  bool removeIfUnreferenced(NodeValue* nv) {
+    size_t h = NodeValueTable::hashOf(nv);
+    unsigned s = shardOf(h);
+    ShardGuard g(*this, s);
+    if(!nv->isUnreferenced()) {
+      return false;
+    }
+    CVC4_UNUSED bool removed = d_shards[s].remove(h, nv);
+    Assert(removed, "NodeValue is not in the pool!");
+    return true;
+  }
+
+  /** The number of NodeValues in the pool (a snapshot if concurrent). */
+  size_t size() const {
+    size_t n = 0;
+    for(unsigned s = 0; s < NUM_SHARDS; ++s) {
+      ShardGuard g(*this, s);
+      n += d_shards[s].size();
+    }
+    return n;
+  }
+
+  /**
+   * Apply f to every pooled NodeValue.  Not synchronized; intended
+   * for debugging output at NodeManager destruction.
+   */
+  template <class F>
+  void forEach(F& f) const {
+    for(unsigned s = 0; s < NUM_SHARDS; ++s) {
+      d_shards[s].forEach(f);
+    }
+  }
+
+};/* class NodeValuePool */
+
+}/* CVC4::expr namespace */
+}/* CVC4 namespace */
+
+#endif /* __CVC4__EXPR__NODE_VALUE_POOL_H */
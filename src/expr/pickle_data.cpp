@@ -38,11 +38,9 @@ namespace expr {
 namespace pickle {
 
 void PickleData::writeToStringStream(std::ostringstream& oss) const {
-  BlockDeque::const_iterator i = d_blocks.begin(), end = d_blocks.end();
+  std::vector<uint8_t>::const_iterator i = d_bytes.begin(), end = d_bytes.end();
   for(; i != end; ++i) {
-    Block b = *i;
-    Assert(sizeof(b) * 8 == NBITS_BLOCK);
-    oss << b.d_body.d_data << " ";
+    oss << unsigned(*i) << " ";
   }
 }
 
@@ -24,9 +24,8 @@
 #define __CVC4__PICKLE_DATA_H
 
 #include <sstream>
-#include <deque>
-#include <stack>
-#include <exception>
+#include <string>
+#include <vector>
 
 #include "expr/expr.h"
 #include "expr/node.h"
@@ -35,6 +34,7 @@
 #include "expr/variable_type_map.h"
 #include "expr/kind.h"
 #include "expr/metakind.h"
+#include "util/cvc4_assert.h"
 
 namespace CVC4 {
 
@@ -43,75 +43,112 @@ class NodeManager;
 namespace expr {
 namespace pickle {
 
-const unsigned NBITS_BLOCK = 64;
-const unsigned NBITS_KIND = __CVC4__EXPR__NODE_VALUE__NBITS__KIND;
-const unsigned NBITS_NCHILDREN = __CVC4__EXPR__NODE_VALUE__NBITS__NCHILDREN;
-const unsigned NBITS_CONSTBLOCKS = 32;
+/**
+ * The pickle encoding version, written as the first byte of every
+ * non-empty pickle.
+ *
+ * Version 2 is a byte stream of unsigned LEB128 varints.  After the
+ * version byte comes the root's DAG in postorder (a node's operator
+ * and children before the node); each entry starts with a varint h:
+ *
+ *   h odd  - a back-reference to the (h >> 1)th node defined so far
+ *   h even - a new node of kind h >> 1, followed by
+ *              VARIABLE:  the variable's mapped id
+ *              CONSTANT:  a kind-specific payload (see Pickler)
+ *              otherwise: the number of children (not counting a
+ *                         parameterized kind's operator)
+ *
+ * Every new node is numbered as it is defined, so subterms shared in
+ * the DAG are encoded once.  (Version 1 was a deque of 64-bit blocks
+ * and encoded the expression as a tree.)
+ */
+const uint8_t PICKLE_VERSION = 2;
 
-struct BlockHeader {
-  uint64_t d_kind          : NBITS_KIND;
-};/* struct BlockHeader */
+class PickleData {
+  std::vector<uint8_t> d_bytes;
 
-struct BlockHeaderOperator {
-  uint64_t d_kind          : NBITS_KIND;
-  uint64_t d_nchildren     : NBITS_NCHILDREN;
-  uint64_t                 : NBITS_BLOCK - (NBITS_KIND + NBITS_NCHILDREN);
-};/* struct BlockHeaderOperator */
+public:
+  std::string toString() const;
 
-struct BlockHeaderConstant {
-  uint64_t d_kind          : NBITS_KIND;
-  uint64_t d_constblocks   : NBITS_BLOCK - NBITS_KIND;
-};/* struct BlockHeaderConstant */
+  /** Append x as an unsigned LEB128 varint. */
+  void writeVarint(uint64_t x) {
+    while(x >= 0x80) {
+      d_bytes.push_back(uint8_t(x) | 0x80);
+      x >>= 7;
+    }
+    d_bytes.push_back(uint8_t(x));
+  }
 
-struct BlockHeaderVariable {
-  uint64_t d_kind          : NBITS_KIND;
-  uint64_t                 : NBITS_BLOCK - NBITS_KIND;
-};/* struct BlockHeaderVariable */
+  void writeByte(uint8_t b) {
+    d_bytes.push_back(b);
+  }
 
-struct BlockBody  {
-  uint64_t d_data          : NBITS_BLOCK;
-};/* struct BlockBody */
+  /** Append s, preceded by its length. */
+  void writeString(const std::string& s) {
+    writeVarint(s.size());
+    d_bytes.insert(d_bytes.end(), s.begin(), s.end());
+  }
 
-union Block {
-  BlockHeader d_header;
-  BlockHeaderConstant d_headerConstant;
-  BlockHeaderOperator d_headerOperator;
-  BlockHeaderVariable d_headerVariable;
+  const uint8_t* begin() const { return d_bytes.empty() ? NULL : &d_bytes[0]; }
+  const uint8_t* end() const { return begin() + d_bytes.size(); }
 
-  BlockBody d_body;
-};/* union Block */
+  bool empty() const { return d_bytes.empty(); }
+  /** the encoded size, in bytes */
+  uint32_t size() const { return d_bytes.size(); }
 
-class PickleData {
-  typedef std::deque<Block> BlockDeque;
-  BlockDeque d_blocks;
+  void clear() {
+    d_bytes.clear();
+  }
 
-public:
-  PickleData& operator<<(Block b) {
-    enqueue(b);
-    return (*this);
+  void swap(PickleData& other){
+    d_bytes.swap(other.d_bytes);
   }
 
-  std::string toString() const;
+  void writeToStringStream(std::ostringstream& oss) const;
+};/* class PickleData */
 
-  void enqueue(Block b) {
-    d_blocks.push_back(b);
-  }
+/**
+ * Reads a PickleData in place.  Running off the end is an internal
+ * error; a pickle is only ever decoded by the CVC4 that produced it.
+ */
+class PickleReader {
+  const uint8_t* d_pos;
+  const uint8_t* d_end;
 
-  Block dequeue() {
-    Block b = d_blocks.front();
-    d_blocks.pop_front();
-    return b;
+public:
+  PickleReader(const PickleData& data) :
+    d_pos(data.begin()),
+    d_end(data.end()) {
   }
 
-  bool empty() const { return d_blocks.empty(); }
-  uint32_t size() const { return d_blocks.size(); }
+  bool done() const { return d_pos == d_end; }
 
-  void swap(PickleData& other){
-    d_blocks.swap(other.d_blocks);
+  uint8_t readByte() {
+    Assert(d_pos != d_end);
+    return *d_pos++;
   }
 
-  void writeToStringStream(std::ostringstream& oss) const;
-};/* class PickleData */
+  uint64_t readVarint() {
+    uint64_t x = 0;
+    unsigned shift = 0;
+    uint8_t b;
+    do {
+      Assert(d_pos != d_end && shift < 64);
+      b = *d_pos++;
+      x |= uint64_t(b & 0x7f) << shift;
+      shift += 7;
+    } while(b & 0x80);
+    return x;
+  }
+
+  std::string readString() {
+    uint64_t len = readVarint();
+    Assert(uint64_t(d_end - d_pos) >= len);
+    const char* s = reinterpret_cast<const char*>(d_pos);
+    d_pos += len;
+    return std::string(s, len);
+  }
+};/* class PickleReader */
 
 }/* CVC4::expr::pickle namespace */
 }/* CVC4::expr namespace */
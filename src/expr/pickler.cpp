@@ -19,6 +19,8 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <ext/hash_map>
 
 #include "expr/pickler.h"
 #include "expr/pickle_data.h"
@@ -39,8 +41,14 @@ namespace pickle {
 
 class PicklerPrivate {
 public:
-  typedef std::stack<Node> NodeStack;
-  NodeStack d_stack;
+  /** indices of the nodes written so far to the current pickle */
+  typedef __gnu_cxx::hash_map<TNode, uint64_t, TNodeHashFunction> IndexMap;
+  IndexMap d_indices;
+
+  /** nodes read so far from the current pickle, by index */
+  std::vector<Node> d_defined;
+  /** operands of the nodes yet to be read */
+  std::vector<Node> d_stack;
 
   PickleData d_current;
 
@@ -54,70 +62,30 @@ public:
   }
 
   bool atDefaultState(){
-    return d_stack.empty() && d_current.empty();
+    return d_indices.empty() && d_defined.empty() && d_stack.empty() &&
+      d_current.empty();
+  }
+
+  void reset() {
+    d_indices.clear();
+    d_defined.clear();
+    d_stack.clear();
+    d_current.clear();
   }
 
   /* Helper functions for toPickle */
   void toCaseNode(TNode n) throw(AssertionException, PicklingException);
   void toCaseVariable(TNode n) throw(AssertionException, PicklingException);
-  void toCaseConstant(TNode n);
+  void toCaseConstant(TNode n) throw(PicklingException);
   void toCaseOperator(TNode n) throw(AssertionException, PicklingException);
-  void toCaseString(Kind k, const std::string& s);
 
-  /* Helper functions for toPickle */
+  /* Helper functions for fromPickle */
   Node fromCaseOperator(Kind k, uint32_t nchildren);
-  Node fromCaseConstant(Kind k, uint32_t nblocks);
-  std::string fromCaseString(uint32_t nblocks);
-  Node fromCaseVariable(Kind k);
+  Node fromCaseConstant(Kind k, PickleReader& r);
+  Node fromCaseVariable(Kind k, PickleReader& r);
 
 };/* class PicklerPrivate */
 
-static Block mkBlockBody4Chars(char a, char b, char c, char d) {
-  Block newBody;
-  newBody.d_body.d_data = (a << 24) | (b << 16) | (c << 8) | d;
-  return newBody;
-}
-
-static char getCharBlockBody(BlockBody body, int i) {
-  Assert(0 <= i && i <= 3);
-
-  switch(i) {
-  case 0: return (body.d_data & 0xff000000) >> 24;
-  case 1: return (body.d_data & 0x00ff0000) >> 16;
-  case 2: return (body.d_data & 0x0000ff00) >> 8;
-  case 3: return (body.d_data & 0x000000ff);
-  default:
-    Unreachable();
-  }
-  return '\0';
-}
-
-static Block mkBlockBody(unsigned data) {
-  Block newBody;
-  newBody.d_body.d_data = data;
-  return newBody;
-}
-
-static Block mkOperatorHeader(Kind k, unsigned numChildren) {
-  Block newHeader;
-  newHeader.d_headerOperator.d_kind = k;
-  newHeader.d_headerOperator.d_nchildren = numChildren;
-  return newHeader;
-}
-
-static Block mkVariableHeader(Kind k) {
-  Block newHeader;
-  newHeader.d_header.d_kind = k;
-  return newHeader;
-}
-
-static Block mkConstantHeader(Kind k, unsigned numBlocks) {
-  Block newHeader;
-  newHeader.d_headerConstant.d_kind = k;
-  newHeader.d_headerConstant.d_constblocks = numBlocks;
-  return newHeader;
-}
-
 Pickler::Pickler(ExprManager* em) :
   d_private(new PicklerPrivate(*this, em)) {
 }
@@ -132,11 +100,12 @@ void Pickler::toPickle(Expr e, Pickle& p)
   Assert(d_private->atDefaultState());
 
   try{
-    d_private->d_current.swap(*p.d_data);
+    d_private->d_current.writeByte(PICKLE_VERSION);
     d_private->toCaseNode(e.getTNode());
     d_private->d_current.swap(*p.d_data);
+    d_private->reset();
   }catch(PicklingException& pe){
-    d_private->d_current = PickleData();
+    d_private->reset();
     Assert(d_private->atDefaultState());
     throw pe;
   }
@@ -144,121 +113,109 @@ void Pickler::toPickle(Expr e, Pickle& p)
   Assert(d_private->atDefaultState());
 }
 
-void PicklerPrivate::toCaseNode(TNode n)
+void PicklerPrivate::toCaseNode(TNode root)
   throw(AssertionException, PicklingException) {
-  Debug("pickler") << "toCaseNode: " << n << std::endl;
-  Kind k = n.getKind();
-  kind::MetaKind m = metaKindOf(k);
-  switch(m) {
-  case kind::metakind::CONSTANT:
-    toCaseConstant(n);
-    break;
-  case kind::metakind::VARIABLE:
-    toCaseVariable(n);
-    break;
-  case kind::metakind::OPERATOR:
-  case kind::metakind::PARAMETERIZED:
-    toCaseOperator(n);
-    break;
-  default:
-    Unhandled(m);
+  Debug("pickler") << "toCaseNode: " << root << std::endl;
+
+  // Postorder, with an explicit stack (lemmas can be deep).  The
+  // flag records whether a node's operands have been pushed already.
+  std::vector< std::pair<TNode, bool> > work;
+  work.push_back(std::make_pair(root, false));
+  while(!work.empty()) {
+    TNode n = work.back().first;
+
+    IndexMap::const_iterator i = d_indices.find(n);
+    if(i != d_indices.end()) {
+      // already written; refer back to it
+      d_current.writeVarint((i->second << 1) | 1);
+      work.pop_back();
+      continue;
+    }
+
+    Kind k = n.getKind();
+    kind::MetaKind m = metaKindOf(k);
+    if(!work.back().second &&
+       (m == kind::metakind::OPERATOR || m == kind::metakind::PARAMETERIZED)) {
+      work.back().second = true;
+      for(unsigned j = n.getNumChildren(); j > 0; --j) {
+        work.push_back(std::make_pair(n[j - 1], false));
+      }
+      if(m == kind::metakind::PARAMETERIZED) {
+        work.push_back(std::make_pair(TNode(n.getOperator()), false));
+      }
+      continue;
+    }
+
+    work.pop_back();
+    d_current.writeVarint(uint64_t(k) << 1);
+    switch(m) {
+    case kind::metakind::CONSTANT:
+      toCaseConstant(n);
+      break;
+    case kind::metakind::VARIABLE:
+      toCaseVariable(n);
+      break;
+    case kind::metakind::OPERATOR:
+    case kind::metakind::PARAMETERIZED:
+      toCaseOperator(n);
+      break;
+    default:
+      Unhandled(m);
+    }
+    uint64_t index = d_indices.size();
+    d_indices[n] = index;
   }
 }
 
 void PicklerPrivate::toCaseOperator(TNode n)
   throw(AssertionException, PicklingException) {
-  Kind k = n.getKind();
-  kind::MetaKind m = metaKindOf(k);
-  Assert(m == kind::metakind::PARAMETERIZED || m == kind::metakind::OPERATOR);
-  if(m == kind::metakind::PARAMETERIZED) {
-    toCaseNode(n.getOperator());
-  }
-  for(TNode::iterator i = n.begin(), i_end = n.end(); i != i_end; ++i) {
-    toCaseNode(*i);
-  }
-  d_current << mkOperatorHeader(k, n.getNumChildren());
+  Kind k CVC4_UNUSED = n.getKind();
+  Assert(metaKindOf(k) == kind::metakind::PARAMETERIZED ||
+         metaKindOf(k) == kind::metakind::OPERATOR);
+  d_current.writeVarint(n.getNumChildren());
 }
 
 void PicklerPrivate::toCaseVariable(TNode n)
   throw(AssertionException, PicklingException) {
-  Kind k = n.getKind();
+  Kind k CVC4_UNUSED = n.getKind();
   Assert(metaKindOf(k) == kind::metakind::VARIABLE);
 
   const NodeValue* nv = n.d_nv;
   uint64_t asInt = reinterpret_cast<uint64_t>(nv);
-  uint64_t mapped = d_pickler.variableToMap(asInt);
-
-  uint32_t firstHalf = mapped >> 32;
-  uint32_t secondHalf = mapped & 0xffffffff;
-
-  d_current << mkVariableHeader(k);
-  d_current << mkBlockBody(firstHalf);
-  d_current << mkBlockBody(secondHalf);
+  d_current.writeVarint(d_pickler.variableToMap(asInt));
 }
 
-
-void PicklerPrivate::toCaseConstant(TNode n) {
+void PicklerPrivate::toCaseConstant(TNode n) throw(PicklingException) {
   Kind k = n.getKind();
   Assert(metaKindOf(k) == kind::metakind::CONSTANT);
   switch(k) {
   case kind::CONST_BOOLEAN:
-    d_current << mkConstantHeader(k, 1);
-    d_current << mkBlockBody(n.getConst<bool>());
+    d_current.writeByte(n.getConst<bool>());
     break;
-  case kind::CONST_RATIONAL: {
-    std::string asString;
-    Assert(k == kind::CONST_RATIONAL);
-    const Rational& q = n.getConst<Rational>();
-    asString = q.toString(16);
-    toCaseString(k, asString);
+  case kind::CONST_RATIONAL:
+    d_current.writeString(n.getConst<Rational>().toString(16));
     break;
-  }
   case kind::BITVECTOR_EXTRACT_OP: {
     BitVectorExtract bve = n.getConst<BitVectorExtract>();
-    d_current << mkConstantHeader(k, 2);
-    d_current << mkBlockBody(bve.high);
-    d_current << mkBlockBody(bve.low);
+    d_current.writeVarint(bve.high);
+    d_current.writeVarint(bve.low);
     break;
   }
   case kind::CONST_BITVECTOR: {
-    // irritating: we incorporate the size of the string in with the
-    // size of this constant, so it appears as one big constant and
-    // doesn't confuse anybody
     BitVector bv = n.getConst<BitVector>();
-    std::string asString = bv.getValue().toString(16);
-    d_current << mkConstantHeader(k, 2 + asString.size());
-    d_current << mkBlockBody(bv.getSize());
-    toCaseString(k, asString);
+    d_current.writeVarint(bv.getSize());
+    d_current.writeString(bv.getValue().toString(16));
     break;
   }
-  case  kind::BITVECTOR_SIGN_EXTEND_OP: {
-    BitVectorSignExtend bvse = n.getConst<BitVectorSignExtend>();
-    d_current << mkConstantHeader(k, 1);
-    d_current << mkBlockBody(bvse.signExtendAmount);
+  case kind::BITVECTOR_SIGN_EXTEND_OP:
+    d_current.writeVarint(n.getConst<BitVectorSignExtend>().signExtendAmount);
     break;
+  default: {
+    std::stringstream ss;
+    ss << "cannot pickle constants of kind " << k;
+    throw PicklingException(ss.str());
   }
-  default:
-    Unhandled(k);
-  }
-}
-
-void PicklerPrivate::toCaseString(Kind k, const std::string& s) {
-  d_current << mkConstantHeader(k, s.size());
-
-  unsigned size = s.size();
-  unsigned i;
-  for(i = 0; i + 4 <= size; i += 4) {
-    d_current << mkBlockBody4Chars(s[i + 0], s[i + 1],s[i + 2], s[i + 3]);
-  }
-  switch(size % 4) {
-  case 0: break;
-  case 1: d_current << mkBlockBody4Chars(s[i + 0], '\0','\0', '\0'); break;
-  case 2: d_current << mkBlockBody4Chars(s[i + 0], s[i + 1], '\0', '\0'); break;
-  case 3: d_current << mkBlockBody4Chars(s[i + 0], s[i + 1],s[i + 2], '\0'); break;
-  default:
-    Unreachable();
   }
-
 }
 
 void Pickler::debugPickleTest(Expr e) {
@@ -289,54 +246,58 @@ void Pickler::debugPickleTest(Expr e) {
 Expr Pickler::fromPickle(Pickle& p) {
   Assert(d_private->atDefaultState());
 
-  d_private->d_current.swap(*p.d_data);
+  NodeManagerScope nms(d_private->d_nm);
 
-  while(!d_private->d_current.empty()) {
-    Block front = d_private->d_current.dequeue();
+  // decode straight out of the pickle's buffer
+  PickleReader r(*p.d_data);
+  uint8_t version CVC4_UNUSED = r.readByte();
+  Assert(version == PICKLE_VERSION);
 
-    Kind k = (Kind)front.d_header.d_kind;
+  while(!r.done()) {
+    uint64_t h = r.readVarint();
+    if(h & 1) {
+      Assert((h >> 1) < d_private->d_defined.size());
+      d_private->d_stack.push_back(d_private->d_defined[h >> 1]);
+      continue;
+    }
+
+    Kind k = (Kind)(h >> 1);
     kind::MetaKind m = metaKindOf(k);
 
     Node result = Node::null();
     switch(m) {
     case kind::metakind::VARIABLE:
-      result = d_private->fromCaseVariable(k);
+      result = d_private->fromCaseVariable(k, r);
       break;
     case kind::metakind::CONSTANT:
-      result = d_private->fromCaseConstant(k, front.d_headerConstant.d_constblocks);
+      result = d_private->fromCaseConstant(k, r);
       break;
     case kind::metakind::OPERATOR:
     case kind::metakind::PARAMETERIZED:
-      result = d_private->fromCaseOperator(k, front.d_headerOperator.d_nchildren);
+      result = d_private->fromCaseOperator(k, r.readVarint());
       break;
     default:
       Unhandled(m);
     }
     Assert(result != Node::null());
-    d_private->d_stack.push(result);
+    d_private->d_defined.push_back(result);
+    d_private->d_stack.push_back(result);
   }
 
-  Assert(d_private->d_current.empty());
   Assert(d_private->d_stack.size() == 1);
-  Node res = d_private->d_stack.top();
-  d_private->d_stack.pop();
+  Node res = d_private->d_stack.back();
+  d_private->reset();
+  p.d_data->clear();
 
   Assert(d_private->atDefaultState());
 
   return d_private->d_nm->toExpr(res);
 }
 
-Node PicklerPrivate::fromCaseVariable(Kind k) {
+Node PicklerPrivate::fromCaseVariable(Kind k, PickleReader& r) {
   Assert(metaKindOf(k) == kind::metakind::VARIABLE);
 
-  Block firstHalf = d_current.dequeue();
-  Block secondHalf = d_current.dequeue();
-
-  uint64_t asInt = firstHalf.d_body.d_data;
-  asInt = asInt << 32;
-  asInt = asInt | (secondHalf.d_body.d_data);
-
-  uint64_t mapped = d_pickler.variableFromMap(asInt);
+  uint64_t mapped = d_pickler.variableFromMap(r.readVarint());
 
   NodeValue* nv = reinterpret_cast<NodeValue*>(mapped);
   Node fromNodeValue(nv);
@@ -346,101 +307,43 @@ Node PicklerPrivate::fromCaseVariable(Kind k) {
   return fromNodeValue;
 }
 
-Node PicklerPrivate::fromCaseConstant(Kind k, uint32_t constblocks) {
+Node PicklerPrivate::fromCaseConstant(Kind k, PickleReader& r) {
   switch(k) {
-  case kind::CONST_BOOLEAN: {
-    Assert(constblocks == 1);
-    Block val = d_current.dequeue();
-
-    bool b= val.d_body.d_data;
-    return d_nm->mkConst<bool>(b);
-  }
-  case kind::CONST_RATIONAL: {
-    std::string s = fromCaseString(constblocks);
-    Rational q(s, 16);
-    return d_nm->mkConst<Rational>(q);
-  }
+  case kind::CONST_BOOLEAN:
+    return d_nm->mkConst<bool>(r.readByte() != 0);
+  case kind::CONST_RATIONAL:
+    return d_nm->mkConst<Rational>(Rational(r.readString(), 16));
   case kind::BITVECTOR_EXTRACT_OP: {
-    Block high = d_current.dequeue();
-    Block low = d_current.dequeue();
-    BitVectorExtract bve(high.d_body.d_data, low.d_body.d_data);
-    return d_nm->mkConst<BitVectorExtract>(bve);
+    unsigned high = r.readVarint();
+    unsigned low = r.readVarint();
+    return d_nm->mkConst<BitVectorExtract>(BitVectorExtract(high, low));
   }
   case kind::CONST_BITVECTOR: {
-    unsigned size = d_current.dequeue().d_body.d_data;
-    Block header CVC4_UNUSED = d_current.dequeue();
-    Assert(header.d_headerConstant.d_kind == kind::CONST_BITVECTOR);
-    Assert(header.d_headerConstant.d_constblocks == constblocks - 2);
-    Integer value(fromCaseString(constblocks - 2));
-    BitVector bv(size, value);
-    return d_nm->mkConst(bv);
-  }
-  case  kind::BITVECTOR_SIGN_EXTEND_OP: {
-    Block signExtendAmount = d_current.dequeue();
-    BitVectorSignExtend bvse(signExtendAmount.d_body.d_data);
-    return d_nm->mkConst<BitVectorSignExtend>(bvse);
+    unsigned size = r.readVarint();
+    Integer value(r.readString(), 16);
+    return d_nm->mkConst(BitVector(size, value));
   }
+  case kind::BITVECTOR_SIGN_EXTEND_OP:
+    return d_nm->mkConst<BitVectorSignExtend>(BitVectorSignExtend(r.readVarint()));
   default:
     Unhandled(k);
   }
 }
 
-std::string PicklerPrivate::fromCaseString(uint32_t size) {
-  std::stringstream ss;
-  unsigned i;
-  for(i = 0; i + 4 <= size; i += 4) {
-    Block front = d_current.dequeue();
-    BlockBody body = front.d_body;
-
-    ss << getCharBlockBody(body,0)
-       << getCharBlockBody(body,1)
-       << getCharBlockBody(body,2)
-       << getCharBlockBody(body,3);
-  }
-  Assert(i == size - (size%4) );
-  if(size % 4 != 0) {
-    Block front = d_current.dequeue();
-    BlockBody body = front.d_body;
-    switch(size % 4) {
-    case 1:
-      ss << getCharBlockBody(body,0);
-      break;
-    case 2:
-      ss << getCharBlockBody(body,0)
-         << getCharBlockBody(body,1);
-      break;
-    case 3:
-      ss << getCharBlockBody(body,0)
-         << getCharBlockBody(body,1)
-         << getCharBlockBody(body,2);
-      break;
-    default:
-      Unreachable();
-    }
-  }
-  return ss.str();
-}
-
 Node PicklerPrivate::fromCaseOperator(Kind k, uint32_t nchildren) {
   kind::MetaKind m = metaKindOf(k);
   bool parameterized = (m == kind::metakind::PARAMETERIZED);
   uint32_t npops = nchildren + (parameterized? 1 : 0);
-
-  NodeStack aux;
-  while(npops > 0) {
-    Assert(!d_stack.empty());
-    Node top = d_stack.top();
-    aux.push(top);
-    d_stack.pop();
-    --npops;
-  }
+  Assert(d_stack.size() >= npops);
 
   NodeBuilder<> nb(d_nm, k);
-  while(!aux.empty()) {
-    Node top = aux.top();
-    nb << top;
-    aux.pop();
+  for(std::vector<Node>::const_iterator i = d_stack.end() - npops,
+        i_end = d_stack.end();
+      i != i_end;
+      ++i) {
+    nb << *i;
   }
+  d_stack.resize(d_stack.size() - npops);
 
   return nb;
 }
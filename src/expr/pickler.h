@@ -56,6 +56,9 @@ public:
   PicklingException() :
     Exception("Pickling failed") {
   }
+  PicklingException(const std::string& msg) :
+    Exception(msg) {
+  }
 };/* class PicklingException */
 
 class CVC4_PUBLIC Pickler {
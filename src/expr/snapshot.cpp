@@ -0,0 +1,1500 @@
+/*********************                                                        */
+/*! \file snapshot.cpp
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A binary, memory-mappable snapshot of a command sequence
+ **
+ ** A binary, memory-mappable snapshot of a command sequence and the
+ ** term DAG it refers to.
+ **
+ ** A snapshot is a sequence of native-endian 32-bit words: a fixed
+ ** header, then three sections.
+ **
+ **   strings  - each a length followed by its bytes, padded to a word
+ **   nodes    - terms and types, children before parents; each entry
+ **              is a header word (kind, plus flags), for terms the
+ **              index of the term's type, then a kind-dependent body
+ **              (child indices, a name, or a constant's payload)
+ **   commands - a tag word per command followed by its arguments
+ **              (string indices, node indices, and counts)
+ **/
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif /* _WIN32 */
+
+#include "expr/snapshot.h"
+#include "expr/command.h"
+#include "expr/expr_manager.h"
+#include "expr/kind.h"
+#include "expr/metakind.h"
+#include "expr/node.h"
+#include "expr/node_builder.h"
+#include "expr/node_manager.h"
+#include "expr/node_manager_attributes.h"
+#include "expr/type_node.h"
+#include "util/cvc4_assert.h"
+#include "util/hash.h"
+#include "util/output.h"
+
+using namespace std;
+
+namespace CVC4 {
+namespace expr {
+namespace pickle {
+
+namespace snapshot {
+
+static const char MAGIC[8] = { 'C', 'V', 'C', '4', 'S', 'N', 'A', 'P' };
+static const uint32_t VERSION = 2;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/** An absent string or node index */
+static const uint32_t NONE = 0xffffffff;
+
+/* node header flags; the kind is in the low 16 bits */
+static const uint32_t KIND_MASK = 0xffff;
+static const uint32_t NODE_TYPE = 1 << 16;
+static const uint32_t NODE_GLOBAL = 1 << 17;
+static const uint32_t NODE_DEFINED = 1 << 18;
+static const uint32_t NODE_PLACEHOLDER = 1 << 19;
+
+struct Header {
+  char d_magic[8];
+  uint32_t d_version;
+  uint32_t d_byteOrder;
+  /* kind numbering is build-specific; refuse snapshots from elsewhere */
+  uint32_t d_lastKind;
+  uint32_t d_lastType;
+  int32_t d_inputLanguage;
+  uint32_t d_nstrings;
+  uint32_t d_nnodes;
+  uint32_t d_ncommands;
+  /* section offsets, in words from the start of the file */
+  uint32_t d_strings;
+  uint32_t d_nodes;
+  uint32_t d_commands;
+  uint32_t d_end;
+};/* struct Header */
+
+enum CommandTag {
+  CMD_EMPTY,
+  CMD_ECHO,
+  CMD_ASSERT,
+  CMD_PUSH,
+  CMD_POP,
+  CMD_DECLARE_FUNCTION,
+  CMD_DECLARE_TYPE,
+  CMD_DEFINE_TYPE,
+  CMD_DEFINE_FUNCTION,
+  CMD_DEFINE_NAMED_FUNCTION,
+  CMD_CHECK_SAT,
+  CMD_QUERY,
+  CMD_SIMPLIFY,
+  CMD_EXPAND_DEFINITIONS,
+  CMD_GET_VALUE,
+  CMD_GET_ASSIGNMENT,
+  CMD_GET_MODEL,
+  CMD_GET_PROOF,
+  CMD_GET_INSTANTIATIONS,
+  CMD_GET_UNSAT_CORE,
+  CMD_GET_ASSERTIONS,
+  CMD_SET_BENCHMARK_STATUS,
+  CMD_SET_BENCHMARK_LOGIC,
+  CMD_SET_INFO,
+  CMD_GET_INFO,
+  CMD_SET_OPTION,
+  CMD_GET_OPTION,
+  CMD_RESET,
+  CMD_RESET_ASSERTIONS,
+  CMD_QUIT,
+  CMD_COMMENT,
+  CMD_SEQUENCE,
+  CMD_DECLARATION_SEQUENCE,
+  CMD_CHECK_SAT_ASSUMING,
+  CMD_GET_UNSAT_ASSUMPTIONS
+};/* enum CommandTag */
+
+enum SExprTag {
+  SEXPR_STRING,
+  SEXPR_KEYWORD,
+  SEXPR_INTEGER,
+  SEXPR_RATIONAL,
+  SEXPR_LIST
+};/* enum SExprTag */
+
+/** A bounds-checked read position within one section */
+class Cursor {
+  const uint32_t* d_pos;
+  const uint32_t* d_end;
+public:
+  Cursor(const uint32_t* begin, const uint32_t* end) :
+    d_pos(begin),
+    d_end(end) {
+  }
+  uint32_t next() throw(PicklingException) {
+    if(d_pos == d_end) {
+      throw PicklingException("snapshot is truncated or corrupt");
+    }
+    return *d_pos++;
+  }
+  const uint32_t* position() const { return d_pos; }
+  void skip(size_t words) throw(PicklingException) {
+    if(size_t(d_end - d_pos) < words) {
+      throw PicklingException("snapshot is truncated or corrupt");
+    }
+    d_pos += words;
+  }
+};/* class Cursor */
+
+}/* CVC4::expr::pickle::snapshot namespace */
+
+using namespace snapshot;
+
+/**
+ * Builds the sections of a snapshot.  Nodes are numbered on first
+ * use, by an explicit-stack postorder walk, so that every entry's
+ * children (and type) precede it however deep the term is.
+ */
+class SnapshotWriter {
+  typedef __gnu_cxx::hash_map<std::string, uint32_t, StringHashFunction> StringIdMap;
+  typedef __gnu_cxx::hash_map<uint64_t, uint32_t> NodeIdMap;
+  typedef __gnu_cxx::hash_set<uint64_t> NodeIdSet;
+
+  /** a term or a type still to be numbered */
+  struct Frame {
+    Node d_term;
+    TypeNode d_type;
+    bool d_expanded;
+    Frame(TNode n) : d_term(n), d_expanded(false) {}
+    Frame(TypeNode t) : d_type(t), d_expanded(false) {}
+    uint64_t getId() const {
+      return d_type.isNull() ? d_term.getId() : d_type.getId();
+    }
+  };/* struct SnapshotWriter::Frame */
+
+  ExprManager* d_em;
+  NodeManager* d_nm;
+
+  std::vector<uint32_t> d_strings;
+  std::vector<uint32_t> d_nodes;
+  std::vector<uint32_t> d_commands;
+  uint32_t d_nstrings;
+  uint32_t d_nnodes;
+  uint32_t d_ncommands;
+
+  StringIdMap d_stringIds;
+  /** node ids (which are never reused) to snapshot indices */
+  NodeIdMap d_nodeIds;
+
+  /** functions introduced by define-fun (VAR_FLAG_DEFINED) */
+  NodeIdSet d_defined;
+  /** sort parameters of define-sort (SORT_FLAG_PLACEHOLDER) */
+  NodeIdSet d_placeholders;
+  /** sort constructors rebuilt to order their instances after them */
+  std::vector<TypeNode> d_sortConstructors;
+
+public:
+  SnapshotWriter(ExprManager* em) :
+    d_em(em),
+    d_nm(NodeManager::fromExprManager(em)),
+    d_nstrings(0),
+    d_nnodes(0),
+    d_ncommands(0) {
+  }
+
+  void write(const CommandSequence& commands) throw(PicklingException);
+  void finish(std::ostream& out, InputLanguage lang);
+
+private:
+  void prepare(const Command* c);
+  void writeCommand(const Command* c) throw(PicklingException);
+  uint32_t string(const std::string& s);
+  uint32_t term(Expr e) throw(PicklingException);
+  uint32_t type(Type t) throw(PicklingException);
+  uint32_t visit(const Frame& root) throw(PicklingException);
+  void emitTerm(TNode n) throw(PicklingException);
+  void emitType(TypeNode t) throw(PicklingException);
+  uint32_t id(uint64_t nodeId) const;
+  TypeNode sortConstructor(TypeNode t);
+  std::string constant(TNode n) throw(PicklingException);
+  std::string constant(TypeNode t) throw(PicklingException);
+  void sexpr(const SExpr& e);
+  void tag(CommandTag t) { d_commands.push_back(t); }
+  void word(uint32_t w) { d_commands.push_back(w); }
+};/* class SnapshotWriter */
+
+uint32_t SnapshotWriter::string(const std::string& s) {
+  StringIdMap::const_iterator i = d_stringIds.find(s);
+  if(i != d_stringIds.end()) {
+    return (*i).second;
+  }
+  d_strings.push_back(s.size());
+  size_t first = d_strings.size();
+  d_strings.resize(first + (s.size() + 3) / 4, 0);
+  if(!s.empty()) {
+    memcpy(&d_strings[first], s.data(), s.size());
+  }
+  d_stringIds[s] = d_nstrings;
+  return d_nstrings++;
+}
+
+uint32_t SnapshotWriter::id(uint64_t nodeId) const {
+  NodeIdMap::const_iterator i = d_nodeIds.find(nodeId);
+  Assert(i != d_nodeIds.end());
+  return (*i).second;
+}
+
+uint32_t SnapshotWriter::term(Expr e) throw(PicklingException) {
+  if(e.isNull()) {
+    return NONE;
+  }
+  if(e.getExprManager() != d_em) {
+    throw PicklingException("cannot snapshot expressions from more than one ExprManager");
+  }
+  Node n = Node::fromExpr(e);
+  try {
+    // check the whole term now, so that the loader can trust the
+    // types it finds in the snapshot
+    n.getType(true);
+  } catch(TypeCheckingExceptionPrivate& ex) {
+    throw PicklingException(ex.getMessage());
+  }
+  return visit(Frame(n));
+}
+
+uint32_t SnapshotWriter::type(Type t) throw(PicklingException) {
+  if(t.isNull()) {
+    return NONE;
+  }
+  if(t.getExprManager() != d_em) {
+    throw PicklingException("cannot snapshot types from more than one ExprManager");
+  }
+  return visit(Frame(TypeNode::fromType(t)));
+}
+
+TypeNode SnapshotWriter::sortConstructor(TypeNode t) {
+  // an instance of a sort constructor is SORT_TYPE(tag, params...),
+  // the constructor itself SORT_TYPE(tag)
+  Assert(t.getKind() == kind::SORT_TYPE && t.getNumChildren() > 0);
+  NodeBuilder<1> nb(d_nm, kind::SORT_TYPE);
+  nb << t.getOperator();
+  return nb.constructTypeNode();
+}
+
+uint32_t SnapshotWriter::visit(const Frame& root) throw(PicklingException) {
+  if(d_nodeIds.find(root.getId()) != d_nodeIds.end()) {
+    return id(root.getId());
+  }
+
+  std::vector<Frame> stack;
+  stack.push_back(root);
+  while(!stack.empty()) {
+    Frame f = stack.back();
+    if(d_nodeIds.find(f.getId()) != d_nodeIds.end()) {
+      stack.pop_back();
+      continue;
+    }
+    if(f.d_expanded) {
+      if(f.d_type.isNull()) {
+        emitTerm(f.d_term);
+      } else {
+        emitType(f.d_type);
+      }
+      stack.pop_back();
+      continue;
+    }
+    stack.back().d_expanded = true;
+
+    if(!f.d_type.isNull()) {
+      TypeNode t = f.d_type;
+      if(t.getKind() == kind::SORT_TYPE) {
+        if(t.getNumChildren() > 0) {
+          TypeNode ctor = sortConstructor(t);
+          d_sortConstructors.push_back(ctor);
+          stack.push_back(Frame(ctor));
+          for(unsigned i = 0; i < t.getNumChildren(); ++i) {
+            stack.push_back(Frame(t[i]));
+          }
+        }
+      } else if(t.getMetaKind() != kind::metakind::CONSTANT) {
+        for(unsigned i = 0; i < t.getNumChildren(); ++i) {
+          stack.push_back(Frame(t[i]));
+        }
+      }
+    } else {
+      TNode n = f.d_term;
+      TypeNode t = n.getAttribute(TypeAttr());
+      if(!t.isNull()) {
+        stack.push_back(Frame(t));
+      }
+      if(n.getMetaKind() == kind::metakind::PARAMETERIZED) {
+        stack.push_back(Frame(n.getOperator()));
+      }
+      for(unsigned i = 0; i < n.getNumChildren(); ++i) {
+        stack.push_back(Frame(n[i]));
+      }
+    }
+  }
+
+  return id(root.getId());
+}
+
+void SnapshotWriter::emitType(TypeNode t) throw(PicklingException) {
+  Kind k = t.getKind();
+  uint32_t header = k | NODE_TYPE;
+  Assert((uint32_t(k) & ~KIND_MASK) == 0);
+
+  if(k == kind::SORT_TYPE) {
+    if(d_placeholders.find(t.getId()) != d_placeholders.end()) {
+      header |= NODE_PLACEHOLDER;
+    }
+    std::string name;
+    uint64_t arity = 0;
+    t.getAttribute(SortArityAttr(), arity);
+    d_nodes.push_back(header);
+    d_nodes.push_back(t.getAttribute(VarNameAttr(), name) ? string(name) : NONE);
+    d_nodes.push_back(arity);
+    d_nodes.push_back(t.getNumChildren());
+    if(t.getNumChildren() > 0) {
+      d_nodes.push_back(id(sortConstructor(t).getId()));
+      for(unsigned i = 0; i < t.getNumChildren(); ++i) {
+        d_nodes.push_back(id(t[i].getId()));
+      }
+    }
+  } else if(t.getMetaKind() == kind::metakind::CONSTANT) {
+    d_nodes.push_back(header);
+    d_nodes.push_back(string(constant(t)));
+  } else if(t.getMetaKind() == kind::metakind::OPERATOR) {
+    d_nodes.push_back(header);
+    d_nodes.push_back(t.getNumChildren());
+    for(unsigned i = 0; i < t.getNumChildren(); ++i) {
+      d_nodes.push_back(id(t[i].getId()));
+    }
+  } else {
+    std::stringstream ss;
+    ss << "cannot snapshot a type of kind " << k;
+    throw PicklingException(ss.str());
+  }
+
+  d_nodeIds[t.getId()] = d_nnodes++;
+}
+
+void SnapshotWriter::emitTerm(TNode n) throw(PicklingException) {
+  Kind k = n.getKind();
+  uint32_t header = k;
+  Assert((uint32_t(k) & ~KIND_MASK) == 0);
+
+  TypeNode t = n.getAttribute(TypeAttr());
+  uint32_t typeId = t.isNull() ? NONE : id(t.getId());
+  switch(n.getMetaKind()) {
+  case kind::metakind::VARIABLE: {
+    if(k != kind::VARIABLE && k != kind::BOUND_VARIABLE && k != kind::SKOLEM) {
+      std::stringstream ss;
+      ss << "cannot snapshot a variable of kind " << k;
+      throw PicklingException(ss.str());
+    }
+    Assert(typeId != NONE);
+    if(d_defined.find(n.getId()) != d_defined.end()) {
+      header |= NODE_DEFINED;
+    }
+    if(k == kind::VARIABLE && n.getAttribute(GlobalVarAttr())) {
+      header |= NODE_GLOBAL;
+    }
+    std::string name;
+    d_nodes.push_back(header);
+    d_nodes.push_back(typeId);
+    d_nodes.push_back(n.getAttribute(VarNameAttr(), name) ? string(name) : NONE);
+    break;
+  }
+  case kind::metakind::CONSTANT:
+    d_nodes.push_back(header);
+    d_nodes.push_back(typeId);
+    d_nodes.push_back(string(constant(n)));
+    break;
+  case kind::metakind::PARAMETERIZED:
+    d_nodes.push_back(header);
+    d_nodes.push_back(typeId);
+    d_nodes.push_back(n.getNumChildren() + 1);
+    d_nodes.push_back(id(n.getOperator().getId()));
+    for(unsigned i = 0; i < n.getNumChildren(); ++i) {
+      d_nodes.push_back(id(n[i].getId()));
+    }
+    break;
+  default:
+    d_nodes.push_back(header);
+    d_nodes.push_back(typeId);
+    d_nodes.push_back(n.getNumChildren());
+    for(unsigned i = 0; i < n.getNumChildren(); ++i) {
+      d_nodes.push_back(id(n[i].getId()));
+    }
+  }
+
+  d_nodeIds[n.getId()] = d_nnodes++;
+}
+
+std::string SnapshotWriter::constant(TNode n) throw(PicklingException) {
+  std::stringstream ss;
+  switch(Kind k = n.getKind()) {
+  case kind::CONST_BOOLEAN:
+    ss << (n.getConst<bool>() ? 1 : 0);
+    break;
+  case kind::CONST_RATIONAL:
+    ss << n.getConst<Rational>().toString(16);
+    break;
+  case kind::CONST_BITVECTOR: {
+    const BitVector& bv = n.getConst<BitVector>();
+    ss << bv.getSize() << ' ' << bv.getValue().toString(16);
+    break;
+  }
+  case kind::CONST_STRING: {
+    const String& s = n.getConst<String>();
+    for(unsigned i = 0; i < s.size(); ++i) {
+      ss << (i == 0 ? "" : " ") << s[i];
+    }
+    break;
+  }
+  case kind::DIVISIBLE_OP:
+    ss << n.getConst<Divisible>().k.toString(16);
+    break;
+  case kind::BITVECTOR_EXTRACT_OP: {
+    const BitVectorExtract& e = n.getConst<BitVectorExtract>();
+    ss << e.high << ' ' << e.low;
+    break;
+  }
+  case kind::BITVECTOR_BITOF_OP:
+    ss << n.getConst<BitVectorBitOf>().bitIndex;
+    break;
+  case kind::BITVECTOR_REPEAT_OP:
+    ss << unsigned(n.getConst<BitVectorRepeat>());
+    break;
+  case kind::BITVECTOR_ZERO_EXTEND_OP:
+    ss << unsigned(n.getConst<BitVectorZeroExtend>());
+    break;
+  case kind::BITVECTOR_SIGN_EXTEND_OP:
+    ss << unsigned(n.getConst<BitVectorSignExtend>());
+    break;
+  case kind::BITVECTOR_ROTATE_LEFT_OP:
+    ss << unsigned(n.getConst<BitVectorRotateLeft>());
+    break;
+  case kind::BITVECTOR_ROTATE_RIGHT_OP:
+    ss << unsigned(n.getConst<BitVectorRotateRight>());
+    break;
+  case kind::INT_TO_BITVECTOR_OP:
+    ss << unsigned(n.getConst<IntToBitVector>());
+    break;
+  case kind::BUILTIN:
+    ss << unsigned(n.getConst<Kind>());
+    break;
+  default:
+    ss << "cannot snapshot a constant of kind " << k;
+    throw PicklingException(ss.str());
+  }
+  return ss.str();
+}
+
+std::string SnapshotWriter::constant(TypeNode t) throw(PicklingException) {
+  std::stringstream ss;
+  switch(Kind k = t.getKind()) {
+  case kind::BITVECTOR_TYPE:
+    ss << unsigned(t.getConst<BitVectorSize>());
+    break;
+  case kind::TYPE_CONSTANT:
+    ss << unsigned(t.getConst<TypeConstant>());
+    break;
+  default:
+    ss << "cannot snapshot a type of kind " << k;
+    throw PicklingException(ss.str());
+  }
+  return ss.str();
+}
+
+void SnapshotWriter::sexpr(const SExpr& e) {
+  if(e.isInteger()) {
+    word(SEXPR_INTEGER);
+    word(string(e.getIntegerValue().toString()));
+  } else if(e.isRational()) {
+    word(SEXPR_RATIONAL);
+    word(string(e.getRationalValue().toString()));
+  } else if(e.isKeyword()) {
+    word(SEXPR_KEYWORD);
+    word(string(e.getValue()));
+  } else if(e.isString()) {
+    word(SEXPR_STRING);
+    word(string(e.getValue()));
+  } else {
+    const std::vector<SExpr>& children = e.getChildren();
+    word(SEXPR_LIST);
+    word(children.size());
+    for(std::vector<SExpr>::const_iterator i = children.begin(); i != children.end(); ++i) {
+      sexpr(*i);
+    }
+  }
+}
+
+void SnapshotWriter::write(const CommandSequence& commands)
+  throw(PicklingException) {
+  prepare(&commands);
+  for(CommandSequence::const_iterator i = commands.begin(); i != commands.end(); ++i) {
+    writeCommand(*i);
+    ++d_ncommands;
+  }
+}
+
+void SnapshotWriter::prepare(const Command* c) {
+  if(const CommandSequence* seq = dynamic_cast<const CommandSequence*>(c)) {
+    for(CommandSequence::const_iterator i = seq->begin(); i != seq->end(); ++i) {
+      prepare(*i);
+    }
+  } else if(const DefineFunctionCommand* def = dynamic_cast<const DefineFunctionCommand*>(c)) {
+    d_defined.insert(Node::fromExpr(def->getFunction()).getId());
+  } else if(const DefineTypeCommand* def = dynamic_cast<const DefineTypeCommand*>(c)) {
+    const std::vector<Type>& params = def->getParameters();
+    for(std::vector<Type>::const_iterator i = params.begin(); i != params.end(); ++i) {
+      d_placeholders.insert(TypeNode::fromType(*i).getId());
+    }
+  }
+}
+
+void SnapshotWriter::writeCommand(const Command* c)
+  throw(PicklingException) {
+  // more derived classes must be tested before their bases
+  if(const DeclarationSequence* seq = dynamic_cast<const DeclarationSequence*>(c)) {
+    size_t n = std::distance(seq->begin(), seq->end());
+    tag(CMD_DECLARATION_SEQUENCE);
+    word(n);
+    for(CommandSequence::const_iterator i = seq->begin(); i != seq->end(); ++i) {
+      writeCommand(*i);
+    }
+  } else if(const CommandSequence* seq = dynamic_cast<const CommandSequence*>(c)) {
+    size_t n = std::distance(seq->begin(), seq->end());
+    tag(CMD_SEQUENCE);
+    word(n);
+    for(CommandSequence::const_iterator i = seq->begin(); i != seq->end(); ++i) {
+      writeCommand(*i);
+    }
+  } else if(const EmptyCommand* cmd = dynamic_cast<const EmptyCommand*>(c)) {
+    tag(CMD_EMPTY);
+    word(string(cmd->getName()));
+  } else if(const EchoCommand* cmd = dynamic_cast<const EchoCommand*>(c)) {
+    tag(CMD_ECHO);
+    word(string(cmd->getOutput()));
+  } else if(const AssertCommand* cmd = dynamic_cast<const AssertCommand*>(c)) {
+    uint32_t e = term(cmd->getExpr());
+    tag(CMD_ASSERT);
+    word(e);
+    word(cmd->inUnsatCore());
+  } else if(dynamic_cast<const PushCommand*>(c) != NULL) {
+    tag(CMD_PUSH);
+  } else if(dynamic_cast<const PopCommand*>(c) != NULL) {
+    tag(CMD_POP);
+  } else if(const DeclareFunctionCommand* cmd = dynamic_cast<const DeclareFunctionCommand*>(c)) {
+    uint32_t f = term(cmd->getFunction());
+    uint32_t t = type(cmd->getType());
+    tag(CMD_DECLARE_FUNCTION);
+    word(string(cmd->getSymbol()));
+    word(f);
+    word(t);
+    word(cmd->getPrintInModelSetByUser() ? 1 + cmd->getPrintInModel() : 0);
+  } else if(const DeclareTypeCommand* cmd = dynamic_cast<const DeclareTypeCommand*>(c)) {
+    uint32_t t = type(cmd->getType());
+    tag(CMD_DECLARE_TYPE);
+    word(string(cmd->getSymbol()));
+    word(cmd->getArity());
+    word(t);
+  } else if(const DefineTypeCommand* cmd = dynamic_cast<const DefineTypeCommand*>(c)) {
+    const std::vector<Type>& params = cmd->getParameters();
+    std::vector<uint32_t> ps;
+    for(std::vector<Type>::const_iterator i = params.begin(); i != params.end(); ++i) {
+      ps.push_back(type(*i));
+    }
+    uint32_t t = type(cmd->getType());
+    tag(CMD_DEFINE_TYPE);
+    word(string(cmd->getSymbol()));
+    word(ps.size());
+    d_commands.insert(d_commands.end(), ps.begin(), ps.end());
+    word(t);
+  } else if(const DefineFunctionCommand* cmd = dynamic_cast<const DefineFunctionCommand*>(c)) {
+    const std::vector<Expr>& formals = cmd->getFormals();
+    uint32_t f = term(cmd->getFunction());
+    std::vector<uint32_t> fs;
+    for(std::vector<Expr>::const_iterator i = formals.begin(); i != formals.end(); ++i) {
+      fs.push_back(term(*i));
+    }
+    uint32_t body = term(cmd->getFormula());
+    tag(dynamic_cast<const DefineNamedFunctionCommand*>(c) != NULL ?
+        CMD_DEFINE_NAMED_FUNCTION : CMD_DEFINE_FUNCTION);
+    word(string(cmd->getSymbol()));
+    word(f);
+    word(fs.size());
+    d_commands.insert(d_commands.end(), fs.begin(), fs.end());
+    word(body);
+  } else if(const CheckSatCommand* cmd = dynamic_cast<const CheckSatCommand*>(c)) {
+    uint32_t e = term(cmd->getExpr());
+    tag(CMD_CHECK_SAT);
+    word(e);
+    word(cmd->inUnsatCore());
+  } else if(const CheckSatAssumingCommand* cmd = dynamic_cast<const CheckSatAssumingCommand*>(c)) {
+    const std::vector<Expr>& assumptions = cmd->getAssumptions();
+    std::vector<uint32_t> as;
+    for(std::vector<Expr>::const_iterator i = assumptions.begin(); i != assumptions.end(); ++i) {
+      as.push_back(term(*i));
+    }
+    tag(CMD_CHECK_SAT_ASSUMING);
+    word(as.size());
+    d_commands.insert(d_commands.end(), as.begin(), as.end());
+  } else if(const QueryCommand* cmd = dynamic_cast<const QueryCommand*>(c)) {
+    uint32_t e = term(cmd->getExpr());
+    tag(CMD_QUERY);
+    word(e);
+    word(cmd->inUnsatCore());
+  } else if(const SimplifyCommand* cmd = dynamic_cast<const SimplifyCommand*>(c)) {
+    uint32_t e = term(cmd->getTerm());
+    tag(CMD_SIMPLIFY);
+    word(e);
+  } else if(const ExpandDefinitionsCommand* cmd = dynamic_cast<const ExpandDefinitionsCommand*>(c)) {
+    uint32_t e = term(cmd->getTerm());
+    tag(CMD_EXPAND_DEFINITIONS);
+    word(e);
+  } else if(const GetValueCommand* cmd = dynamic_cast<const GetValueCommand*>(c)) {
+    const std::vector<Expr>& terms = cmd->getTerms();
+    std::vector<uint32_t> ts;
+    for(std::vector<Expr>::const_iterator i = terms.begin(); i != terms.end(); ++i) {
+      ts.push_back(term(*i));
+    }
+    tag(CMD_GET_VALUE);
+    word(ts.size());
+    d_commands.insert(d_commands.end(), ts.begin(), ts.end());
+  } else if(dynamic_cast<const GetAssignmentCommand*>(c) != NULL) {
+    tag(CMD_GET_ASSIGNMENT);
+  } else if(dynamic_cast<const GetModelCommand*>(c) != NULL) {
+    tag(CMD_GET_MODEL);
+  } else if(dynamic_cast<const GetProofCommand*>(c) != NULL) {
+    tag(CMD_GET_PROOF);
+  } else if(dynamic_cast<const GetInstantiationsCommand*>(c) != NULL) {
+    tag(CMD_GET_INSTANTIATIONS);
+  } else if(const GetUnsatCoreCommand* cmd = dynamic_cast<const GetUnsatCoreCommand*>(c)) {
+    const std::map<Expr, std::string>& names = cmd->getNames();
+    std::vector<uint32_t> ns;
+    for(std::map<Expr, std::string>::const_iterator i = names.begin(); i != names.end(); ++i) {
+      ns.push_back(term((*i).first));
+      ns.push_back(string((*i).second));
+    }
+    tag(CMD_GET_UNSAT_CORE);
+    word(names.size());
+    d_commands.insert(d_commands.end(), ns.begin(), ns.end());
+  } else if(dynamic_cast<const GetUnsatAssumptionsCommand*>(c) != NULL) {
+    tag(CMD_GET_UNSAT_ASSUMPTIONS);
+  } else if(dynamic_cast<const GetAssertionsCommand*>(c) != NULL) {
+    tag(CMD_GET_ASSERTIONS);
+  } else if(const SetBenchmarkStatusCommand* cmd = dynamic_cast<const SetBenchmarkStatusCommand*>(c)) {
+    tag(CMD_SET_BENCHMARK_STATUS);
+    word(cmd->getStatus());
+  } else if(const SetBenchmarkLogicCommand* cmd = dynamic_cast<const SetBenchmarkLogicCommand*>(c)) {
+    tag(CMD_SET_BENCHMARK_LOGIC);
+    word(string(cmd->getLogic()));
+  } else if(const SetInfoCommand* cmd = dynamic_cast<const SetInfoCommand*>(c)) {
+    tag(CMD_SET_INFO);
+    word(string(cmd->getFlag()));
+    sexpr(cmd->getSExpr());
+  } else if(const GetInfoCommand* cmd = dynamic_cast<const GetInfoCommand*>(c)) {
+    tag(CMD_GET_INFO);
+    word(string(cmd->getFlag()));
+  } else if(const SetOptionCommand* cmd = dynamic_cast<const SetOptionCommand*>(c)) {
+    tag(CMD_SET_OPTION);
+    word(string(cmd->getFlag()));
+    sexpr(cmd->getSExpr());
+  } else if(const GetOptionCommand* cmd = dynamic_cast<const GetOptionCommand*>(c)) {
+    tag(CMD_GET_OPTION);
+    word(string(cmd->getFlag()));
+  } else if(dynamic_cast<const ResetCommand*>(c) != NULL) {
+    tag(CMD_RESET);
+  } else if(dynamic_cast<const ResetAssertionsCommand*>(c) != NULL) {
+    tag(CMD_RESET_ASSERTIONS);
+  } else if(dynamic_cast<const QuitCommand*>(c) != NULL) {
+    tag(CMD_QUIT);
+  } else if(const CommentCommand* cmd = dynamic_cast<const CommentCommand*>(c)) {
+    tag(CMD_COMMENT);
+    word(string(cmd->getComment()));
+  } else {
+    throw PicklingException("cannot snapshot command `" + c->getCommandName() + "'");
+  }
+}
+
+void SnapshotWriter::finish(std::ostream& out, InputLanguage lang) {
+  Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.d_magic, MAGIC, sizeof(MAGIC));
+  h.d_version = VERSION;
+  h.d_byteOrder = BYTE_ORDER_MARK;
+  h.d_lastKind = kind::LAST_KIND;
+  h.d_lastType = LAST_TYPE;
+  h.d_inputLanguage = lang;
+  h.d_nstrings = d_nstrings;
+  h.d_nnodes = d_nnodes;
+  h.d_ncommands = d_ncommands;
+  h.d_strings = sizeof(Header) / sizeof(uint32_t);
+  h.d_nodes = h.d_strings + d_strings.size();
+  h.d_commands = h.d_nodes + d_nodes.size();
+  h.d_end = h.d_commands + d_commands.size();
+
+  out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  const std::vector<uint32_t>* sections[] = { &d_strings, &d_nodes, &d_commands };
+  for(unsigned i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+    if(!sections[i]->empty()) {
+      out.write(reinterpret_cast<const char*>(&(*sections[i])[0]),
+                sections[i]->size() * sizeof(uint32_t));
+    }
+  }
+  out << std::flush;
+}
+
+void Snapshot::write(std::ostream& out, ExprManager* em,
+                     const CommandSequence& commands, InputLanguage lang)
+  throw(PicklingException) {
+  NodeManagerScope nms(NodeManager::fromExprManager(em));
+  SnapshotWriter writer(em);
+  writer.write(commands);
+  writer.finish(out, lang);
+}
+
+/**
+ * The loading side of a Snapshot: the mapped (or, from standard
+ * input, read) file and the terms and types built from it.
+ */
+class SnapshotPrivate {
+public:
+  /** the mapping, if the file was mapped */
+  void* d_map;
+  size_t d_mapLength;
+  /** the file's contents, if it was read instead */
+  std::vector<uint32_t> d_buffer;
+
+  const uint32_t* d_words;
+  size_t d_nwords;
+  const Header* d_header;
+
+  /** start and length of each string, pointing into the file */
+  std::vector< std::pair<const char*, uint32_t> > d_strings;
+
+  ExprManager* d_em;
+  NodeManager* d_nm;
+  /**
+   * One of these is non-null for each node entry built so far.
+   * Entries are built on demand, as the commands that first use
+   * them are loaded, so that variables and sorts are declared to
+   * the SmtEngine when their declaring command is replayed (in the
+   * user context current then), just as parsing them would.
+   */
+  std::vector<Node> d_terms;
+  std::vector<TypeNode> d_types;
+
+  /** the next node entry to build, and the next command to load */
+  Cursor d_nodeCursor;
+  Cursor d_commandCursor;
+  uint32_t d_ncommandsLoaded;
+
+  SnapshotPrivate() :
+    d_map(NULL),
+    d_mapLength(0),
+    d_words(NULL),
+    d_nwords(0),
+    d_header(NULL),
+    d_em(NULL),
+    d_nm(NULL),
+    d_nodeCursor(NULL, NULL),
+    d_commandCursor(NULL, NULL),
+    d_ncommandsLoaded(0) {
+  }
+
+  ~SnapshotPrivate() {
+    // the nodes must go before their NodeManager is out of scope
+    if(d_nm != NULL) {
+      NodeManagerScope nms(d_nm);
+      d_terms.clear();
+      d_types.clear();
+    }
+#ifndef _WIN32
+    if(d_map != NULL) {
+      munmap(d_map, d_mapLength);
+    }
+#endif /* ! _WIN32 */
+  }
+
+  void open(const std::string& filename) throw(PicklingException);
+  void read(std::istream& in) throw(PicklingException);
+  void checkHeader() throw(PicklingException);
+
+  Cursor section(uint32_t begin, uint32_t end) const {
+    return Cursor(d_words + begin, d_words + end);
+  }
+
+  std::string string(uint32_t i) const throw(PicklingException);
+  Node term(uint32_t i) throw(PicklingException);
+  TypeNode type(uint32_t i) throw(PicklingException);
+  Node builtTerm(uint32_t i) const throw(PicklingException);
+  TypeNode builtType(uint32_t i) const throw(PicklingException);
+  Expr expr(Cursor& c) throw(PicklingException);
+
+  void start(ExprManager* em);
+  Command* nextCommand() throw(PicklingException);
+  void loadNodesThrough(uint32_t i) throw(PicklingException);
+  void loadNode() throw(PicklingException);
+  Node loadConstant(Kind k, const std::string& payload) throw(PicklingException);
+  TypeNode loadTypeConstant(Kind k, const std::string& payload) throw(PicklingException);
+  Command* loadCommand(Cursor& c) throw(PicklingException);
+  SExpr loadSExpr(Cursor& c) throw(PicklingException);
+};/* class SnapshotPrivate */
+
+void SnapshotPrivate::open(const std::string& filename)
+  throw(PicklingException) {
+#ifdef _WIN32
+  std::ifstream in(filename.c_str(), std::ios::binary);
+  if(!in) {
+    throw PicklingException("cannot open snapshot `" + filename + "'");
+  }
+  read(in);
+#else /* _WIN32 */
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw PicklingException("cannot open snapshot `" + filename + "': " + strerror(errno));
+  }
+  struct stat st;
+  if(fstat(fd, &st) < 0) {
+    int err = errno;
+    close(fd);
+    throw PicklingException("cannot stat snapshot `" + filename + "': " + strerror(err));
+  }
+  d_mapLength = st.st_size;
+  if(d_mapLength < sizeof(Header)) {
+    close(fd);
+    throw PicklingException("`" + filename + "' is not a CVC4 snapshot");
+  }
+  d_map = mmap(NULL, d_mapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(d_map == MAP_FAILED) {
+    d_map = NULL;
+    throw PicklingException("cannot map snapshot `" + filename + "': " + strerror(errno));
+  }
+  // the load is a front-to-back scan
+  madvise(d_map, d_mapLength, MADV_SEQUENTIAL);
+  d_words = static_cast<const uint32_t*>(d_map);
+  d_nwords = d_mapLength / sizeof(uint32_t);
+#endif /* _WIN32 */
+  checkHeader();
+}
+
+void SnapshotPrivate::read(std::istream& in) throw(PicklingException) {
+  std::string contents((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  d_buffer.resize((contents.size() + 3) / 4);
+  if(!contents.empty()) {
+    memcpy(&d_buffer[0], contents.data(), contents.size());
+  }
+  d_words = d_buffer.empty() ? NULL : &d_buffer[0];
+  d_nwords = contents.size() / sizeof(uint32_t);
+  checkHeader();
+}
+
+void SnapshotPrivate::checkHeader() throw(PicklingException) {
+  d_header = reinterpret_cast<const Header*>(d_words);
+  if(d_nwords < sizeof(Header) / sizeof(uint32_t) ||
+     memcmp(d_header->d_magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw PicklingException("input is not a CVC4 snapshot");
+  }
+  if(d_header->d_byteOrder != BYTE_ORDER_MARK) {
+    throw PicklingException("snapshot was written on a machine of different byte order");
+  }
+  if(d_header->d_version != VERSION) {
+    throw PicklingException("unsupported snapshot version");
+  }
+  if(d_header->d_lastKind != uint32_t(kind::LAST_KIND) ||
+     d_header->d_lastType != uint32_t(LAST_TYPE)) {
+    throw PicklingException("snapshot was written by an incompatible build of CVC4");
+  }
+  if(d_header->d_strings != sizeof(Header) / sizeof(uint32_t) ||
+     d_header->d_nodes < d_header->d_strings ||
+     d_header->d_commands < d_header->d_nodes ||
+     d_header->d_end < d_header->d_commands ||
+     d_header->d_end > d_nwords ||
+     // every string, node entry, and command takes at least a word
+     d_header->d_nstrings > d_header->d_nodes - d_header->d_strings ||
+     d_header->d_nnodes > d_header->d_commands - d_header->d_nodes ||
+     d_header->d_ncommands > d_header->d_end - d_header->d_commands) {
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+
+  // index the string table; the strings themselves stay in the file
+  Cursor c = section(d_header->d_strings, d_header->d_nodes);
+  d_strings.reserve(d_header->d_nstrings);
+  for(uint32_t i = 0; i < d_header->d_nstrings; ++i) {
+    uint32_t len = c.next();
+    const char* s = reinterpret_cast<const char*>(c.position());
+    c.skip((size_t(len) + 3) / 4);
+    d_strings.push_back(std::make_pair(s, len));
+  }
+}
+
+std::string SnapshotPrivate::string(uint32_t i) const
+  throw(PicklingException) {
+  if(i >= d_strings.size()) {
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+  return std::string(d_strings[i].first, d_strings[i].second);
+}
+
+Node SnapshotPrivate::builtTerm(uint32_t i) const throw(PicklingException) {
+  if(i >= d_terms.size() || d_terms[i].isNull()) {
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+  return d_terms[i];
+}
+
+TypeNode SnapshotPrivate::builtType(uint32_t i) const throw(PicklingException) {
+  if(i >= d_types.size() || d_types[i].isNull()) {
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+  return d_types[i];
+}
+
+Node SnapshotPrivate::term(uint32_t i) throw(PicklingException) {
+  loadNodesThrough(i);
+  return builtTerm(i);
+}
+
+TypeNode SnapshotPrivate::type(uint32_t i) throw(PicklingException) {
+  loadNodesThrough(i);
+  return builtType(i);
+}
+
+Expr SnapshotPrivate::expr(Cursor& c) throw(PicklingException) {
+  uint32_t i = c.next();
+  return i == NONE ? Expr() : d_nm->toExpr(term(i));
+}
+
+void SnapshotPrivate::start(ExprManager* em) {
+  d_em = em;
+  d_nm = NodeManager::fromExprManager(em);
+  d_terms.reserve(d_header->d_nnodes);
+  d_types.reserve(d_header->d_nnodes);
+  d_nodeCursor = section(d_header->d_nodes, d_header->d_commands);
+  d_commandCursor = section(d_header->d_commands, d_header->d_end);
+}
+
+Command* SnapshotPrivate::nextCommand() throw(PicklingException) {
+  if(d_ncommandsLoaded == d_header->d_ncommands) {
+    return NULL;
+  }
+  Command* c = loadCommand(d_commandCursor);
+  if(++d_ncommandsLoaded == d_header->d_ncommands) {
+    Debug("snapshot") << "snapshot: loaded " << d_terms.size()
+                      << " nodes and " << d_ncommandsLoaded
+                      << " commands" << std::endl;
+    // the commands hold what they need; don't keep the rest of the
+    // DAG alive for the caller's whole run
+    d_terms.clear();
+    d_types.clear();
+  }
+  return c;
+}
+
+void SnapshotPrivate::loadNodesThrough(uint32_t i) throw(PicklingException) {
+  if(i >= d_header->d_nnodes) {
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+  while(d_terms.size() <= i) {
+    loadNode();
+  }
+}
+
+static bool arityInBounds(Kind k, uint32_t nchildren) {
+  return nchildren >= kind::metakind::getLowerBoundForKind(k) &&
+         nchildren <= kind::metakind::getUpperBoundForKind(k);
+}
+
+void SnapshotPrivate::loadNode() throw(PicklingException) {
+  // entries refer only to those before them, so built ones suffice
+  Cursor& c = d_nodeCursor;
+  uint32_t header = c.next();
+  Kind k = Kind(header & KIND_MASK);
+  if(k >= kind::LAST_KIND) {
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+  kind::MetaKind mk = kind::metaKindOf(k);
+  if(mk == kind::metakind::INVALID) {
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+
+  if(header & NODE_TYPE) {
+    TypeNode t;
+    if(k == kind::SORT_TYPE) {
+      uint32_t name = c.next();
+      uint32_t arity = c.next();
+      uint32_t nparams = c.next();
+      uint32_t flags = (header & NODE_PLACEHOLDER) ?
+        ExprManager::SORT_FLAG_PLACEHOLDER : ExprManager::SORT_FLAG_NONE;
+      if(nparams > 0) {
+        TypeNode ctor = builtType(c.next());
+        uint64_t ctorArity = 0;
+        if(ctor.getKind() != kind::SORT_TYPE || ctor.getNumChildren() != 0 ||
+           !ctor.getAttribute(SortArityAttr(), ctorArity) || ctorArity != nparams) {
+          throw PicklingException("snapshot is truncated or corrupt");
+        }
+        std::vector<TypeNode> params;
+        for(uint32_t i = 0; i < nparams; ++i) {
+          params.push_back(builtType(c.next()));
+        }
+        t = d_nm->mkSort(ctor, params, flags);
+      } else if(arity > 0) {
+        t = d_nm->mkSortConstructor(string(name), arity);
+      } else if(name != NONE) {
+        t = d_nm->mkSort(string(name), flags);
+      } else {
+        t = d_nm->mkSort(flags);
+      }
+    } else if(mk == kind::metakind::CONSTANT) {
+      t = loadTypeConstant(k, string(c.next()));
+    } else {
+      uint32_t n = c.next();
+      if(mk != kind::metakind::OPERATOR || !arityInBounds(k, n)) {
+        throw PicklingException("snapshot is truncated or corrupt");
+      }
+      NodeBuilder<> nb(d_nm, k);
+      for(uint32_t i = 0; i < n; ++i) {
+        nb << builtType(c.next());
+      }
+      t = nb.constructTypeNode();
+    }
+    d_terms.push_back(Node::null());
+    d_types.push_back(t);
+    return;
+  }
+
+  uint32_t typeId = c.next();
+  TypeNode t = (typeId == NONE) ? TypeNode::null() : builtType(typeId);
+  Node n;
+  if(mk == kind::metakind::VARIABLE) {
+    uint32_t name = c.next();
+    if(t.isNull()) {
+      throw PicklingException("snapshot is truncated or corrupt");
+    }
+    // made through the usual channels, so that the SmtEngine hears
+    // about them (and they appear in models)
+    switch(k) {
+    case kind::VARIABLE: {
+      uint32_t flags = ExprManager::VAR_FLAG_NONE;
+      if(header & NODE_GLOBAL) {
+        flags |= ExprManager::VAR_FLAG_GLOBAL;
+      }
+      if(header & NODE_DEFINED) {
+        flags |= ExprManager::VAR_FLAG_DEFINED;
+      }
+      Expr v = (name == NONE) ?
+        d_em->mkVar(t.toType(), flags) :
+        d_em->mkVar(string(name), t.toType(), flags);
+      n = Node::fromExpr(v);
+      break;
+    }
+    case kind::BOUND_VARIABLE:
+      n = (name == NONE) ? d_nm->mkBoundVar(t) : d_nm->mkBoundVar(string(name), t);
+      break;
+    case kind::SKOLEM:
+      n = d_nm->mkSkolem(name == NONE ? "sk" : string(name), t,
+                         "restored from a snapshot",
+                         NodeManager::SKOLEM_EXACT_NAME);
+      break;
+    default:
+      throw PicklingException("snapshot is truncated or corrupt");
+    }
+  } else {
+    if(mk == kind::metakind::CONSTANT) {
+      n = loadConstant(k, string(c.next()));
+    } else {
+      uint32_t nchildren = c.next();
+      // a parameterized node's operator is stored as its first child
+      if(mk == kind::metakind::PARAMETERIZED ?
+         nchildren == 0 || !arityInBounds(k, nchildren - 1) :
+         !arityInBounds(k, nchildren)) {
+        throw PicklingException("snapshot is truncated or corrupt");
+      }
+      NodeBuilder<> nb(d_nm, k);
+      for(uint32_t i = 0; i < nchildren; ++i) {
+        nb << builtTerm(c.next());
+      }
+      n = nb.constructNode();
+    }
+    if(!t.isNull()) {
+      // the writer checked it; don't do it again
+      d_nm->setAttribute(n, TypeAttr(), t);
+      d_nm->setAttribute(n, TypeCheckedAttr(), true);
+    }
+  }
+  d_terms.push_back(n);
+  d_types.push_back(TypeNode::null());
+}
+
+static unsigned toUnsigned(const std::string& s) {
+  return strtoul(s.c_str(), NULL, 10);
+}
+
+/** Whether s is an integer, or a fraction with nonzero denominator, in hex */
+static bool isHexNumeral(const std::string& s, bool fraction) {
+  static const char* const digits = "0123456789abcdefABCDEF";
+  std::string::size_type begin = (!s.empty() && s[0] == '-') ? 1 : 0;
+  std::string::size_type slash = fraction ? s.find('/') : std::string::npos;
+  std::string num = s.substr(begin, slash == std::string::npos ?
+                             std::string::npos : slash - begin);
+  if(num.empty() || num.find_first_not_of(digits) != std::string::npos) {
+    return false;
+  }
+  if(slash == std::string::npos) {
+    return true;
+  }
+  std::string den = s.substr(slash + 1);
+  return !den.empty() && den.find_first_not_of(digits) == std::string::npos &&
+         den.find_first_not_of('0') != std::string::npos;
+}
+
+Node SnapshotPrivate::loadConstant(Kind k, const std::string& payload)
+  throw(PicklingException) {
+  switch(k) {
+  case kind::CONST_BOOLEAN:
+    return d_nm->mkConst(payload == "1");
+  case kind::CONST_RATIONAL:
+    if(!isHexNumeral(payload, true)) {
+      break;
+    }
+    return d_nm->mkConst(Rational(payload, 16));
+  case kind::CONST_BITVECTOR: {
+    std::string::size_type space = payload.find(' ');
+    if(space == std::string::npos ||
+       !isHexNumeral(payload.substr(space + 1), false)) {
+      break;
+    }
+    return d_nm->mkConst(BitVector(toUnsigned(payload.substr(0, space)),
+                                   Integer(payload.substr(space + 1), 16)));
+  }
+  case kind::CONST_STRING: {
+    std::vector<unsigned> chars;
+    std::istringstream ss(payload);
+    unsigned ch;
+    while(ss >> ch) {
+      chars.push_back(ch);
+    }
+    return d_nm->mkConst(String(chars));
+  }
+  case kind::DIVISIBLE_OP: {
+    if(!isHexNumeral(payload, false)) {
+      break;
+    }
+    Integer divisor(payload, 16);
+    if(divisor.sgn() <= 0) {
+      break;
+    }
+    return d_nm->mkConst(Divisible(divisor));
+  }
+  case kind::BITVECTOR_EXTRACT_OP: {
+    std::istringstream ss(payload);
+    unsigned high, low;
+    if(!(ss >> high >> low)) {
+      break;
+    }
+    return d_nm->mkConst(BitVectorExtract(high, low));
+  }
+  case kind::BITVECTOR_BITOF_OP:
+    return d_nm->mkConst(BitVectorBitOf(toUnsigned(payload)));
+  case kind::BITVECTOR_REPEAT_OP:
+    return d_nm->mkConst(BitVectorRepeat(toUnsigned(payload)));
+  case kind::BITVECTOR_ZERO_EXTEND_OP:
+    return d_nm->mkConst(BitVectorZeroExtend(toUnsigned(payload)));
+  case kind::BITVECTOR_SIGN_EXTEND_OP:
+    return d_nm->mkConst(BitVectorSignExtend(toUnsigned(payload)));
+  case kind::BITVECTOR_ROTATE_LEFT_OP:
+    return d_nm->mkConst(BitVectorRotateLeft(toUnsigned(payload)));
+  case kind::BITVECTOR_ROTATE_RIGHT_OP:
+    return d_nm->mkConst(BitVectorRotateRight(toUnsigned(payload)));
+  case kind::INT_TO_BITVECTOR_OP:
+    return d_nm->mkConst(IntToBitVector(toUnsigned(payload)));
+  case kind::BUILTIN: {
+    unsigned builtin = toUnsigned(payload);
+    if(builtin >= kind::LAST_KIND) {
+      break;
+    }
+    return d_nm->mkConst(Kind(builtin));
+  }
+  default:
+    break;
+  }
+  throw PicklingException("snapshot is truncated or corrupt");
+}
+
+TypeNode SnapshotPrivate::loadTypeConstant(Kind k, const std::string& payload)
+  throw(PicklingException) {
+  switch(k) {
+  case kind::BITVECTOR_TYPE: {
+    unsigned size = toUnsigned(payload);
+    if(size == 0) {
+      break;
+    }
+    return d_nm->mkBitVectorType(size);
+  }
+  case kind::TYPE_CONSTANT: {
+    unsigned tc = toUnsigned(payload);
+    if(tc >= LAST_TYPE) {
+      break;
+    }
+    return d_nm->mkTypeConst(TypeConstant(tc));
+  }
+  default:
+    break;
+  }
+  throw PicklingException("snapshot is truncated or corrupt");
+}
+
+SExpr SnapshotPrivate::loadSExpr(Cursor& c) throw(PicklingException) {
+  switch(c.next()) {
+  case SEXPR_STRING:
+    return SExpr(string(c.next()));
+  case SEXPR_KEYWORD:
+    return SExpr(SExpr::Keyword(string(c.next())));
+  case SEXPR_INTEGER:
+    return SExpr(Integer(string(c.next())));
+  case SEXPR_RATIONAL:
+    return SExpr(Rational(string(c.next())));
+  case SEXPR_LIST: {
+    uint32_t n = c.next();
+    std::vector<SExpr> children;
+    for(uint32_t i = 0; i < n; ++i) {
+      children.push_back(loadSExpr(c));
+    }
+    return SExpr(children);
+  }
+  default:
+    throw PicklingException("snapshot is truncated or corrupt");
+  }
+}
+
+Command* SnapshotPrivate::loadCommand(Cursor& c) throw(PicklingException) {
+  uint32_t tag = c.next();
+  switch(tag) {
+  case CMD_EMPTY:
+    return new EmptyCommand(string(c.next()));
+  case CMD_ECHO:
+    return new EchoCommand(string(c.next()));
+  case CMD_ASSERT: {
+    Expr e = expr(c);
+    return new AssertCommand(e, c.next());
+  }
+  case CMD_PUSH:
+    return new PushCommand();
+  case CMD_POP:
+    return new PopCommand();
+  case CMD_DECLARE_FUNCTION: {
+    std::string id = string(c.next());
+    Expr f = expr(c);
+    Type t = type(c.next()).toType();
+    uint32_t printInModel = c.next();
+    DeclareFunctionCommand* cmd = new DeclareFunctionCommand(id, f, t);
+    if(printInModel != 0) {
+      cmd->setPrintInModel(printInModel == 2);
+    }
+    return cmd;
+  }
+  case CMD_DECLARE_TYPE: {
+    std::string id = string(c.next());
+    size_t arity = c.next();
+    return new DeclareTypeCommand(id, arity, type(c.next()).toType());
+  }
+  case CMD_DEFINE_TYPE: {
+    std::string id = string(c.next());
+    uint32_t n = c.next();
+    std::vector<Type> params;
+    for(uint32_t i = 0; i < n; ++i) {
+      params.push_back(type(c.next()).toType());
+    }
+    return new DefineTypeCommand(id, params, type(c.next()).toType());
+  }
+  case CMD_DEFINE_FUNCTION:
+  case CMD_DEFINE_NAMED_FUNCTION: {
+    bool named = (tag == CMD_DEFINE_NAMED_FUNCTION);
+    std::string id = string(c.next());
+    Expr f = expr(c);
+    uint32_t n = c.next();
+    std::vector<Expr> formals;
+    for(uint32_t i = 0; i < n; ++i) {
+      formals.push_back(expr(c));
+    }
+    Expr body = expr(c);
+    if(named) {
+      return new DefineNamedFunctionCommand(id, f, formals, body);
+    }
+    return new DefineFunctionCommand(id, f, formals, body);
+  }
+  case CMD_CHECK_SAT: {
+    Expr e = expr(c);
+    bool inUnsatCore = c.next();
+    return e.isNull() ? new CheckSatCommand() : new CheckSatCommand(e, inUnsatCore);
+  }
+  case CMD_CHECK_SAT_ASSUMING: {
+    uint32_t n = c.next();
+    std::vector<Expr> assumptions;
+    for(uint32_t i = 0; i < n; ++i) {
+      assumptions.push_back(expr(c));
+    }
+    return new CheckSatAssumingCommand(assumptions);
+  }
+  case CMD_QUERY: {
+    Expr e = expr(c);
+    return new QueryCommand(e, c.next());
+  }
+  case CMD_SIMPLIFY:
+    return new SimplifyCommand(expr(c));
+  case CMD_EXPAND_DEFINITIONS:
+    return new ExpandDefinitionsCommand(expr(c));
+  case CMD_GET_VALUE: {
+    uint32_t n = c.next();
+    std::vector<Expr> terms;
+    for(uint32_t i = 0; i < n; ++i) {
+      terms.push_back(expr(c));
+    }
+    return new GetValueCommand(terms);
+  }
+  case CMD_GET_ASSIGNMENT:
+    return new GetAssignmentCommand();
+  case CMD_GET_MODEL:
+    return new GetModelCommand();
+  case CMD_GET_PROOF:
+    return new GetProofCommand();
+  case CMD_GET_INSTANTIATIONS:
+    return new GetInstantiationsCommand();
+  case CMD_GET_UNSAT_CORE: {
+    uint32_t n = c.next();
+    std::map<Expr, std::string> names;
+    for(uint32_t i = 0; i < n; ++i) {
+      Expr e = expr(c);
+      names[e] = string(c.next());
+    }
+    return new GetUnsatCoreCommand(names);
+  }
+  case CMD_GET_UNSAT_ASSUMPTIONS:
+    return new GetUnsatAssumptionsCommand();
+  case CMD_GET_ASSERTIONS:
+    return new GetAssertionsCommand();
+  case CMD_SET_BENCHMARK_STATUS: {
+    uint32_t status = c.next();
+    if(status > SMT_UNKNOWN) {
+      break;
+    }
+    return new SetBenchmarkStatusCommand(BenchmarkStatus(status));
+  }
+  case CMD_SET_BENCHMARK_LOGIC:
+    return new SetBenchmarkLogicCommand(string(c.next()));
+  case CMD_SET_INFO: {
+    std::string flag = string(c.next());
+    return new SetInfoCommand(flag, loadSExpr(c));
+  }
+  case CMD_GET_INFO:
+    return new GetInfoCommand(string(c.next()));
+  case CMD_SET_OPTION: {
+    std::string flag = string(c.next());
+    return new SetOptionCommand(flag, loadSExpr(c));
+  }
+  case CMD_GET_OPTION:
+    return new GetOptionCommand(string(c.next()));
+  case CMD_RESET:
+    return new ResetCommand();
+  case CMD_RESET_ASSERTIONS:
+    return new ResetAssertionsCommand();
+  case CMD_QUIT:
+    return new QuitCommand();
+  case CMD_COMMENT:
+    return new CommentCommand(string(c.next()));
+  case CMD_SEQUENCE:
+  case CMD_DECLARATION_SEQUENCE: {
+    CommandSequence* seq = (tag == CMD_SEQUENCE) ?
+      new CommandSequence() : new DeclarationSequence();
+    uint32_t n = c.next();
+    try {
+      for(uint32_t i = 0; i < n; ++i) {
+        seq->addCommand(loadCommand(c));
+      }
+    } catch(...) {
+      delete seq;
+      throw;
+    }
+    return seq;
+  }
+  default:
+    break;
+  }
+  throw PicklingException("snapshot is truncated or corrupt");
+}
+
+Snapshot::Snapshot(const std::string& filename) throw(PicklingException) :
+  d_private(new SnapshotPrivate()) {
+  try {
+    if(filename == "-") {
+      d_private->read(std::cin);
+    } else {
+      d_private->open(filename);
+    }
+  } catch(...) {
+    delete d_private;
+    throw;
+  }
+}
+
+Snapshot::~Snapshot() {
+  delete d_private;
+}
+
+InputLanguage Snapshot::getInputLanguage() const throw() {
+  return InputLanguage(d_private->d_header->d_inputLanguage);
+}
+
+void Snapshot::start(ExprManager* em) throw() {
+  Assert(d_private->d_nm == NULL, "snapshot already loaded");
+  d_private->start(em);
+}
+
+Command* Snapshot::nextCommand() throw(PicklingException) {
+  Assert(d_private->d_nm != NULL, "snapshot not started");
+  NodeManagerScope nms(d_private->d_nm);
+  return d_private->nextCommand();
+}
+
+CommandSequence* Snapshot::load(ExprManager* em) throw(PicklingException) {
+  start(em);
+  CommandSequence* commands = new CommandSequence();
+  try {
+    Command* c;
+    while((c = nextCommand()) != NULL) {
+      commands->addCommand(c);
+    }
+  } catch(...) {
+    delete commands;
+    throw;
+  }
+  return commands;
+}
+
+}/* CVC4::expr::pickle namespace */
+}/* CVC4::expr namespace */
+}/* CVC4 namespace */
@@ -0,0 +1,109 @@
+/*********************                                                        */
+/*! \file snapshot.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A binary, memory-mappable snapshot of a command sequence
+ **
+ ** A binary, memory-mappable snapshot of a command sequence and the
+ ** term DAG it refers to.  Where the Pickler serializes a single
+ ** expression as a tree, a snapshot stores every term and type
+ ** exactly once, in topological order, along with a string table
+ ** (symbol names and constant payloads) and the commands.  Loading
+ ** it maps the file and rebuilds the DAG in a single pass, children
+ ** before parents, installing the recorded types directly rather
+ ** than type checking again; parsing is skipped entirely.
+ **
+ ** Snapshots are not portable: they are tied to the kind numbering
+ ** (and byte order) of the CVC4 build that wrote them, and loading
+ ** one written by another build is refused.
+ **/
+
+#include "cvc4_public.h"
+
+#ifndef __CVC4__SNAPSHOT_H
+#define __CVC4__SNAPSHOT_H
+
+#include <iostream>
+#include <string>
+
+#include "expr/pickler.h"
+#include "util/language.h"
+
+namespace CVC4 {
+
+class ExprManager;
+class Command;
+class CommandSequence;
+
+namespace expr {
+namespace pickle {
+
+class SnapshotPrivate;
+
+class CVC4_PUBLIC Snapshot {
+  SnapshotPrivate* d_private;
+
+  // disallow copy/assignment
+  Snapshot(const Snapshot&) CVC4_UNDEFINED;
+  Snapshot& operator=(const Snapshot&) CVC4_UNDEFINED;
+
+public:
+
+  /**
+   * Opens the snapshot in the named file ("-" for standard input)
+   * and checks its header.  The file is mapped, not read, so opening
+   * is cheap regardless of its size.
+   */
+  Snapshot(const std::string& filename) throw(PicklingException);
+
+  ~Snapshot();
+
+  /** The language the snapshotted commands were originally written in. */
+  InputLanguage getInputLanguage() const throw();
+
+  /**
+   * Prepares to hand out the snapshot's commands, building their
+   * terms and types in em.
+   */
+  void start(ExprManager* em) throw();
+
+  /**
+   * The next command, in the original order, or NULL after the last;
+   * the caller owns it.  Like a Parser, this makes each declaration
+   * only when the command declaring it is reached, so a command
+   * should be executed before the next is asked for: variables
+   * declared inside a push then belong to that user context.
+   */
+  Command* nextCommand() throw(PicklingException);
+
+  /**
+   * Builds the snapshot's terms and types in em and returns all its
+   * commands, in their original order.  The caller owns the result.
+   */
+  CommandSequence* load(ExprManager* em) throw(PicklingException);
+
+  /**
+   * Writes a snapshot of commands, originally written in lang, to
+   * out.  All expressions must belong to em, and must be well-typed
+   * (they are type checked here, so that loading need not).  Throws
+   * a PicklingException if a command or constant has no snapshot
+   * representation (datatypes, rewrite rules, ...).
+   */
+  static void write(std::ostream& out, ExprManager* em,
+                    const CommandSequence& commands,
+                    InputLanguage lang) throw(PicklingException);
+
+};/* class Snapshot */
+
+}/* CVC4::expr::pickle namespace */
+}/* CVC4::expr namespace */
+}/* CVC4 namespace */
+
+#endif /* __CVC4__SNAPSHOT_H */
@@ -107,12 +107,16 @@ bool CommandExecutor::doCommandSingleton(Command* cmd)
   if(cs != NULL) {
     d_result = res = cs->getResult();
   }
+  CheckSatAssumingCommand* csa = dynamic_cast<CheckSatAssumingCommand*>(cmd);
+  if(csa != NULL) {
+    d_result = res = csa->getResult();
+  }
   QueryCommand* q = dynamic_cast<QueryCommand*>(cmd);
   if(q != NULL) {
     d_result = res = q->getResult();
   }
 
-  if((cs != NULL || q != NULL) && d_options[options::statsEveryQuery]) {
+  if((cs != NULL || csa != NULL || q != NULL) && d_options[options::statsEveryQuery]) {
     std::ostringstream ossCurStats;
     flushStatistics(ossCurStats);
     printStatsIncremental(*d_options[options::err], d_lastStatistics, ossCurStats.str());
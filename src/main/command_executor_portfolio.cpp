@@ -12,7 +12,8 @@
  ** \brief An additional layer between commands and invoking them.
  **
  ** The portfolio executor branches check-sat queries to several
- ** threads.
+ ** threads.  It either races them on the whole query, or (with
+ ** --cube-and-conquer) splits the query into cubes that they share.
  **/
 
 #include <boost/thread.hpp>
@@ -20,6 +21,7 @@
 #include <boost/exception_ptr.hpp>
 #include <boost/lexical_cast.hpp>
 #include <string>
+#include <vector>
 
 #include "expr/command.h"
 #include "expr/pickler.h"
@@ -42,6 +44,110 @@ using namespace std;
 namespace CVC4 {
 namespace main {
 
+/** The cubes of a check-sat, shared by the threads solving them */
+struct CubeQueue {
+  boost::mutex d_mutex;
+  /** the number of cubes, and the next one to solve */
+  size_t d_numCubes, d_next;
+  /** the number of cubes found unsatisfiable */
+  size_t d_refuted;
+  /** the thread that found a cube satisfiable, or -1 */
+  int d_winner;
+  /** the result of a cube neither sat nor unsat, and its thread */
+  Result d_unknown;
+  int d_unknownThread;
+  /** the error a thread failed with, if any */
+  std::string d_failure;
+  /**
+   * whether each thread was interrupted; a thread checks its flag
+   * before each cube, as SmtEngine::interrupt() does nothing unless
+   * the thread is already searching
+   */
+  std::vector<bool> d_interruptPending;
+
+  CubeQueue(size_t numCubes, unsigned numThreads) :
+    d_numCubes(numCubes),
+    d_next(0),
+    d_refuted(0),
+    d_winner(-1),
+    d_unknown(),
+    d_unknownThread(-1),
+    d_failure(),
+    d_interruptPending(numThreads, false) {
+  }
+
+  /** Is there nothing (left) to do? */
+  bool done() const {
+    return d_winner >= 0 || !d_failure.empty() || d_next == d_numCubes;
+  }
+};/* struct CubeQueue */
+
+/**
+ * A cube-and-conquer thread: after catching up on the commands in seq
+ * (if any), it takes cubes from the queue and solves them (as the
+ * queries given, one for each cube) until there are none left, or one
+ * is satisfiable; then it interrupts the others.
+ */
+static void cubeWorker(CubeQueue* queue, unsigned t, unsigned numThreads,
+                       SmtEngine* smts[], Command* seq,
+                       const vector<Expr>* queries) {
+  try {
+    if(seq != NULL) {
+      smtEngineInvoke(smts[t], seq, NULL);
+    }
+    for(;;) {
+      size_t c;
+      {
+        boost::lock_guard<boost::mutex> lock(queue->d_mutex);
+        if(queue->done() || queue->d_interruptPending[t]) {
+          return;
+        }
+        c = queue->d_next++;
+      }
+
+      Result r = smts[t]->checkSat((*queries)[c]);
+      Trace("cubes") << "thread #" << t << ": cube " << c << " is " << r << endl;
+
+      boost::lock_guard<boost::mutex> lock(queue->d_mutex);
+      if(queue->d_winner >= 0) {
+        // interrupted (or too late)
+        return;
+      }
+      if(r.asSatisfiabilityResult().isSat() == Result::SAT) {
+        queue->d_winner = t;
+        break;
+      } else if(r.asSatisfiabilityResult().isSat() == Result::UNSAT) {
+        ++queue->d_refuted;
+      } else if(queue->d_unknown.isNull()) {
+        queue->d_unknown = r;
+        queue->d_unknownThread = t;
+      }
+    }
+  } catch(Exception& e) {
+    boost::lock_guard<boost::mutex> lock(queue->d_mutex);
+    queue->d_failure = e.toString();
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(queue->d_mutex);
+    for(unsigned u = 0; u < numThreads; ++u) {
+      if(u != t) {
+        queue->d_interruptPending[u] = true;
+      }
+    }
+  }
+  for(unsigned u = 0; u < numThreads; ++u) {
+    if(u != t) {
+      try {
+        smts[u]->interrupt();
+      } catch(ModalException& e) {
+        // It's fine, its pending flag stops it before its next cube.
+        Trace("interrupt") << "Could not interrupt thread #" << u << std::endl;
+      }
+    }
+  }
+}/* cubeWorker() */
+
 CommandExecutorPortfolio::CommandExecutorPortfolio
 (ExprManager &exprMgr, Options &options, vector<Options>& tOpts):
   CommandExecutor(exprMgr, options),
@@ -55,13 +161,19 @@ CommandExecutorPortfolio::CommandExecutorPortfolio
   d_channelsIn(),
   d_ostringstreams(),
   d_statLastWinner("portfolio::lastWinner"),
-  d_statWaitTime("portfolio::waitTime")
+  d_statWaitTime("portfolio::waitTime"),
+  d_statSplitTime("portfolio::splitTime"),
+  d_statCubes("portfolio::cubes", 0),
+  d_statCubesRefuted("portfolio::cubesRefuted", 0)
 {
   assert(d_threadOptions.size() == d_numThreads);
 
   d_statLastWinner.setData(d_lastWinner);
   d_stats.registerStat_(&d_statLastWinner);
   d_stats.registerStat_(&d_statWaitTime);
+  d_stats.registerStat_(&d_statSplitTime);
+  d_stats.registerStat_(&d_statCubes);
+  d_stats.registerStat_(&d_statCubesRefuted);
 
   /* Duplication, individualization */
   d_exprMgrs.push_back(&d_exprMgr);
@@ -98,6 +210,9 @@ CommandExecutorPortfolio::~CommandExecutorPortfolio()
 
   d_stats.unregisterStat_(&d_statLastWinner);
   d_stats.unregisterStat_(&d_statWaitTime);
+  d_stats.unregisterStat_(&d_statSplitTime);
+  d_stats.unregisterStat_(&d_statCubes);
+  d_stats.unregisterStat_(&d_statCubesRefuted);
 }
 
 void CommandExecutorPortfolio::lemmaSharingInit()
@@ -196,6 +311,7 @@ bool CommandExecutorPortfolio::doCommandSingleton(Command* cmd)
   // command
 
   if(dynamic_cast<CheckSatCommand*>(cmd) != NULL ||
+     dynamic_cast<CheckSatAssumingCommand*>(cmd) != NULL ||
      dynamic_cast<QueryCommand*>(cmd) != NULL) {
     mode = 1;
   } else if(dynamic_cast<GetValueCommand*>(cmd) != NULL ||
@@ -204,6 +320,7 @@ bool CommandExecutorPortfolio::doCommandSingleton(Command* cmd)
             dynamic_cast<GetProofCommand*>(cmd) != NULL ||
             dynamic_cast<GetInstantiationsCommand*>(cmd) != NULL ||
             dynamic_cast<GetUnsatCoreCommand*>(cmd) != NULL ||
+            dynamic_cast<GetUnsatAssumptionsCommand*>(cmd) != NULL ||
             dynamic_cast<GetAssertionsCommand*>(cmd) != NULL ||
             dynamic_cast<GetInfoCommand*>(cmd) != NULL ||
             dynamic_cast<GetOptionCommand*>(cmd) != NULL ||
@@ -226,6 +343,11 @@ bool CommandExecutorPortfolio::doCommandSingleton(Command* cmd)
     if(d_lastWinner != 0) delete cmdExported;
     return ret;
   } else if(mode == 1) {               // portfolio
+    CheckSatCommand* cs = dynamic_cast<CheckSatCommand*>(cmd);
+    if(d_options[options::cubeAndConquer] && cs != NULL) {
+      return doCubeAndConquer(cs);
+    }
+
     d_seq->addCommand(cmd->clone());
 
     // We currently don't support changing number of threads for each
@@ -361,28 +483,7 @@ bool CommandExecutorPortfolio::doCommandSingleton(Command* cmd)
 
     // dump the model/proof/unsat core if option is set
     if(status) {
-      if( d_options[options::produceModels] &&
-          d_options[options::dumpModels] &&
-          ( d_result.asSatisfiabilityResult() == Result::SAT ||
-            (d_result.isUnknown() && d_result.whyUnknown() == Result::INCOMPLETE) ) ) {
-        Command* gm = new GetModelCommand();
-        status = doCommandSingleton(gm);
-      } else if( d_options[options::proof] &&
-                 d_options[options::dumpProofs] &&
-                 d_result.asSatisfiabilityResult() == Result::UNSAT ) {
-        Command* gp = new GetProofCommand();
-        status = doCommandSingleton(gp);
-      } else if( d_options[options::dumpInstantiations] &&
-                 ( ( d_options[options::instFormatMode]!=INST_FORMAT_MODE_SZS && 
-                   ( d_result.asSatisfiabilityResult() == Result::SAT || (d_result.isUnknown() && d_result.whyUnknown() == Result::INCOMPLETE) ) ) || 
-                 d_result.asSatisfiabilityResult() == Result::UNSAT ) ) {
-        Command* gi = new GetInstantiationsCommand();
-        status = doCommandSingleton(gi);
-      } else if( d_options[options::dumpUnsatCores] &&
-                 d_result.asSatisfiabilityResult() == Result::UNSAT ) {
-        Command* guc = new GetUnsatCoreCommand();
-        status = doCommandSingleton(guc);
-      }
+      status = dumpQueryResult();
     }
 
     return status;
@@ -403,6 +504,181 @@ bool CommandExecutorPortfolio::doCommandSingleton(Command* cmd)
 
 }/* CommandExecutorPortfolio::doCommandSingleton() */
 
+bool CommandExecutorPortfolio::dumpQueryResult()
+{
+  if( d_options[options::produceModels] &&
+      d_options[options::dumpModels] &&
+      ( d_result.asSatisfiabilityResult() == Result::SAT ||
+        (d_result.isUnknown() && d_result.whyUnknown() == Result::INCOMPLETE) ) ) {
+    Command* gm = new GetModelCommand();
+    return doCommandSingleton(gm);
+  } else if( d_options[options::proof] &&
+             d_options[options::dumpProofs] &&
+             d_result.asSatisfiabilityResult() == Result::UNSAT ) {
+    Command* gp = new GetProofCommand();
+    return doCommandSingleton(gp);
+  } else if( d_options[options::dumpInstantiations] &&
+             ( ( d_options[options::instFormatMode]!=INST_FORMAT_MODE_SZS && 
+               ( d_result.asSatisfiabilityResult() == Result::SAT || (d_result.isUnknown() && d_result.whyUnknown() == Result::INCOMPLETE) ) ) || 
+             d_result.asSatisfiabilityResult() == Result::UNSAT ) ) {
+    Command* gi = new GetInstantiationsCommand();
+    return doCommandSingleton(gi);
+  } else if( d_options[options::dumpUnsatCores] &&
+             d_result.asSatisfiabilityResult() == Result::UNSAT ) {
+    Command* guc = new GetUnsatCoreCommand();
+    return doCommandSingleton(guc);
+  }
+  return true;
+}/* CommandExecutorPortfolio::dumpQueryResult() */
+
+bool CommandExecutorPortfolio::doCubeAndConquer(CheckSatCommand* cmd)
+{
+  /**
+   * Each thread catches up on the commands since the last check-sat
+   * (see mode 0 in doCommandSingleton()).  Thread #0 searches first,
+   * with a resource limit, to find the atoms to split on (unless that
+   * settles the query).  The query is then split into the cubes over
+   * those atoms (all of their sign combinations), and the threads
+   * take the cubes from a shared queue as they become idle, until one
+   * cube is satisfiable (sat) or all are refuted (unsat).
+   */
+
+  Command* seqs[d_numThreads];
+  for(unsigned i = 0; i < d_numThreads; ++i) {
+    seqs[i] = NULL;
+  }
+
+  vector< vector<Expr> > queries(d_numThreads);
+  size_t numCubes = 0;
+  Result splitResult;
+
+  try {
+    for(unsigned i = 0; i < d_numThreads; ++i) {
+      if(int(i) != d_lastWinner) {
+        seqs[i] = i == 0 ? d_seq : d_seq->exportTo(d_exprMgrs[i], *(d_vmaps[i]));
+      }
+    }
+
+    vector<Expr> atoms;
+    {
+      CodeTimer splitTimer(d_statSplitTime);
+
+      if(seqs[0] != NULL) {
+        smtEngineInvoke(d_smts[0], seqs[0], NULL);
+        seqs[0] = NULL;
+      }
+      d_smts[0]->setResourceLimit(d_threadOptions[0][options::cubeSplitResourceLimit]);
+      splitResult = d_smts[0]->checkSat(cmd->getExpr());
+      d_smts[0]->setResourceLimit(d_threadOptions[0][options::perCallResourceLimit]);
+
+      if(splitResult.isUnknown() &&
+         splitResult.whyUnknown() == Result::RESOURCEOUT) {
+        unsigned depth = 0;
+        unsigned wanted = d_options[options::cubes] > 0 ?
+          d_options[options::cubes] : 4 * d_numThreads;
+        while((1u << depth) < wanted && depth < 30) {
+          ++depth;
+        }
+        // (twice as many, in case some can't be exported)
+        atoms = d_smts[0]->getSplitAtoms(2 * depth);
+        if(atoms.size() > depth) {
+          atoms.resize(depth);
+        }
+      }
+    }
+
+    if(splitResult.isUnknown() &&
+       splitResult.whyUnknown() == Result::RESOURCEOUT) {
+      numCubes = size_t(1) << atoms.size();
+      for(unsigned i = 0; i < d_numThreads; ++i) {
+        ExprManager* em = d_exprMgrs[i];
+        vector<Expr> threadAtoms;
+        for(unsigned j = 0; j < atoms.size(); ++j) {
+          threadAtoms.push_back(i == 0 ? atoms[j] : atoms[j].exportTo(em, *(d_vmaps[i])));
+        }
+        Expr threadExpr = cmd->getExpr();
+        if(i != 0 && !threadExpr.isNull()) {
+          threadExpr = threadExpr.exportTo(em, *(d_vmaps[i]));
+        }
+        for(size_t c = 0; c < numCubes; ++c) {
+          vector<Expr> lits;
+          for(unsigned j = 0; j < threadAtoms.size(); ++j) {
+            lits.push_back(((c >> j) & 1) != 0 ? threadAtoms[j] :
+                           em->mkExpr(kind::NOT, threadAtoms[j]));
+          }
+          if(!threadExpr.isNull()) {
+            lits.push_back(threadExpr);
+          }
+          queries[i].push_back(lits.empty() ? em->mkConst(true) :
+                               lits.size() == 1 ? lits[0] :
+                               em->mkExpr(kind::AND, lits));
+        }
+      }
+    }
+  } catch(ExportUnsupportedException& e) {
+    for(unsigned i = 1; i < d_numThreads; ++i) {
+      delete seqs[i];
+    }
+    if(d_options[options::fallbackSequential]) {
+      Notice() << "Unsupported theory encountered, switching to sequential mode.";
+      return CommandExecutor::doCommandSingleton(cmd);
+    }
+    else
+      throw Exception("Certain theories (e.g., datatypes) are (currently) unsupported in portfolio\n"
+                      "mode. Please see option --fallback-sequential to make this a soft error.");
+  }
+
+  Debug("cubes") << "cube-and-conquer: " << numCubes << " cubes, split result "
+                 << splitResult << std::endl;
+
+  /* Conquer (the threads catch up even if there are no cubes) */
+  CubeQueue queue(numCubes, d_numThreads);
+  boost::function<void()>* fns = new boost::function<void()>[d_numThreads];
+  for(unsigned i = 0; i < d_numThreads; ++i) {
+    fns[i] = boost::bind(cubeWorker, &queue, i, d_numThreads, &d_smts[0],
+                         seqs[i], &queries[i]);
+  }
+
+  size_t threadStackSize = d_options[options::threadStackSize];
+  threadStackSize *= 1024 * 1024;
+
+  runWorkers(d_numThreads, fns, threadStackSize);
+
+  delete[] fns;
+  for(unsigned i = 1; i < d_numThreads; ++i) {
+    delete seqs[i];
+  }
+  delete d_seq;
+  d_seq = new CommandSequence();
+
+  d_statCubes += numCubes;
+  d_statCubesRefuted += queue.d_refuted;
+
+  if(!queue.d_failure.empty()) {
+    throw Exception(queue.d_failure);
+  }
+
+  if(numCubes == 0) {
+    d_lastWinner = 0;
+    d_result = splitResult;
+  } else if(queue.d_winner >= 0) {
+    d_lastWinner = queue.d_winner;
+    d_result = d_smts[d_lastWinner]->getStatusOfLastCommand();
+  } else if(queue.d_refuted == numCubes) {
+    d_lastWinner = 0;
+    d_result = Result(Result::UNSAT, splitResult.getInputName());
+  } else {
+    d_lastWinner = queue.d_unknownThread;
+    d_result = queue.d_unknown;
+  }
+
+  if(d_options[options::verbosity] >= -1) {
+    *d_options[options::out] << d_result << endl;
+  }
+
+  return dumpQueryResult();
+}/* CommandExecutorPortfolio::doCubeAndConquer() */
+
 void CommandExecutorPortfolio::flushStatistics(std::ostream& out) const {
   assert(d_numThreads == d_exprMgrs.size() && d_exprMgrs.size() == d_smts.size());
   for(size_t i = 0; i < d_numThreads; ++i) {
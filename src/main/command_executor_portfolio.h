@@ -12,7 +12,8 @@
  ** \brief An additional layer between commands and invoking them.
  **
  ** The portfolio executer branches check-sat queries to several
- ** threads.
+ ** threads.  It either races them on the whole query, or (with
+ ** --cube-and-conquer) splits the query into cubes that they share.
  **/
 
 #ifndef __CVC4__MAIN__COMMAND_EXECUTOR_PORTFOLIO_H
@@ -29,6 +30,7 @@
 namespace CVC4 {
 
 class CommandSequence;
+class CheckSatCommand;
 
 namespace main {
 
@@ -53,6 +55,9 @@ class CommandExecutorPortfolio : public CommandExecutor {
   // Stats
   ReferenceStat<int> d_statLastWinner;
   TimerStat d_statWaitTime;
+  TimerStat d_statSplitTime;
+  IntStat d_statCubes;
+  IntStat d_statCubesRefuted;
 
 public:
   CommandExecutorPortfolio(ExprManager &exprMgr,
@@ -71,6 +76,8 @@ private:
   CommandExecutorPortfolio();
   void lemmaSharingInit();
   void lemmaSharingCleanup();
+  bool doCubeAndConquer(CheckSatCommand* cmd);
+  bool dumpQueryResult();
 };/* class CommandExecutorPortfolio */
 
 }/* CVC4::main namespace */
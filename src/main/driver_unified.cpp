@@ -32,6 +32,7 @@
 #include "parser/parser_exception.h"
 #include "expr/expr_manager.h"
 #include "expr/command.h"
+#include "expr/snapshot.h"
 #include "util/configuration.h"
 #include "options/options.h"
 #include "main/command_executor.h"
@@ -135,6 +136,7 @@ int runCvc4(int argc, char* argv[], Options& opts) {
 # ifndef PORTFOLIO_BUILD
   if( opts.wasSetByUser(options::threads) ||
       opts.wasSetByUser(options::threadStackSize) ||
+      opts.wasSetByUser(options::cubeAndConquer) ||
       ! opts[options::threadArgv].empty() ) {
     throw OptionException("Thread options cannot be used with sequential CVC4.  Please build and use the portfolio binary `pcvc4'.");
   }
@@ -142,6 +144,10 @@ int runCvc4(int argc, char* argv[], Options& opts) {
   if( opts[options::checkProofs] ) {
     throw OptionException("Cannot run portfolio in check-proofs mode.");
   }
+  if( opts[options::cubeAndConquer] &&
+      ( opts[options::proof] || opts[options::unsatCores] ) ) {
+    throw OptionException("Cannot produce proofs or unsat cores in cube-and-conquer mode.");
+  }
 # endif
 
   progName = opts[options::binary_name].c_str();
@@ -202,6 +208,19 @@ int runCvc4(int argc, char* argv[], Options& opts) {
     }
   }
 
+  // A snapshot records the language it was parsed from; carry on as
+  // if reading that, so that output (and language-dependent
+  // behavior) is the same as for the original input.
+  expr::pickle::Snapshot* snapshot = NULL;
+  if(opts[options::inputLanguage] == language::input::LANG_BINARY) {
+    if(opts[options::tearDownIncremental]) {
+      throw OptionException("--tear-down-incremental doesn't work with --lang=binary");
+    }
+    snapshot = new expr::pickle::Snapshot(inputFromStdin ? "-" : filenames[0]);
+    opts.set(options::inputLanguage, snapshot->getInputLanguage());
+    opts.set(options::interactive, false);
+  }
+
   if(opts[options::outputLanguage] == language::output::LANG_AUTO) {
     opts.set(options::outputLanguage, language::toOutputLanguage(opts[options::inputLanguage]));
   }
@@ -268,7 +287,28 @@ int runCvc4(int argc, char* argv[], Options& opts) {
     // Parse and execute commands until we are done
     Command* cmd;
     bool status = true;
-    if(opts[options::interactive] && inputFromStdin) {
+    if(opts[options::outputLanguage] == language::output::LANG_BINARY) {
+      // Don't solve; just write the problem out for later reloading
+      // with --lang=binary.
+      CommandSequence* commands;
+      if(snapshot != NULL) {
+        commands = snapshot->load(exprMgr);
+      } else {
+        ParserBuilder parserBuilder(exprMgr, filename, opts);
+        if( inputFromStdin ) {
+          parserBuilder.withStreamInput(cin);
+        }
+        Parser *parser = parserBuilder.build();
+        commands = new CommandSequence();
+        while((cmd = parser->nextCommand()) != NULL) {
+          commands->addCommand(cmd);
+        }
+        delete parser;
+      }
+      expr::pickle::Snapshot::write(*opts[options::out], exprMgr, *commands,
+                                    opts[options::inputLanguage]);
+      delete commands;
+    } else if(opts[options::interactive] && inputFromStdin) {
       if(opts[options::tearDownIncremental]) {
         throw OptionException("--tear-down-incremental doesn't work in interactive mode");
       }
@@ -397,6 +437,7 @@ int runCvc4(int argc, char* argv[], Options& opts) {
           if (interrupted) continue;
           *opts[options::out] << CommandSuccess();
         } else if(dynamic_cast<CheckSatCommand*>(cmd) != NULL ||
+                  dynamic_cast<CheckSatAssumingCommand*>(cmd) != NULL ||
                   dynamic_cast<QueryCommand*>(cmd) != NULL) {
           if(needReset) {
             pExecutor->reset();
@@ -431,6 +472,7 @@ int runCvc4(int argc, char* argv[], Options& opts) {
           // an error on replay since there's no associated sat/unsat check
           // preceding them.
           if(dynamic_cast<GetUnsatCoreCommand*>(cmd) == NULL &&
+             dynamic_cast<GetUnsatAssumptionsCommand*>(cmd) == NULL &&
              dynamic_cast<GetProofCommand*>(cmd) == NULL &&
              dynamic_cast<GetValueCommand*>(cmd) == NULL &&
              dynamic_cast<GetModelCommand*>(cmd) == NULL &&
@@ -465,20 +507,27 @@ int runCvc4(int argc, char* argv[], Options& opts) {
         delete cmd;
       }
 
-      ParserBuilder parserBuilder(exprMgr, filename, opts);
+      Parser *parser = NULL;
+      if(snapshot != NULL) {
+        // the whole problem, already type checked; commands are handed
+        // out below one at a time, as the parser would
+        snapshot->start(exprMgr);
+      } else {
+        ParserBuilder parserBuilder(exprMgr, filename, opts);
 
-      if( inputFromStdin ) {
+        if( inputFromStdin ) {
 #if defined(CVC4_COMPETITION_MODE) && !defined(CVC4_SMTCOMP_APPLICATION_TRACK)
-        parserBuilder.withStreamInput(cin);
+          parserBuilder.withStreamInput(cin);
 #else /* CVC4_COMPETITION_MODE && !CVC4_SMTCOMP_APPLICATION_TRACK */
-        parserBuilder.withLineBufferedStreamInput(cin);
+          parserBuilder.withLineBufferedStreamInput(cin);
 #endif /* CVC4_COMPETITION_MODE && !CVC4_SMTCOMP_APPLICATION_TRACK */
-      }
+        }
 
-      Parser *parser = parserBuilder.build();
-      if(replayParser != NULL) {
-        // have the replay parser use the file's declarations
-        replayParser->useDeclarationsFrom(parser);
+        parser = parserBuilder.build();
+        if(replayParser != NULL) {
+          // have the replay parser use the file's declarations
+          replayParser->useDeclarationsFrom(parser);
+        }
       }
       bool interrupted = false;
       while(status || opts[options::continuedExecution]) {
@@ -488,7 +537,11 @@ int runCvc4(int argc, char* argv[], Options& opts) {
           break;
         }
         try {
-          cmd = parser->nextCommand();
+          if(snapshot != NULL) {
+            cmd = snapshot->nextCommand();
+          } else {
+            cmd = parser->nextCommand();
+          }
           if (cmd == NULL) break;
         } catch (UnsafeInterruptException& e) {
           interrupted = true;
@@ -575,6 +628,7 @@ int runCvc4(int argc, char* argv[], Options& opts) {
   // need to be around in that case for main() to print statistics.
   delete pTotalTime;
   delete pExecutor;
+  delete snapshot;
   delete exprMgr;
 
   pTotalTime = NULL;
@@ -38,6 +38,37 @@ boost::condition_variable condition_var_main_wait;
 bool global_flag_done;
 int global_winner;
 
+/** Starts fn in thread, with the given stack size (if nonzero) */
+static void startThread(boost::thread& thread, int thread_id,
+                        boost::function<void()> fn, size_t stackSize) {
+#if BOOST_HAS_THREAD_ATTR
+  boost::thread::attributes attrs;
+
+  if(stackSize > 0) {
+    attrs.set_stack_size(stackSize);
+  }
+
+  thread = boost::thread(attrs, fn);
+#else /* BOOST_HAS_THREAD_ATTR */
+  if(stackSize > 0) {
+    throw OptionException("cannot specify a stack size for worker threads; requires CVC4 to be built with Boost thread library >= 1.50.0");
+  }
+
+  thread = boost::thread(fn);
+#endif /* BOOST_HAS_THREAD_ATTR */
+
+#if defined(BOOST_THREAD_PLATFORM_PTHREAD)
+  if(Chat.isOn()) {
+    void *stackaddr;
+    size_t stacksize;
+    pthread_attr_t attr;
+    pthread_getattr_np(thread.native_handle(), &attr);
+    pthread_attr_getstack(&attr, &stackaddr, &stacksize);
+    Chat() << "Created worker thread " << thread_id << " with stack size " << stacksize << std::endl;
+  }
+#endif
+}
+
 template<typename S>
 void runThread(int thread_id, boost::function<S()> threadFn, S& returnValue)
 {
@@ -74,38 +105,10 @@ std::pair<int, S> runPortfolio(int numThreads,
   global_winner = -1;
 
   for(int t = 0; t < numThreads; ++t) {
-
-#if BOOST_HAS_THREAD_ATTR
-    boost::thread::attributes attrs;
-
-    if(stackSize > 0) {
-      attrs.set_stack_size(stackSize);
-    }
-
-    threads[t] =
-      boost::thread(attrs, boost::bind(runThread<S>, t, threadFns[t],
-                                       boost::ref(threads_returnValue[t]) ) );
-#else /* BOOST_HAS_THREAD_ATTR */
-    if(stackSize > 0) {
-      throw OptionException("cannot specify a stack size for worker threads; requires CVC4 to be built with Boost thread library >= 1.50.0");
-    }
-
-    threads[t] =
-      boost::thread(boost::bind(runThread<S>, t, threadFns[t],
-                                boost::ref(threads_returnValue[t]) ) );
-
-#endif /* BOOST_HAS_THREAD_ATTR */
-
-#if defined(BOOST_THREAD_PLATFORM_PTHREAD)
-    if(Chat.isOn()) {
-      void *stackaddr;
-      size_t stacksize;
-      pthread_attr_t attr;
-      pthread_getattr_np(threads[t].native_handle(), &attr);
-      pthread_attr_getstack(&attr, &stackaddr, &stacksize);
-      Chat() << "Created worker thread " << t << " with stack size " << stacksize << std::endl;
-    }
-#endif
+    startThread(threads[t], t,
+                boost::bind(runThread<S>, t, threadFns[t],
+                            boost::ref(threads_returnValue[t])),
+                stackSize);
   }
 
   if(not driverFn.empty())
@@ -137,6 +140,22 @@ std::pair<int, S> runPortfolio(int numThreads,
   return retval;
 }
 
+void runWorkers(int numThreads,
+                boost::function<void()> threadFns[],
+                size_t stackSize) {
+  boost::thread* threads = new boost::thread[numThreads];
+
+  for(int t = 0; t < numThreads; ++t) {
+    startThread(threads[t], t, threadFns[t], stackSize);
+  }
+
+  for(int t = 0; t < numThreads; ++t) {
+    threads[t].join();
+  }
+
+  delete[] threads;
+}
+
 // instantiation
 template
 std::pair<int, bool>
@@ -36,6 +36,15 @@ std::pair<int, S> runPortfolio(int numThreads,
 // as we have defined things, S=void would give compile errors
 // do we want to fix this? yes, no, maybe?
 
+/**
+ * Runs each of the threadFns in its own thread and waits for all of
+ * them to finish.  Unlike in runPortfolio(), no thread wins; they
+ * coordinate among themselves (e.g., by sharing work).
+ */
+void runWorkers(int numThreads,
+                boost::function<void()> threadFns[],
+                size_t stackSize);
+
 }/* CVC4 namespace */
 
 #endif /* __CVC4__PORTFOLIO_H */
@@ -37,6 +37,11 @@ vector<Options> parseThreadSpecificOptions(Options opts)
     // Set thread identifier
     tOpts.set(options::thread_id, i);
 
+    // With cube-and-conquer, each thread solves several cubes per query
+    if(opts[options::cubeAndConquer]) {
+      tOpts.set(options::incrementalSolving, true);
+    }
+
     if(i < opts[options::threadArgv].size() && 
        !opts[options::threadArgv][i].empty()) {
 
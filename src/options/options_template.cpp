@@ -265,6 +265,7 @@ Languages currently supported as arguments to the -L / --lang option:\n\
     smt2.0 | smtlib2 | smtlib2.0 SMT-LIB format 2.0\n\
   smt2.5 | smtlib2.5             SMT-LIB format 2.5\n\
   tptp                           TPTP format (cnf and fof)\n\
+  binary                         snapshot written with --output-lang=binary\n\
 \n\
 Languages currently supported as arguments to the --output-lang option:\n\
   auto                           match output language to input language\n\
@@ -276,6 +277,8 @@ Languages currently supported as arguments to the --output-lang option:\n\
   smt2.5 | smtlib2.5             SMT-LIB format 2.5\n\
   z3str                          SMT-LIB 2.0 with Z3-str string constraints\n\
   tptp                           TPTP format\n\
+  binary                         binary snapshot of the parsed input, for\n\
+                                   fast reloading with --lang=binary\n\
   ast                            internal format (simple syntax trees)\n\
 ";
 
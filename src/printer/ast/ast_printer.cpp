@@ -139,6 +139,8 @@ void AstPrinter::toStream(std::ostream& out, const Command* c,
      tryToStream<PushCommand>(out, c) ||
      tryToStream<PopCommand>(out, c) ||
      tryToStream<CheckSatCommand>(out, c) ||
+     tryToStream<CheckSatAssumingCommand>(out, c) ||
+     tryToStream<GetUnsatAssumptionsCommand>(out, c) ||
      tryToStream<QueryCommand>(out, c) ||
      tryToStream<ResetCommand>(out, c) ||
      tryToStream<ResetAssertionsCommand>(out, c) ||
@@ -223,6 +225,17 @@ static void toStream(std::ostream& out, const CheckSatCommand* c) throw() {
   }
 }
 
+static void toStream(std::ostream& out, const CheckSatAssumingCommand* c) throw() {
+  const vector<Expr>& assumptions = c->getAssumptions();
+  out << "CheckSatAssuming(";
+  copy(assumptions.begin(), assumptions.end(), ostream_iterator<Expr>(out, ", "));
+  out << ")";
+}
+
+static void toStream(std::ostream& out, const GetUnsatAssumptionsCommand* c) throw() {
+  out << "GetUnsatAssumptions()";
+}
+
 static void toStream(std::ostream& out, const QueryCommand* c) throw() {
   out << "Query(" << c->getExpr() << ')';
 }
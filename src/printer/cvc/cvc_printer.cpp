@@ -858,6 +858,7 @@ void CvcPrinter::toStream(std::ostream& out, const Command* c,
      tryToStream<PushCommand>(out, c, d_cvc3Mode) ||
      tryToStream<PopCommand>(out, c, d_cvc3Mode) ||
      tryToStream<CheckSatCommand>(out, c, d_cvc3Mode) ||
+     tryToStream<CheckSatAssumingCommand>(out, c, d_cvc3Mode) ||
      tryToStream<QueryCommand>(out, c, d_cvc3Mode) ||
      tryToStream<ResetCommand>(out, c, d_cvc3Mode) ||
      tryToStream<ResetAssertionsCommand>(out, c, d_cvc3Mode) ||
@@ -876,6 +877,7 @@ void CvcPrinter::toStream(std::ostream& out, const Command* c,
      tryToStream<GetAssertionsCommand>(out, c, d_cvc3Mode) ||
      tryToStream<GetProofCommand>(out, c, d_cvc3Mode) ||
      tryToStream<GetUnsatCoreCommand>(out, c, d_cvc3Mode) ||
+     tryToStream<GetUnsatAssumptionsCommand>(out, c, d_cvc3Mode) ||
      tryToStream<SetBenchmarkStatusCommand>(out, c, d_cvc3Mode) ||
      tryToStream<SetBenchmarkLogicCommand>(out, c, d_cvc3Mode) ||
      tryToStream<SetInfoCommand>(out, c, d_cvc3Mode) ||
@@ -1034,6 +1036,28 @@ static void toStream(std::ostream& out, const CheckSatCommand* c, bool cvc3Mode)
   }
 }
 
+static void toStream(std::ostream& out, const CheckSatAssumingCommand* c, bool cvc3Mode) throw() {
+  const vector<Expr>& assumptions = c->getAssumptions();
+  if(cvc3Mode) {
+    out << "PUSH; ";
+  }
+  if(assumptions.empty()) {
+    out << "CHECKSAT;";
+  } else {
+    out << "CHECKSAT ";
+    for(unsigned i = 0; i < assumptions.size(); ++i) {
+      if(i > 0) {
+        out << " AND ";
+      }
+      out << "(" << assumptions[i] << ")";
+    }
+    out << ";";
+  }
+  if(cvc3Mode) {
+    out << " POP;";
+  }
+}
+
 static void toStream(std::ostream& out, const QueryCommand* c, bool cvc3Mode) throw() {
   Expr e = c->getExpr();
   if(cvc3Mode) {
@@ -1160,6 +1184,10 @@ static void toStream(std::ostream& out, const GetUnsatCoreCommand* c, bool cvc3M
   out << "DUMP_UNSAT_CORE;";
 }
 
+static void toStream(std::ostream& out, const GetUnsatAssumptionsCommand* c, bool cvc3Mode) throw() {
+  out << "% (get-unsat-assumptions)";
+}
+
 static void toStream(std::ostream& out, const SetBenchmarkStatusCommand* c, bool cvc3Mode) throw() {
   out << "% (set-info :status " << c->getStatus() << ")";
 }
@@ -56,6 +56,8 @@ Printer* Printer::makePrinter(OutputLanguage lang) throw() {
     return new printer::smt2::Smt2Printer(printer::smt2::z3str_variant);
 
   case LANG_AST:
+  case LANG_BINARY: // snapshots are written by the driver; anything
+                    // else printed while writing one is diagnostic
     return new printer::ast::AstPrinter();
 
   case LANG_CVC3:
@@ -718,6 +718,7 @@ void Smt2Printer::toStream(std::ostream& out, const Command* c,
      tryToStream<PushCommand>(out, c) ||
      tryToStream<PopCommand>(out, c) ||
      tryToStream<CheckSatCommand>(out, c) ||
+     tryToStream<CheckSatAssumingCommand>(out, c) ||
      tryToStream<QueryCommand>(out, c) ||
      tryToStream<ResetCommand>(out, c) ||
      tryToStream<ResetAssertionsCommand>(out, c) ||
@@ -736,6 +737,7 @@ void Smt2Printer::toStream(std::ostream& out, const Command* c,
      tryToStream<GetAssertionsCommand>(out, c) ||
      tryToStream<GetProofCommand>(out, c) ||
      tryToStream<GetUnsatCoreCommand>(out, c) ||
+     tryToStream<GetUnsatAssumptionsCommand>(out, c) ||
      tryToStream<SetBenchmarkStatusCommand>(out, c, d_variant) ||
      tryToStream<SetBenchmarkLogicCommand>(out, c, d_variant) ||
      tryToStream<SetInfoCommand>(out, c, d_variant) ||
@@ -951,6 +953,13 @@ static void toStream(std::ostream& out, const CheckSatCommand* c) throw() {
   }
 }
 
+static void toStream(std::ostream& out, const CheckSatAssumingCommand* c) throw() {
+  out << "(check-sat-assuming ( ";
+  const vector<Expr>& assumptions = c->getAssumptions();
+  copy(assumptions.begin(), assumptions.end(), ostream_iterator<Expr>(out, " "));
+  out << "))";
+}
+
 static void toStream(std::ostream& out, const QueryCommand* c) throw() {
   Expr e = c->getExpr();
   if(!e.isNull()) {
@@ -1092,6 +1101,10 @@ static void toStream(std::ostream& out, const GetUnsatCoreCommand* c) throw() {
   out << "(get-unsat-core)";
 }
 
+static void toStream(std::ostream& out, const GetUnsatAssumptionsCommand* c) throw() {
+  out << "(get-unsat-assumptions)";
+}
+
 static void toStream(std::ostream& out, const SetBenchmarkStatusCommand* c, Variant v) throw() {
   if(v == z3str_variant || v == smt2_0_variant) {
     out << "(set-info :status " << c->getStatus() << ")";
@@ -0,0 +1,56 @@
+/*********************                                                        */
+/*! \file drat_stream.cpp
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A stream of the SAT solver's clause additions and deletions
+ ** in binary DRAT format
+ **
+ ** A stream of the SAT solver's clause additions and deletions in
+ ** binary DRAT format.
+ **/
+
+#include "proof/drat_stream.h"
+#include "util/cvc4_assert.h"
+
+namespace CVC4 {
+
+DratStream::DratStream(std::ostream* out) :
+  d_out(out),
+  d_records(0) {
+  Assert(out != NULL);
+}
+
+void DratStream::writeLit(::Minisat::Lit lit) {
+  uint64_t n = 2 * (uint64_t(::Minisat::var(lit)) + 1) + (::Minisat::sign(lit) ? 1 : 0);
+  while(n > 0x7f) {
+    d_out->put(char(0x80 | (n & 0x7f)));
+    n >>= 7;
+  }
+  d_out->put(char(n));
+}
+
+void DratStream::write(Kind kind, ::Minisat::Lit lit) {
+  d_out->put(char(kind));
+  writeLit(lit);
+  d_out->put(0);
+  ++d_records;
+}
+
+void DratStream::writeEmpty(Kind kind) {
+  d_out->put(char(kind));
+  d_out->put(0);
+  ++d_records;
+}
+
+void DratStream::flush() {
+  d_out->flush();
+}
+
+}/* CVC4 namespace */
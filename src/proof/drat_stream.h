@@ -0,0 +1,108 @@
+/*********************                                                        */
+/*! \file drat_stream.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief A stream of the SAT solver's clause additions and deletions
+ ** in binary DRAT format
+ **
+ ** A stream of the SAT solver's clause additions and deletions in
+ ** binary DRAT format, written as the search goes, so that nothing
+ ** needs to be kept in memory (unlike the resolution proofs of
+ ** SatProof).
+ **/
+
+#include "cvc4_private.h"
+
+#ifndef __CVC4__PROOF__DRAT_STREAM_H
+#define __CVC4__PROOF__DRAT_STREAM_H
+
+#include <iostream>
+#include <stdint.h>
+
+#include "prop/minisat/core/SolverTypes.h"
+
+namespace CVC4 {
+
+/**
+ * Writes the clauses the SAT solver adds and deletes, one record
+ * each, in binary DRAT format: a record is a byte for its kind, then
+ * the literals, each as the unsigned integer 2 * (var + 1) + sign
+ * (with the least significant 7 bits in each byte first, the high bit
+ * set in all but the last), then a zero byte.
+ *
+ * Besides DRAT's additions ('a', which must be implied by unit
+ * propagation, or be a resolution asymmetric tautology) and deletions
+ * ('d'), there are records for the clauses the Boolean skeleton takes
+ * as given: input clauses ('i'), and theory lemmas ('t'), including
+ * the explanations of theory propagations.  A checker adds those to
+ * the formula as they come, so that the stream also certifies
+ * incremental runs: the clauses of a popped user level are deleted,
+ * each unsat answer adds the empty clause, and the pop that lifts it
+ * deletes it.
+ */
+class DratStream {
+public:
+
+  /** The kinds of records */
+  enum Kind {
+    ADD = 'a',
+    DELETE = 'd',
+    INPUT = 'i',
+    THEORY_LEMMA = 't'
+  };/* enum DratStream::Kind */
+
+private:
+
+  std::ostream* d_out;
+
+  uint64_t d_records;
+
+  // disable copy, assignment
+  DratStream(const DratStream&) CVC4_UNDEFINED;
+  DratStream& operator=(const DratStream&) CVC4_UNDEFINED;
+
+  void writeLit(::Minisat::Lit lit);
+
+public:
+
+  /** Writes to out, which must be open in binary mode */
+  DratStream(std::ostream* out);
+
+  /** Writes a record for the clause of the given literals */
+  template <class Lits>
+  void write(Kind kind, const Lits& lits) {
+    d_out->put(char(kind));
+    for(int i = 0; i < lits.size(); ++i) {
+      writeLit(lits[i]);
+    }
+    d_out->put(0);
+    ++d_records;
+  }
+
+  /** Writes a record for the unit clause lit */
+  void write(Kind kind, ::Minisat::Lit lit);
+
+  /** Writes a record for the empty clause */
+  void writeEmpty(Kind kind);
+
+  /**
+   * Flushes the underlying stream (e.g., at the end of a search, so
+   * that a checker reading from a pipe gets the whole certificate)
+   */
+  void flush();
+
+  /** Returns the number of records written */
+  uint64_t getRecords() const { return d_records; }
+
+};/* class DratStream */
+
+}/* CVC4 namespace */
+
+#endif /* __CVC4__PROOF__DRAT_STREAM_H */
@@ -239,6 +239,8 @@ protected:
     double              var_inc;          // Amount to bump next variable with.
     OccLists<Lit, vec<Watcher>, WatcherDeleted>
                         watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    OccLists<Lit, vec<Watcher>, WatcherDeleted>
+                        watches_bin;      // 'watches_bin[lit]' is the same, for binary clauses, with the other literal as blocker.
     vec<lbool>          assigns;          // The current assignments.
     vec<char>           polarity;         // The preferred polarity of each variable.
     vec<char>           marker;           // Is the variable a marker literal
@@ -313,6 +315,7 @@ protected:
     void     detachClause     (CRef cr, bool strict = false); // Detach a clause to watcher lists.
     void     removeClause     (CRef cr);               // Detach and free a clause.
     bool     locked           (const Clause& c) const; // Returns TRUE if a clause is a reason for some implication in the current state.
+    Lit      implied          (const Clause& c) const; // The literal a clause implies, if it's a reason (see 'propagate()').
     bool     satisfied        (const Clause& c) const; // Returns TRUE if a clause is satisfied in the current state.
 
     void     relocAll         (ClauseAllocator& to);
@@ -321,7 +324,7 @@ protected:
     //
     int      decisionLevel    ()      const; // Gives the current decisionlevel.
     uint32_t abstractLevel    (Var x) const; // Used to represent an abstraction of sets of decision levels.
-    CRef     reason           (Var x) const;
+    CRef     reason           (Var x);
     int      level            (Var x) const;
     double   progressEstimate ()      const; // DELETE THIS ?? IT'S NOT VERY USEFUL ...
     bool     withinBudget     ()      const;
@@ -345,7 +348,18 @@ protected:
 //=================================================================================================
 // Implementation of inline methods:
 
-inline CRef Solver::reason(Var x) const { assert(x < vardata.size()); return vardata[x].reason; }
+inline CRef Solver::reason(Var x) {
+    assert(x < vardata.size());
+    CRef r = vardata[x].reason;
+    if (r != CRef_Undef) {
+        // Binary clauses aren't reordered when they propagate (see 'propagate()'), so put the
+        // propagated literal first, where analysis expects it (unless the clause has been
+        // relocated, and its first literal overwritten)
+        Clause& c = ca[r];
+        if (c.size() == 2 && !c.reloced() && var(c[0]) != x) {
+            Lit tmp = c[0]; c[0] = c[1]; c[1] = tmp; }
+    }
+    return r; }
 inline int  Solver::level (Var x) const { assert(x < vardata.size()); return vardata[x].level; }
 
 inline void Solver::insertVarOrder(Var x) {
@@ -384,7 +398,9 @@ inline bool     Solver::addEmptyClause  ()                      { add_tmp.clear(
 inline bool     Solver::addClause       (Lit p)                 { add_tmp.clear(); add_tmp.push(p); return addClause_(add_tmp); }
 inline bool     Solver::addClause       (Lit p, Lit q)          { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); return addClause_(add_tmp); }
 inline bool     Solver::addClause       (Lit p, Lit q, Lit r)   { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); add_tmp.push(r); return addClause_(add_tmp); }
-inline bool     Solver::locked          (const Clause& c) const { return value(c[0]) == l_True && reason(var(c[0])) != CRef_Undef && ca.lea(reason(var(c[0]))) == &c; }
+inline bool     Solver::locked          (const Clause& c) const { Lit p = implied(c); return value(p) == l_True && vardata[var(p)].reason != CRef_Undef && ca.lea(vardata[var(p)].reason) == &c; }
+// Binary clauses propagate without being reordered, so one that implies c[1] has c[0] false
+inline Lit      Solver::implied         (const Clause& c) const { return c.size() == 2 && value(c[0]) != l_True ? c[1] : c[0]; }
 inline void     Solver::newDecisionLevel()                      { trail_lim.push(trail.size()); }
 
 inline int      Solver::decisionLevel ()      const   { return trail_lim.size(); }
@@ -30,6 +30,7 @@
 #include "proof/proof_manager.h"
 #include "proof/sat_proof.h"
 #include "prop/minisat/minisat.h"
+#include "prop/options.h"
 #include "smt/smt_engine_scope.h"
 #include <queue>
 
@@ -57,7 +58,10 @@ CnfStream::CnfStream(SatSolver *satSolver, Registrar* registrar, context::Contex
 }
 
 TseitinCnfStream::TseitinCnfStream(SatSolver* satSolver, Registrar* registrar, context::Context* context, bool fullLitToNodeMap) :
-  CnfStream(satSolver, registrar, context, fullLitToNodeMap) {
+  CnfStream(satSolver, registrar, context, fullLitToNodeMap),
+  // proofs are built from the full definitions
+  d_polarityAware(options::cnfPolarity() && !options::proof()),
+  d_definedLiterals(context) {
 }
 
 void CnfStream::assertClause(TNode node, SatClause& c) {
@@ -100,8 +104,7 @@ void CnfStream::assertClause(TNode node, SatLiteral a, SatLiteral b, SatLiteral
 }
 
 bool CnfStream::hasLiteral(TNode n) const {
-  NodeToLiteralMap::const_iterator find = d_nodeToLiteralMap.find(n);
-  return find != d_nodeToLiteralMap.end();
+  return d_nodeToLiteralMap.contains(n);
 }
 
 void TseitinCnfStream::ensureLiteral(TNode n) {
@@ -112,6 +115,10 @@ void TseitinCnfStream::ensureLiteral(TNode n) {
   Debug("cnf") << "ensureLiteral(" << n << ")" << endl;
   if(hasLiteral(n)) {
     SatLiteral lit = getLiteral(n);
+    if(d_polarityAware) {
+      // it might only be defined in one polarity so far
+      toCNF(n, false, POLARITY_BOTH);
+    }
     if(!d_literalToNodeMap.contains(lit)){
       // Store backward-mappings
       d_literalToNodeMap.insert(lit, n);
@@ -140,7 +147,7 @@ void TseitinCnfStream::ensureLiteral(TNode n) {
     // If we were called with something other than a theory atom (or
     // Boolean variable), we get a SatLiteral that is definitionally
     // equal to it.
-    lit = toCNF(n, false);
+    lit = toCNF(n, false, POLARITY_BOTH);
 
     // Store backward-mappings
     // These may already exist
@@ -248,27 +255,46 @@ SatLiteral CnfStream::getLiteral(TNode node) {
   return literal;
 }
 
-SatLiteral TseitinCnfStream::handleXor(TNode xorNode) {
-  Assert(!hasLiteral(xorNode), "Atom already mapped!");
+TseitinCnfStream::Polarity
+TseitinCnfStream::undefinedPolarity(SatLiteral lit, Polarity polarity) const {
+  if(!d_polarityAware) {
+    // translated formulas are fully defined
+    return POLARITY_NONE;
+  }
+  unsigned p = polarity;
+  if(d_definedLiterals.contains(lit)) {
+    p &= ~POLARITY_POSITIVE;
+  }
+  if(d_definedLiterals.contains(~lit)) {
+    p &= ~POLARITY_NEGATIVE;
+  }
+  return Polarity(p);
+}
+
+SatLiteral TseitinCnfStream::handleXor(TNode xorNode, Polarity polarity) {
   Assert(xorNode.getKind() == XOR, "Expecting an XOR expression!");
   Assert(xorNode.getNumChildren() == 2, "Expecting exactly 2 children!");
   Assert(!d_removable, "Removable clauses can not contain Boolean structure");
 
-  SatLiteral a = toCNF(xorNode[0]);
-  SatLiteral b = toCNF(xorNode[1]);
+  // The children occur in both polarities
+  SatLiteral a = toCNF(xorNode[0], false, POLARITY_BOTH);
+  SatLiteral b = toCNF(xorNode[1], false, POLARITY_BOTH);
 
   SatLiteral xorLit = newLiteral(xorNode);
 
-  assertClause(xorNode, a, b, ~xorLit);
-  assertClause(xorNode, ~a, ~b, ~xorLit);
-  assertClause(xorNode, a, ~b, xorLit);
-  assertClause(xorNode, ~a, b, xorLit);
+  if(polarity & POLARITY_POSITIVE) {
+    assertClause(xorNode, a, b, ~xorLit);
+    assertClause(xorNode, ~a, ~b, ~xorLit);
+  }
+  if(polarity & POLARITY_NEGATIVE) {
+    assertClause(xorNode, a, ~b, xorLit);
+    assertClause(xorNode, ~a, b, xorLit);
+  }
 
   return xorLit;
 }
 
-SatLiteral TseitinCnfStream::handleOr(TNode orNode) {
-  Assert(!hasLiteral(orNode), "Atom already mapped!");
+SatLiteral TseitinCnfStream::handleOr(TNode orNode, Polarity polarity) {
   Assert(orNode.getKind() == OR, "Expecting an OR expression!");
   Assert(orNode.getNumChildren() > 1, "Expecting more then 1 child!");
   Assert(!d_removable, "Removable clauses can not contain Boolean structure");
@@ -281,31 +307,34 @@ SatLiteral TseitinCnfStream::handleOr(TNode orNode) {
   TNode::const_iterator node_it_end = orNode.end();
   SatClause clause(n_children + 1);
   for(int i = 0; node_it != node_it_end; ++node_it, ++i) {
-    clause[i] = toCNF(*node_it);
+    clause[i] = toCNF(*node_it, false, polarity);
   }
 
   // Get the literal for this node
   SatLiteral orLit = newLiteral(orNode);
 
-  // lit <- (a_1 | a_2 | a_3 | ... | a_n)
-  // lit | ~(a_1 | a_2 | a_3 | ... | a_n)
-  // (lit | ~a_1) & (lit | ~a_2) & (lit & ~a_3) & ... & (lit & ~a_n)
-  for(unsigned i = 0; i < n_children; ++i) {
-    assertClause(orNode, orLit, ~clause[i]);
+  if(polarity & POLARITY_NEGATIVE) {
+    // lit <- (a_1 | a_2 | a_3 | ... | a_n)
+    // lit | ~(a_1 | a_2 | a_3 | ... | a_n)
+    // (lit | ~a_1) & (lit | ~a_2) & (lit & ~a_3) & ... & (lit & ~a_n)
+    for(unsigned i = 0; i < n_children; ++i) {
+      assertClause(orNode, orLit, ~clause[i]);
+    }
   }
 
-  // lit -> (a_1 | a_2 | a_3 | ... | a_n)
-  // ~lit | a_1 | a_2 | a_3 | ... | a_n
-  clause[n_children] = ~orLit;
-  // This needs to go last, as the clause might get modified by the SAT solver
-  assertClause(orNode, clause);
+  if(polarity & POLARITY_POSITIVE) {
+    // lit -> (a_1 | a_2 | a_3 | ... | a_n)
+    // ~lit | a_1 | a_2 | a_3 | ... | a_n
+    clause[n_children] = ~orLit;
+    // This needs to go last, as the clause might get modified by the SAT solver
+    assertClause(orNode, clause);
+  }
 
   // Return the literal
   return orLit;
 }
 
-SatLiteral TseitinCnfStream::handleAnd(TNode andNode) {
-  Assert(!hasLiteral(andNode), "Atom already mapped!");
+SatLiteral TseitinCnfStream::handleAnd(TNode andNode, Polarity polarity) {
   Assert(andNode.getKind() == AND, "Expecting an AND expression!");
   Assert(andNode.getNumChildren() > 1, "Expecting more than 1 child!");
   Assert(!d_removable, "Removable clauses can not contain Boolean structure");
@@ -318,186 +347,222 @@ SatLiteral TseitinCnfStream::handleAnd(TNode andNode) {
   TNode::const_iterator node_it_end = andNode.end();
   SatClause clause(n_children + 1);
   for(int i = 0; node_it != node_it_end; ++node_it, ++i) {
-    clause[i] = ~toCNF(*node_it);
+    clause[i] = ~toCNF(*node_it, false, polarity);
   }
 
   // Get the literal for this node
   SatLiteral andLit = newLiteral(andNode);
 
-  // lit -> (a_1 & a_2 & a_3 & ... & a_n)
-  // ~lit | (a_1 & a_2 & a_3 & ... & a_n)
-  // (~lit | a_1) & (~lit | a_2) & ... & (~lit | a_n)
-  for(unsigned i = 0; i < n_children; ++i) {
-    assertClause(andNode, ~andLit, ~clause[i]);
+  if(polarity & POLARITY_POSITIVE) {
+    // lit -> (a_1 & a_2 & a_3 & ... & a_n)
+    // ~lit | (a_1 & a_2 & a_3 & ... & a_n)
+    // (~lit | a_1) & (~lit | a_2) & ... & (~lit | a_n)
+    for(unsigned i = 0; i < n_children; ++i) {
+      assertClause(andNode, ~andLit, ~clause[i]);
+    }
   }
 
-  // lit <- (a_1 & a_2 & a_3 & ... a_n)
-  // lit | ~(a_1 & a_2 & a_3 & ... & a_n)
-  // lit | ~a_1 | ~a_2 | ~a_3 | ... | ~a_n
-  clause[n_children] = andLit;
-  // This needs to go last, as the clause might get modified by the SAT solver
-  assertClause(andNode, clause);
+  if(polarity & POLARITY_NEGATIVE) {
+    // lit <- (a_1 & a_2 & a_3 & ... a_n)
+    // lit | ~(a_1 & a_2 & a_3 & ... & a_n)
+    // lit | ~a_1 | ~a_2 | ~a_3 | ... | ~a_n
+    clause[n_children] = andLit;
+    // This needs to go last, as the clause might get modified by the SAT solver
+    assertClause(andNode, clause);
+  }
 
   return andLit;
 }
 
-SatLiteral TseitinCnfStream::handleImplies(TNode impliesNode) {
-  Assert(!hasLiteral(impliesNode), "Atom already mapped!");
+SatLiteral TseitinCnfStream::handleImplies(TNode impliesNode, Polarity polarity) {
   Assert(impliesNode.getKind() == IMPLIES, "Expecting an IMPLIES expression!");
   Assert(impliesNode.getNumChildren() == 2, "Expecting exactly 2 children!");
   Assert(!d_removable, "Removable clauses can not contain Boolean structure");
 
-  // Convert the children to cnf
-  SatLiteral a = toCNF(impliesNode[0]);
-  SatLiteral b = toCNF(impliesNode[1]);
+  // Convert the children to cnf (the antecedent occurs in the
+  // opposite polarity)
+  SatLiteral a = toCNF(impliesNode[0], false, flip(polarity));
+  SatLiteral b = toCNF(impliesNode[1], false, polarity);
 
   SatLiteral impliesLit = newLiteral(impliesNode);
 
-  // lit -> (a->b)
-  // ~lit | ~ a | b
-  assertClause(impliesNode, ~impliesLit, ~a, b);
+  if(polarity & POLARITY_POSITIVE) {
+    // lit -> (a->b)
+    // ~lit | ~ a | b
+    assertClause(impliesNode, ~impliesLit, ~a, b);
+  }
 
-  // (a->b) -> lit
-  // ~(~a | b) | lit
-  // (a | l) & (~b | l)
-  assertClause(impliesNode, a, impliesLit);
-  assertClause(impliesNode, ~b, impliesLit);
+  if(polarity & POLARITY_NEGATIVE) {
+    // (a->b) -> lit
+    // ~(~a | b) | lit
+    // (a | l) & (~b | l)
+    assertClause(impliesNode, a, impliesLit);
+    assertClause(impliesNode, ~b, impliesLit);
+  }
 
   return impliesLit;
 }
 
 
-SatLiteral TseitinCnfStream::handleIff(TNode iffNode) {
-  Assert(!hasLiteral(iffNode), "Atom already mapped!");
+SatLiteral TseitinCnfStream::handleIff(TNode iffNode, Polarity polarity) {
   Assert(iffNode.getKind() == IFF, "Expecting an IFF expression!");
   Assert(iffNode.getNumChildren() == 2, "Expecting exactly 2 children!");
 
   Debug("cnf") << "handleIff(" << iffNode << ")" << endl;
 
-  // Convert the children to CNF
-  SatLiteral a = toCNF(iffNode[0]);
-  SatLiteral b = toCNF(iffNode[1]);
+  // Convert the children to CNF (they occur in both polarities)
+  SatLiteral a = toCNF(iffNode[0], false, POLARITY_BOTH);
+  SatLiteral b = toCNF(iffNode[1], false, POLARITY_BOTH);
 
   // Get the now literal
   SatLiteral iffLit = newLiteral(iffNode);
 
-  // lit -> ((a-> b) & (b->a))
-  // ~lit | ((~a | b) & (~b | a))
-  // (~a | b | ~lit) & (~b | a | ~lit)
-  assertClause(iffNode, ~a, b, ~iffLit);
-  assertClause(iffNode, a, ~b, ~iffLit);
+  if(polarity & POLARITY_POSITIVE) {
+    // lit -> ((a-> b) & (b->a))
+    // ~lit | ((~a | b) & (~b | a))
+    // (~a | b | ~lit) & (~b | a | ~lit)
+    assertClause(iffNode, ~a, b, ~iffLit);
+    assertClause(iffNode, a, ~b, ~iffLit);
+  }
 
-  // (a<->b) -> lit
-  // ~((a & b) | (~a & ~b)) | lit
-  // (~(a & b)) & (~(~a & ~b)) | lit
-  // ((~a | ~b) & (a | b)) | lit
-  // (~a | ~b | lit) & (a | b | lit)
-  assertClause(iffNode, ~a, ~b, iffLit);
-  assertClause(iffNode, a, b, iffLit);
+  if(polarity & POLARITY_NEGATIVE) {
+    // (a<->b) -> lit
+    // ~((a & b) | (~a & ~b)) | lit
+    // (~(a & b)) & (~(~a & ~b)) | lit
+    // ((~a | ~b) & (a | b)) | lit
+    // (~a | ~b | lit) & (a | b | lit)
+    assertClause(iffNode, ~a, ~b, iffLit);
+    assertClause(iffNode, a, b, iffLit);
+  }
 
   return iffLit;
 }
 
 
-SatLiteral TseitinCnfStream::handleNot(TNode notNode) {
-  Assert(!hasLiteral(notNode), "Atom already mapped!");
+SatLiteral TseitinCnfStream::handleNot(TNode notNode, Polarity polarity) {
   Assert(notNode.getKind() == NOT, "Expecting a NOT expression!");
   Assert(notNode.getNumChildren() == 1, "Expecting exactly 1 child!");
 
-  SatLiteral notLit = ~toCNF(notNode[0]);
+  SatLiteral notLit = ~toCNF(notNode[0], false, flip(polarity));
 
   return notLit;
 }
 
-SatLiteral TseitinCnfStream::handleIte(TNode iteNode) {
+SatLiteral TseitinCnfStream::handleIte(TNode iteNode, Polarity polarity) {
   Assert(iteNode.getKind() == ITE);
   Assert(iteNode.getNumChildren() == 3);
   Assert(!d_removable, "Removable clauses can not contain Boolean structure");
 
   Debug("cnf") << "handleIte(" << iteNode[0] << " " << iteNode[1] << " " << iteNode[2] << ")" << endl;
 
-  SatLiteral condLit = toCNF(iteNode[0]);
-  SatLiteral thenLit = toCNF(iteNode[1]);
-  SatLiteral elseLit = toCNF(iteNode[2]);
+  // The condition occurs in both polarities
+  SatLiteral condLit = toCNF(iteNode[0], false, POLARITY_BOTH);
+  SatLiteral thenLit = toCNF(iteNode[1], false, polarity);
+  SatLiteral elseLit = toCNF(iteNode[2], false, polarity);
 
   SatLiteral iteLit = newLiteral(iteNode);
 
-  // If ITE is true then one of the branches is true and the condition
-  // implies which one
-  // lit -> (ite b t e)
-  // lit -> (t | e) & (b -> t) & (!b -> e)
-  // lit -> (t | e) & (!b | t) & (b | e)
-  // (!lit | t | e) & (!lit | !b | t) & (!lit | b | e)
-  assertClause(iteNode, ~iteLit, thenLit, elseLit);
-  assertClause(iteNode, ~iteLit, ~condLit, thenLit);
-  assertClause(iteNode, ~iteLit, condLit, elseLit);
-
-  // If ITE is false then one of the branches is false and the condition
-  // implies which one
-  // !lit -> !(ite b t e)
-  // !lit -> (!t | !e) & (b -> !t) & (!b -> !e)
-  // !lit -> (!t | !e) & (!b | !t) & (b | !e)
-  // (lit | !t | !e) & (lit | !b | !t) & (lit | b | !e)
-  assertClause(iteNode, iteLit, ~thenLit, ~elseLit);
-  assertClause(iteNode, iteLit, ~condLit, ~thenLit);
-  assertClause(iteNode, iteLit, condLit, ~elseLit);
+  if(polarity & POLARITY_POSITIVE) {
+    // If ITE is true then one of the branches is true and the condition
+    // implies which one
+    // lit -> (ite b t e)
+    // lit -> (t | e) & (b -> t) & (!b -> e)
+    // lit -> (t | e) & (!b | t) & (b | e)
+    // (!lit | t | e) & (!lit | !b | t) & (!lit | b | e)
+    assertClause(iteNode, ~iteLit, thenLit, elseLit);
+    assertClause(iteNode, ~iteLit, ~condLit, thenLit);
+    assertClause(iteNode, ~iteLit, condLit, elseLit);
+  }
+
+  if(polarity & POLARITY_NEGATIVE) {
+    // If ITE is false then one of the branches is false and the condition
+    // implies which one
+    // !lit -> !(ite b t e)
+    // !lit -> (!t | !e) & (b -> !t) & (!b -> !e)
+    // !lit -> (!t | !e) & (!b | !t) & (b | !e)
+    // (lit | !t | !e) & (lit | !b | !t) & (lit | b | !e)
+    assertClause(iteNode, iteLit, ~thenLit, ~elseLit);
+    assertClause(iteNode, iteLit, ~condLit, ~thenLit);
+    assertClause(iteNode, iteLit, condLit, ~elseLit);
+  }
 
   return iteLit;
 }
 
 
-SatLiteral TseitinCnfStream::toCNF(TNode node, bool negated) {
+SatLiteral TseitinCnfStream::toCNF(TNode node, bool negated, Polarity polarity) {
   Debug("cnf") << "toCNF(" << node << ", negated = " << (negated ? "true" : "false") << ")" << endl;
 
   SatLiteral nodeLit;
   Node negatedNode = node.notNode();
 
-  // If the non-negated node has already been translated, get the translation
-  if(hasLiteral(node)) {
+  if(!d_polarityAware) {
+    polarity = POLARITY_BOTH;
+  }
+
+  // If the non-negated node has already been translated, get the
+  // translation, and only define it in the polarities it's still
+  // missing
+  bool translated = hasLiteral(node);
+  if(translated) {
     Debug("cnf") << "toCNF(): already translated" << endl;
     nodeLit = getLiteral(node);
-  } else {
+    polarity = undefinedPolarity(nodeLit, polarity);
+  }
+
+  if(!translated || polarity != POLARITY_NONE) {
     // Handle each Boolean operator case
     switch(node.getKind()) {
     case NOT:
-      nodeLit = handleNot(node);
+      nodeLit = handleNot(node, polarity);
       break;
     case XOR:
-      nodeLit = handleXor(node);
+      nodeLit = handleXor(node, polarity);
       break;
     case ITE:
-      nodeLit = handleIte(node);
+      nodeLit = handleIte(node, polarity);
       break;
     case IFF:
-      nodeLit = handleIff(node);
+      nodeLit = handleIff(node, polarity);
       break;
     case IMPLIES:
-      nodeLit = handleImplies(node);
+      nodeLit = handleImplies(node, polarity);
       break;
     case OR:
-      nodeLit = handleOr(node);
+      nodeLit = handleOr(node, polarity);
       break;
     case AND:
-      nodeLit = handleAnd(node);
+      nodeLit = handleAnd(node, polarity);
       break;
     case EQUAL:
       if(node[0].getType().isBoolean()) {
         // normally this is an IFF, but EQUAL is possible with pseudobooleans
-        nodeLit = handleIff(node[0].iffNode(node[1]));
-      } else {
+        nodeLit = toCNF(node[0].iffNode(node[1]), false, polarity);
+      } else if(!translated) {
         nodeLit = convertAtom(node);
       }
       break;
     default:
       {
         //TODO make sure this does not contain any boolean substructure
-        nodeLit = convertAtom(node);
+        if(!translated) {
+          nodeLit = convertAtom(node);
+        }
         //Unreachable();
         //Node atomic = handleNonAtomicNode(node);
         //return isCached(atomic) ? lookupInCache(atomic) : convertAtom(atomic);
       }
       break;
     }
+
+    if(d_polarityAware) {
+      if(polarity & POLARITY_POSITIVE) {
+        d_definedLiterals.insert(nodeLit);
+      }
+      if(polarity & POLARITY_NEGATIVE) {
+        d_definedLiterals.insert(~nodeLit);
+      }
+    }
   }
 
   // Return the appropriate (negated) literal
@@ -552,8 +617,8 @@ void TseitinCnfStream::convertAndAssertOr(TNode node, bool negated) {
 void TseitinCnfStream::convertAndAssertXor(TNode node, bool negated) {
   if (!negated) {
     // p XOR q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => !q) and (!q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -565,8 +630,8 @@ void TseitinCnfStream::convertAndAssertXor(TNode node, bool negated) {
     assertClause(node, clause2);
   } else {
     // !(p XOR q) is the same as p <=> q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => q) and (q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -582,8 +647,8 @@ void TseitinCnfStream::convertAndAssertXor(TNode node, bool negated) {
 void TseitinCnfStream::convertAndAssertIff(TNode node, bool negated) {
   if (!negated) {
     // p <=> q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => q) and (q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -595,8 +660,8 @@ void TseitinCnfStream::convertAndAssertIff(TNode node, bool negated) {
     assertClause(node, clause2);
   } else {
     // !(p <=> q) is the same as p XOR q
-    SatLiteral p = toCNF(node[0], false);
-    SatLiteral q = toCNF(node[1], false);
+    SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
+    SatLiteral q = toCNF(node[1], false, POLARITY_BOTH);
     // Construct the clauses (p => !q) and (!q => p)
     SatClause clause1(2);
     clause1[0] = ~p;
@@ -612,11 +677,11 @@ void TseitinCnfStream::convertAndAssertIff(TNode node, bool negated) {
 void TseitinCnfStream::convertAndAssertImplies(TNode node, bool negated) {
   if (!negated) {
     // p => q
-    SatLiteral p = toCNF(node[0], false);
+    SatLiteral notP = toCNF(node[0], true);
     SatLiteral q = toCNF(node[1], false);
     // Construct the clause ~p || q
     SatClause clause(2);
-    clause[0] = ~p;
+    clause[0] = notP;
     clause[1] = q;
     assertClause(node, clause);
   } else {// Construct the
@@ -628,7 +693,7 @@ void TseitinCnfStream::convertAndAssertImplies(TNode node, bool negated) {
 
 void TseitinCnfStream::convertAndAssertIte(TNode node, bool negated) {
   // ITE(p, q, r)
-  SatLiteral p = toCNF(node[0], false);
+  SatLiteral p = toCNF(node[0], false, POLARITY_BOTH);
   SatLiteral q = toCNF(node[1], negated);
   SatLiteral r = toCNF(node[2], negated);
   // Construct the clauses:
@@ -30,7 +30,8 @@
 #include "prop/registrar.h"
 #include "proof/proof_manager.h"
 #include "context/cdlist.h"
-#include "context/cdinsert_hashmap.h"
+#include "context/cddense_map.h"
+#include "context/cdhashset.h"
 
 #include <ext/hash_map>
 
@@ -47,11 +48,17 @@ class CnfStream {
 
 public:
 
-  /** Cache of what nodes have been registered to a literal. */
-  typedef context::CDInsertHashMap<SatLiteral, TNode, SatLiteralHashFunction> LiteralToNodeMap;
+  /**
+   * Cache of what nodes have been registered to a literal, indexed by
+   * the literal (the SAT variables are dense).
+   */
+  typedef context::CDDenseMap<SatLiteral, TNode, SatLiteralHashFunction> LiteralToNodeMap;
 
-  /** Cache of what literals have been registered to a node. */
-  typedef context::CDInsertHashMap<Node, SatLiteral, NodeHashFunction> NodeToLiteralMap;
+  /**
+   * Cache of what literals have been registered to a node, indexed by
+   * the node's id (only the pages of ids that are used are allocated).
+   */
+  typedef context::CDDenseMap<Node, SatLiteral, TNodeHashFunction> NodeToLiteralMap;
 
 protected:
 
@@ -271,6 +278,15 @@ public:
  * recursively.
  *
  * This implementation does this in a single recursive pass. [??? -Chris]
+ *
+ * With --cnf-polarity, the encoding is polarity-aware (after Plaisted
+ * and Greenbaum): a subformula's literal is only defined by the
+ * clauses needed for the polarities the subformula occurs in, i.e.,
+ * lit -> formula where it occurs positively, and formula -> lit where
+ * it occurs negatively.  If the literal is later needed in the other
+ * polarity (by a new assertion or lemma, or by ensureLiteral()), the
+ * missing clauses are added then.  Atoms are always fully defined, as
+ * they're their own literals.
  */
 class TseitinCnfStream : public CnfStream {
 
@@ -295,6 +311,38 @@ public:
 
 private:
 
+  /**
+   * The polarities in which a subformula is defined: positive for the
+   * clauses lit -> formula, negative for formula -> lit.
+   */
+  enum Polarity {
+    POLARITY_NONE = 0,
+    POLARITY_POSITIVE = 1,
+    POLARITY_NEGATIVE = 2,
+    POLARITY_BOTH = 3
+  };/* enum Polarity */
+
+  /** The opposite polarities of p */
+  static Polarity flip(Polarity p) {
+    return Polarity(((p & POLARITY_POSITIVE) << 1) | ((p & POLARITY_NEGATIVE) >> 1));
+  }
+
+  /** Whether the encoding is polarity-aware (see above) */
+  const bool d_polarityAware;
+
+  /**
+   * With the polarity-aware encoding, the literals whose definitions
+   * have been asserted: lit is here if the clauses lit -> formula
+   * have been, and ~lit if the clauses formula -> lit have been.
+   */
+  context::CDHashSet<SatLiteral, SatLiteralHashFunction> d_definedLiterals;
+
+  /**
+   * The polarities, among those given, in which the (already
+   * translated) formula with literal lit isn't defined yet.
+   */
+  Polarity undefinedPolarity(SatLiteral lit, Polarity polarity) const;
+
   /**
    * Same as above, except that removable is remembered.
    */
@@ -302,21 +350,23 @@ private:
 
   // Each of these formulas handles takes care of a Node of each Kind.
   //
-  // Each handleX(Node &n) is responsible for:
+  // Each handleX(Node &n, Polarity p) is responsible for:
   //   - constructing a new literal, l (if necessary)
   //   - calling registerNode(n,l)
-  //   - adding clauses assure that l is equivalent to the Node
+  //   - adding clauses assure that l is equivalent to the Node, in
+  //     the polarities p
   //   - calling toCNF on its children (if necessary)
   //   - returning l
   //
-  // handleX( n ) can assume that n is not in d_translationCache
-  SatLiteral handleNot(TNode node);
-  SatLiteral handleXor(TNode node);
-  SatLiteral handleImplies(TNode node);
-  SatLiteral handleIff(TNode node);
-  SatLiteral handleIte(TNode node);
-  SatLiteral handleAnd(TNode node);
-  SatLiteral handleOr(TNode node);
+  // handleX( n ) can assume that n is not in d_translationCache, or
+  // that it isn't yet defined in the polarities p
+  SatLiteral handleNot(TNode node, Polarity polarity);
+  SatLiteral handleXor(TNode node, Polarity polarity);
+  SatLiteral handleImplies(TNode node, Polarity polarity);
+  SatLiteral handleIff(TNode node, Polarity polarity);
+  SatLiteral handleIte(TNode node, Polarity polarity);
+  SatLiteral handleAnd(TNode node, Polarity polarity);
+  SatLiteral handleOr(TNode node, Polarity polarity);
 
   void convertAndAssertAnd(TNode node, bool negated);
   void convertAndAssertOr(TNode node, bool negated);
@@ -331,7 +381,16 @@ private:
    * @param negated whether the literal is negated
    * @return the literal representing the root of the formula
    */
-  SatLiteral toCNF(TNode node, bool negated = false);
+  SatLiteral toCNF(TNode node, bool negated = false) {
+    return toCNF(node, negated, negated ? POLARITY_NEGATIVE : POLARITY_POSITIVE);
+  }
+
+  /**
+   * Same as above, but with the polarities the formula must be
+   * defined in (with the polarity-aware encoding; it's always defined
+   * in both otherwise).
+   */
+  SatLiteral toCNF(TNode node, bool negated, Polarity polarity);
 
   void ensureLiteral(TNode n);
 
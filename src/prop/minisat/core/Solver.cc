@@ -32,6 +32,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "expr/command.h"
 #include "proof/proof_manager.h"
 #include "proof/sat_proof.h"
+#include "proof/drat_stream.h"
 
 using namespace Minisat;
 using namespace CVC4;
@@ -55,6 +56,19 @@ static IntOption     opt_restart_first     (_cat, "rfirst",      "The base resta
 static DoubleOption  opt_restart_inc       (_cat, "rinc",        "Restart interval increase factor", 3, DoubleRange(1, false, HUGE_VAL, false));
 static DoubleOption  opt_garbage_frac      (_cat, "gc-frac",     "The fraction of wasted memory allowed before a garbage collection is triggered",  0.20, DoubleRange(0, false, HUGE_VAL, false));
 
+// Dynamic restarts ('restart_ema'): the minimum number of conflicts between restarts, and the number
+// of conflicts before restarts can be blocked.
+static const int      restart_min         = 50;
+static const uint64_t restart_block_start = 10000;
+
+// Inprocessing ('inprocess()'): the minimum effort of a round, the largest clauses considered for
+// subsumption, and the bounds on variable elimination: the number of occurrences of each polarity
+// of an eliminated variable, and the size of the resolvents.
+static const int64_t  inprocess_min_effort = 10000;
+static const int      subsume_clause_lim   = 100;
+static const int      elim_occ_lim         = 16;
+static const int      elim_clause_lim      = 20;
+
 
 class ScopedBool {
   bool& watch;
@@ -103,22 +117,54 @@ Solver::Solver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* context,
     //
   , learntsize_adjust_start_confl (100)
   , learntsize_adjust_inc         (1.5)
+  , lbd_mode                      (true)
+  , core_lbd                      (2)
+  , tier2_lbd                     (6)
+  , reduce_first                  (2000)
+  , reduce_inc                    (300)
+  , restart_ema                   (false)
+  , restart_margin                (1.25)
+  , restart_block                 (1.4)
+  , rephasing                     (false)
+  , rephase_int                   (1000)
+  , inprocessing                  (false)
+  , inprocess_int                 (5000)
+  , inprocess_effort              (0.1)
+  , inprocess_elim                (false)
 
     // Statistics: (formerly in 'SolverStats')
     //
   , solves(0), starts(0), decisions(0), rnd_decisions(0), propagations(0), conflicts(0), resources_consumed(0)
   , dec_vars(0), clauses_literals(0), learnts_literals(0), max_literals(0), tot_literals(0)
+  , reductions(0), blocked_restarts(0), rephases(0)
+  , inprocessings(0), vivified_clauses(0), vivified_lits(0), subsumed_clauses(0), var_eliminations(0)
 
   , ok                 (true)
   , cla_inc            (1)
   , var_inc            (1)
   , watches            (WatcherDeleted(ca))
+  , watches_bin        (WatcherDeleted(ca))
+  , target_assigned    (0)
+  , best_assigned      (0)
+  , next_rephase       (0)
+  , lbd_fast           (1.0 / 32)
+  , lbd_slow           (1e-5)
+  , trail_avg          (1.0 / 5000)
   , qhead              (0)
   , simpDB_assigns     (-1)
   , simpDB_props       (0)
   , order_heap         (VarOrderLt(activity))
   , progress_estimate  (0)
   , remove_satisfied   (!enable_incremental)
+  , inprocess_original (true)
+  , next_inprocess     (0)
+  , inprocess_props    (0)
+  , drat               (NULL)
+  , drat_empty         (false)
+  , drat_derived       (false)
+
+  , next_reduce        (0)
+  , lbd_stamp          (0)
 
     // Resource constraints:
     //
@@ -128,6 +174,8 @@ Solver::Solver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* context,
 {
   PROOF(ProofManager::initSatProof(this);)
 
+  learnts_tiers[Clause::TIER_CORE] = learnts_tiers[Clause::TIER_2] = learnts_tiers[Clause::TIER_LOCAL] = 0;
+
   // Create the constant variables
   varTrue = newVar(true, false, false);
   varFalse = newVar(false, false, false);
@@ -145,6 +193,18 @@ Solver::~Solver()
 }
 
 
+void Solver::setDratStream(CVC4::DratStream* s)
+{
+    assert(nClauses() == 0 && nLearnts() == 0);
+    drat = s;
+    // The constants are given
+    if (drat != NULL) {
+        drat->write(CVC4::DratStream::INPUT, mkLit(varTrue, false));
+        drat->write(CVC4::DratStream::INPUT, mkLit(varFalse, true));
+    }
+}
+
+
 //=================================================================================================
 // Minor methods:
 
@@ -158,14 +218,21 @@ Var Solver::newVar(bool sign, bool dvar, bool isTheoryAtom, bool preRegister, bo
 
     watches  .init(mkLit(v, false));
     watches  .init(mkLit(v, true ));
+    watches_bin.init(mkLit(v, false));
+    watches_bin.init(mkLit(v, true ));
     assigns  .push(l_Undef);
     vardata  .push(VarData(CRef_Undef, -1, -1, assertionLevel, -1));
     activity .push(rnd_init_act ? drand(random_seed) * 0.00001 : 0);
     seen     .push(0);
     polarity .push(sign);
+    init_polarity.push(sign);
+    target_phase.push(2);
+    best_phase.push(2);
     decision .push();
     trail    .capacity(v+1);
     theory   .push(isTheoryAtom);
+    erasable .push(canErase && !isTheoryAtom);
+    elim_index.push(-1);
 
     setDecisionVar(v, dvar);
 
@@ -188,6 +255,7 @@ void Solver::resizeVars(int newSize) {
 
     // Resize watches up to the negated last literal
     watches.resizeTo(mkLit(newSize-1, true));
+    watches_bin.resizeTo(mkLit(newSize-1, true));
 
     // Resize all info arrays
     assigns.shrink(shrinkSize);
@@ -195,8 +263,13 @@ void Solver::resizeVars(int newSize) {
     activity.shrink(shrinkSize);
     seen.shrink(shrinkSize);
     polarity.shrink(shrinkSize);
+    init_polarity.shrink(shrinkSize);
+    target_phase.shrink(shrinkSize);
+    best_phase.shrink(shrinkSize);
     decision.shrink(shrinkSize);
     theory.shrink(shrinkSize);
+    erasable.shrink(shrinkSize);
+    elim_index.shrink(shrinkSize);
 
   }
 
@@ -207,25 +280,157 @@ void Solver::resizeVars(int newSize) {
   }
 }
 
+// The literal block distance (LBD) of a clause: the number of distinct decision levels of its
+// literals, counting each unassigned literal as a level of its own.
+template<class Lits>
+unsigned Solver::computeLBD(const Lits& ps) {
+    unsigned lbd = 0;
+    lbd_stamp++;
+    for (int i = 0; i < ps.size(); i++) {
+        Var x = var(ps[i]);
+        if (value(x) == l_Undef) {
+            lbd++;
+            continue;
+        }
+        int l = level(x);
+        if (l >= lbd_stamps.size()) lbd_stamps.growTo(l + 1, 0);
+        if (lbd_stamps[l] != lbd_stamp) {
+            lbd_stamps[l] = lbd_stamp;
+            lbd++;
+        }
+    }
+    return lbd;
+}
+
+// A learnt clause is used in conflict analysis: mark it (for 'reduceDBByLBD()'), and if its LBD
+// has improved, record it and move the clause up to the tier of the new LBD.
+void Solver::updateLBD(Clause& c) {
+    c.used(true);
+    if (c.tier() == Clause::TIER_CORE) return;
+    unsigned lbd = computeLBD(c);
+    if (lbd < c.lbd()) {
+        c.lbd(lbd);
+        if (lbdTier(lbd) < c.tier()) setTier(c, lbdTier(lbd));
+    }
+}
+
+// At a conflict, before backtracking: the trail below the conflict level is conflict-free, so if
+// it's the largest since the last restart (or rephasing), record its phases as the target (best) ones.
+void Solver::savePhases() {
+    int assigned = trail_lim.last();
+    if (assigned > target_assigned) {
+        for (int i = 0; i < assigned; i++)
+            target_phase[var(trail[i])] = sign(trail[i]);
+        target_assigned = assigned;
+    }
+    if (assigned > best_assigned) {
+        for (int i = 0; i < assigned; i++)
+            best_phase[var(trail[i])] = sign(trail[i]);
+        best_assigned = assigned;
+    }
+}
+
+// Reset the saved phases of the variables that aren't phase-locked, in turn to the best, original,
+// best and flipped ones, and start over looking for target and best phases. The interval until
+// the next rephasing grows arithmetically.
+void Solver::rephase() {
+    rephases++;
+    next_rephase = conflicts + rephase_int * (rephases + 1);
+    for (Var v = 0; v < nVars(); v++) {
+        if (polarity[v] & 0x2) continue;
+        switch (rephases % 4) {
+        case 1:
+        case 3: if (best_phase[v] != 2) polarity[v] = best_phase[v]; break;
+        case 2: polarity[v] = init_polarity[v]; break;
+        default: polarity[v] ^= 1;
+        }
+        target_phase[v] = 2;
+    }
+    target_assigned = best_assigned = 0;
+}
+
 CRef Solver::reason(Var x) {
 
     // If we already have a reason, just return it
-    if (vardata[x].reason != CRef_Lazy) return vardata[x].reason;
+    if (vardata[x].reason != CRef_Lazy) {
+      CRef r = vardata[x].reason;
+      if (r != CRef_Undef) {
+        // Binary clauses aren't reordered when they propagate (see 'propagateBool()'), so put
+        // the propagated literal first, where analysis expects it (unless the clause has been
+        // relocated, and its first literal overwritten)
+        Clause& c = ca[r];
+        if (c.size() == 2 && !c.reloced() && var(c[0]) != x) {
+          Lit tmp = c[0]; c[0] = c[1]; c[1] = tmp;
+        }
+      }
+      return r;
+    }
+
+    // Get the explanation from the theory
+    vec<Var> xs;
+    xs.push(x);
+    explainLazy(xs);
+    return vardata[x].reason;
+}
+
+void Solver::explainLazy(const vec<Var>& xs)
+{
+    // What are the literals we are trying to explain
+    std::vector<SatLiteral> lits;
+    for (int i = 0; i < xs.size(); i++){
+        assert(vardata[xs[i]].reason == CRef_Lazy);
+        lits.push_back(MinisatSatSolver::toSatLiteral(mkLit(xs[i], value(xs[i]) != l_True)));
+    }
+
+    // Get the explanations from the theory, all at once (an explanation the proxy gives again,
+    // from an earlier propagation of the literal, might not fit the trail anymore: then it's
+    // asked for again)
+    std::vector<SatClause> explanations_cl;
+    proxy->explainPropagations(lits, explanations_cl, false);
+    vec<Var> stale;
+    std::vector<SatLiteral> stale_lits;
+    for (int i = 0; i < xs.size(); i++){
+        vec<Lit> explanation;
+        MinisatSatSolver::toMinisatClause(explanations_cl[i], explanation);
+        if (!theoryReason(xs[i], explanation, true)){
+            stale.push(xs[i]);
+            stale_lits.push_back(lits[i]);
+        }
+    }
+    if (stale.size() == 0)
+        return;
 
-    // What's the literal we are trying to explain
+    proxy->explainPropagations(stale_lits, explanations_cl, true);
+    for (int i = 0; i < stale.size(); i++){
+        vec<Lit> explanation;
+        MinisatSatSolver::toMinisatClause(explanations_cl[i], explanation);
+        theoryReason(stale[i], explanation, false);
+    }
+}
+
+bool Solver::theoryReason(Var x, vec<Lit>& explanation, bool check)
+{
+    // What's the literal we are explaining
     Lit l = mkLit(x, value(x) != l_True);
 
-    // Get the explanation from the theory
-    SatClause explanation_cl;
-    proxy->explainPropagation(MinisatSatSolver::toSatLiteral(l), explanation_cl);
-    vec<Lit> explanation;
-    MinisatSatSolver::toMinisatClause(explanation_cl, explanation); 
+    // The other literals must be false, and before it on the trail
+    if (check){
+        if (explanation.size() == 0 || explanation[0] != l)
+            return false;
+        for (int k = 1; k < explanation.size(); k++)
+            if (value(explanation[k]) != l_False || trail_index(var(explanation[k])) >= trail_index(x))
+                return false;
+    }
 
     // Sort the literals by trail index level
     lemma_lt lt(*this);
     sort(explanation, lt);
     Assert(explanation[0] == l);
 
+    // (the explanation as given, if it's streamed: see below)
+    vec<Lit> given;
+    if (drat != NULL) explanation.copyTo(given);
+
     // Compute the assertion level for this clause
     int explLevel = 0;
     int i, j;
@@ -261,20 +466,45 @@ CRef Solver::reason(Var x) {
       explanation.push(mkLit(varTrue, true));
     }
 
+    // The explanation is a theory lemma, but it's kept without the literals false at level 0
+    if (drat != NULL) {
+      drat->write(CVC4::DratStream::THEORY_LEMMA, given);
+      if (i != j || j == 1) {
+        drat->write(CVC4::DratStream::ADD, explanation);
+        drat->write(CVC4::DratStream::DELETE, given);
+      }
+    }
+
     // Construct the reason
     CRef real_reason = ca.alloc(explLevel, explanation, true);
+    // Explanations go to the local tier, whatever their LBD: they're only promoted if it improves
+    if (lbd_mode) ca[real_reason].lbd(computeLBD(explanation));
     PROOF (ProofManager::getSatProof()->registerClause(real_reason, THEORY_LEMMA, (uint64_t(RULE_CONFLICT) << 32)); );
     vardata[x] = VarData(real_reason, level(x), user_level(x), intro_level(x), trail_index(x));
     clauses_removable.push(real_reason);
     attachClause(real_reason);
 
-    return real_reason;
+    return true;
 }
 
 bool Solver::addClause_(vec<Lit>& ps, bool removable, uint64_t proof_id)
 {
     if (!ok) return false;
 
+    // Eliminated variables the clause mentions are brought back first
+    if (eliminations.size() > 0) {
+      for (int k = 0; k < ps.size(); k++) {
+        if (elim_index[var(ps[k])] >= 0) {
+          restoreVar(var(ps[k]));
+        }
+      }
+      if (!ok) return false;
+    }
+
+    // (the clause as given, if it's streamed: see below)
+    vec<Lit> given;
+    if (drat != NULL) ps.copyTo(given);
+
     // Check if clause is satisfied and remove false/duplicate literals:
     sort(ps);
     Lit p; int i, j;
@@ -316,6 +546,19 @@ bool Solver::addClause_(vec<Lit>& ps, bool removable, uint64_t proof_id)
     // Fit to size
     ps.shrink(i - j);
 
+    // The clause is given (an input clause, or a theory lemma during search, unless it was derived),
+    // but it's kept without its repeated literals and those false at level 0
+    if (drat != NULL) {
+      if (!drat_derived)
+        drat->write(minisat_busy || decisionLevel() > 0 ? CVC4::DratStream::THEORY_LEMMA : CVC4::DratStream::INPUT, given);
+      if (ps.size() < given.size()) {
+        drat->write(CVC4::DratStream::ADD, ps);
+        drat->write(CVC4::DratStream::DELETE, given);
+      }
+      if (ps.size() == 1) dratUnit(ps[0], assertionLevel);
+      if (ps.size() == 0) drat_empty = true;
+    }
+
     // If we are in solve or decision level > 0
     if (minisat_busy || decisionLevel() > 0) {
       lemmas.push();
@@ -323,6 +566,7 @@ bool Solver::addClause_(vec<Lit>& ps, bool removable, uint64_t proof_id)
       lemmas_removable.push(removable);
       Debug("cores") << "lemma push " << proof_id << " " << (proof_id & 0xffffffff) << std::endl;
       lemmas_proof_id.push(proof_id);
+      lemmas_level.push(-1);
     } else {
       // If all false, we're in conflict
       if (ps.size() == falseLiteralsCount) {
@@ -390,9 +634,10 @@ void Solver::attachClause(CRef cr) {
     const Clause& c = ca[cr];
     Debug("minisat") << "Solver::attachClause(" << c << "): level " << c.level() << std::endl;
     Assert(c.size() > 1);
-    watches[~c[0]].push(Watcher(cr, c[1]));
-    watches[~c[1]].push(Watcher(cr, c[0]));
-    if (c.removable()) learnts_literals += c.size();
+    OccLists<Lit, vec<Watcher>, WatcherDeleted>& ws = c.size() == 2 ? watches_bin : watches;
+    ws[~c[0]].push(Watcher(cr, c[1]));
+    ws[~c[1]].push(Watcher(cr, c[0]));
+    if (c.removable()) learnts_literals += c.size(), learnts_tiers[c.tier()]++;
     else            clauses_literals += c.size();
 }
 
@@ -403,30 +648,48 @@ void Solver::detachClause(CRef cr, bool strict) {
     Debug("minisat") << "Solver::detachClause(" << c << ")" << std::endl;
     assert(c.size() > 1);
 
+    OccLists<Lit, vec<Watcher>, WatcherDeleted>& ws = c.size() == 2 ? watches_bin : watches;
     if (strict){
-        remove(watches[~c[0]], Watcher(cr, c[1]));
-        remove(watches[~c[1]], Watcher(cr, c[0]));
+        remove(ws[~c[0]], Watcher(cr, c[1]));
+        remove(ws[~c[1]], Watcher(cr, c[0]));
     }else{
         // Lazy detaching: (NOTE! Must clean all watcher lists before garbage collecting this clause)
-        watches.smudge(~c[0]);
-        watches.smudge(~c[1]);
+        ws.smudge(~c[0]);
+        ws.smudge(~c[1]);
     }
 
-    if (c.removable()) learnts_literals -= c.size();
+    if (c.removable()) learnts_literals -= c.size(), learnts_tiers[c.tier()]--;
     else            clauses_literals -= c.size(); }
 
 
 void Solver::removeClause(CRef cr) {
     Clause& c = ca[cr];
     Debug("minisat::remove-clause") << "Solver::removeClause(" << c << ")" << std::endl;
+    if (drat != NULL) {
+        // The literal a reason implies stays, as a unit
+        if (locked(c)) {
+            drat->write(CVC4::DratStream::ADD, implied(c));
+            dratUnit(implied(c), user_level(var(implied(c))));
+        }
+        drat->write(CVC4::DratStream::DELETE, c);
+    }
     detachClause(cr);
     // Don't leave pointers to free'd memory!
-    if (locked(c)) vardata[var(c[0])].reason = CRef_Undef;
+    if (locked(c)) vardata[var(implied(c))].reason = CRef_Undef;
     c.mark(1);
     ca.free(cr);
 }
 
 
+void Solver::dratUnit(Lit p, int level) {
+    // (units at user level 0 stay)
+    if (level > 0) {
+        drat_units.push(p);
+        drat_unit_levels.push(level);
+    }
+}
+
+
 bool Solver::satisfied(const Clause& c) const {
     for (int i = 0; i < c.size(); i++)
         if (value(c[i]) == l_True)
@@ -494,6 +757,8 @@ Lit Solver::pickBranchLit()
     while (nextLit != lit_Undef) {
       if(value(var(nextLit)) == l_Undef) {
         Debug("propagateAsDecision") << "propagateAsDecision(): now deciding on " << nextLit << std::endl;
+        // (its clauses are brought back as lemmas if it was eliminated)
+        if (elim_index[var(nextLit)] >= 0) restoreVar(var(nextLit));
         decisions++;
         return nextLit;
       } else {
@@ -551,7 +816,10 @@ Lit Solver::pickBranchLit()
         return mkLit(next, (dec_pol == l_True) );
       }
       // If it can't use internal heuristic to do that
-      return mkLit(next, rnd_pol ? drand(random_seed) < 0.5 : (polarity[next] & 0x1));
+      bool sign = polarity[next] & 0x1;
+      if (rephasing && (polarity[next] & 0x2) == 0 && target_phase[next] != 2)
+        sign = target_phase[next];
+      return mkLit(next, rnd_pol ? drand(random_seed) < 0.5 : sign);
     }
 }
 
@@ -586,24 +854,39 @@ int Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
 
     int max_resolution_level = 0; // Maximal level of the resolved clauses
 
+    // The earliest literal (on the trail) of the conflict level seen so far: the only one that
+    // can be the UIP, so all the others are resolved on, and their reasons will be needed
+    Var first = var_Undef;
+
     PROOF( ProofManager::getSatProof()->startResChain(confl); )
     do{
         assert(confl != CRef_Undef); // (otherwise should be UIP)
         Clause& c = ca[confl];
         max_resolution_level = std::max(max_resolution_level, c.level());
 
-        if (c.removable())
+        if (c.removable()) {
             claBumpActivity(c);
+            if (lbd_mode) updateLBD(c);
+        }
 
+        analyze_lazy.clear();
         for (int j = (p == lit_Undef) ? 0 : 1; j < c.size(); j++){
             Lit q = c[j];
 
             if (!seen[var(q)] && level(var(q)) > 0){
                 varBumpActivity(var(q));
                 seen[var(q)] = 1;
-                if (level(var(q)) >= decisionLevel())
+                if (level(var(q)) >= decisionLevel()){
                     pathC++;
-                else
+                    Var v = var(q);
+                    if (first == var_Undef || trail_index(v) < trail_index(first)){
+                        Var prev = first;
+                        first = v;
+                        v = prev;
+                    }
+                    if (v != var_Undef && vardata[v].reason == CRef_Lazy)
+                        analyze_lazy.push(v);
+                }else
                     out_learnt.push(q);
             } else {
               // We could be resolving a literal propagated by a clause/theory using
@@ -619,12 +902,17 @@ int Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
             }
         }
         
-        // Select next clause to look at:
+        // Explain the theory propagations that will be resolved on in one batch (this allocates
+        // clauses, so 'c' is not to be used after this)
+        if (analyze_lazy.size() > 0)
+            explainLazy(analyze_lazy);
+
+        // Select next clause to look at (the UIP's reason isn't needed):
         while (!seen[var(trail[index--])]);
         p     = trail[index+1];
-        confl = reason(var(p));
         seen[var(p)] = 0;
         pathC--;
+        confl = pathC > 0 ? reason(var(p)) : CRef_Undef;
         
         if ( pathC > 0 && confl != CRef_Undef ) {
           PROOF( ProofManager::getSatProof()->addResolutionStep(p, confl, sign(p)); )
@@ -642,7 +930,7 @@ int Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
             abstract_level |= abstractLevel(var(out_learnt[i])); // (maintain an abstraction of levels involved in conflict)
         
         for (i = j = 1; i < out_learnt.size(); i++) {
-            if (reason(var(out_learnt[i])) == CRef_Undef) {
+            if (!isPropagated(var(out_learnt[i]))) {
                 out_learnt[j++] = out_learnt[i];
             } else {
               // Check if the literal is redundant
@@ -722,7 +1010,7 @@ bool Solver::litRedundant(Lit p, uint32_t abstract_levels)
         for (int i = 1; i < c_size; i++){
             Lit p  = ca[c_reason][i];
             if (!seen[var(p)] && level(var(p)) > 0){
-                if (reason(var(p)) != CRef_Undef && (abstractLevel(var(p)) & abstract_levels) != 0){
+                if (isPropagated(var(p)) && (abstractLevel(var(p)) & abstract_levels) != 0){
                     seen[var(p)] = 1;
                     analyze_stack.push(p);
                     analyze_toclear.push(p);
@@ -762,7 +1050,7 @@ void Solver::analyzeFinal(Lit p, vec<Lit>& out_conflict)
     for (int i = trail.size()-1; i >= trail_lim[0]; i--){
         Var x = var(trail[i]);
         if (seen[x]){
-            if (reason(x) == CRef_Undef){
+            if (!isPropagated(x)){
                 assert(level(x) > 0);
                 out_conflict.push(~trail[i]);
             }else{
@@ -882,15 +1170,23 @@ void Solver::propagateTheory() {
 
   int oldTrailSize = trail.size();
   Debug("minisat") << "old trail size is " << oldTrailSize << ", propagating " << propagatedLiterals.size() << " lits..." << std::endl;
+  vec<Var> unexplained;
   for (unsigned i = 0, i_end = propagatedLiterals.size(); i < i_end; ++ i) {
     Debug("minisat") << "Theory propagated: " << propagatedLiterals[i] << std::endl;
     // multiple theories can propagate the same literal
     Lit p = propagatedLiterals[i];
     if (value(p) == l_Undef) {
       uncheckedEnqueue(p, CRef_Lazy);
+      // Conflict analysis doesn't explain the literals at level 0, so the stream needs their
+      // explanations now
+      if (drat != NULL && decisionLevel() == 0) unexplained.push(var(p));
     } else {
       if (value(p) == l_False) {
         Debug("minisat") << "Conflict in theory propagation" << std::endl;
+        if (unexplained.size() > 0) {
+          explainLazy(unexplained);
+          unexplained.clear();
+        }
         SatClause explanation_cl;
         proxy->explainPropagation(MinisatSatSolver::toSatLiteral(p), explanation_cl);
         vec<Lit> explanation;
@@ -899,6 +1195,9 @@ void Solver::propagateTheory() {
       }
     }
   }
+  if (unexplained.size() > 0) {
+    explainLazy(unexplained);
+  }
 }
 
 /*_________________________________________________________________________________________________
@@ -932,6 +1231,7 @@ CRef Solver::propagateBool()
     CRef    confl     = CRef_Undef;
     int     num_props = 0;
     watches.cleanAll();
+    watches_bin.cleanAll();
 
     while (qhead < trail.size()){
         Lit            p   = trail[qhead++];     // 'p' is enqueued fact to propagate.
@@ -939,6 +1239,22 @@ CRef Solver::propagateBool()
         Watcher        *i, *j, *end;
         num_props++;
 
+        // Binary clauses first: the blocker is the other literal, so the clause itself is never
+        // read (nor reordered, see 'reason()')
+        vec<Watcher>&  ws_bin = watches_bin[p];
+        for (int k = 0; k < ws_bin.size(); k++){
+            Lit imp = ws_bin[k].blocker;
+            if (value(imp) == l_False){
+                confl = ws_bin[k].cref;
+                break;
+            }else if (value(imp) == l_Undef)
+                uncheckedEnqueue(imp, ws_bin[k].cref);
+        }
+        if (confl != CRef_Undef){
+            qhead = trail.size();
+            break;
+        }
+
         for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
             // Try to avoid inspecting the clause:
             Lit blocker = i->blocker;
@@ -997,6 +1313,7 @@ CRef Solver::propagateBool()
 |  Description:
 |    Remove half of the learnt clauses, minus the clauses locked by the current assignment. Locked
 |    clauses are clauses that are reason to some assignment. Binary clauses are never removed.
+|    In LBD mode, only (half of) the local tier is reduced; see 'reduceDBByLBD()'.
 |________________________________________________________________________________________________@*/
 struct reduceDB_lt { 
     ClauseAllocator& ca;
@@ -1006,6 +1323,11 @@ struct reduceDB_lt {
 };
 void Solver::reduceDB()
 {
+    if (lbd_mode) {
+        reduceDBByLBD();
+        return;
+    }
+
     int     i, j;
     double  extra_lim = cla_inc / clauses_removable.size();    // Remove any clause below this activity
 
@@ -1024,6 +1346,63 @@ void Solver::reduceDB()
 }
 
 
+
+/*_________________________________________________________________________________________________
+|
+|  reduceDBByLBD : ()  ->  [void]
+|  
+|  Description:
+|    Reduce the learnt clauses, Glucose-style, by tiers (see 'lbdTier()'):
+|      * core clauses (LBD <= core_lbd) are never removed (only satisfied ones, by 'simplify()',
+|        and the ones above the user level popped, by 'pop()');
+|      * tier-2 clauses not used in conflict analysis since the last reduction go to the local
+|        tier, and will be considered at the next one;
+|      * local clauses used since the last reduction are kept, and of the rest, the half with
+|        the highest LBD (then the lowest activity) is removed, minus the binary and locked ones.
+|    Clauses are moved up a tier when their LBD improves (see 'updateLBD()').
+|________________________________________________________________________________________________@*/
+struct reduceDBByLBD_lt {
+    ClauseAllocator& ca;
+    reduceDBByLBD_lt(ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) {
+        return ca[x].lbd() > ca[y].lbd() || (ca[x].lbd() == ca[y].lbd() && ca[x].activity() < ca[y].activity()); }
+};
+void Solver::reduceDBByLBD()
+{
+    int      i, j;
+    vec<CRef> local;
+
+    reductions++;
+    next_reduce = conflicts + reduce_first + reductions * reduce_inc;
+
+    for (i = 0; i < clauses_removable.size(); i++){
+        Clause& c = ca[clauses_removable[i]];
+        switch (c.tier()) {
+        case Clause::TIER_CORE:
+            break;
+        case Clause::TIER_2:
+            if (!c.used()) setTier(c, Clause::TIER_LOCAL);
+            c.used(false);
+            break;
+        default:
+            if (c.used()) c.used(false);
+            else if (c.size() > 2 && !locked(c)) local.push(clauses_removable[i]);
+        }
+    }
+
+    sort(local, reduceDBByLBD_lt(ca));
+    for (i = 0; i < local.size() / 2; i++)
+        removeClause(local[i]);
+
+    // Drop the removed (marked) clauses from the list
+    for (i = j = 0; i < clauses_removable.size(); i++)
+        if (ca[clauses_removable[i]].mark() != 1)
+            clauses_removable[j++] = clauses_removable[i];
+    clauses_removable.shrink(i - j);
+    checkGarbage();
+}
+
+
 void Solver::removeSatisfied(vec<CRef>& cs)
 {
     int i, j;
@@ -1032,7 +1411,7 @@ void Solver::removeSatisfied(vec<CRef>& cs)
         if (satisfied(c)) {
           if (locked(c)) {
             // store a resolution of the literal c propagated
-            PROOF( ProofManager::getSatProof()->storeUnitResolution(c[0]); )
+            PROOF( ProofManager::getSatProof()->storeUnitResolution(implied(c)); )
           }
             removeClause(cs[i]);
         }
@@ -1099,6 +1478,562 @@ bool Solver::simplify()
 }
 
 
+/*_________________________________________________________________________________________________
+|
+|  inprocess : [void]  ->  [bool]
+|  
+|  Description:
+|    Simplify the clause database at level 0, between restarts, with an effort proportional to the
+|    propagations made since the last round:
+|      * vivify the core and tier-2 learnt clauses (see 'vivifyLearnts()');
+|      * remove the clauses subsumed by others (see 'subsumeClauses()');
+|      * with 'inprocess_elim', eliminate variables (see 'eliminateVars()').
+|    Only Boolean propagation is used, so the theories don't take part. The clauses derived are
+|    given the highest user level of the clauses they're derived from, so that they go away on a
+|    'pop()' with them, and eliminations are undone on a 'pop()' of the level they're made at.
+|    Lemmas queued by the theories at the restart are attached first (see 'updateLemmas()').
+|    Returns FALSE if a conflict is found at level 0.
+|________________________________________________________________________________________________@*/
+bool Solver::inprocess()
+{
+    assert(decisionLevel() == 0);
+
+    inprocessings++;
+    next_inprocess = conflicts + inprocess_int * (inprocessings + 1);
+
+    // (the proofs don't record these derivations)
+    if (PROOF_ON())
+        return true;
+
+    // 'proxy->notifyRestart()' may have queued lemmas (shared ones, say); they must be clauses
+    // before any are vivified, subsumed or eliminated against
+    if (lemmas.size() > 0 && updateLemmas() != CRef_Undef)
+        return ok = false;
+
+    if (!ok || propagate(CHECK_WITHOUT_THEORY) != CRef_Undef)
+        return ok = false;
+
+    int64_t effort = (int64_t)((propagations - inprocess_props) * inprocess_effort);
+    if (effort < inprocess_min_effort)
+        effort = inprocess_min_effort;
+
+    if (!vivifyLearnts(effort))
+        return ok = false;
+    subsumeClauses(effort);
+    if (inprocess_elim && inprocess_original)
+        eliminateVars(effort);
+
+    removeMarked(clauses_removable);
+    removeMarked(clauses_persistent);
+    checkGarbage();
+    inprocess_props = propagations;
+
+    return true;
+}
+
+
+void Solver::removeMarked(vec<CRef>& cs)
+{
+    int i, j;
+    for (i = j = 0; i < cs.size(); i++)
+        if (ca[cs[i]].mark() != 1)
+            cs[j++] = cs[i];
+    cs.shrink(i - j);
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  vivifyLearnts : (effort : int64_t)  ->  [bool]
+|  
+|  Description:
+|    Vivify the learnt clauses of the core and tier-2 tiers (all of them if not in LBD mode), best
+|    ones first, each once, until 'effort' propagations are made: the negations of the literals of
+|    a clause are assigned in turn, and propagated (without the clause); literals found false are
+|    dropped, and the clause is cut short at the first literal found true, or at a conflict.
+|    Returns FALSE if a conflict is found at level 0.
+|________________________________________________________________________________________________@*/
+struct vivify_lt {
+    ClauseAllocator& ca;
+    vivify_lt(ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) {
+        const Clause& c = ca[x];
+        const Clause& d = ca[y];
+        return c.tier() < d.tier() || (c.tier() == d.tier() &&
+               (c.lbd() < d.lbd() || (c.lbd() == d.lbd() && ca[x].activity() > ca[y].activity()))); }
+};
+bool Solver::vivifyLearnts(int64_t effort)
+{
+    vec<CRef> cands;
+    for (int i = 0; i < clauses_removable.size(); i++){
+        const Clause& c = ca[clauses_removable[i]];
+        if (c.mark() == 0 && !c.vivified() && c.size() > 2 && (!lbd_mode || c.tier() != Clause::TIER_LOCAL))
+            cands.push(clauses_removable[i]);
+    }
+    sort(cands, vivify_lt(ca));
+
+    uint64_t limit = propagations + effort;
+    vec<Lit> lits, kept, dropped;
+    for (int i = 0; i < cands.size() && propagations < limit; i++){
+        CRef   cr = cands[i];
+        Clause& c = ca[cr];
+        c.vivified(true);
+        if (satisfied(c) || locked(c))
+            continue;
+
+        detachClause(cr, true);
+        lits.clear();
+        for (int j = 0; j < c.size(); j++)
+            lits.push(c[j]);
+
+        kept.clear();
+        dropped.clear();
+        CRef confl = CRef_Undef;
+        for (int j = 0; j < lits.size(); j++){
+            Lit p = lits[j];
+            if (value(p) == l_False){
+                // Implied false by the negations of the literals kept
+                dropped.push(p);
+                continue;
+            }
+            kept.push(p);
+            if (value(p) == l_True){
+                // Implied true: the rest of the clause isn't needed
+                dropped.push(p);
+                break;
+            }
+            if (j == lits.size() - 1)
+                break;
+            newDecisionLevel();
+            uncheckedEnqueue(~p);
+            confl = propagate(CHECK_WITHOUT_THEORY);
+            if (confl != CRef_Undef)
+                break;
+        }
+
+        int level = kept.size() < lits.size() ? derivationLevel(confl, dropped, c.level()) : c.level();
+        cancelUntil(0);
+
+        if (kept.size() == lits.size()){
+            attachClause(cr);
+            continue;
+        }
+
+        vivified_clauses++;
+        vivified_lits += lits.size() - kept.size();
+        if (drat != NULL) drat->write(CVC4::DratStream::ADD, kept);
+        if (kept.size() == 1){
+            // A unit: the clause is satisfied once it's asserted
+            attachClause(cr);
+            if (drat != NULL) dratUnit(kept[0], assertionLevel);
+            if (value(kept[0]) == l_False)
+                return false;
+            if (value(kept[0]) == l_Undef){
+                uncheckedEnqueue(kept[0]);
+                if (propagate(CHECK_WITHOUT_THEORY) != CRef_Undef)
+                    return false;
+            }
+        }else{
+            if (drat != NULL) drat->write(CVC4::DratStream::DELETE, lits);
+            for (int j = 0; j < kept.size(); j++)
+                c[j] = kept[j];
+            c.shrink(lits.size() - kept.size());
+            c.level(level);
+            if (lbd_mode && c.lbd() >= (unsigned)kept.size()){
+                c.lbd(kept.size() - 1);
+                if (lbdTier(c.lbd()) < c.tier())
+                    c.tier(lbdTier(c.lbd()));
+            }
+            attachClause(cr);
+        }
+    }
+
+    return true;
+}
+
+
+// The user level a clause derived by the current probe of 'vivifyLearnts()', starting from one at
+// 'level', belongs to: the highest level of the clauses the conflict 'confl' (if any) and the
+// values of the literals 'ps' are derived from, through the reasons on the trail down to level 0
+// (where a literal's user level accounts for the clauses it's derived from).
+int Solver::derivationLevel(CRef confl, const vec<Lit>& ps, int level)
+{
+    vec<Var> sources;
+    if (confl != CRef_Undef){
+        const Clause& c = ca[confl];
+        level = std::max(level, c.level());
+        for (int i = 0; i < c.size(); i++)
+            sources.push(var(c[i]));
+    }
+    for (int i = 0; i < ps.size(); i++)
+        sources.push(var(ps[i]));
+
+    for (int i = 0; i < sources.size(); i++){
+        Var x = sources[i];
+        if (this->level(x) == 0)
+            level = std::max(level, user_level(x));
+        else
+            seen[x] = 1;
+    }
+
+    for (int i = trail.size() - 1; decisionLevel() > 0 && i >= trail_lim[0]; i--){
+        Var x = var(trail[i]);
+        if (!seen[x])
+            continue;
+        seen[x] = 0;
+        CRef r = vardata[x].reason;
+        if (r == CRef_Undef)
+            continue;
+        assert(r != CRef_Lazy);
+        const Clause& c = ca[r];
+        level = std::max(level, c.level());
+        for (int j = 0; j < c.size(); j++){
+            Var y = var(c[j]);
+            if (y == x)
+                continue;
+            if (this->level(y) == 0)
+                level = std::max(level, user_level(y));
+            else
+                seen[y] = 1;
+        }
+    }
+
+    return level;
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  subsumeClauses : (effort : int64_t)  ->  [void]
+|  
+|  Description:
+|    Remove the clauses (of at most 'subsume_clause_lim' literals) subsumed by others, smallest
+|    first, until about 'effort' literals are compared. A clause only replaces one it subsumes if
+|    it's there whenever that one is: at the same or a lower user level, and, unless the subsumed
+|    clause is removable, not removable itself. Original clauses are only considered with
+|    'inprocess_original'.
+|________________________________________________________________________________________________@*/
+struct subsume_lt {
+    ClauseAllocator& ca;
+    subsume_lt(ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) { return ca[x].size() < ca[y].size(); }
+};
+void Solver::subsumeClauses(int64_t effort)
+{
+    vec<CRef> cands;
+    for (int i = 0; i < clauses_removable.size(); i++){
+        const Clause& c = ca[clauses_removable[i]];
+        if (c.mark() == 0 && c.size() <= subsume_clause_lim && !satisfied(c))
+            cands.push(clauses_removable[i]);
+    }
+    if (inprocess_original)
+        for (int i = 0; i < clauses_persistent.size(); i++){
+            const Clause& c = ca[clauses_persistent[i]];
+            if (c.mark() == 0 && c.size() <= subsume_clause_lim && !satisfied(c))
+                cands.push(clauses_persistent[i]);
+        }
+    sort(cands, subsume_lt(ca));
+
+    // Each clause kept is listed under just one of its literals: a clause subsuming another is
+    // then in the list of one of the other's literals
+    vec< vec<CRef> > occ;
+    vec<char>        marks;
+    occ  .growTo(2 * nVars());
+    marks.growTo(2 * nVars(), 0);
+
+    for (int i = 0; i < cands.size() && effort > 0; i++){
+        CRef    dr = cands[i];
+        Clause& d  = ca[dr];
+        for (int k = 0; k < d.size(); k++)
+            marks[toInt(d[k])] = 1;
+
+        CRef subsumer = CRef_Undef;
+        for (int k = 0; k < d.size() && subsumer == CRef_Undef; k++){
+            const vec<CRef>& cs = occ[toInt(d[k])];
+            for (int l = 0; l < cs.size(); l++){
+                const Clause& c = ca[cs[l]];
+                int m = 0;
+                while (m < c.size() && marks[toInt(c[m])])
+                    m++;
+                effort -= m + 1;
+                if (m == c.size() && c.level() <= d.level() && (d.removable() || !c.removable())){
+                    subsumer = cs[l];
+                    break;
+                }
+            }
+        }
+
+        for (int k = 0; k < d.size(); k++)
+            marks[toInt(d[k])] = 0;
+
+        if (subsumer != CRef_Undef && !locked(d)){
+            Clause& c = ca[subsumer];
+            if (lbd_mode && c.removable() && d.removable() && d.tier() < c.tier()){
+                c.lbd(d.lbd());
+                setTier(c, d.tier());
+            }
+            removeClause(dr);
+            subsumed_clauses++;
+        }else{
+            int best = 0;
+            for (int k = 1; k < d.size(); k++)
+                if (occ[toInt(d[k])].size() < occ[toInt(d[best])].size())
+                    best = k;
+            occ[toInt(d[best])].push(dr);
+        }
+    }
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  eliminateVars : (effort : int64_t)  ->  [void]
+|  
+|  Description:
+|    Bounded variable elimination: replace the original clauses of an erasable variable (not a
+|    theory atom, nor created frozen) by their resolvents on it, if there are no more of them and
+|    they're not too long (see 'tryEliminate()'), cheapest variables first, until about 'effort'
+|    literals are merged. The learnt clauses of the variables eliminated are removed. The clauses
+|    of an eliminated variable are kept, and restored (see 'restoreVar()') if a new clause refers
+|    to it, or if the user level it was eliminated at is popped.
+|________________________________________________________________________________________________@*/
+struct elim_lt {
+    const vec< vec<CRef> >& occ;
+    elim_lt(const vec< vec<CRef> >& occ_) : occ(occ_) {}
+    uint64_t cost(Var x) const { return (uint64_t)occ[toInt(mkLit(x))].size() * (uint64_t)occ[toInt(~mkLit(x))].size(); }
+    bool operator () (Var x, Var y) const { return cost(x) < cost(y) || (cost(x) == cost(y) && x < y); }
+};
+void Solver::eliminateVars(int64_t effort)
+{
+    vec< vec<CRef> > occ;
+    occ.growTo(2 * nVars());
+    for (int i = 0; i < clauses_persistent.size(); i++){
+        const Clause& c = ca[clauses_persistent[i]];
+        if (c.mark() == 0)
+            for (int k = 0; k < c.size(); k++)
+                occ[toInt(c[k])].push(clauses_persistent[i]);
+    }
+
+    // (the assumptions of this search stay)
+    vec<char> assumed(nVars(), 0);
+    for (int i = 0; i < assumptions.size(); i++)
+        assumed[var(assumptions[i])] = 1;
+
+    vec<Var> cands;
+    for (Var v = 0; v < nVars(); v++){
+        if (!erasable[v] || !decision[v] || value(v) != l_Undef || elim_index[v] >= 0 || (polarity[v] & 0x2) != 0 || assumed[v])
+            continue;
+        int pos = occ[toInt(mkLit(v))].size(), neg = occ[toInt(~mkLit(v))].size();
+        if (pos + neg > 0 && pos <= elim_occ_lim && neg <= elim_occ_lim)
+            cands.push(v);
+    }
+    sort(cands, elim_lt(occ));
+
+    uint64_t eliminated = var_eliminations;
+    for (int i = 0; i < cands.size() && effort > 0; i++)
+        tryEliminate(cands[i], occ, effort);
+
+    if (var_eliminations > eliminated)
+        for (int i = 0; i < clauses_removable.size(); i++){
+            const Clause& c = ca[clauses_removable[i]];
+            if (c.mark() != 0)
+                continue;
+            for (int k = 0; k < c.size(); k++)
+                if (elim_index[var(c[k])] >= 0){
+                    removeClause(clauses_removable[i]);
+                    break;
+                }
+        }
+}
+
+
+bool Solver::tryEliminate(Var v, vec< vec<CRef> >& occ, int64_t& effort)
+{
+    vec<CRef>& pos = occ[toInt(mkLit(v))];
+    vec<CRef>& neg = occ[toInt(~mkLit(v))];
+    // (clauses removed since the lists were built are dropped)
+    removeMarked(pos);
+    removeMarked(neg);
+    if (pos.size() + neg.size() == 0)
+        return false;
+
+    // The resolvents on 'v', leaving out tautologies and the ones satisfied at level 0; there
+    // mustn't be more of them than clauses, and they must be able to propagate
+    vec<Lit> res, out;
+    vec<int> res_sizes, res_levels;
+    for (int i = 0; i < pos.size(); i++){
+        const Clause& c = ca[pos[i]];
+        for (int j = 0; j < neg.size(); j++){
+            const Clause& d = ca[neg[j]];
+            effort -= c.size() + d.size();
+
+            out.clear();
+            for (int k = 0; k < c.size(); k++)
+                if (var(c[k]) != v){
+                    seen[var(c[k])] = sign(c[k]) ? 2 : 1;
+                    out.push(c[k]);
+                }
+            bool tautology = false;
+            for (int k = 0; k < d.size() && !tautology; k++){
+                Var x = var(d[k]);
+                if (x == v)
+                    continue;
+                if (seen[x] == 0)
+                    out.push(d[k]);
+                else if (seen[x] != (sign(d[k]) ? 2 : 1))
+                    tautology = true;
+            }
+            for (int k = 0; k < c.size(); k++)
+                seen[var(c[k])] = 0;
+            if (tautology)
+                continue;
+
+            bool sat = false;
+            int  open = 0;
+            for (int k = 0; k < out.size(); k++){
+                if (value(out[k]) == l_True)
+                    sat = true;
+                if (value(out[k]) != l_False)
+                    open++;
+            }
+            if (sat)
+                continue;
+            if (out.size() > elim_clause_lim || open < 2 || res_sizes.size() >= pos.size() + neg.size())
+                return false;
+            for (int k = 0; k < out.size(); k++)
+                res.push(out[k]);
+            res_sizes.push(out.size());
+            res_levels.push(std::max(c.level(), d.level()));
+        }
+    }
+
+    // Store the clauses of 'v' and remove them (after streaming the resolvents, which they imply)
+    if (drat != NULL)
+        for (int i = 0, first = 0; i < res_sizes.size(); first += res_sizes[i++]){
+            vec<Lit> ps;
+            for (int k = 0; k < res_sizes[i]; k++)
+                ps.push(res[first + k]);
+            drat->write(CVC4::DratStream::ADD, ps);
+        }
+    eliminations.push(Elimination(v, assertionLevel, elim_clauses.size()));
+    elim_index[v] = eliminations.size() - 1;
+    for (int s = 0; s < 2; s++){
+        vec<CRef>& cs = s == 0 ? pos : neg;
+        for (int i = 0; i < cs.size(); i++){
+            const Clause& c = ca[cs[i]];
+            elim_clauses.push(ElimClause(c.level(), elim_lits.size(), c.size()));
+            for (int k = 0; k < c.size(); k++)
+                elim_lits.push(c[k]);
+            removeClause(cs[i]);
+        }
+        cs.clear();
+    }
+    setDecisionVar(v, false);
+    var_eliminations++;
+
+    // Add the resolvents
+    vec<Lit> ps;
+    for (int i = 0, first = 0; i < res_sizes.size(); first += res_sizes[i++]){
+        ps.clear();
+        for (int k = 0; k < res_sizes[i]; k++)
+            ps.push(res[first + k]);
+        sort(ps, lemma_lt(*this));
+        CRef cr = ca.alloc(res_levels[i], ps, false);
+        clauses_persistent.push(cr);
+        attachClause(cr);
+        for (int k = 0; k < ps.size(); k++)
+            occ[toInt(ps[k])].push(cr);
+    }
+
+    return true;
+}
+
+
+// Bring back an eliminated variable: add its clauses that are still there at the current user
+// level, first bringing back the other eliminated variables they mention.
+void Solver::restoreVar(Var v)
+{
+    int e = elim_index[v];
+    assert(e >= 0);
+    elim_index[v] = -1;
+    eliminations[e].var = var_Undef;
+    setDecisionVar(v, true);
+
+    int end = e + 1 < eliminations.size() ? eliminations[e + 1].clauses : elim_clauses.size();
+    vec<Lit> ps;
+    for (int i = eliminations[e].clauses; i < end; i++){
+        const ElimClause& ec = elim_clauses[i];
+        if (ec.level > assertionLevel)
+            continue;
+        ps.clear();
+        for (int k = 0; k < ec.size; k++){
+            Lit p = elim_lits[ec.lits + k];
+            if (elim_index[var(p)] >= 0)
+                restoreVar(var(p));
+            ps.push(p);
+        }
+        restoreClause(ps, ec.level);
+    }
+}
+
+
+// Add back a clause of an eliminated variable at its user level: as a lemma during search, and
+// otherwise directly (it can only propagate, or conflict, because of level 0 assignments made
+// after it was removed).
+void Solver::restoreClause(vec<Lit>& ps, int level)
+{
+    if (drat != NULL) drat->write(CVC4::DratStream::INPUT, ps);
+
+    if (minisat_busy || decisionLevel() > 0){
+        lemmas.push();
+        ps.copyTo(lemmas.last());
+        lemmas_removable.push(false);
+        lemmas_proof_id.push(uint64_t(-1));
+        lemmas_level.push(level);
+        return;
+    }
+
+    sort(ps, lemma_lt(*this));
+    CRef cr = ca.alloc(level, ps, false);
+    clauses_persistent.push(cr);
+    attachClause(cr);
+    if (ok && value(ps[0]) != l_True && value(ps[1]) == l_False){
+        if (value(ps[0]) == l_False)
+            ok = false;
+        else
+            uncheckedEnqueue(ps[0], cr);
+    }
+}
+
+
+// Extend the model to the eliminated variables, latest eliminated first, satisfying their clauses
+// (the resolvents, all satisfied, guarantee this can be done).
+void Solver::extendEliminated()
+{
+    for (int i = eliminations.size() - 1; i >= 0; i--){
+        Var v = eliminations[i].var;
+        if (v == var_Undef)
+            continue;
+        int end = i + 1 < eliminations.size() ? eliminations[i + 1].clauses : elim_clauses.size();
+        model[v] = l_False;
+        for (int j = eliminations[i].clauses; j < end; j++){
+            const ElimClause& ec = elim_clauses[j];
+            Lit  x   = lit_Undef;
+            bool sat = false;
+            for (int k = 0; k < ec.size && !sat; k++){
+                Lit p = elim_lits[ec.lits + k];
+                if (var(p) == v)
+                    x = p;
+                else if (modelValue(p) == l_True)
+                    sat = true;
+            }
+            if (!sat)
+                model[v] = lbool(!sign(x));
+        }
+    }
+}
+
+
 /*_________________________________________________________________________________________________
 |
 |  search : (nof_conflicts : int) (params : const SearchParams&)  ->  [lbool]
@@ -1139,16 +2074,36 @@ lbool Solver::search(int nof_conflicts)
             // Analyze the conflict
             learnt_clause.clear();
             int max_level = analyze(confl, learnt_clause, backtrack_level);
+            // (the LBD is computed while all the literals are still assigned)
+            unsigned lbd = lbd_mode || restart_ema ? computeLBD(learnt_clause) : 0;
+            if (restart_ema) {
+                lbd_fast.update(lbd);
+                lbd_slow.update(lbd);
+                // Postpone restarting while the trail is much larger than usual: the search may be
+                // getting close to a model
+                if (conflicts > restart_block_start && trail.size() > restart_block * trail_avg) {
+                    if (conflictC >= restart_min) blocked_restarts++;
+                    conflictC = 0;
+                }
+                trail_avg.update(trail.size());
+            }
+            if (rephasing) savePhases();
             cancelUntil(backtrack_level);
 
             // Assert the conflict clause and the asserting literal
+            if (drat != NULL) drat->write(CVC4::DratStream::ADD, learnt_clause);
             if (learnt_clause.size() == 1) {
                 uncheckedEnqueue(learnt_clause[0]);
+                if (drat != NULL) dratUnit(learnt_clause[0], assertionLevel);
 
                 PROOF( ProofManager::getSatProof()->endResChain(learnt_clause[0]); )
 
             } else {
                 CRef cr = ca.alloc(max_level, learnt_clause, true);
+                if (lbd_mode) {
+                    ca[cr].lbd(lbd);
+                    ca[cr].tier(lbdTier(lbd));
+                }
                 clauses_removable.push(cr);
                 attachClause(cr);
                 claBumpActivity(ca[cr]);
@@ -1199,10 +2154,17 @@ lbool Solver::search(int nof_conflicts)
               check_type = CHECK_WITH_THEORY;
             }
 
-            if (nof_conflicts >= 0 && conflictC >= nof_conflicts || !withinBudget()) {
+            bool restart = restart_ema
+                ? conflictC >= restart_min && lbd_fast > restart_margin * lbd_slow
+                : nof_conflicts >= 0 && conflictC >= nof_conflicts;
+            if (restart || !withinBudget()) {
                 // Reached bound on number of conflicts:
                 progress_estimate = progressEstimate();
                 cancelUntil(0);
+                if (rephasing) {
+                    target_assigned = 0;
+                    if (conflicts >= next_rephase) rephase();
+                }
                 // [mdeters] notify theory engine of restarts for deferred
                 // theory processing
                 proxy->notifyRestart();
@@ -1214,7 +2176,7 @@ lbool Solver::search(int nof_conflicts)
                 return l_False;
             }
 
-            if (clauses_removable.size()-nAssigns() >= max_learnts) {
+            if (lbd_mode ? conflicts >= next_reduce : clauses_removable.size()-nAssigns() >= max_learnts) {
                 // Reduce the set of learnt clauses:
                 reduceDB();
             }
@@ -1314,13 +2276,28 @@ lbool Solver::solve_()
     model.clear();
     conflict.clear();
     if (!ok){
+      if (drat != NULL) {
+        dratEmpty();
+        drat->flush();
+      }
       minisat_busy = false;
       return l_False;
     }
 
+    // Bring back the assumptions that were eliminated (by an earlier search)
+    for (int i = 0; i < assumptions.size(); i++)
+        if (elim_index[var(assumptions[i])] >= 0)
+            restoreVar(var(assumptions[i]));
+
     solves++;
 
     max_learnts               = nClauses() * learntsize_factor;
+    if (next_reduce == 0)
+        next_reduce           = conflicts + reduce_first;
+    if (next_rephase == 0)
+        next_rephase          = conflicts + rephase_int;
+    if (next_inprocess == 0)
+        next_inprocess        = conflicts + inprocess_int;
     learntsize_adjust_confl   = learntsize_adjust_start_confl;
     learntsize_adjust_cnt     = (int)learntsize_adjust_confl;
     lbool   status            = l_Undef;
@@ -1336,9 +2313,11 @@ lbool Solver::solve_()
     int curr_restarts = 0;
     while (status == l_Undef){
         double rest_base = luby_restart ? luby(restart_inc, curr_restarts) : pow(restart_inc, curr_restarts);
-        status = search(rest_base * restart_first);
+        status = search(restart_ema ? -1 : rest_base * restart_first);
         if (!withinBudget()) break;
         curr_restarts++;
+        if (status == l_Undef && inprocessing && conflicts >= next_inprocess && !inprocess())
+            status = l_False;
     }
 
     if(!withinBudget())
@@ -1355,12 +2334,28 @@ lbool Solver::solve_()
           model[i] = value(i);
           Debug("minisat") << i << " = " << model[i] << std::endl;
         }
+        extendEliminated();
     }else if (status == l_False && conflict.size() == 0)
         ok = false;
 
+    if (drat != NULL) {
+        if (!ok) dratEmpty();
+        drat->flush();
+    }
+
     return status;
 }
 
+
+// Stream the empty clause, once, for an unsat answer (it's implied by unit propagation then).
+void Solver::dratEmpty()
+{
+    if (!drat_empty) {
+        drat->writeEmpty(CVC4::DratStream::ADD);
+        drat_empty = true;
+    }
+}
+
 //=================================================================================================
 // Writing CNF to DIMACS:
 // 
@@ -1448,6 +2443,7 @@ void Solver::relocAll(ClauseAllocator& to)
     //
     // for (int i = 0; i < watches.size(); i++)
     watches.cleanAll();
+    watches_bin.cleanAll();
     for (int v = 0; v < nVars(); v++)
         for (int s = 0; s < 2; s++){
             Lit p = mkLit(v, s);
@@ -1455,6 +2451,9 @@ void Solver::relocAll(ClauseAllocator& to)
             vec<Watcher>& ws = watches[p];
             for (int j = 0; j < ws.size(); j++)
               ca.reloc(ws[j].cref, to,   NULLPROOF( ProofManager::getSatProof()->getProxy() ));
+            vec<Watcher>& ws_bin = watches_bin[p];
+            for (int j = 0; j < ws_bin.size(); j++)
+              ca.reloc(ws_bin[j].cref, to,   NULLPROOF( ProofManager::getSatProof()->getProxy() ));
         }
 
     // All reasons:
@@ -1534,9 +2533,20 @@ void Solver::pop()
   // The head should be at the trail top
   qhead = trail.size();
 
-  // Remove the clauses
+  // Remove the clauses (and the unit clauses streamed)
   removeClausesAboveLevel(clauses_persistent, assertionLevel);
   removeClausesAboveLevel(clauses_removable, assertionLevel);
+  int i, j;
+  for (i = j = 0; i < drat_units.size(); i++) {
+    if (drat_unit_levels[i] > assertionLevel) {
+      drat->write(CVC4::DratStream::DELETE, drat_units[i]);
+    } else {
+      drat_units[j] = drat_units[i];
+      drat_unit_levels[j++] = drat_unit_levels[i];
+    }
+  }
+  drat_units.shrink(i - j);
+  drat_unit_levels.shrink(i - j);
 
   // Pop the SAT context to notify everyone
   context->pop(); // SAT context for CVC4
@@ -1549,6 +2559,35 @@ void Solver::pop()
   // Pop the OK
   ok = trail_ok.last();
   trail_ok.pop();
+  if (ok && drat_empty) {
+    // (the empty clause was derived above the user level)
+    drat->writeEmpty(CVC4::DratStream::DELETE);
+    drat_empty = false;
+  }
+
+  // Undo the variable eliminations done above the user level, bringing back
+  // the variables' clauses that are still there at this level
+  while (eliminations.size() > 0 && eliminations.last().user_level > assertionLevel) {
+    const Elimination& e = eliminations.last();
+    if (e.var != var_Undef && e.var < nVars()) {
+      restoreVar(e.var);
+    }
+    if (e.clauses < elim_clauses.size()) {
+      elim_lits.shrink(elim_lits.size() - elim_clauses[e.clauses].lits);
+      elim_clauses.shrink(elim_clauses.size() - e.clauses);
+    }
+    eliminations.pop();
+  }
+}
+
+void Solver::splitVars(vec<Var>& vars) const {
+  vars.clear();
+  for (Var v = 0; v < nVars(); v++) {
+    if (decision[v] && elim_index[v] < 0 && (value(v) == l_Undef || level(v) > 0)) {
+      vars.push(v);
+    }
+  }
+  sort(vars, VarOrderLt(activity));
 }
 
 bool Solver::flipDecision() {
@@ -1650,13 +2689,15 @@ CRef Solver::updateLemmas() {
     vec<Lit>& lemma = lemmas[i];
     bool removable = lemmas_removable[i];
     uint64_t proof_id = lemmas_proof_id[i];
+    int lemma_level = lemmas_level[i];
     Debug("cores") << "pulled lemma proof id " << proof_id << " " << (proof_id & 0xffffffff) << std::endl;
 
     // Attach it if non-unit
     CRef lemma_ref = CRef_Undef;
     if (lemma.size() > 1) {
       // If the lemmas is removable, we can compute its level by the level
-      int clauseLevel = assertionLevel;
+      // (restored clauses keep theirs)
+      int clauseLevel = lemma_level >= 0 ? lemma_level : assertionLevel;
       if (removable) {
         clauseLevel = 0;
         for (int i = 0; i < lemma.size(); ++ i) {
@@ -1665,6 +2706,9 @@ CRef Solver::updateLemmas() {
       }
 
       lemma_ref = ca.alloc(clauseLevel, lemma, removable);
+      // Removable lemmas go to the local tier, like explanations: their literals needn't be
+      // assigned yet, so the LBD is only a bound (unassigned literals count one level each)
+      if (removable && lbd_mode) ca[lemma_ref].lbd(computeLBD(lemma));
       PROOF( ProofManager::getSatProof()->registerClause(lemma_ref, THEORY_LEMMA, proof_id); );
       if (removable) {
         clauses_removable.push(lemma_ref);
@@ -1701,6 +2745,7 @@ CRef Solver::updateLemmas() {
   lemmas.clear();
   lemmas_removable.clear();
   lemmas_proof_id.clear();
+  lemmas_level.clear();
 
   if (conflict != CRef_Undef) {
     theoryConflict = true;
@@ -38,6 +38,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 
 namespace CVC4 {
   class SatProof;
+  class DratStream;
 
   namespace prop {
     class TheoryProxy;
@@ -87,6 +88,9 @@ protected:
   /** Proof IDs for lemmas */
   vec<uint64_t> lemmas_proof_id;
 
+  /** User level of the lemma (for restored clauses), or -1 to work it out */
+  vec<int> lemmas_level;
+
   /** Do a another check if FULL_EFFORT was the last one */
   bool recheck;
 
@@ -123,6 +127,8 @@ public:
     Var     trueVar() const { return varTrue; }
     Var     falseVar() const { return varFalse; }
 
+    void    setDratStream(CVC4::DratStream* s); // Stream the clause additions and deletions, with the input clauses and theory lemmas, to 's'.
+
     // Less than for literals in a lemma
     struct lemma_lt {
         Solver& solver;
@@ -207,6 +213,7 @@ public:
     int     nVars      ()      const;       // The current number of variables.
     int     nFreeVars  ()      const;
     bool    isDecision (Var x) const;       // is the given var a decision?
+    void    splitVars  (vec<Var>& vars) const; // The decision variables not assigned at level 0, most active first (to split the search on).
 
     // Debugging SMT explanations
     //
@@ -254,10 +261,30 @@ public:
     int       learntsize_adjust_start_confl;
     double    learntsize_adjust_inc;
 
+    bool      lbd_mode;           // Manage the learnt clauses by LBD, in tiers, rather than by activity only.
+    unsigned  core_lbd;           // Learnt clauses with LBD at most this are never reduced.                                  (default 2)
+    unsigned  tier2_lbd;          // Learnt clauses with LBD at most this are kept while they're used.                        (default 6)
+    int       reduce_first;       // In LBD mode, the number of conflicts before the first reduction.                         (default 2000)
+    int       reduce_inc;         // In LBD mode, the increase in the number of conflicts between reductions.                 (default 300)
+
+    bool      restart_ema;        // Restart when the fast moving average of the LBD exceeds the slow one, instead of by 'luby_restart'.
+    double    restart_margin;     // By how much the fast average must exceed the slow one to restart.                         (default 1.25)
+    double    restart_block;      // Block restarts while the trail is larger than this times its moving average.             (default 1.4)
+    bool      rephasing;          // Decide on target phases, and reset the saved phases periodically.
+    int       rephase_int;        // The base interval, in conflicts, between resets of the saved phases.                    (default 1000)
+
+    bool      inprocessing;       // Simplify the clause database periodically, at restarts (see 'inprocess()').
+    int       inprocess_int;      // The base interval, in conflicts, between inprocessing rounds.                           (default 5000)
+    double    inprocess_effort;   // The effort of a round, relative to the propagations since the last one.                 (default 0.1)
+    bool      inprocess_elim;     // Also eliminate variables in the rounds (see 'eliminateVars()').
+
     // Statistics: (read-only member variable)
     //
     uint64_t solves, starts, decisions, rnd_decisions, propagations, conflicts, resources_consumed;
     uint64_t dec_vars, clauses_literals, learnts_literals, max_literals, tot_literals;
+    uint64_t reductions, learnts_tiers[3];  // (learnts_tiers[t] is the number of learnt clauses in tier t)
+    uint64_t blocked_restarts, rephases;
+    uint64_t inprocessings, vivified_clauses, vivified_lits, subsumed_clauses, var_eliminations;
 
 protected:
 
@@ -299,12 +326,44 @@ protected:
         bool operator()(const Watcher& w) const { return ca[w.cref].mark() == 1; }
     };
 
+    // An exponential moving average, for the dynamic restarts. It starts with a smoothing factor of 1,
+    // halved at exponentially growing intervals down to 'alpha', so that it isn't biased towards its
+    // initial zero.
+    struct EMA {
+        double value, alpha, beta;
+        int    wait, period;
+        EMA(double alpha) : value(0), alpha(alpha), beta(1), wait(0), period(0) {}
+        void update(double x) {
+            value += beta * (x - value);
+            if (beta > alpha && wait-- == 0) {
+                wait = period = 2 * (period + 1) - 1;
+                beta = beta / 2 < alpha ? alpha : beta / 2; } }
+        operator double () const { return value; }
+    };
+
     struct VarOrderLt {
         const vec<double>&  activity;
         bool operator () (Var x, Var y) const { return activity[x] > activity[y]; }
         VarOrderLt(const vec<double>&  act) : activity(act) { }
     };
 
+    // A variable eliminated by 'eliminateVars()', with the user level it was eliminated at, and
+    // its clauses (the first of which is 'elim_clauses[clauses]'), to restore it with.
+    struct Elimination {
+        Var var;            // (var_Undef once it's restored)
+        int user_level;
+        int clauses;
+        Elimination(Var v, int user_level, int clauses) : var(v), user_level(user_level), clauses(clauses) {}
+    };
+
+    // A clause of an eliminated variable: its literals are 'elim_lits[lits .. lits+size-1]'.
+    struct ElimClause {
+        int level;
+        int lits;
+        int size;
+        ElimClause(int level, int lits, int size) : level(level), lits(lits), size(size) {}
+    };
+
     // Solver state:
     //
     bool                ok;                 // If FALSE, the constraints are already unsatisfiable. No part of the solver state may be used!
@@ -315,9 +374,20 @@ protected:
     double              var_inc;            // Amount to bump next variable with.
     OccLists<Lit, vec<Watcher>, WatcherDeleted>
                         watches;            // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    OccLists<Lit, vec<Watcher>, WatcherDeleted>
+                        watches_bin;        // 'watches_bin[lit]' is the same, for binary clauses, with the other literal as blocker.
     vec<lbool>          assigns;            // The current assignments.
     vec<int>            assigns_lim;        // The size by levels of the current assignment
     vec<char>           polarity;           // The preferred polarity of each variable (bit 0) and whether it's locked (bit 1).
+    vec<char>           init_polarity;      // The polarity each variable was created with.
+    vec<char>           target_phase;       // The polarity of each variable in the largest conflict-free trail since the last restart (2 if none).
+    vec<char>           best_phase;         // The polarity of each variable in the largest conflict-free trail since the last rephasing (2 if none).
+    int                 target_assigned;    // The size of those trails.
+    int                 best_assigned;
+    uint64_t            next_rephase;       // The number of conflicts at which to reset the saved phases next.
+    EMA                 lbd_fast;           // Moving averages of the LBD of learnt clauses, over a short and a long window,
+    EMA                 lbd_slow;           // and of the size of the trail at conflicts, for 'restart_ema'.
+    EMA                 trail_avg;
     vec<char>           decision;           // Declares if a variable is eligible for selection in the decision heuristic.
     vec<int>            flipped;            // Which trail_lim decisions have been flipped in this context.
     vec<Lit>            trail;              // Assignment stack; stores all assigments made in the order they were made.
@@ -331,6 +401,19 @@ protected:
     Heap<VarOrderLt>    order_heap;         // A priority queue of variables ordered with respect to the variable activity.
     double              progress_estimate;  // Set by 'search()'.
     bool                remove_satisfied;   // Indicates whether possibly inefficient linear scan for satisfied clauses should be performed in 'simplify'.
+    bool                inprocess_original; // Can inprocessing remove and eliminate original clauses? (Not while 'SimpSolver' keeps their occurrences.)
+    uint64_t            next_inprocess;     // The number of conflicts at which to run the next inprocessing round.
+    uint64_t            inprocess_props;    // The number of propagations at the end of the last round.
+    vec<char>           erasable;           // Can the variable be eliminated? (Not if it's a theory atom, or was created frozen.)
+    vec<int>            elim_index;         // The index of the variable's elimination in 'eliminations', or -1.
+    vec<Elimination>    eliminations;       // The eliminated variables, by increasing user level.
+    vec<ElimClause>     elim_clauses;
+    vec<Lit>            elim_lits;
+    CVC4::DratStream*   drat;               // Where the clause additions and deletions are streamed (see 'setDratStream()'), or NULL.
+    bool                drat_empty;         // Has the empty clause been streamed (and not deleted by a 'pop()' since)?
+    bool                drat_derived;       // Are the clauses given to 'addClause_()' derived ones, already streamed as additions (e.g., resolvents)?
+    vec<Lit>            drat_units;         // The unit clauses streamed above user level 0, to delete on the 'pop()' of their level...
+    vec<int>            drat_unit_levels;   // ... the user levels they belong to.
 
     ClauseAllocator     ca;
 
@@ -354,9 +437,13 @@ protected:
     vec<char>           seen;
     vec<Lit>            analyze_stack;
     vec<Lit>            analyze_toclear;
+    vec<Var>            analyze_lazy;
     vec<Lit>            add_tmp;
 
     double              max_learnts;
+    uint64_t            next_reduce;        // In LBD mode, the number of conflicts at which to reduce the learnt clauses next.
+    vec<uint64_t>       lbd_stamps;         // Temporary for 'computeLBD()': the last stamp each decision level was seen with.
+    uint64_t            lbd_stamp;
     double              learntsize_adjust_confl;
     int                 learntsize_adjust_cnt;
 
@@ -387,7 +474,25 @@ protected:
     lbool    search           (int nof_conflicts);                                     // Search for a given number of conflicts.
     lbool    solve_           ();                                                      // Main solve method (assumptions given in 'assumptions').
     void     reduceDB         ();                                                      // Reduce the set of learnt clauses.
+    void     reduceDBByLBD    ();                                                      // Reduce the set of learnt clauses, by tiers and LBD.
+    template<class Lits>
+    unsigned computeLBD       (const Lits& ps);                                        // The number of distinct decision levels of the literals 'ps'.
+    unsigned lbdTier          (unsigned lbd) const;                                    // The tier a learnt clause with the given LBD belongs to.
+    void     setTier          (Clause& c, unsigned tier);                              // Move an (attached) learnt clause to a tier.
+    void     updateLBD        (Clause& c);                                             // Update the LBD of a learnt clause used in conflict analysis.
+    void     savePhases       ();                                                      // Record the target and best phases, at a conflict.
+    void     rephase          ();                                                      // Reset the saved phases to the best, original or flipped ones.
     void     removeSatisfied  (vec<CRef>& cs);                                         // Shrink 'cs' to contain only non-satisfied clauses.
+    void     removeMarked     (vec<CRef>& cs);                                         // Shrink 'cs' to contain only clauses not removed.
+    bool     inprocess        ();                                                      // Simplify the clause database at level 0. Returns FALSE on a conflict.
+    bool     vivifyLearnts    (int64_t effort);                                        // Shorten learnt clauses by propagating their negations.
+    int      derivationLevel  (CRef confl, const vec<Lit>& ps, int level);             // (helper method for 'vivifyLearnts()')
+    void     subsumeClauses   (int64_t effort);                                        // Remove subsumed clauses.
+    void     eliminateVars    (int64_t effort);                                        // Bounded variable elimination of the erasable variables.
+    bool     tryEliminate     (Var v, vec< vec<CRef> >& occ, int64_t& effort);         // (helper method for 'eliminateVars()')
+    void     restoreVar       (Var v);                                                 // Add back the clauses of an eliminated variable.
+    void     restoreClause    (vec<Lit>& ps, int level);                               // (helper method for 'restoreVar()')
+    void     extendEliminated ();                                                      // Extend the model to the eliminated variables.
     void     rebuildOrderHeap ();
 
     // Maintaining Variable/Clause activity:
@@ -403,7 +508,10 @@ protected:
     void     attachClause     (CRef cr);               // Attach a clause to watcher lists.
     void     detachClause     (CRef cr, bool strict = false); // Detach a clause to watcher lists.
     void     removeClause     (CRef cr);               // Detach and free a clause.
+    void     dratUnit         (Lit p, int level);      // Note that the unit clause 'p' was streamed at a user level (to delete it on its 'pop()').
+    void     dratEmpty        ();                      // Stream the empty clause, for an unsat answer.
     bool     locked           (const Clause& c) const; // Returns TRUE if a clause is a reason for some implication in the current state.
+    Lit      implied          (const Clause& c) const; // The literal a clause implies, if it's a reason (see 'propagateBool()').
     bool     satisfied        (const Clause& c) const; // Returns TRUE if a clause is satisfied in the current state.
 
     void     relocAll         (ClauseAllocator& to);
@@ -413,6 +521,8 @@ protected:
     int      decisionLevel    ()      const; // Gives the current decisionlevel.
     uint32_t abstractLevel    (Var x) const; // Used to represent an abstraction of sets of decision levels.
     CRef     reason           (Var x); // Get the reason of the variable (non const as it might create the explanation on the fly)
+    void     explainLazy      (const vec<Var>& xs); // Create the explanations of the theory propagated variables, in one batch
+    bool     theoryReason     (Var x, vec<Lit>& explanation, bool check); // Make the explanation the reason of x (false if it doesn't fit the trail, when checked)
     bool     hasReasonClause  (Var x) const; // Does the variable have a reason
     bool     isPropagated     (Var x) const; // Does the variable have a propagated variables
     bool     isPropagatedBy   (Var x, const Clause& c) const; // Is the value of the variable propagated by the clause Clause C
@@ -450,7 +560,7 @@ inline bool Solver::hasReasonClause(Var x) const { return vardata[x].reason != C
 
 inline bool Solver::isPropagated(Var x) const { return vardata[x].reason != CRef_Undef; }
 
-inline bool Solver::isPropagatedBy(Var x, const Clause& c) const { return vardata[x].reason != CRef_Undef && vardata[x].reason != CRef_Lazy && ca.lea(vardata[var(c[0])].reason) == &c; }
+inline bool Solver::isPropagatedBy(Var x, const Clause& c) const { return vardata[x].reason != CRef_Undef && vardata[x].reason != CRef_Lazy && ca.lea(vardata[x].reason) == &c; }
 
 inline bool Solver::isDecision(Var x) const { Debug("minisat") << "var " << x << " is a decision iff " << (vardata[x].reason == CRef_Undef) << " && " << level(x) << " > 0" << std::endl; return vardata[x].reason == CRef_Undef && level(x) > 0; }
 
@@ -487,6 +597,14 @@ inline void Solver::claBumpActivity (Clause& c) {
                 ca[clauses_removable[i]].activity() *= 1e-20;
             cla_inc *= 1e-20; } }
 
+inline unsigned Solver::lbdTier(unsigned lbd) const {
+    return lbd <= core_lbd ? Clause::TIER_CORE : lbd <= tier2_lbd ? Clause::TIER_2 : Clause::TIER_LOCAL; }
+inline void Solver::setTier(Clause& c, unsigned tier) {
+    assert(c.removable());
+    learnts_tiers[c.tier()]--;
+    learnts_tiers[tier]++;
+    c.tier(tier); }
+
 inline void Solver::checkGarbage(void){ return checkGarbage(garbage_frac); }
 inline void Solver::checkGarbage(double gf){
     if (ca.wasted() > ca.size() * gf)
@@ -503,7 +621,9 @@ inline bool     Solver::addClause       (Lit p, Lit q, bool removable, uint64_t
                                                                 { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); return addClause_(add_tmp, removable, proof_id); }
 inline bool     Solver::addClause       (Lit p, Lit q, Lit r, bool removable, uint64_t proof_id)
                                                                 { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); add_tmp.push(r); return addClause_(add_tmp, removable, proof_id); }
-inline bool     Solver::locked          (const Clause& c) const { return value(c[0]) == l_True && isPropagatedBy(var(c[0]), c); }
+inline bool     Solver::locked          (const Clause& c) const { Lit p = implied(c); return value(p) == l_True && isPropagatedBy(var(p), c); }
+// Binary clauses propagate without being reordered, so one that implies c[1] has c[0] false
+inline Lit      Solver::implied         (const Clause& c) const { return c.size() == 2 && value(c[0]) != l_True ? c[1] : c[0]; }
 inline void     Solver::newDecisionLevel()                      { trail_lim.push(trail.size()); flipped.push(false); context->push(); if(Dump.isOn("state")) { Dump("state") << CVC4::PushCommand(); } }
 
 inline int      Solver::decisionLevel ()      const   { return trail_lim.size(); }
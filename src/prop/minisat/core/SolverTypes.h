@@ -25,6 +25,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 
 #include <assert.h>
 #include "util/output.h"
+#include "util/cvc4_assert.h"
 #include "prop/minisat/mtl/IntTypes.h"
 #include "prop/minisat/mtl/Alg.h"
 #include "prop/minisat/mtl/Vec.h"
@@ -192,8 +193,12 @@ class Clause {
         unsigned removable : 1;
         unsigned has_extra : 1;
         unsigned reloced   : 1;
-        unsigned size      : 27;
-        unsigned level     : 32; }                            header;
+        unsigned size      : 26;
+        unsigned vivified  : 1;
+        unsigned level     : 22;
+        unsigned lbd       : 7;
+        unsigned tier      : 2;
+        unsigned used      : 1; }                             header;
     union { Lit lit; float act; uint32_t abs; CRef rel; } data[0];
 
     friend class ClauseAllocator;
@@ -207,6 +212,12 @@ class Clause {
         header.reloced   = 0;
         header.size      = ps.size();
         header.level     = level;
+        header.lbd       = 0;
+        header.tier      = removable ? TIER_LOCAL : TIER_CORE;
+        header.used      = 0;
+        header.vivified  = 0;
+        // the level has 22 bits; check it in release builds, too
+        AlwaysAssert((int)header.level == level, "clause level out of range");
 
         for (int i = 0; i < ps.size(); i++) 
             data[i].lit = ps[i];
@@ -219,6 +230,12 @@ class Clause {
     }
 
 public:
+    // The tiers of the learnt clause database (see Solver::reduceDB()):
+    // core clauses are kept, tier-2 ones are kept while they're used,
+    // and local ones are reduced by LBD and activity.
+    enum { TIER_CORE = 0, TIER_2 = 1, TIER_LOCAL = 2 };
+    enum { LBD_MAX = 127 };
+
     void calcAbstraction() {
         assert(header.has_extra);
         uint32_t abstraction = 0;
@@ -228,10 +245,19 @@ public:
 
 
     int          level       ()      const   { return header.level; }
+    void         level       (int l)         { header.level = l; AlwaysAssert((int)header.level == l, "clause level out of range"); }
     int          size        ()      const   { return header.size; }
     void         shrink      (int i)         { assert(i <= size()); if (header.has_extra) data[header.size-i] = data[header.size]; header.size -= i; }
     void         pop         ()              { shrink(1); }
     bool         removable   ()      const   { return header.removable; }
+    unsigned     lbd         ()      const   { return header.lbd; }
+    void         lbd         (unsigned l)    { header.lbd = l < LBD_MAX ? l : LBD_MAX; }
+    unsigned     tier        ()      const   { return header.tier; }
+    void         tier        (unsigned t)    { header.tier = t; }
+    bool         used        ()      const   { return header.used; }
+    void         used        (bool u)        { header.used = u; }
+    bool         vivified    ()      const   { return header.vivified; }
+    void         vivified    (bool v)        { header.vivified = v; }
     bool         has_extra   ()      const   { return header.has_extra; }
     uint32_t     mark        ()      const   { return header.mark; }
     void         mark        (uint32_t m)    { header.mark = m; }
@@ -319,6 +345,10 @@ class ClauseAllocator : public RegionAllocator<uint32_t>
         // Copy extra data-fields: 
         // (This could be cleaned-up. Generalize Clause-constructor to be applicable here instead?)
         to[cr].mark(c.mark());
+        to[cr].lbd(c.lbd());
+        to[cr].tier(c.tier());
+        to[cr].used(c.used());
+        to[cr].vivified(c.vivified());
         if (to[cr].removable())         to[cr].activity() = c.activity();
         else if (to[cr].has_extra()) to[cr].calcAbstraction();
     }
@@ -21,6 +21,8 @@
 #include "prop/options.h"
 #include "smt/options.h"
 #include "decision/options.h"
+#include "proof/options.h"
+#include "proof/drat_stream.h"
 
 using namespace CVC4;
 using namespace CVC4::prop;
@@ -29,11 +31,13 @@ using namespace CVC4::prop;
 
 MinisatSatSolver::MinisatSatSolver() :
   d_minisat(NULL),
-  d_context(NULL)
+  d_context(NULL),
+  d_drat(NULL)
 {}
 
 MinisatSatSolver::~MinisatSatSolver() {
   delete d_minisat;
+  delete d_drat;
 }
 
 SatVariable MinisatSatSolver::toSatVariable(Minisat::Var var) {
@@ -119,10 +123,15 @@ void MinisatSatSolver::initialize(context::Context* context, TheoryProxy* theory
              << " unless using internal decision strategy." << std::endl;
   }
 
+  if(options::dratFile() != NULL) {
+    d_drat = new DratStream(options::dratFile());
+  }
+
   // Create the solver
   d_minisat = new Minisat::SimpSolver(theoryProxy, d_context,
                                       options::incrementalSolving() ||
-                                      options::decisionMode() != decision::DECISION_STRATEGY_INTERNAL );
+                                      options::decisionMode() != decision::DECISION_STRATEGY_INTERNAL,
+                                      d_drat);
 
   d_statistics.init(d_minisat);
 }
@@ -147,6 +156,28 @@ void MinisatSatSolver::setupOptions() {
   d_minisat->clause_decay = options::satClauseDecay();
   d_minisat->restart_first = options::satRestartFirst();
   d_minisat->restart_inc = options::satRestartInc();
+
+  // Learnt clause database management
+  d_minisat->lbd_mode = options::satLbd();
+  d_minisat->core_lbd = options::satCoreLbd();
+  d_minisat->tier2_lbd = options::satTier2Lbd();
+  d_minisat->reduce_first = options::satReduceFirst();
+  d_minisat->reduce_inc = options::satReduceInc();
+
+  // Restarts and phases
+  d_minisat->restart_ema = options::satRestartEma();
+  d_minisat->restart_margin = options::satRestartMargin();
+  d_minisat->restart_block = options::satRestartBlock();
+  d_minisat->rephasing = options::satRephase();
+  d_minisat->rephase_int = options::satRephaseInt();
+
+  // Inprocessing
+  d_minisat->inprocessing = options::satInprocess();
+  d_minisat->inprocess_int = options::satInprocessInt();
+  // (not tied to --minisat-elimination, which models turn off: the
+  // eliminated variables' values are reconstructed, see extendEliminated())
+  d_minisat->inprocess_elim = options::satInprocessElim() &&
+                              options::decisionMode() == decision::DECISION_STRATEGY_INTERNAL;
 }
 
 void MinisatSatSolver::addClause(SatClause& clause, bool removable, uint64_t proof_id) {
@@ -182,6 +213,23 @@ SatValue MinisatSatSolver::solve() {
   return toSatLiteralValue(d_minisat->solve());
 }
 
+SatValue MinisatSatSolver::solve(const std::vector<SatLiteral>& assumptions) {
+  setupOptions();
+  Minisat::vec<Minisat::Lit> assumps;
+  for(unsigned i = 0; i < assumptions.size(); ++i) {
+    assumps.push(toMinisatLit(assumptions[i]));
+  }
+  d_minisat->budgetOff();
+  return toSatLiteralValue(d_minisat->solve(assumps));
+}
+
+void MinisatSatSolver::getUnsatAssumptions(std::vector<SatLiteral>& failed) const {
+  // the final conflict is the clause of the negated failed assumptions
+  for(int i = 0; i < d_minisat->conflict.size(); ++i) {
+    failed.push_back(toSatLiteral(~d_minisat->conflict[i]));
+  }
+}
+
 
 void MinisatSatSolver::interrupt() {
   d_minisat->interrupt();
@@ -215,6 +263,14 @@ bool MinisatSatSolver::isDecision(SatVariable decn) const {
   return d_minisat->isDecision( decn ); 
 }
 
+void MinisatSatSolver::getSplitVariables(std::vector<SatVariable>& vars) const {
+  Minisat::vec<Minisat::Var> splitVars;
+  d_minisat->splitVars(splitVars);
+  for(int i = 0; i < splitVars.size(); ++i) {
+    vars.push_back(toSatVariable(splitVars[i]));
+  }
+}
+
 /** Incremental interface */
 
 unsigned MinisatSatSolver::getAssertionLevel() const {
@@ -240,7 +296,18 @@ MinisatSatSolver::Statistics::Statistics() :
   d_statClausesLiterals("sat::clauses_literals"),
   d_statLearntsLiterals("sat::learnts_literals"),
   d_statMaxLiterals("sat::max_literals"),
-  d_statTotLiterals("sat::tot_literals")
+  d_statTotLiterals("sat::tot_literals"),
+  d_statReductions("sat::reductions"),
+  d_statLearntsCore("sat::learnts_core"),
+  d_statLearntsTier2("sat::learnts_tier2"),
+  d_statLearntsLocal("sat::learnts_local"),
+  d_statBlockedRestarts("sat::blocked_restarts"),
+  d_statRephases("sat::rephases"),
+  d_statInprocessings("sat::inprocessings"),
+  d_statVivifiedClauses("sat::vivified_clauses"),
+  d_statVivifiedLits("sat::vivified_lits"),
+  d_statSubsumedClauses("sat::subsumed_clauses"),
+  d_statVarEliminations("sat::var_eliminations")
 {
   StatisticsRegistry::registerStat(&d_statStarts);
   StatisticsRegistry::registerStat(&d_statDecisions);
@@ -251,6 +318,17 @@ MinisatSatSolver::Statistics::Statistics() :
   StatisticsRegistry::registerStat(&d_statLearntsLiterals);
   StatisticsRegistry::registerStat(&d_statMaxLiterals);
   StatisticsRegistry::registerStat(&d_statTotLiterals);
+  StatisticsRegistry::registerStat(&d_statReductions);
+  StatisticsRegistry::registerStat(&d_statLearntsCore);
+  StatisticsRegistry::registerStat(&d_statLearntsTier2);
+  StatisticsRegistry::registerStat(&d_statLearntsLocal);
+  StatisticsRegistry::registerStat(&d_statBlockedRestarts);
+  StatisticsRegistry::registerStat(&d_statRephases);
+  StatisticsRegistry::registerStat(&d_statInprocessings);
+  StatisticsRegistry::registerStat(&d_statVivifiedClauses);
+  StatisticsRegistry::registerStat(&d_statVivifiedLits);
+  StatisticsRegistry::registerStat(&d_statSubsumedClauses);
+  StatisticsRegistry::registerStat(&d_statVarEliminations);
 }
 MinisatSatSolver::Statistics::~Statistics() {
   StatisticsRegistry::unregisterStat(&d_statStarts);
@@ -262,6 +340,17 @@ MinisatSatSolver::Statistics::~Statistics() {
   StatisticsRegistry::unregisterStat(&d_statLearntsLiterals);
   StatisticsRegistry::unregisterStat(&d_statMaxLiterals);
   StatisticsRegistry::unregisterStat(&d_statTotLiterals);
+  StatisticsRegistry::unregisterStat(&d_statReductions);
+  StatisticsRegistry::unregisterStat(&d_statLearntsCore);
+  StatisticsRegistry::unregisterStat(&d_statLearntsTier2);
+  StatisticsRegistry::unregisterStat(&d_statLearntsLocal);
+  StatisticsRegistry::unregisterStat(&d_statBlockedRestarts);
+  StatisticsRegistry::unregisterStat(&d_statRephases);
+  StatisticsRegistry::unregisterStat(&d_statInprocessings);
+  StatisticsRegistry::unregisterStat(&d_statVivifiedClauses);
+  StatisticsRegistry::unregisterStat(&d_statVivifiedLits);
+  StatisticsRegistry::unregisterStat(&d_statSubsumedClauses);
+  StatisticsRegistry::unregisterStat(&d_statVarEliminations);
 }
 void MinisatSatSolver::Statistics::init(Minisat::SimpSolver* d_minisat){
   d_statStarts.setData(d_minisat->starts);
@@ -273,4 +362,15 @@ void MinisatSatSolver::Statistics::init(Minisat::SimpSolver* d_minisat){
   d_statLearntsLiterals.setData(d_minisat->learnts_literals);
   d_statMaxLiterals.setData(d_minisat->max_literals);
   d_statTotLiterals.setData(d_minisat->tot_literals);
+  d_statReductions.setData(d_minisat->reductions);
+  d_statLearntsCore.setData(d_minisat->learnts_tiers[Minisat::Clause::TIER_CORE]);
+  d_statLearntsTier2.setData(d_minisat->learnts_tiers[Minisat::Clause::TIER_2]);
+  d_statLearntsLocal.setData(d_minisat->learnts_tiers[Minisat::Clause::TIER_LOCAL]);
+  d_statBlockedRestarts.setData(d_minisat->blocked_restarts);
+  d_statRephases.setData(d_minisat->rephases);
+  d_statInprocessings.setData(d_minisat->inprocessings);
+  d_statVivifiedClauses.setData(d_minisat->vivified_clauses);
+  d_statVivifiedLits.setData(d_minisat->vivified_lits);
+  d_statSubsumedClauses.setData(d_minisat->subsumed_clauses);
+  d_statVarEliminations.setData(d_minisat->var_eliminations);
 }
@@ -22,6 +22,9 @@
 #include "prop/minisat/simp/SimpSolver.h"
 
 namespace CVC4 {
+
+class DratStream;
+
 namespace prop {
 
 class MinisatSatSolver : public DPLLSatSolverInterface {
@@ -32,6 +35,9 @@ class MinisatSatSolver : public DPLLSatSolverInterface {
   /** Context we will be using to synchronize the sat solver */
   context::Context* d_context;
 
+  /** The stream of clause additions and deletions, with --drat-file */
+  DratStream* d_drat;
+
   void setupOptions();
 
 public:
@@ -60,6 +66,9 @@ public:
 
   SatValue solve();
   SatValue solve(long unsigned int&);
+  SatValue solve(const std::vector<SatLiteral>& assumptions);
+
+  void getUnsatAssumptions(std::vector<SatLiteral>& failed) const;
 
   void interrupt();
 
@@ -83,13 +92,20 @@ public:
 
   bool isDecision(SatVariable decn) const;
 
+  void getSplitVariables(std::vector<SatVariable>& vars) const;
+
   class Statistics {
   private:
     ReferenceStat<uint64_t> d_statStarts, d_statDecisions;
     ReferenceStat<uint64_t> d_statRndDecisions, d_statPropagations;
     ReferenceStat<uint64_t> d_statConflicts, d_statClausesLiterals;
     ReferenceStat<uint64_t> d_statLearntsLiterals,  d_statMaxLiterals;
-    ReferenceStat<uint64_t> d_statTotLiterals;
+    ReferenceStat<uint64_t> d_statTotLiterals, d_statReductions;
+    ReferenceStat<uint64_t> d_statLearntsCore, d_statLearntsTier2;
+    ReferenceStat<uint64_t> d_statLearntsLocal, d_statBlockedRestarts;
+    ReferenceStat<uint64_t> d_statRephases, d_statInprocessings;
+    ReferenceStat<uint64_t> d_statVivifiedClauses, d_statVivifiedLits;
+    ReferenceStat<uint64_t> d_statSubsumedClauses, d_statVarEliminations;
   public:
     Statistics();
     ~Statistics();
@@ -22,6 +22,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "prop/minisat/simp/SimpSolver.h"
 #include "prop/minisat/utils/System.h"
 #include "prop/options.h"
+#include "proof/drat_stream.h"
 #include "proof/proof.h"
 using namespace Minisat;
 using namespace CVC4;
@@ -45,7 +46,7 @@ static DoubleOption opt_simp_garbage_frac(_cat, "simp-gc-frac", "The fraction of
 // Constructor/Destructor:
 
 
-SimpSolver::SimpSolver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* context, bool enableIncremental) :
+SimpSolver::SimpSolver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* context, bool enableIncremental, CVC4::DratStream* drat) :
     Solver(proxy, context, enableIncremental)
   , grow               (opt_grow)
   , clause_lim         (opt_clause_lim)
@@ -74,6 +75,8 @@ SimpSolver::SimpSolver(CVC4::prop::TheoryProxy* proxy, CVC4::context::Context* c
     ca.extra_clause_field = true; // NOTE: must happen before allocating the dummy clause below.
     bwdsub_tmpunit        = ca.alloc(0, dummy);
     remove_satisfied      = false;
+    inprocess_original    = !use_simplification;
+    setDratStream(drat);
 
     // add the initialization for all the internal variables
     for (int i = frozen.size(); i < vardata.size(); ++ i) {
@@ -227,6 +230,17 @@ bool SimpSolver::strengthenClause(CRef cr, Lit l)
     // if (!find(subsumption_queue, &c))
     subsumption_queue.insert(cr);
 
+    // The strengthened clause is streamed before the old one is deleted
+    if (drat != NULL){
+        vec<Lit> ps;
+        for (int i = 0; i < c.size(); i++)
+            if (c[i] != l)
+                ps.push(c[i]);
+        drat->write(CVC4::DratStream::ADD, ps);
+        if (ps.size() == 1) dratUnit(ps[0], assertionLevel);
+        if (c.size() > 2) drat->write(CVC4::DratStream::DELETE, c);
+    }
+
     if (c.size() == 2){
         removeClause(cr);
         c.strengthen(l);
@@ -537,18 +551,28 @@ bool SimpSolver::eliminateVar(Var v)
         mkElimClause(elimclauses, ~mkLit(v));
     }
 
+    // The resolvents are streamed before the clauses that imply them are deleted
+    vec<Lit>& resolvent = add_tmp;
+    if (drat != NULL)
+        for (int i = 0; i < pos.size(); i++)
+            for (int j = 0; j < neg.size(); j++)
+                if (merge(ca[pos[i]], ca[neg[j]], v, resolvent))
+                    drat->write(CVC4::DratStream::ADD, resolvent);
+
     for (int i = 0; i < cls.size(); i++)
         removeClause(cls[i]); 
 
     // Produce clauses in cross product:
-    vec<Lit>& resolvent = add_tmp;
+    drat_derived = true;
     for (int i = 0; i < pos.size(); i++)
         for (int j = 0; j < neg.size(); j++) {
             bool removable = ca[pos[i]].removable() && ca[pos[neg[j]]].removable();
             if (merge(ca[pos[i]], ca[neg[j]], v, resolvent) && !addClause_(resolvent, removable, uint64_t(-1))) {
+                drat_derived = false;
                 return false;
             }
         }
+    drat_derived = false;
 
     // Free occurs list for this variable:
     occurs[v].clear(true);
@@ -556,6 +580,8 @@ bool SimpSolver::eliminateVar(Var v)
     // Free watchers lists for this variable, if possible:
     if (watches[ mkLit(v)].size() == 0) watches[ mkLit(v)].clear(true);
     if (watches[~mkLit(v)].size() == 0) watches[~mkLit(v)].clear(true);
+    if (watches_bin[ mkLit(v)].size() == 0) watches_bin[ mkLit(v)].clear(true);
+    if (watches_bin[~mkLit(v)].size() == 0) watches_bin[~mkLit(v)].clear(true);
 
     return backwardSubsumptionCheck();
 }
@@ -29,10 +29,13 @@
 #include "util/cvc4_assert.h"
 #include "options/options.h"
 #include "smt/options.h"
+#include "expr/options.h"
 #include "main/options.h"
 #include "util/output.h"
 #include "util/result.h"
 #include "util/resource_manager.h"
+#include "util/node_visitor.h"
+#include "util/hash.h"
 #include "expr/expr.h"
 #include "expr/command.h"
 
@@ -91,7 +94,7 @@ PropEngine::PropEngine(TheoryEngine* te, DecisionEngine *de, Context* satContext
      options::decisionMode() == decision::DECISION_STRATEGY_RELEVANCY
      );
 
-  d_theoryProxy = new TheoryProxy(this, d_theoryEngine, d_decisionEngine, d_context, d_cnfStream);
+  d_theoryProxy = new TheoryProxy(this, d_theoryEngine, d_decisionEngine, d_context, userContext, d_cnfStream);
   d_satSolver->initialize(d_context, d_theoryProxy);
 
   d_decisionEngine->setSatSolver(d_satSolver);
@@ -140,6 +143,31 @@ bool PropEngine::isDecision(Node lit) const {
   return d_satSolver->isDecision(d_cnfStream->getLiteral(lit).getSatVariable());
 }
 
+void PropEngine::getSplitAtoms(std::vector<Node>& atoms, unsigned n) const {
+  Assert(!d_inCheckSat, "Sat solver in solve()!");
+  vector<SatVariable> vars;
+  d_satSolver->getSplitVariables(vars);
+  const CnfStream::LiteralToNodeMap& nodeCache = d_cnfStream->getNodeCache();
+  for(unsigned i = 0; i < vars.size() && atoms.size() < n; ++i) {
+    SatLiteral lit(vars[i]);
+    if(!nodeCache.contains(lit)) {
+      continue;
+    }
+    TNode atom = nodeCache[lit];
+    // skolems come from preprocessing; an atom over them can't be
+    // stated in terms of the input
+    bool hasSkolem = false;
+    NodeMarks visited;
+    for(PreorderNodeIterator j(atom, visited); !j.done() && !hasSkolem; ++j) {
+      hasSkolem = j->getKind() == kind::SKOLEM;
+    }
+    if(!hasSkolem) {
+      Debug("prop::split") << "split atom " << lit << ": " << atom << endl;
+      atoms.push_back(atom);
+    }
+  }
+}
+
 void PropEngine::printSatisfyingAssignment(){
   const CnfStream::NodeToLiteralMap& transCache =
     d_cnfStream->getTranslationCache();
@@ -161,8 +189,21 @@ void PropEngine::printSatisfyingAssignment(){
 }
 
 Result PropEngine::checkSat() {
+  return checkSat(std::vector<Node>());
+}
+
+Result PropEngine::checkSat(const std::vector<Node>& assumptions) {
   Assert(!d_inCheckSat, "Sat solver in solve()!");
-  Debug("prop") << "PropEngine::checkSat()" << endl;
+  Debug("prop") << "PropEngine::checkSat(" << assumptions.size() << " assumptions)" << endl;
+
+  // Get the literals of the assumptions (before the search starts)
+  d_assumptions = assumptions;
+  d_assumptionLiterals.clear();
+  for(unsigned i = 0; i < assumptions.size(); ++i) {
+    Assert(assumptions[i].getType().isBoolean());
+    d_cnfStream->ensureLiteral(assumptions[i]);
+    d_assumptionLiterals.push_back(d_cnfStream->getLiteral(assumptions[i]));
+  }
 
   // Mark that we are in the checkSat
   ScopedBool scopedBool(d_inCheckSat);
@@ -179,7 +220,16 @@ Result PropEngine::checkSat() {
   d_interrupted = false;
 
   // Check the problem
-  SatValue result = d_satSolver->solve();
+  SatValue result;
+  {
+    ZombieReclamationDeferral deferGc(NodeManager::currentNM(),
+                                      options::deferGcDuringSearch());
+    if(d_assumptionLiterals.empty()) {
+      result = d_satSolver->solve();
+    } else {
+      result = d_satSolver->solve(d_assumptionLiterals);
+    }
+  }
 
   if( result == SAT_VALUE_UNKNOWN ) {
 
@@ -203,6 +253,17 @@ Result PropEngine::checkSat() {
   return Result(result == SAT_VALUE_TRUE ? Result::SAT : Result::UNSAT);
 }
 
+void PropEngine::getUnsatAssumptions(std::vector<Node>& assumptions) const {
+  std::vector<SatLiteral> failed;
+  d_satSolver->getUnsatAssumptions(failed);
+  std::hash_set<SatLiteral, SatLiteralHashFunction> failedSet(failed.begin(), failed.end());
+  for(unsigned i = 0; i < d_assumptionLiterals.size(); ++i) {
+    if(failedSet.find(d_assumptionLiterals[i]) != failedSet.end()) {
+      assumptions.push_back(d_assumptions[i]);
+    }
+  }
+}
+
 Node PropEngine::getValue(TNode node) const {
   Assert(node.getType().isBoolean());
   Assert(d_cnfStream->hasLiteral(node));
@@ -27,6 +27,7 @@
 #include "util/unsafe_interrupt_exception.h"
 #include "smt/modal_exception.h"
 #include "proof/proof_manager.h"
+#include "prop/sat_solver_types.h"
 #include <sys/time.h>
 
 namespace CVC4 {
@@ -82,6 +83,12 @@ class PropEngine {
   /** The CNF converter in use */
   CnfStream* d_cnfStream;
 
+  /** The assumptions of the last checkSat() */
+  std::vector<Node> d_assumptions;
+
+  /** The SAT literals of d_assumptions, in the same order */
+  std::vector<SatLiteral> d_assumptionLiterals;
+
   /** Whether we were just interrupted (or not) */
   bool d_interrupted;
   /** Pointer to resource manager for associated SmtEngine */
@@ -162,12 +169,34 @@ public:
    */
   bool isDecision(Node lit) const;
 
+  /**
+   * Get (at most) n atoms to split the search on, the most promising
+   * first, as the SAT solver sees it after a check: among the atoms
+   * not assigned at the root, those over the user's symbols (not
+   * skolems) only.
+   */
+  void getSplitAtoms(std::vector<Node>& atoms, unsigned n) const;
+
   /**
    * Checks the current context for satisfiability.
    *
    */
   Result checkSat();
 
+  /**
+   * Checks the current context for satisfiability under the given
+   * (Boolean) assumptions.  They are only assumed by the SAT solver
+   * for the duration of this call, so unlike asserting them no
+   * push()/pop() is needed around it.
+   */
+  Result checkSat(const std::vector<Node>& assumptions);
+
+  /**
+   * After an UNSAT checkSat() under assumptions, get the assumptions
+   * the SAT solver found enough for the conflict.
+   */
+  void getUnsatAssumptions(std::vector<Node>& assumptions) const;
+
   /**
    * Get the value of a boolean variable.
    *
@@ -136,6 +136,26 @@ public:
 
   virtual bool isDecision(SatVariable decn) const = 0;
 
+  /**
+   * The variables still open at the root, the most promising ones to
+   * split the search on first (e.g., by the decision heuristic's
+   * activity).
+   */
+  virtual void getSplitVariables(std::vector<SatVariable>& vars) const = 0;
+
+  /**
+   * Check the satisfiability of the added clauses under the given
+   * assumptions, which only hold for this call.
+   */
+  virtual SatValue solve(const std::vector<SatLiteral>& assumptions) = 0;
+
+  /**
+   * After an unsatisfiable solve() under assumptions, the assumptions
+   * that were enough for the conflict (empty if the clauses are
+   * unsatisfiable on their own).
+   */
+  virtual void getUnsatAssumptions(std::vector<SatLiteral>& failed) const = 0;
+
 };/* class DPLLSatSolverInterface */
 
 inline std::ostream& operator <<(std::ostream& out, prop::SatLiteral lit) {
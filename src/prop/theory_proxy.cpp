@@ -59,6 +59,61 @@ void TheoryProxy::explainPropagation(SatLiteral l, SatClause& explanation) {
   Debug("prop-explain") << "explainPropagation(" << lNode << ")" << std::endl;
   Node theoryExplanation = d_theoryEngine->getExplanation(lNode);
   Debug("prop-explain") << "explainPropagation() => " <<  theoryExplanation << std::endl;
+  ++d_explanationsComputed;
+  d_explanations.insert(lNode, theoryExplanation);
+  toExplanationClause(l, theoryExplanation, explanation);
+}
+
+void TheoryProxy::explainPropagations(const std::vector<SatLiteral>& literals,
+                                      std::vector<SatClause>& explanations,
+                                      bool fresh) {
+  explanations.clear();
+  explanations.resize(literals.size());
+
+  // Reuse what we can, and ask the theories for the rest in one go
+  std::vector<TNode> toExplain;
+  std::vector<unsigned> toExplainIndex;
+  for (unsigned i = 0, i_end = literals.size(); i < i_end; ++ i) {
+    TNode lNode = d_cnfStream->getNode(literals[i]);
+    if (!fresh) {
+      context::CDHashMap<Node, Node, NodeHashFunction>::const_iterator find = d_explanations.find(lNode);
+      if (find != d_explanations.end() && hasLiterals((*find).second)) {
+        Debug("prop-explain") << "explainPropagations(): reusing " << (*find).second << " for " << lNode << std::endl;
+        ++d_explanationsReused;
+        toExplanationClause(literals[i], (*find).second, explanations[i]);
+        continue;
+      }
+    }
+    toExplain.push_back(lNode);
+    toExplainIndex.push_back(i);
+  }
+  if (toExplain.empty()) {
+    return;
+  }
+
+  std::vector<Node> theoryExplanations;
+  d_theoryEngine->getExplanations(toExplain, theoryExplanations);
+  for (unsigned k = 0, k_end = toExplain.size(); k < k_end; ++ k) {
+    Debug("prop-explain") << "explainPropagations(): " << toExplain[k] << " => " << theoryExplanations[k] << std::endl;
+    ++d_explanationsComputed;
+    d_explanations.insert(toExplain[k], theoryExplanations[k]);
+    toExplanationClause(literals[toExplainIndex[k]], theoryExplanations[k], explanations[toExplainIndex[k]]);
+  }
+}
+
+bool TheoryProxy::hasLiterals(TNode theoryExplanation) const {
+  if (theoryExplanation.getKind() == kind::AND) {
+    for (unsigned i = 0; i < theoryExplanation.getNumChildren(); ++ i) {
+      if (!d_cnfStream->hasLiteral(theoryExplanation[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return d_cnfStream->hasLiteral(theoryExplanation);
+}
+
+void TheoryProxy::toExplanationClause(SatLiteral l, TNode theoryExplanation, SatClause& explanation) {
   if (theoryExplanation.getKind() == kind::AND) {
     Node::const_iterator it = theoryExplanation.begin();
     Node::const_iterator it_end = theoryExplanation.end();
@@ -27,6 +27,7 @@
 #include "util/statistics_registry.h"
 
 #include "context/cdqueue.h"
+#include "context/cdhashmap.h"
 
 #include "prop/sat_solver.h"
 
@@ -60,6 +61,12 @@ class TheoryProxy {
   /** Queue of asserted facts */
   context::CDQueue<TNode> d_queue;
 
+  /**
+   * The explanations of the theory propagations, by literal, kept
+   * (until the user pops) for when the literal is propagated again.
+   */
+  context::CDHashMap<Node, Node, NodeHashFunction> d_explanations;
+
   /**
    * Set of all lemmas that have been "shared" in the portfolio---i.e.,
    * all imported and exported lemmas.
@@ -72,11 +79,27 @@ class TheoryProxy {
   KEEP_STATISTIC(IntStat, d_replayedDecisions,
                  "prop::theoryproxy::replayedDecisions", 0);
 
+  /**
+   * Statistic: the number of explanations asked of the theories, and
+   * of those given again from d_explanations instead.
+   */
+  KEEP_STATISTIC(IntStat, d_explanationsComputed,
+                 "prop::theoryproxy::explanationsComputed", 0);
+  KEEP_STATISTIC(IntStat, d_explanationsReused,
+                 "prop::theoryproxy::explanationsReused", 0);
+
+  /** Make the clause (l, ~e1, ..., ~en) of a theory explanation of l */
+  void toExplanationClause(SatLiteral l, TNode theoryExplanation, SatClause& explanation);
+
+  /** Whether all the literals of a theory explanation are (still) in the CNF */
+  bool hasLiterals(TNode theoryExplanation) const;
+
 public:
   TheoryProxy(PropEngine* propEngine,
               TheoryEngine* theoryEngine,
               DecisionEngine* decisionEngine,
               context::Context* context,
+              context::Context* userContext,
               CnfStream* cnfStream);
 
   ~TheoryProxy();
@@ -86,6 +109,17 @@ public:
 
   void explainPropagation(SatLiteral l, SatClause& explanation);
 
+  /**
+   * Explain a batch of theory propagations, one clause (with the
+   * literal first) per literal, asking the theories for all of them
+   * at once.  Unless fresh is set, a literal explained before gets
+   * its last explanation again: the SAT solver checks that it still
+   * fits the trail (and otherwise asks again, fresh).
+   */
+  void explainPropagations(const std::vector<SatLiteral>& literals,
+                           std::vector<SatClause>& explanations,
+                           bool fresh);
+
   void theoryPropagate(SatClause& output);
 
   void enqueueTheoryLiteral(const SatLiteral& l);
@@ -127,12 +161,14 @@ inline TheoryProxy::TheoryProxy(PropEngine* propEngine,
                                 TheoryEngine* theoryEngine,
                                 DecisionEngine* decisionEngine,
                                 context::Context* context,
+                                context::Context* userContext,
                                 CnfStream* cnfStream) :
   d_propEngine(propEngine),
   d_cnfStream(cnfStream),
   d_decisionEngine(decisionEngine),
   d_theoryEngine(theoryEngine),
-  d_queue(context)
+  d_queue(context),
+  d_explanations(userContext)
 {}
 
 inline TheoryProxy::~TheoryProxy() {
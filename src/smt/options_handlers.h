@@ -442,6 +442,26 @@ inline std::ostream* checkReplayLogFilename(std::string option, std::string opta
 #endif /* CVC4_REPLAY */
 }
 
+inline std::ostream* checkDratFilename(std::string option, std::string optarg, SmtEngine* smt) {
+  if(optarg == "") {
+    throw OptionException(std::string("Bad file name for --drat-file"));
+  } else if(optarg == "-") {
+    // the binary records would be interleaved with the solver's answers
+    throw OptionException(std::string("--drat-file cannot be standard output; give a file name (e.g., /dev/fd/3)"));
+  } else if(!options::filesystemAccess()) {
+    throw OptionException(std::string("Filesystem access not permitted"));
+  } else {
+    errno = 0;
+    std::ostream* dratFile = new std::ofstream(optarg.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if(dratFile == NULL || !*dratFile) {
+      std::stringstream ss;
+      ss << "Cannot open DRAT file: `" << optarg << "': " << __cvc4_errno_failreason();
+      throw OptionException(ss.str());
+    }
+    return dratFile;
+  }
+}
+
 // ensure we are a stats-enabled build of CVC4
 inline void statsEnabledBuild(std::string option, bool value, SmtEngine* smt) throw(OptionException) {
 #ifndef CVC4_STATISTICS_ON
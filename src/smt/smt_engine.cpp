@@ -14,6 +14,7 @@
  ** The main entry point into the CVC4 library's SMT interface.
  **/
 
+#include <fstream>
 #include <vector>
 #include <string>
 #include <iterator>
@@ -26,6 +27,7 @@
 
 #include "context/cdlist.h"
 #include "context/cdhashset.h"
+#include "context/cdhashmap.h"
 #include "context/context.h"
 #include "decision/decision_engine.h"
 #include "decision/decision_mode.h"
@@ -358,6 +360,13 @@ class SmtEnginePrivate : public NodeManagerListener {
    */
   unsigned d_simplifyAssertionsDepth;
 
+  /**
+   * The Boolean proxies of check-sat-assuming assumptions, each
+   * defined (by an assertion) in the user context it was first used
+   * in.
+   */
+  context::CDHashMap<Node, Node, NodeHashFunction> d_assumptionProxies;
+
 public:
   /**
    * Map from skolem variables to index in d_assertions containing
@@ -368,6 +377,13 @@ public:
   /** Instance of the ITE remover */
   RemoveITE d_iteRemover;
 
+  /**
+   * The proxies of the assumptions of the current checkSatAssuming(),
+   * which check() replaces by their preprocessed forms (empty for any
+   * other query).
+   */
+  std::vector<Node> d_assumptions;
+
 private:
 
   theory::arith::PseudoBooleanProcessor d_pbsProcessor;
@@ -398,7 +414,7 @@ private:
   /**
    * Helper function to fix up assertion list to restore invariants needed after ite removal
    */
-  void collectSkolems(TNode n, set<TNode>& skolemSet, hash_map<Node, bool, NodeHashFunction>& cache);
+  void collectSkolems(TNode n, set<TNode>& skolemSet, NodeMarks& visited);
 
   /**
    * Helper function to fix up assertion list to restore invariants needed after ite removal
@@ -464,8 +480,10 @@ public:
     d_abstractValueMap(&d_fakeContext),
     d_abstractValues(),
     d_simplifyAssertionsDepth(0),
+    d_assumptionProxies(smt.d_userContext),
     d_iteSkolemMap(),
     d_iteRemover(smt.d_userContext),
+    d_assumptions(),
     d_pbsProcessor(smt.d_userContext),
     d_topLevelSubstitutions(smt.d_userContext)
   {
@@ -575,6 +593,26 @@ public:
   void addFormula(TNode n)
     throw(TypeCheckingException, LogicException);
 
+  /**
+   * Get the Boolean proxy of an assumption for checkSatAssuming(): a
+   * fresh Boolean that implies it, by an assertion added on its first
+   * use in the current user context.  Assuming the proxy in the SAT
+   * solver then assumes the (preprocessed) assumption.
+   */
+  Node getAssumptionProxy(TNode assumption)
+    throw(TypeCheckingException, LogicException) {
+    context::CDHashMap<Node, Node, NodeHashFunction>::const_iterator i =
+      d_assumptionProxies.find(assumption);
+    if(i != d_assumptionProxies.end()) {
+      return (*i).second;
+    }
+    NodeManager* nm = NodeManager::currentNM();
+    Node proxy = nm->mkSkolem("assumption_$$", nm->booleanType(), "a proxy for a check-sat-assuming assumption");
+    addFormula(nm->mkNode(kind::OR, proxy.notNode(), assumption));
+    d_assumptionProxies.insert(assumption, proxy);
+    return proxy;
+  }
+
   /**
    * Expand definitions in n.
    */
@@ -713,6 +751,8 @@ SmtEngine::SmtEngine(ExprManager* em) throw() :
   d_private = new smt::SmtEnginePrivate(*this);
   d_statisticsRegistry = new StatisticsRegistry();
   d_stats = new SmtEngineStatistics();
+  d_context->getCMM()->registerStatistics("context::sat::");
+  d_userContext->getCMM()->registerStatistics("context::user::");
 
   // We have mutual dependency here, so we add the prop engine to the theory
   // engine later (it is non-essential there)
@@ -732,10 +772,27 @@ SmtEngine::SmtEngine(ExprManager* em) throw() :
   d_modelCommands = new(true) smt::CommandList(d_userContext);
 }
 
+/**
+ * Size a context's memory, and start profiling it, as the options
+ * say; profile statistics are named starting with prefix.
+ */
+static void configureContext(context::Context* c, const std::string& prefix) {
+  context::ContextMemoryManager* cmm = c->getCMM();
+  cmm->setHugePages(options::contextHugePages());
+  cmm->setChunkSize(options::contextChunkSize());
+  cmm->setMaxFreeChunks(options::contextFreeChunks());
+  if(options::contextProfile() || !options::contextProfileDump().empty()) {
+    c->startProfiling()->registerStatistics(prefix);
+  }
+}
+
 void SmtEngine::finishInit() {
   // ensure that our heuristics are properly set up
   setDefaults();
 
+  configureContext(d_context, "context::sat::");
+  configureContext(d_userContext, "context::user::");
+
   Assert(d_proofManager == NULL);
   PROOF( d_proofManager = new ProofManager(); );
 
@@ -831,6 +888,17 @@ SmtEngine::~SmtEngine() throw() {
   try {
     shutdown();
 
+    if(!options::contextProfileDump().empty() &&
+       d_context->getProfiler() != NULL) {
+      ofstream out(options::contextProfileDump().c_str());
+      d_context->getProfiler()->dumpFolded(out, "sat");
+      d_userContext->getProfiler()->dumpFolded(out, "user");
+      if(!out) {
+        Warning() << "couldn't write the context profile to "
+                  << options::contextProfileDump() << endl;
+      }
+    }
+
     // global push/pop around everything, to ensure proper destruction
     // of context-dependent data structures
     d_context->popto(0);
@@ -863,6 +931,12 @@ SmtEngine::~SmtEngine() throw() {
     delete d_decisionEngine;
     d_decisionEngine = NULL;
 
+    d_context->getCMM()->unregisterStatistics();
+    d_userContext->getCMM()->unregisterStatistics();
+    if(d_context->getProfiler() != NULL) {
+      d_context->getProfiler()->unregisterStatistics();
+      d_userContext->getProfiler()->unregisterStatistics();
+    }
     delete d_stats;
     d_stats = NULL;
     delete d_statisticsRegistry;
@@ -2849,9 +2923,16 @@ Result SmtEngine::check() {
 
   TimerStat::CodeTimer solveTimer(d_stats->d_solveTime);
 
+  // The assumption proxies as they are after preprocessing (e.g.,
+  // one found false is substituted by it)
+  std::vector<Node>& assumptions = d_private->d_assumptions;
+  for(unsigned i = 0; i < assumptions.size(); ++i) {
+    assumptions[i] = d_private->applySubstitutions(assumptions[i]);
+  }
+
   Chat() << "solving..." << endl;
   Trace("smt") << "SmtEngine::check(): running check" << endl;
-  Result result = d_propEngine->checkSat();
+  Result result = d_propEngine->checkSat(assumptions);
 
   resourceManager->endCall();
   Trace("limit") << "SmtEngine::check(): cumulative millis " << resourceManager->getTimeUsage()
@@ -2868,29 +2949,14 @@ Result SmtEngine::quickCheck() {
 }
 
 
-void SmtEnginePrivate::collectSkolems(TNode n, set<TNode>& skolemSet, hash_map<Node, bool, NodeHashFunction>& cache)
+void SmtEnginePrivate::collectSkolems(TNode n, set<TNode>& skolemSet, NodeMarks& visited)
 {
-  hash_map<Node, bool, NodeHashFunction>::iterator it;
-  it = cache.find(n);
-  if (it != cache.end()) {
-    return;
-  }
-
-  size_t sz = n.getNumChildren();
-  if (sz == 0) {
-    IteSkolemMap::iterator it = d_iteSkolemMap.find(n);
-    if (it != d_iteSkolemMap.end()) {
-      skolemSet.insert(n);
+  for(PreorderNodeIterator i(n, visited); !i.done(); ++i) {
+    if(i->getNumChildren() == 0 &&
+       d_iteSkolemMap.find(*i) != d_iteSkolemMap.end()) {
+      skolemSet.insert(*i);
     }
-    cache[n] = true;
-    return;
-  }
-
-  size_t k = 0;
-  for (; k < sz; ++k) {
-    collectSkolems(n[k], skolemSet, cache);
   }
-  cache[n] = true;
 }
 
 
@@ -3231,16 +3297,16 @@ void SmtEnginePrivate::processAssertions() {
       // during ite removal.
       // For each skolem variable sk, let iteExpr = iteMap(sk) be the ite expr mapped to by sk.
 
-      // cache for expression traversal
-      hash_map<Node, bool, NodeHashFunction> cache;
-
       // First, find all skolems that appear in the substitution map - their associated iteExpr will need
       // to be moved to the main assertion set
       set<TNode> skolemSet;
-      SubstitutionMap::iterator pos = d_topLevelSubstitutions.begin();
-      for (; pos != d_topLevelSubstitutions.end(); ++pos) {
-        collectSkolems((*pos).first, skolemSet, cache);
-        collectSkolems((*pos).second, skolemSet, cache);
+      {
+        NodeMarks visited;
+        SubstitutionMap::iterator pos = d_topLevelSubstitutions.begin();
+        for (; pos != d_topLevelSubstitutions.end(); ++pos) {
+          collectSkolems((*pos).first, skolemSet, visited);
+          collectSkolems((*pos).second, skolemSet, visited);
+        }
       }
 
       // We need to ensure:
@@ -3252,6 +3318,8 @@ void SmtEnginePrivate::processAssertions() {
       NodeBuilder<> builder(kind::AND);
       builder << d_assertions[d_realAssertionsEnd - 1];
       vector<TNode> toErase;
+      // cache for expression traversal
+      hash_map<Node, bool, NodeHashFunction> cache;
       for (; it != iend; ++it) {
         if (skolemSet.find((*it).first) == skolemSet.end()) {
           TNode iteExpr = d_assertions[(*it).second];
@@ -3414,6 +3482,9 @@ Result SmtEngine::checkSat(const Expr& ex, bool inUnsatCore) throw(TypeCheckingE
                            "(try --incremental)");
     }
 
+    d_assumptions.clear();
+    d_private->d_assumptions.clear();
+
     Expr e;
     if(!ex.isNull()) {
       // Substitute out any abstract values in ex.
@@ -3496,6 +3567,93 @@ Result SmtEngine::checkSat(const Expr& ex, bool inUnsatCore) throw(TypeCheckingE
   }
 }/* SmtEngine::checkSat() */
 
+Result SmtEngine::checkSatAssuming(const std::vector<Expr>& assumptions) throw(TypeCheckingException, ModalException, LogicException) {
+  SmtScope smts(this);
+  finalOptionsAreSet();
+
+  // Without incremental solving, the preprocessing (e.g., unconstrained
+  // simplification) is free to drop the proxy definitions; and the SAT
+  // proof of an unsat core can't be "under assumptions".  So there,
+  // the assumptions are just checked as a conjunction (and they're
+  // all in the unsat core).
+  if(!options::incrementalSolving() || options::proof() || options::unsatCores() ||
+     assumptions.empty()) {
+    Expr conj;
+    if(assumptions.size() == 1) {
+      conj = assumptions[0];
+    } else if(assumptions.size() > 1) {
+      conj = d_exprManager->mkExpr(kind::AND, assumptions);
+    }
+    Result r = checkSat(conj);
+    d_assumptions = assumptions;
+    return r;
+  }
+
+  try {
+    doPendingPops();
+
+    Trace("smt") << "SmtEngine::checkSatAssuming(" << assumptions.size() << " assumptions)" << endl;
+
+    std::vector<Node> nodes;
+    for(unsigned i = 0; i < assumptions.size(); ++i) {
+      Assert(assumptions[i].getExprManager() == d_exprManager);
+      // Substitute out any abstract values in the assumption.
+      Expr e = d_private->substituteAbstractValues(Node::fromExpr(assumptions[i])).toExpr();
+      // Ensure expr is type-checked at this point.
+      ensureBoolean(e);
+      nodes.push_back(e.getNode());
+    }
+
+    // check to see if a postsolve() is pending
+    if(d_needPostsolve) {
+      d_theoryEngine->postsolve();
+      d_needPostsolve = false;
+    }
+
+    // Unlike checkSat(), nothing is pushed (or popped): the assumptions
+    // reach the SAT solver as assumptions, through their proxies.
+    d_assumptions = assumptions;
+    d_private->d_assumptions.clear();
+    for(unsigned i = 0; i < nodes.size(); ++i) {
+      d_private->d_assumptions.push_back(d_private->getAssumptionProxy(nodes[i]));
+    }
+
+    // Note that a query has been made
+    d_queryMade = true;
+
+    Result r(Result::SAT_UNKNOWN, Result::UNKNOWN_REASON);
+    r = check().asSatisfiabilityResult();
+    d_needPostsolve = true;
+
+    // Dump the query if requested
+    if(Dump.isOn("benchmark")) {
+      Dump("benchmark") << CheckSatAssumingCommand(assumptions);
+    }
+
+    // Remember the status
+    d_status = r;
+
+    d_problemExtended = false;
+
+    Trace("smt") << "SmtEngine::checkSatAssuming(" << assumptions.size() << " assumptions) => " << r << endl;
+
+    // Check that SAT results generate a model correctly.
+    if(options::checkModels()) {
+      if(r.asSatisfiabilityResult().isSat() == Result::SAT ||
+         (r.isUnknown() && r.whyUnknown() == Result::INCOMPLETE) ){
+        checkModel(/* hard failure iff */ ! r.isUnknown());
+      }
+    }
+
+    return r;
+  } catch (UnsafeInterruptException& e) {
+    AlwaysAssert(d_private->getResourceManager()->out());
+    Result::UnknownExplanation why = d_private->getResourceManager()->outOfResources() ?
+      Result::RESOURCEOUT : Result::TIMEOUT;
+    return Result(Result::SAT_UNKNOWN, why, d_filename);
+  }
+}/* SmtEngine::checkSatAssuming() */
+
 Result SmtEngine::query(const Expr& ex, bool inUnsatCore) throw(TypeCheckingException, ModalException, LogicException) {
   Assert(!ex.isNull());
   Assert(ex.getExprManager() == d_exprManager);
@@ -3511,6 +3669,9 @@ Result SmtEngine::query(const Expr& ex, bool inUnsatCore) throw(TypeCheckingExce
                          "(try --incremental)");
   }
 
+  d_assumptions.clear();
+  d_private->d_assumptions.clear();
+
   // Substitute out any abstract values in ex
   Expr e = d_private->substituteAbstractValues(Node::fromExpr(ex)).toExpr();
   // Ensure that the expression is type-checked at this point, and Boolean
@@ -4032,8 +4193,11 @@ void SmtEngine::checkModel(bool hardFailure) {
     }
   }
 
-  // Now go through all our user assertions checking if they're satisfied.
-  for(AssertionList::const_iterator i = d_assertionList->begin(); i != d_assertionList->end(); ++i) {
+  // Now go through all our user assertions checking if they're satisfied,
+  // and the assumptions of a check-sat-assuming (which aren't asserted).
+  vector<Expr> assertions(d_assertionList->begin(), d_assertionList->end());
+  assertions.insert(assertions.end(), d_assumptions.begin(), d_assumptions.end());
+  for(vector<Expr>::const_iterator i = assertions.begin(); i != assertions.end(); ++i) {
     Notice() << "SmtEngine::checkModel(): checking assertion " << *i << endl;
     Node n = Node::fromExpr(*i);
 
@@ -4132,6 +4296,37 @@ UnsatCore SmtEngine::getUnsatCore() throw(ModalException, UnsafeInterruptExcepti
 #endif /* CVC4_PROOF */
 }
 
+std::vector<Expr> SmtEngine::getUnsatAssumptions() throw(ModalException) {
+  Trace("smt") << "SMT getUnsatAssumptions()" << endl;
+  SmtScope smts(this);
+  finalOptionsAreSet();
+  if(Dump.isOn("benchmark")) {
+    Dump("benchmark") << GetUnsatAssumptionsCommand();
+  }
+  if(d_status.isNull() ||
+     d_status.asSatisfiabilityResult() != Result::UNSAT ||
+     d_problemExtended) {
+    throw ModalException("Cannot get unsat assumptions unless immediately preceded by UNSAT response.");
+  }
+
+  const std::vector<Node>& literals = d_private->d_assumptions;
+  if(literals.empty()) {
+    // they were checked as a conjunction
+    return d_assumptions;
+  }
+
+  std::vector<Node> failed;
+  d_propEngine->getUnsatAssumptions(failed);
+  std::hash_set<Node, NodeHashFunction> failedSet(failed.begin(), failed.end());
+  std::vector<Expr> core;
+  for(unsigned i = 0; i < literals.size(); ++i) {
+    if(failedSet.find(literals[i]) != failedSet.end()) {
+      core.push_back(d_assumptions[i]);
+    }
+  }
+  return core;
+}
+
 Proof* SmtEngine::getProof() throw(ModalException, UnsafeInterruptException) {
   Trace("smt") << "SMT getProof()" << endl;
   SmtScope smts(this);
@@ -4185,6 +4380,24 @@ vector<Expr> SmtEngine::getAssertions() throw(ModalException) {
   return vector<Expr>(d_assertionList->begin(), d_assertionList->end());
 }
 
+vector<Expr> SmtEngine::getSplitAtoms(unsigned n) throw(ModalException) {
+  SmtScope smts(this);
+  finalOptionsAreSet();
+  Trace("smt") << "SMT getSplitAtoms(" << n << ")" << endl;
+  if(!d_queryMade || d_problemExtended) {
+    const char* msg =
+      "Cannot get split atoms unless immediately preceded by a query.";
+    throw ModalException(msg);
+  }
+  vector<Node> atoms;
+  d_propEngine->getSplitAtoms(atoms, n);
+  vector<Expr> result;
+  for(vector<Node>::const_iterator i = atoms.begin(); i != atoms.end(); ++i) {
+    result.push_back((*i).toExpr());
+  }
+  return result;
+}
+
 void SmtEngine::push() throw(ModalException, LogicException, UnsafeInterruptException) {
   SmtScope smts(this);
   finalOptionsAreSet();
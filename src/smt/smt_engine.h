@@ -240,6 +240,12 @@ class CVC4_PUBLIC SmtEngine {
    */
   Result d_status;
 
+  /**
+   * The assumptions of the last query, if it was a checkSatAssuming()
+   * (for getUnsatAssumptions()).
+   */
+  std::vector<Expr> d_assumptions;
+
   /**
    * The name of the input (if any).
    */
@@ -471,6 +477,14 @@ public:
    */
   Result checkSat(const Expr& e = Expr(), bool inUnsatCore = true) throw(TypeCheckingException, ModalException, LogicException);
 
+  /**
+   * Call check() with the given formulas assumed for this query only.
+   * In incremental mode they're assumptions of the SAT solver, so
+   * (unlike checkSat() of their conjunction) no push/pop of the
+   * contexts is needed.  Returns sat, unsat, or unknown result.
+   */
+  Result checkSatAssuming(const std::vector<Expr>& assumptions) throw(TypeCheckingException, ModalException, LogicException);
+
   /**
    * Simplify a formula without doing "much" work.  Does not involve
    * the SAT Engine in the simplification, but uses the current
@@ -532,12 +546,29 @@ public:
    */
   UnsatCore getUnsatCore() throw(ModalException, UnsafeInterruptException);
 
+  /**
+   * Get the assumptions of the last checkSatAssuming() that are enough
+   * for its UNSAT result (only if immediately preceded by one).  They
+   * are all of them unless the assumptions reached the SAT solver as
+   * such (see checkSatAssuming()).
+   */
+  std::vector<Expr> getUnsatAssumptions() throw(ModalException);
+
   /**
    * Get the current set of assertions.  Only permitted if the
    * SmtEngine is set to operate interactively.
    */
   std::vector<Expr> getAssertions() throw(ModalException);
 
+  /**
+   * Get (at most) n atoms to split the search on (e.g., into cubes
+   * for parallel solving), the most active in the SAT solver's
+   * decision heuristic first.  Only atoms over the user's symbols,
+   * still open at the root after the last query, are given.  Only
+   * permitted after a checkSat() or query().
+   */
+  std::vector<Expr> getSplitAtoms(unsigned n) throw(ModalException);
+
   /**
    * Push a user-level context.
    */
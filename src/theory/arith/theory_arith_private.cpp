@@ -25,7 +25,7 @@
 #include "context/context.h"
 #include "context/cdlist.h"
 #include "context/cdhashset.h"
-#include "context/cdinsert_hashmap.h"
+#include "context/cdflat_hashmap.h"
 #include "context/cdqueue.h"
 
 #include "theory/valuation.h"
@@ -27,7 +27,7 @@
 #include "context/context.h"
 #include "context/cdlist.h"
 #include "context/cdhashset.h"
-#include "context/cdinsert_hashmap.h"
+#include "context/cdflat_hashmap.h"
 #include "context/cdqueue.h"
 
 #include "theory/valuation.h"
@@ -224,7 +224,7 @@ private:
    * A superset of all of the assertions that currently are not the literal for
    * their constraint do not match constraint literals. Not just the witnesses.
    */
-  context::CDInsertHashMap<Node, ConstraintP, NodeHashFunction> d_assertionsThatDoNotMatchTheirLiterals;
+  context::CDFlatHashMap<Node, ConstraintP, NodeHashFunction> d_assertionsThatDoNotMatchTheirLiterals;
 
 
   /** Returns true if x is of type Integer. */
@@ -1446,41 +1446,68 @@ void ITECareSimplifier::updateQueue(CareMap& queue,
 
 Node ITECareSimplifier::substitute(TNode e, TNodeMap& substTable, TNodeMap& cache)
 {
-  TNodeMap::iterator it = cache.find(e), iend = cache.end();
-  if (it != iend) {
-    return it->second;
-  }
+  // Each node is popped once its result is in the cache; the flag
+  // records whether its children (or its substitute) were pushed.
+  vector< pair<TNode, bool> > toVisit;
+  toVisit.push_back(make_pair(e, false));
 
-  // do substitution?
-  it = substTable.find(e);
-  iend = substTable.end();
-  if (it != iend) {
-    Node result = substitute(it->second, substTable, cache);
-    cache[e] = result;
-    return result;
-  }
+  while (!toVisit.empty()) {
+    TNode current = toVisit.back().first;
+    bool expanded = toVisit.back().second;
 
-  size_t sz = e.getNumChildren();
-  if (sz == 0) {
-    cache[e] = e;
-    return e;
-  }
+    if (cache.find(current) != cache.end()) {
+      toVisit.pop_back();
+      continue;
+    }
 
-  NodeBuilder<> builder(e.getKind());
-  if (e.getMetaKind() == kind::metakind::PARAMETERIZED) {
-    builder << e.getOperator();
-  }
-  for (unsigned i = 0; i < e.getNumChildren(); ++ i) {
-    builder << substitute(e[i], substTable, cache);
+    // do substitution?
+    TNodeMap::iterator it = substTable.find(current);
+    if (it != substTable.end()) {
+      if (expanded) {
+        Node result = cache[it->second];
+        cache[current] = result;
+        toVisit.pop_back();
+      } else {
+        toVisit.back().second = true;
+        toVisit.push_back(make_pair(TNode(it->second), false));
+      }
+      continue;
+    }
+
+    size_t sz = current.getNumChildren();
+    if (sz == 0) {
+      cache[current] = current;
+      toVisit.pop_back();
+      continue;
+    }
+
+    if (!expanded) {
+      toVisit.back().second = true;
+      for (size_t i = sz; i > 0; --i) {
+        toVisit.push_back(make_pair(current[i - 1], false));
+      }
+      continue;
+    }
+
+    NodeBuilder<> builder(current.getKind());
+    if (current.getMetaKind() == kind::metakind::PARAMETERIZED) {
+      builder << current.getOperator();
+    }
+    for (unsigned i = 0; i < sz; ++ i) {
+      Assert(cache.find(current[i]) != cache.end());
+      builder << cache[current[i]];
+    }
+
+    Node result = builder;
+    // it = substTable.find(result);
+    // if (it != iend) {
+    //   result = substitute(it->second, substTable, cache);
+    // }
+    cache[current] = result;
+    toVisit.pop_back();
   }
 
-  Node result = builder;
-  // it = substTable.find(result);
-  // if (it != iend) {
-  //   result = substitute(it->second, substTable, cache);
-  // }
-  cache[e] = result;
-  return result;
+  return cache[e];
 }
 
 
@@ -29,17 +29,16 @@ struct RewriteCacheTag {};
 template <theory::TheoryId theoryId>
 struct RewriteAttibute {
 
-  typedef expr::Attribute< RewriteCacheTag<true, theoryId>, Node> pre_rewrite;
-  typedef expr::Attribute< RewriteCacheTag<false, theoryId>, Node> post_rewrite;
+  // consulted for every node on every rewrite, so kept dense
+  typedef expr::DenseAttribute< RewriteCacheTag<true, theoryId>, Node> pre_rewrite;
+  typedef expr::DenseAttribute< RewriteCacheTag<false, theoryId>, Node> post_rewrite;
 
   /**
    * Get the value of the pre-rewrite cache.
    */
   static Node getPreRewriteCache(TNode node) throw() {
     Node cache;
-    if (node.hasAttribute(pre_rewrite())) {
-      node.getAttribute(pre_rewrite(), cache);
-    } else {
+    if (!node.getAttribute(pre_rewrite(), cache)) {
       return Node::null();
     }
     if (cache.isNull()) {
@@ -68,9 +67,7 @@ struct RewriteAttibute {
    */
   static Node getPostRewriteCache(TNode node) throw() {
     Node cache;
-    if (node.hasAttribute(post_rewrite())) {
-      node.getAttribute(post_rewrite(), cache);
-    } else {
+    if (!node.getAttribute(post_rewrite(), cache)) {
       return Node::null();
     }
     if (cache.isNull()) {
@@ -794,39 +794,84 @@ theory::Theory::PPAssertStatus TheoryEngine::solve(TNode literal, SubstitutionMa
   return solveStatus;
 }
 
-// Recursively traverse a term and call the theory rewriter on its sub-terms
+// The frames of ppTheoryRewrite(), which traverses a term and calls the
+// theory rewriter on its sub-terms
+struct pp_rewrite_stack_element {
+  /** A Node, not a TNode: terms rewritten again aren't referenced elsewhere */
+  Node node;
+  /** 0: not looked at yet, 1: children pushed, 2: rewriting again */
+  unsigned stage;
+  pp_rewrite_stack_element(TNode node)
+  : node(node), stage(0) {}
+};/* struct pp_rewrite_stack_element */
+
 Node TheoryEngine::ppTheoryRewrite(TNode term) {
-  NodeMap::iterator find = d_ppCache.find(term);
-  if (find != d_ppCache.end()) {
-    return (*find).second;
-  }
-  unsigned nc = term.getNumChildren();
-  if (nc == 0) {
-    return theoryOf(term)->ppRewrite(term);
-  }
-  Trace("theory-pp") << "ppTheoryRewrite { " << term << endl;
+  // Each element leaves its result on the results stack.
+  vector<pp_rewrite_stack_element> toVisit;
+  vector<Node> results;
+  toVisit.push_back(term);
 
-  Node newTerm;
-  if (theoryOf(term)->ppDontRewriteSubterm(term)) {
-    newTerm = Rewriter::rewrite(term);
-  } else {
-    NodeBuilder<> newNode(term.getKind());
-    if (term.getMetaKind() == kind::metakind::PARAMETERIZED) {
-      newNode << term.getOperator();
-    }
-    unsigned i;
-    for (i = 0; i < nc; ++i) {
-      newNode << ppTheoryRewrite(term[i]);
+  while (!toVisit.empty()) {
+    pp_rewrite_stack_element& stackHead = toVisit.back();
+    TNode current = stackHead.node;
+    Node newTerm;
+
+    if (stackHead.stage == 2) {
+      // the term's ppRewrite() has been rewritten in turn
+      newTerm = results.back();
+      results.pop_back();
+    } else {
+      if (stackHead.stage == 0) {
+        NodeMap::iterator find = d_ppCache.find(current);
+        if (find != d_ppCache.end()) {
+          results.push_back((*find).second);
+          toVisit.pop_back();
+          continue;
+        }
+        unsigned nc = current.getNumChildren();
+        if (nc == 0) {
+          results.push_back(theoryOf(current)->ppRewrite(current));
+          toVisit.pop_back();
+          continue;
+        }
+        Trace("theory-pp") << "ppTheoryRewrite { " << current << endl;
+
+        if (!theoryOf(current)->ppDontRewriteSubterm(current)) {
+          stackHead.stage = 1;
+          for (unsigned i = nc; i > 0; --i) {
+            toVisit.push_back(current[i - 1]);
+          }
+          continue;
+        }
+        newTerm = Rewriter::rewrite(current);
+      } else {
+        // the children are done
+        unsigned nc = current.getNumChildren();
+        NodeBuilder<> newNode(current.getKind());
+        if (current.getMetaKind() == kind::metakind::PARAMETERIZED) {
+          newNode << current.getOperator();
+        }
+        newNode.append(results.end() - nc, results.end());
+        results.resize(results.size() - nc);
+        newTerm = Rewriter::rewrite(Node(newNode));
+      }
+
+      Node newTerm2 = theoryOf(newTerm)->ppRewrite(newTerm);
+      if (newTerm != newTerm2) {
+        stackHead.stage = 2;
+        toVisit.push_back(pp_rewrite_stack_element(Rewriter::rewrite(newTerm2)));
+        continue;
+      }
     }
-    newTerm = Rewriter::rewrite(Node(newNode));
-  }
-  Node newTerm2 = theoryOf(newTerm)->ppRewrite(newTerm);
-  if (newTerm != newTerm2) {
-    newTerm = ppTheoryRewrite(Rewriter::rewrite(newTerm2));
+
+    d_ppCache[current] = newTerm;
+    Trace("theory-pp")<< "ppTheoryRewrite returning " << newTerm << "}" << endl;
+    results.push_back(newTerm);
+    toVisit.pop_back();
   }
-  d_ppCache[term] = newTerm;
-  Trace("theory-pp")<< "ppTheoryRewrite returning " << newTerm << "}" << endl;
-  return newTerm;
+
+  Assert(results.size() == 1);
+  return results.back();
 }
 
 
@@ -1274,6 +1319,30 @@ Node TheoryEngine::getExplanation(TNode node) {
   return explanation;
 }
 
+void TheoryEngine::getExplanations(const std::vector<TNode>& nodes, std::vector<Node>& explanations) {
+  Debug("theory::explain") << "TheoryEngine::getExplanations(" << nodes.size() << " nodes): current propagation index = " << d_propagationMapTimestamp << endl;
+
+  // If we're not in shared mode, explanations are simple
+  if (!d_logicInfo.isSharingEnabled()) {
+    for (unsigned i = 0; i < nodes.size(); ++ i) {
+      explanations.push_back(getExplanation(nodes[i]));
+    }
+    return;
+  }
+
+  // The explanations the theories give, for all of the batch
+  ExplanationCache cache;
+  for (unsigned i = 0; i < nodes.size(); ++ i) {
+    NodeTheoryPair toExplain(nodes[i], THEORY_SAT_SOLVER, d_propagationMapTimestamp);
+    Assert(d_propagationMap.find(toExplain) != d_propagationMap.end());
+    std::vector<NodeTheoryPair> explanationVector;
+    explanationVector.push_back(d_propagationMap[toExplain]);
+    getExplanation(explanationVector, &cache);
+    explanations.push_back(mkExplanation(explanationVector));
+    Debug("theory::explain") << "TheoryEngine::getExplanations(): " << nodes[i] << " => " << explanations.back() << endl;
+  }
+}
+
 struct AtomsCollect {
 
   std::vector<TNode> d_atoms;
@@ -1616,7 +1685,7 @@ bool TheoryEngine::donePPSimpITE(std::vector<Node>& assertions){
   return result;
 }
 
-void TheoryEngine::getExplanation(std::vector<NodeTheoryPair>& explanationVector)
+void TheoryEngine::getExplanation(std::vector<NodeTheoryPair>& explanationVector, ExplanationCache* cache)
 {
   Assert(explanationVector.size() > 0);
 
@@ -1668,12 +1737,19 @@ void TheoryEngine::getExplanation(std::vector<NodeTheoryPair>& explanationVector
       }
     }
 
-    // It was produced by the theory, so ask for an explanation
+    // It was produced by the theory, so ask for an explanation (unless it was asked for already)
     Node explanation;
-    if (toExplain.theory == THEORY_BUILTIN) {
-      explanation = d_sharedTerms.explain(toExplain.node);
+    if (cache != NULL && cache->find(toExplain) != cache->end()) {
+      explanation = (*cache)[toExplain];
     } else {
-      explanation = theoryOf(toExplain.theory)->explain(toExplain.node);
+      if (toExplain.theory == THEORY_BUILTIN) {
+        explanation = d_sharedTerms.explain(toExplain.node);
+      } else {
+        explanation = theoryOf(toExplain.theory)->explain(toExplain.node);
+      }
+      if (cache != NULL) {
+        (*cache)[toExplain] = explanation;
+      }
     }
     Debug("theory::explain") << "TheoryEngine::explain(): got explanation " << explanation << " got from " << toExplain.theory << endl;
     Assert(explanation != toExplain.node, "wasn't sent to you, so why are you explaining it trivially");
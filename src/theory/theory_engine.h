@@ -187,6 +187,7 @@ class TheoryEngine {
 
   typedef std::hash_map<Node, Node, NodeHashFunction> NodeMap;
   typedef std::hash_map<TNode, Node, TNodeHashFunction> TNodeMap;
+  typedef std::hash_map<NodeTheoryPair, Node, NodeTheoryPairHashFunction> ExplanationCache;
 
   /**
   * Cache for theory-preprocessing of assertions
@@ -599,9 +600,11 @@ private:
    * asking relevant theories to explain the propagations. Initially
    * the explanation vector should contain only the element (node, theory)
    * where the node is the one to be explained, and the theory is the
-   * theory that sent the literal.
+   * theory that sent the literal.  If a cache is given, the theories'
+   * explanations are looked up in (and added to) it: it's only valid
+   * while the assertions don't change.
    */
-  void getExplanation(std::vector<NodeTheoryPair>& explanationVector);
+  void getExplanation(std::vector<NodeTheoryPair>& explanationVector, ExplanationCache* cache = NULL);
 
 public:
 
@@ -719,6 +722,13 @@ public:
    */
   Node getExplanation(TNode node);
 
+  /**
+   * Returns the explanations of a batch of nodes propagated to the SAT
+   * solver (in the same order).  What the theories explain on the way
+   * (e.g., shared equalities) is only asked for once per batch.
+   */
+  void getExplanations(const std::vector<TNode>& nodes, std::vector<Node>& explanations);
+
   /**
    * collect model info
    */
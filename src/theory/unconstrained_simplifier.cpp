@@ -48,7 +48,7 @@ struct unc_preprocess_stack_element {
 };/* struct unc_preprocess_stack_element */
 
 
-void UnconstrainedSimplifier::visitAll(TNode assertion)
+void UnconstrainedSimplifier::visitAll(TNode assertion, NodeMarks& visited)
 {
   // Do a topological sort of the subexpressions and substitute them
   vector<unc_preprocess_stack_element> toVisit;
@@ -61,19 +61,14 @@ void UnconstrainedSimplifier::visitAll(TNode assertion)
     toVisit.pop_back();
     TNode current = stackHead.node;
 
-    TNodeCountMap::iterator find = d_visited.find(current);
-    if (find != d_visited.end()) {
-      if (find->second == 1) {
-        d_visitedOnce.erase(current);
-        if (current.isVar()) {
-          d_unconstrained.erase(current);
-        }
+    if (!visited.mark(current)) {
+      // reached again; it's no longer visited only once
+      if (d_visitedOnce.erase(current) > 0 && current.isVar()) {
+        d_unconstrained.erase(current);
       }
-      ++find->second;
       continue;
     }
 
-    d_visited[current] = 1;
     d_visitedOnce[current] = stackHead.parent;
 
     if (current.getNumChildren() == 0) {
@@ -644,7 +639,8 @@ void UnconstrainedSimplifier::processUnconstrained()
         default:
           break;
       }
-      if (current == parent && d_visited[parent] == 1) {
+      if (current == parent &&
+          d_visitedOnce.find(parent) != d_visitedOnce.end()) {
         d_unconstrained.insert(parent);
         continue;
       }
@@ -684,8 +680,11 @@ void UnconstrainedSimplifier::processAssertions(vector<Node>& assertions)
   d_context->push();
 
   vector<Node>::iterator it = assertions.begin(), iend = assertions.end();
-  for (; it != iend; ++it) {
-    visitAll(*it);
+  {
+    NodeMarks visited;
+    for (; it != iend; ++it) {
+      visitAll(*it, visited);
+    }
   }
 
   if (!d_unconstrained.empty()) {
@@ -699,7 +698,6 @@ void UnconstrainedSimplifier::processAssertions(vector<Node>& assertions)
   // to clear substitutions map
   d_context->pop();
 
-  d_visited.clear();
   d_visitedOnce.clear();
   d_unconstrained.clear();
 }
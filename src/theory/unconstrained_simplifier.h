@@ -26,6 +26,7 @@
 #include "expr/node.h"
 #include "theory/substitutions.h"
 #include "util/statistics_registry.h"
+#include "util/node_visitor.h"
 
 namespace CVC4 {
 
@@ -37,11 +38,10 @@ class UnconstrainedSimplifier {
   /** number of expressions eliminated due to unconstrained simplification */
   IntStat d_numUnconstrainedElim;
 
-  typedef std::hash_map<TNode, unsigned, TNodeHashFunction> TNodeCountMap;
   typedef std::hash_map<TNode, TNode, TNodeHashFunction> TNodeMap;
   typedef std::hash_set<TNode, TNodeHashFunction> TNodeSet;
 
-  TNodeCountMap d_visited;
+  /** nodes reached exactly once by visitAll(), mapped to their parent */
   TNodeMap d_visitedOnce;
   TNodeSet d_unconstrained;
 
@@ -50,7 +50,7 @@ class UnconstrainedSimplifier {
 
   const LogicInfo& d_logicInfo;
 
-  void visitAll(TNode assertion);
+  void visitAll(TNode assertion, NodeMarks& visited);
   Node newUnconstrainedVar(TypeNode t, TNode var);
   void processUnconstrained();
 
@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "util/ite_removal.h"
+#include "expr/node_builder.h"
 #include "expr/command.h"
 #include "theory/ite_utilities.h"
 #include "proof/proof_manager.h"
@@ -73,120 +74,196 @@ bool RemoveITE::containsTermITE(TNode e) const {
   return d_containsVisitor->containsTermITE(e);
 }
 
-Node RemoveITE::run(TNode node, std::vector<Node>& output,
-                    IteSkolemMap& iteSkolemMap, bool inQuant) {
-  // Current node
-  Debug("ite") << "removeITEs(" << node << ")" << endl;
+namespace {
 
-  if(node.isVar() || node.isConst() ||
-     (options::biasedITERemoval() && !containsTermITE(node))){
-    return Node(node);
-  }
+/** A node to be processed by RemoveITE::run() or RemoveITE::replace() */
+struct RemoveITEFrame {
+  enum Stage {
+    /** not yet looked at */
+    VISIT,
+    /** children pushed; rebuild from their results */
+    CHILDREN,
+    /** replaced by d_skolem; the ITE's defining assertion was pushed */
+    ASSERTION
+  };
 
-  // The result may be cached already
-  std::pair<Node, bool> cacheKey(node, inQuant);
-  NodeManager *nodeManager = NodeManager::currentNM();
-  ITECache::const_iterator i = d_iteCache.find(cacheKey);
-  if(i != d_iteCache.end()) {
-    Node cached = (*i).second;
-    Debug("ite") << "removeITEs: in-cache: " << cached << endl;
-    return cached.isNull() ? Node(node) : cached;
+  /** a Node, not a TNode: new assertions aren't referenced elsewhere */
+  Node d_node;
+  /** whether d_node is (syntactically) inside a quantifier */
+  bool d_inQuant;
+  Stage d_stage;
+  Node d_skolem;
+
+  RemoveITEFrame(TNode node, bool inQuant) :
+    d_node(node),
+    d_inQuant(inQuant),
+    d_stage(VISIT) {
   }
+};/* struct RemoveITEFrame */
 
-  // Remember that we're inside a quantifier
-  if(node.getKind() == kind::FORALL || node.getKind() == kind::EXISTS) {
-    inQuant = true;
+/**
+ * Replace node's children with the last getNumChildren() results,
+ * which are removed.  Returns null if nothing changed.
+ */
+Node rebuild(TNode node, std::vector<Node>& results) {
+  unsigned nc = node.getNumChildren();
+  Assert(results.size() >= nc);
+  std::vector<Node>::iterator first = results.end() - nc;
+  bool somethingChanged = false;
+  for(unsigned i = 0; i < nc; ++i) {
+    somethingChanged |= (first[i] != node[i]);
   }
+  Node result;
+  if(somethingChanged) {
+    NodeBuilder<> nb(node.getKind());
+    if(node.getMetaKind() == kind::metakind::PARAMETERIZED) {
+      nb << node.getOperator();
+    }
+    nb.append(first, results.end());
+    result = nb;
+  }
+  results.erase(first, results.end());
+  return result;
+}
 
-  // If an ITE replace it
-  if(node.getKind() == kind::ITE) {
-    TypeNode nodeType = node.getType();
-    if(!nodeType.isBoolean() && (!inQuant || !node.hasBoundVar())) {
-      Node skolem;
-      // Make the skolem to represent the ITE
-      skolem = nodeManager->mkSkolem("termITE", nodeType, "a variable introduced due to term-level ITE removal");
+}/* anonymous namespace */
 
-      // The new assertion
-      Node newAssertion =
-        nodeManager->mkNode(kind::ITE, node[0], skolem.eqNode(node[1]),
-                            skolem.eqNode(node[2]));
-      Debug("ite") << "removeITEs(" << node << ") => " << newAssertion << endl;
+Node RemoveITE::run(TNode node, std::vector<Node>& output,
+                    IteSkolemMap& iteSkolemMap, bool inQuant) {
+  // A loop over frames, as the nested ITEs of an input can go too deep
+  // for the C++ stack.  Each frame leaves its result on the results stack.
+  NodeManager *nodeManager = NodeManager::currentNM();
+  std::vector<RemoveITEFrame> toVisit;
+  std::vector<Node> results;
+  toVisit.push_back(RemoveITEFrame(node, inQuant));
+
+  while(!toVisit.empty()) {
+    RemoveITEFrame& frame = toVisit.back();
+    TNode current = frame.d_node;
+    std::pair<Node, bool> cacheKey(current, frame.d_inQuant);
 
-      // Attach the skolem
-      d_iteCache.insert(cacheKey, skolem);
+    if(frame.d_stage == RemoveITEFrame::ASSERTION) {
+      // ITEs have been removed from the new assertion, too
+      iteSkolemMap[frame.d_skolem] = output.size();
+      output.push_back(results.back());
+      results.back() = frame.d_skolem;
+      toVisit.pop_back();
+      continue;
+    }
 
-      // Remove ITEs from the new assertion, rewrite it and push it to the output
-      newAssertion = run(newAssertion, output, iteSkolemMap, inQuant);
+    if(frame.d_stage == RemoveITEFrame::CHILDREN) {
+      // If changes, we rewrite
+      Node rebuilt = rebuild(current, results);
+      d_iteCache.insert(cacheKey, rebuilt);
+      results.push_back(rebuilt.isNull() ? Node(current) : rebuilt);
+      toVisit.pop_back();
+      continue;
+    }
 
-      iteSkolemMap[skolem] = output.size();
-      output.push_back(newAssertion);
+    Debug("ite") << "removeITEs(" << current << ")" << endl;
 
-      // The representation is now the skolem
-      return skolem;
+    if(current.isVar() || current.isConst() ||
+       (options::biasedITERemoval() && !containsTermITE(current))){
+      results.push_back(current);
+      toVisit.pop_back();
+      continue;
     }
-  }
 
-  // If not an ITE, go deep
-  vector<Node> newChildren;
-  bool somethingChanged = false;
-  if(node.getMetaKind() == kind::metakind::PARAMETERIZED) {
-    newChildren.push_back(node.getOperator());
-  }
-  // Remove the ITEs from the children
-  for(TNode::const_iterator it = node.begin(), end = node.end(); it != end; ++it) {
-    Node newChild = run(*it, output, iteSkolemMap, inQuant);
-    somethingChanged |= (newChild != *it);
-    newChildren.push_back(newChild);
-  }
+    // The result may be cached already
+    ITECache::const_iterator i = d_iteCache.find(cacheKey);
+    if(i != d_iteCache.end()) {
+      Node cached = (*i).second;
+      Debug("ite") << "removeITEs: in-cache: " << cached << endl;
+      results.push_back(cached.isNull() ? Node(current) : cached);
+      toVisit.pop_back();
+      continue;
+    }
 
-  // If changes, we rewrite
-  if(somethingChanged) {
-    Node cached = nodeManager->mkNode(node.getKind(), newChildren);
-    d_iteCache.insert(cacheKey, cached);
-    return cached;
-  } else {
-    d_iteCache.insert(cacheKey, Node::null());
-    return node;
+    // Remember that we're inside a quantifier
+    bool childInQuant = frame.d_inQuant ||
+      current.getKind() == kind::FORALL || current.getKind() == kind::EXISTS;
+
+    // If an ITE replace it
+    if(current.getKind() == kind::ITE) {
+      TypeNode nodeType = current.getType();
+      if(!nodeType.isBoolean() && (!childInQuant || !current.hasBoundVar())) {
+        // Make the skolem to represent the ITE
+        Node skolem = nodeManager->mkSkolem("termITE", nodeType, "a variable introduced due to term-level ITE removal");
+
+        // The new assertion
+        Node newAssertion =
+          nodeManager->mkNode(kind::ITE, current[0], skolem.eqNode(current[1]),
+                              skolem.eqNode(current[2]));
+        Debug("ite") << "removeITEs(" << current << ") => " << newAssertion << endl;
+
+        // Attach the skolem
+        d_iteCache.insert(cacheKey, skolem);
+
+        // Remove ITEs from the new assertion before it goes to the
+        // output; the representation is now the skolem
+        frame.d_stage = RemoveITEFrame::ASSERTION;
+        frame.d_skolem = skolem;
+        toVisit.push_back(RemoveITEFrame(newAssertion, childInQuant));
+        continue;
+      }
+    }
+
+    // If not an ITE, go deep; the first child is processed first
+    frame.d_stage = RemoveITEFrame::CHILDREN;
+    for(unsigned k = current.getNumChildren(); k > 0; --k) {
+      toVisit.push_back(RemoveITEFrame(current[k - 1], childInQuant));
+    }
   }
+
+  Assert(results.size() == 1);
+  return results.back();
 }
 
 Node RemoveITE::replace(TNode node, bool inQuant) const {
-  if(node.isVar() || node.isConst() ||
-     (options::biasedITERemoval() && !containsTermITE(node))){
-    return Node(node);
-  }
+  std::vector<RemoveITEFrame> toVisit;
+  std::vector<Node> results;
+  toVisit.push_back(RemoveITEFrame(node, inQuant));
 
-  // Check the cache
-  NodeManager *nodeManager = NodeManager::currentNM();
-  ITECache::const_iterator i = d_iteCache.find(make_pair(node, inQuant));
-  if(i != d_iteCache.end()) {
-    Node cached = (*i).second;
-    return cached.isNull() ? Node(node) : cached;
-  }
+  while(!toVisit.empty()) {
+    RemoveITEFrame& frame = toVisit.back();
+    TNode current = frame.d_node;
 
-  // Remember that we're inside a quantifier
-  if(node.getKind() == kind::FORALL || node.getKind() == kind::EXISTS) {
-    inQuant = true;
-  }
+    if(frame.d_stage == RemoveITEFrame::CHILDREN) {
+      Node rebuilt = rebuild(current, results);
+      results.push_back(rebuilt.isNull() ? Node(current) : rebuilt);
+      toVisit.pop_back();
+      continue;
+    }
 
-  vector<Node> newChildren;
-  bool somethingChanged = false;
-  if(node.getMetaKind() == kind::metakind::PARAMETERIZED) {
-    newChildren.push_back(node.getOperator());
-  }
-  // Replace in children
-  for(TNode::const_iterator it = node.begin(), end = node.end(); it != end; ++it) {
-    Node newChild = replace(*it, inQuant);
-    somethingChanged |= (newChild != *it);
-    newChildren.push_back(newChild);
-  }
+    if(current.isVar() || current.isConst() ||
+       (options::biasedITERemoval() && !containsTermITE(current))){
+      results.push_back(current);
+      toVisit.pop_back();
+      continue;
+    }
 
-  // If changes, we rewrite
-  if(somethingChanged) {
-    return nodeManager->mkNode(node.getKind(), newChildren);
-  } else {
-    return node;
+    // Check the cache
+    ITECache::const_iterator i = d_iteCache.find(make_pair(Node(current), frame.d_inQuant));
+    if(i != d_iteCache.end()) {
+      Node cached = (*i).second;
+      results.push_back(cached.isNull() ? Node(current) : cached);
+      toVisit.pop_back();
+      continue;
+    }
+
+    // Remember that we're inside a quantifier
+    bool childInQuant = frame.d_inQuant ||
+      current.getKind() == kind::FORALL || current.getKind() == kind::EXISTS;
+
+    // Replace in children
+    frame.d_stage = RemoveITEFrame::CHILDREN;
+    for(unsigned k = current.getNumChildren(); k > 0; --k) {
+      toVisit.push_back(RemoveITEFrame(current[k - 1], childInQuant));
+    }
   }
+
+  Assert(results.size() == 1);
+  return results.back();
 }
 
 }/* CVC4 namespace */
@@ -22,7 +22,7 @@
 #include "expr/node.h"
 #include "util/dump.h"
 #include "context/context.h"
-#include "context/cdinsert_hashmap.h"
+#include "context/cdflat_hashmap.h"
 #include "util/hash.h"
 #include "util/bool.h"
 
@@ -35,7 +35,7 @@ namespace theory {
 typedef std::hash_map<Node, unsigned, NodeHashFunction> IteSkolemMap;
 
 class RemoveITE {
-  typedef context::CDInsertHashMap< std::pair<Node, bool>, Node, PairHashFunction<Node, bool, NodeHashFunction, BoolHashFunction> > ITECache;
+  typedef context::CDFlatHashMap< std::pair<Node, bool>, Node, PairHashFunction<Node, bool, NodeHashFunction, BoolHashFunction> > ITECache;
   ITECache d_iteCache;
 
 
@@ -57,6 +57,8 @@ enum CVC4_PUBLIC Language {
   LANG_CVC4,
   /** The Z3-str input language */
   LANG_Z3STR,
+  /** A binary snapshot of a previously parsed problem (expr/snapshot.h) */
+  LANG_BINARY,
 
   // START INPUT-ONLY LANGUAGES AT ENUM VALUE 10
   // THESE ARE IN PRINCIPLE NOT POSSIBLE OUTPUT LANGUAGES
@@ -89,6 +91,9 @@ inline std::ostream& operator<<(std::ostream& out, Language lang) {
   case LANG_Z3STR:
     out << "LANG_Z3STR";
     break;
+  case LANG_BINARY:
+    out << "LANG_BINARY";
+    break;
   default:
     out << "undefined_input_language";
   }
@@ -126,6 +131,8 @@ enum CVC4_PUBLIC Language {
   LANG_CVC4 = input::LANG_CVC4,
   /** The Z3-str output language */
   LANG_Z3STR = input::LANG_Z3STR,
+  /** A binary snapshot of the parsed problem (expr/snapshot.h) */
+  LANG_BINARY = input::LANG_BINARY,
 
   // START OUTPUT-ONLY LANGUAGES AT ENUM VALUE 10
   // THESE ARE IN PRINCIPLE NOT POSSIBLE INPUT LANGUAGES
@@ -160,6 +167,9 @@ inline std::ostream& operator<<(std::ostream& out, Language lang) {
   case LANG_Z3STR:
     out << "LANG_Z3STR";
     break;
+  case LANG_BINARY:
+    out << "LANG_BINARY";
+    break;
   case LANG_AST:
     out << "LANG_AST";
     break;
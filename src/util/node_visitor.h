@@ -11,15 +11,19 @@
  **
  ** \brief A simple visitor for nodes
  **
- ** A simple visitor for nodes.
+ ** A simple visitor for nodes, and explicit-stack DAG iterators that
+ ** visit each distinct subterm once, using visited marks kept by the
+ ** NodeManager rather than a hash table.
  **/
 
 #pragma once
 
 #include "cvc4_private.h"
 
+#include <algorithm>
 #include <vector>
 #include "expr/node.h"
+#include "expr/node_manager.h"
 
 namespace CVC4 {
 
@@ -116,4 +120,274 @@ public:
 template <typename Visitor>
 CVC4_THREADLOCAL(bool) NodeVisitor<Visitor>::s_inRun = false;
 
+/**
+ * Visited marks, one per node id, for one level of traversal nesting
+ * (see NodeMarks).  A node is marked if its entry holds the current
+ * epoch, so starting a new traversal just bumps the epoch.  Pages are
+ * allocated on first use, and freed again once no traversal has
+ * marked anything on them for TRIM_PERIOD epochs: ids aren't reused,
+ * so the pages of ids that have been collected would otherwise be
+ * kept forever.
+ */
+class NodeMarkTable {
+  static const unsigned PAGE_BITS = 12;
+  static const size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+  static const uint32_t TRIM_PERIOD = 64;
+
+  std::vector<uint32_t*> d_pages;
+  /** The last epoch in which each page was marked on */
+  std::vector<uint32_t> d_pageEpochs;
+  uint32_t d_epoch;
+
+  /** Free the pages unmarked for TRIM_PERIOD epochs. */
+  void trim() {
+    for(size_t p = 0; p < d_pages.size(); ++p) {
+      if(d_pages[p] != NULL && d_epoch - d_pageEpochs[p] > TRIM_PERIOD) {
+        delete [] d_pages[p];
+        d_pages[p] = NULL;
+      }
+    }
+    while(!d_pages.empty() && d_pages.back() == NULL) {
+      d_pages.pop_back();
+      d_pageEpochs.pop_back();
+    }
+  }
+
+public:
+  NodeMarkTable() : d_epoch(0) {}
+
+  ~NodeMarkTable() {
+    for(std::vector<uint32_t*>::iterator i = d_pages.begin();
+        i != d_pages.end();
+        ++i) {
+      delete [] *i;
+    }
+  }
+
+  /** Forget all marks. */
+  void newEpoch() {
+    if(++d_epoch == 0) {
+      // wrapped around; old stamps could now look current, so drop
+      // them all
+      for(std::vector<uint32_t*>::iterator i = d_pages.begin();
+          i != d_pages.end();
+          ++i) {
+        delete [] *i;
+      }
+      d_pages.clear();
+      d_pageEpochs.clear();
+      d_epoch = 1;
+    } else if(d_epoch % TRIM_PERIOD == 0) {
+      trim();
+    }
+  }
+
+  bool isMarked(uint64_t id) const {
+    size_t p = id >> PAGE_BITS;
+    return p < d_pages.size() && d_pages[p] != NULL &&
+      d_pages[p][id & (PAGE_SIZE - 1)] == d_epoch;
+  }
+
+  /** Mark id; returns false if it was already marked. */
+  bool mark(uint64_t id) {
+    size_t p = id >> PAGE_BITS;
+    if(p >= d_pages.size()) {
+      d_pages.resize(p + 1, NULL);
+      d_pageEpochs.resize(p + 1, 0);
+    }
+    if(d_pages[p] == NULL) {
+      d_pages[p] = new uint32_t[PAGE_SIZE]();
+    }
+    uint32_t& m = d_pages[p][id & (PAGE_SIZE - 1)];
+    if(m == d_epoch) {
+      return false;
+    }
+    m = d_epoch;
+    d_pageEpochs[p] = d_epoch;
+    return true;
+  }
+};/* class NodeMarkTable */
+
+/**
+ * A set of visited nodes for a traversal, in place of a
+ * hash_set<Node> (or hash_map<Node, bool>) cache.  Marks are stored
+ * by the NodeManager, indexed by node id; constructing a NodeMarks
+ * starts out with nothing marked, in constant time.
+ *
+ * NodeMarks may nest (a pass may call another that traverses, while
+ * its own marks are live), but must be destroyed in the reverse order
+ * of their construction: keep them on the stack.  The tables are
+ * per NodeManager, not per thread, and aren't locked, so unlike
+ * attributes they are not safe to use from several threads on one
+ * NodeManager, even with --thread-safe-node-manager.  (The
+ * NodeManager's own type checker doesn't use them in that mode.)
+ *
+ * Marks don't keep nodes alive; a node that is garbage collected
+ * while marked isn't seen again, as ids aren't reused.
+ */
+class NodeMarks {
+  NodeManager* d_nm;
+  NodeMarkTable* d_table;
+
+  // disallow copy/assignment
+  NodeMarks(const NodeMarks&) CVC4_UNDEFINED;
+  NodeMarks& operator=(const NodeMarks&) CVC4_UNDEFINED;
+
+public:
+  NodeMarks(NodeManager* nm = NodeManager::currentNM()) :
+    d_nm(nm) {
+    Assert(d_nm != NULL);
+    if(d_nm->d_markTablesInUse == d_nm->d_markTables.size()) {
+      d_nm->d_markTables.push_back(new NodeMarkTable());
+    }
+    d_table = d_nm->d_markTables[d_nm->d_markTablesInUse++];
+    d_table->newEpoch();
+  }
+
+  ~NodeMarks() {
+    Assert(d_nm->d_markTablesInUse > 0 &&
+           d_nm->d_markTables[d_nm->d_markTablesInUse - 1] == d_table,
+           "NodeMarks destroyed out of order");
+    if(--d_nm->d_markTablesInUse == 0) {
+      // keep a table for a pass and one for a traversal nested in it
+      // (e.g. a lazy type check); deeper nesting is rare, so free the
+      // rest rather than hold their pages
+      while(d_nm->d_markTables.size() > 2) {
+        delete d_nm->d_markTables.back();
+        d_nm->d_markTables.pop_back();
+      }
+    }
+  }
+
+  bool isMarked(TNode n) const {
+    return d_table->isMarked(n.getId());
+  }
+
+  /** Mark n; returns false if it was already marked. */
+  bool mark(TNode n) {
+    return d_table->mark(n.getId());
+  }
+
+  /** Forget all marks. */
+  void clear() {
+    d_table->newEpoch();
+  }
+};/* class NodeMarks */
+
+/**
+ * Iterates over the DAG below a node, parents before children, with
+ * an explicit stack.  Nodes already marked in the given NodeMarks are
+ * skipped along with everything below them (unless also reachable
+ * another way); every node reached is marked, so it's seen once.
+ * Sharing a NodeMarks across several roots visits their union once.
+ *
+ * Operators of parameterized nodes aren't visited, as with
+ * TNode::iterator.
+ */
+class PreorderNodeIterator {
+  NodeMarks& d_marks;
+  std::vector<TNode> d_stack;
+  TNode d_current;
+  bool d_descend;
+
+  void findNext() {
+    while(!d_stack.empty()) {
+      TNode n = d_stack.back();
+      d_stack.pop_back();
+      if(d_marks.mark(n)) {
+        d_current = n;
+        d_descend = true;
+        return;
+      }
+    }
+    d_current = TNode::null();
+  }
+
+public:
+  PreorderNodeIterator(TNode root, NodeMarks& marks) :
+    d_marks(marks),
+    d_descend(false) {
+    d_stack.push_back(root);
+    findNext();
+  }
+
+  bool done() const { return d_current.isNull(); }
+
+  TNode operator*() const { return d_current; }
+  const TNode* operator->() const { return &d_current; }
+
+  /** Don't go below the current node. */
+  void skipChildren() { d_descend = false; }
+
+  PreorderNodeIterator& operator++() {
+    Assert(!done());
+    if(d_descend) {
+      // in reverse, so the first child comes off the stack first
+      for(unsigned i = d_current.getNumChildren(); i > 0; --i) {
+        TNode child = d_current[i - 1];
+        if(!d_marks.isMarked(child)) {
+          d_stack.push_back(child);
+        }
+      }
+    }
+    findNext();
+    return *this;
+  }
+};/* class PreorderNodeIterator */
+
+/**
+ * Iterates over the DAG below a node, children before parents (each
+ * node's children in order), with an explicit stack.  As with
+ * PreorderNodeIterator, each node not already marked is visited once
+ * and marked, and already-marked nodes are skipped with everything
+ * below them.
+ */
+class PostorderNodeIterator {
+  NodeMarks& d_marks;
+  /** nodes, and whether their children have been pushed */
+  std::vector< std::pair<TNode, bool> > d_stack;
+
+  void findNext() {
+    while(!d_stack.empty()) {
+      std::pair<TNode, bool>& top = d_stack.back();
+      if(top.second) {
+        // children done; this is the next node
+        return;
+      }
+      if(!d_marks.mark(top.first)) {
+        d_stack.pop_back();
+        continue;
+      }
+      top.second = true;
+      TNode n = top.first;
+      // (top is invalidated by the push_back()s)
+      for(unsigned i = n.getNumChildren(); i > 0; --i) {
+        TNode child = n[i - 1];
+        if(!d_marks.isMarked(child)) {
+          d_stack.push_back(std::make_pair(child, false));
+        }
+      }
+    }
+  }
+
+public:
+  PostorderNodeIterator(TNode root, NodeMarks& marks) :
+    d_marks(marks) {
+    d_stack.push_back(std::make_pair(root, false));
+    findNext();
+  }
+
+  bool done() const { return d_stack.empty(); }
+
+  TNode operator*() const { return d_stack.back().first; }
+  const TNode* operator->() const { return &d_stack.back().first; }
+
+  PostorderNodeIterator& operator++() {
+    Assert(!done());
+    d_stack.pop_back();
+    findNext();
+    return *this;
+  }
+};/* class PostorderNodeIterator */
+
 }/* CVC4 namespace */
@@ -0,0 +1,166 @@
+/*********************                                                        */
+/*! \file attribute_bench.cpp
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Microbenchmark for dense vs. hashed node attributes
+ **
+ ** Compares lookups of a Node-valued and a bool-valued attribute kept
+ ** in the hash tables (Attribute<>) against the same attributes kept
+ ** in dense tables (DenseAttribute<>), and reports the throughput of
+ ** Node::getType() and cached Rewriter::rewrite() calls, which go
+ ** through dense attributes.
+ **
+ ** Usage: attribute_bench [N] [--format=text|csv|json] [--repeat=R]
+ **/
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "expr/attribute.h"
+#include "expr/expr_manager.h"
+#include "expr/node.h"
+#include "expr/node_manager.h"
+#include "smt/smt_engine.h"
+#include "smt/smt_engine_scope.h"
+#include "theory/rewriter.h"
+
+#include "bench.h"
+
+using namespace std;
+using namespace CVC4;
+using namespace CVC4::bench;
+using namespace CVC4::expr;
+using namespace CVC4::theory;
+
+struct HashedNodeTag {};
+struct DenseNodeTag {};
+struct HashedFlagTag {};
+struct DenseFlagTag {};
+typedef Attribute<HashedNodeTag, Node> HashedNodeAttr;
+typedef DenseAttribute<DenseNodeTag, Node> DenseNodeAttr;
+typedef Attribute<HashedFlagTag, bool> HashedFlagAttr;
+typedef DenseAttribute<DenseFlagTag, bool> DenseFlagAttr;
+
+template <class AttrKind>
+static void benchNodeAttr(Reporter& r, const char* what, vector<Node>& nodes) {
+  double t = now();
+  for(size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].setAttribute(AttrKind(), nodes[nodes.size() - 1 - i]);
+  }
+  r.report(string(what) + " set", nodes.size(), now() - t);
+  size_t found = 0;
+  t = now();
+  for(unsigned round = 0; round < 10; ++round) {
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      Node v;
+      found += nodes[i].getAttribute(AttrKind(), v);
+    }
+  }
+  r.report(string(what) + " get", 10 * nodes.size(), now() - t);
+  if(found != 10 * nodes.size()) {
+    r.fail(string(what) + " lost entries!");
+  }
+}
+
+template <class AttrKind>
+static void benchFlagAttr(Reporter& r, const char* what, vector<Node>& nodes) {
+  for(size_t i = 0; i < nodes.size(); i += 2) {
+    nodes[i].setAttribute(AttrKind(), true);
+  }
+  size_t set = 0;
+  double t = now();
+  for(unsigned round = 0; round < 10; ++round) {
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      set += nodes[i].getAttribute(AttrKind());
+    }
+  }
+  r.report(string(what) + " get", 10 * nodes.size(), now() - t);
+  if(set != 10 * ((nodes.size() + 1) / 2)) {
+    r.fail(string(what) + " lost entries!");
+  }
+}
+
+static void run(Reporter& r) {
+  size_t n = r.n();
+
+  ExprManager em;
+  SmtEngine smt(&em);
+  smt::SmtScope smts(&smt);
+  NodeManager* nm = NodeManager::fromExprManager(&em);
+
+  // a random DAG of integer-sorted terms over a few hundred variables
+  srand(42);
+  vector<Node> nodes;
+  nodes.reserve(n);
+  for(unsigned i = 0; i < 256; ++i) {
+    nodes.push_back(nm->mkSkolem("x", nm->integerType()));
+  }
+  const vector<Node> vars(nodes);
+  const Kind kinds[] = { kind::PLUS, kind::MULT, kind::MINUS };
+  while(nodes.size() < n) {
+    TNode a = nodes[rand() % nodes.size()];
+    TNode b = nodes[rand() % nodes.size()];
+    nodes.push_back(nm->mkNode(kinds[rand() % 3], a, b));
+  }
+  // mkNode() hands back existing nodes for duplicates; keep each once
+  sort(nodes.begin(), nodes.end());
+  nodes.erase(unique(nodes.begin(), nodes.end()), nodes.end());
+
+  benchNodeAttr<HashedNodeAttr>(r, "Attribute<Node>", nodes);
+  benchNodeAttr<DenseNodeAttr>(r, "DenseAttribute<Node>", nodes);
+  benchFlagAttr<HashedFlagAttr>(r, "Attribute<bool>", nodes);
+  benchFlagAttr<DenseFlagAttr>(r, "DenseAttribute<bool>", nodes);
+
+  // the first pass computes (and checks) types; the rest are lookups
+  double t = now();
+  for(size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].getType(true);
+  }
+  r.report("Node::getType() (computing)", nodes.size(), now() - t);
+  t = now();
+  for(unsigned round = 0; round < 10; ++round) {
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      nodes[i].getType(true);
+    }
+  }
+  r.report("Node::getType() (cached)", 10 * nodes.size(), now() - t);
+
+  // likewise, the first pass fills the rewrite caches; these terms
+  // are kept linear, as normalizing nested products of sums blows up
+  vector<Node> linear(vars.begin(), vars.begin() + 16);
+  size_t sample = n < 20000 ? n : 20000;
+  while(linear.size() < sample) {
+    TNode a = linear[rand() % linear.size()];
+    TNode b = linear[rand() % linear.size()];
+    linear.push_back(nm->mkNode(rand() % 2 ? kind::PLUS : kind::MINUS, a, b));
+  }
+  t = now();
+  for(size_t i = 0; i < linear.size(); ++i) {
+    Rewriter::rewrite(linear[i]);
+  }
+  r.report("Rewriter::rewrite() (computing)", linear.size(), now() - t);
+  t = now();
+  for(unsigned round = 0; round < 10; ++round) {
+    for(size_t i = 0; i < linear.size(); ++i) {
+      Rewriter::rewrite(linear[i]);
+    }
+  }
+  r.report("Rewriter::rewrite() (cached)", 10 * linear.size(), now() - t);
+}
+
+int main(int argc, char* argv[]) {
+  Reporter r("attribute_bench", 1000000, argc, argv);
+  for(unsigned i = 0; i < r.runs(); ++i) {
+    r.beginRun(i);
+    run(r);
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+/*********************                                                        */
+/*! \file bench.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Timing and reporting shared by the microbenchmarks
+ **
+ ** Timing and reporting shared by the microbenchmarks.  Each
+ ** benchmark program takes the same arguments:
+ **
+ **   bench [N] [--format=text|csv|json] [--repeat=R]
+ **
+ ** where N scales the problem (each program has its own default) and
+ ** the whole program is run R times (default 1); every measurement is
+ ** reported once per run, tagged with the run number, so that tools
+ ** can take the minimum or median.  Inputs are generated from fixed
+ ** seeds, so runs are repeatable, and each report carries the CVC4
+ ** version, so results from different versions can be compared.
+ **/
+
+#ifndef __CVC4__TEST__BENCH__BENCH_H
+#define __CVC4__TEST__BENCH__BENCH_H
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "util/configuration.h"
+
+namespace CVC4 {
+namespace bench {
+
+/** Monotonic wall-clock time, in seconds */
+inline double now() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+class Reporter {
+public:
+  enum Format { TEXT, CSV, JSON };
+
+private:
+  std::string d_suite;
+  size_t d_n;
+  Format d_format;
+  unsigned d_runs;
+  unsigned d_run;
+  bool d_first;
+
+  static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0
+              << " [N] [--format=text|csv|json] [--repeat=R]" << std::endl;
+    exit(2);
+  }
+
+  /** Quotes s as a JSON (or CSV) string; our names need no escapes */
+  static std::string quote(const std::string& s) {
+    return '"' + s + '"';
+  }
+
+public:
+
+  /**
+   * Parses the command line of the benchmark program suite, with
+   * problem size defaultN unless one is given.
+   */
+  Reporter(const char* suite, size_t defaultN, int argc, char* argv[]) :
+    d_suite(suite),
+    d_n(defaultN),
+    d_format(TEXT),
+    d_runs(1),
+    d_run(0),
+    d_first(true) {
+    for(int i = 1; i < argc; ++i) {
+      const char* arg = argv[i];
+      if(!strcmp(arg, "--format=text")) {
+        d_format = TEXT;
+      } else if(!strcmp(arg, "--format=csv")) {
+        d_format = CSV;
+      } else if(!strcmp(arg, "--format=json")) {
+        d_format = JSON;
+      } else if(!strncmp(arg, "--repeat=", 9) && atoi(arg + 9) > 0) {
+        d_runs = atoi(arg + 9);
+      } else if(arg[0] >= '0' && arg[0] <= '9') {
+        d_n = strtoul(arg, NULL, 10);
+      } else {
+        usage(argv[0]);
+      }
+    }
+
+    switch(d_format) {
+    case CSV:
+      std::cout << "suite,version,n,run,name,ops,seconds,mops_per_sec"
+                << std::endl;
+      break;
+    case JSON:
+      std::cout << "{ " << quote("suite") << ": " << quote(d_suite)
+                << ", " << quote("version") << ": "
+                << quote(Configuration::getVersionString())
+                << ", " << quote("n") << ": " << d_n
+                << ", " << quote("results") << ": [" << std::endl;
+      break;
+    case TEXT:
+      std::cout << d_suite << " (CVC4 " << Configuration::getVersionString()
+                << ", N = " << d_n << ")" << std::endl;
+      break;
+    }
+  }
+
+  ~Reporter() {
+    if(d_format == JSON) {
+      std::cout << std::endl << "] }" << std::endl;
+    }
+  }
+
+  /** The problem size */
+  size_t n() const { return d_n; }
+
+  /** The number of times to run the whole benchmark */
+  unsigned runs() const { return d_runs; }
+
+  /** Starts run number run (counting from 0) */
+  void beginRun(unsigned run) {
+    d_run = run;
+    if(d_format == TEXT && d_runs > 1) {
+      std::cout << "--- run " << run << std::endl;
+    }
+  }
+
+  /** Reports that the operation what was done ops times in secs seconds */
+  void report(const std::string& what, size_t ops, double secs) {
+    double mops = ops / secs / 1e6;
+    switch(d_format) {
+    case TEXT:
+      std::cout << what << ": " << ops << " ops in " << secs << " s ("
+                << mops << " Mops/s)" << std::endl;
+      break;
+    case CSV:
+      std::cout << d_suite << ','
+                << Configuration::getVersionString() << ','
+                << d_n << ',' << d_run << ','
+                << quote(what) << ',' << ops << ','
+                << secs << ',' << mops << std::endl;
+      break;
+    case JSON:
+      std::cout << (d_first ? "  " : ",\n  ")
+                << "{ " << quote("name") << ": " << quote(what)
+                << ", " << quote("run") << ": " << d_run
+                << ", " << quote("ops") << ": " << ops
+                << ", " << quote("seconds") << ": " << secs
+                << ", " << quote("mops_per_sec") << ": " << mops << " }";
+      d_first = false;
+      break;
+    }
+  }
+
+  /** Reports a failed sanity check and exits */
+  void fail(const std::string& what) {
+    std::cout << std::flush;
+    std::cerr << d_suite << ": " << what << std::endl;
+    exit(1);
+  }
+
+};/* class Reporter */
+
+/**
+ * Times a section of a benchmark: the time from construction to
+ * done() (or destruction) is reported as ops operations.
+ */
+class Section {
+  Reporter& d_reporter;
+  std::string d_what;
+  size_t d_ops;
+  double d_start;
+  bool d_done;
+
+public:
+  Section(Reporter& reporter, const std::string& what, size_t ops) :
+    d_reporter(reporter),
+    d_what(what),
+    d_ops(ops),
+    d_start(now()),
+    d_done(false) {
+  }
+
+  ~Section() {
+    done();
+  }
+
+  void done() {
+    if(!d_done) {
+      d_reporter.report(d_what, d_ops, now() - d_start);
+      d_done = true;
+    }
+  }
+};/* class Section */
+
+}/* CVC4::bench namespace */
+}/* CVC4 namespace */
+
+#endif /* __CVC4__TEST__BENCH__BENCH_H */
@@ -0,0 +1,309 @@
+/*********************                                                        */
+/*! \file expr_bench.cpp
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Microbenchmarks for the expression layer
+ **
+ ** Microbenchmarks for the core term layer: NodeManager::mkNode()
+ ** throughput, NodeBuilder construction, setting and getting
+ ** attributes (context-independent, in an AttrHash, and
+ ** context-dependent, in a CDAttrHash), Node::getType(),
+ ** Rewriter::rewrite() on synthetic arithmetic and bit-vector terms,
+ ** and zombie reclamation.  Each run starts from a fresh ExprManager.
+ **
+ ** Usage: expr_bench [N] [--format=text|csv|json] [--repeat=R]
+ **/
+
+#include <cstdlib>
+#include <vector>
+
+#include "expr/attribute.h"
+#include "expr/expr_manager.h"
+#include "expr/node.h"
+#include "expr/node_builder.h"
+#include "expr/node_manager.h"
+#include "smt/smt_engine.h"
+#include "smt/smt_engine_scope.h"
+#include "theory/rewriter.h"
+#include "util/bitvector.h"
+#include "util/rational.h"
+
+#include "bench.h"
+
+using namespace std;
+using namespace CVC4;
+using namespace CVC4::bench;
+using namespace CVC4::expr;
+using namespace CVC4::theory;
+
+struct BenchIntTag {};
+struct BenchCDIntTag {};
+typedef Attribute<BenchIntTag, uint64_t> BenchIntAttr;
+typedef CDAttribute<BenchCDIntTag, uint64_t> BenchCDIntAttr;
+
+/** A small, seeded generator, so that runs (and versions) see the same input */
+class Random {
+  uint32_t d_state;
+public:
+  Random(uint32_t seed) : d_state(seed) {}
+  uint32_t operator()(uint32_t bound) {
+    d_state = d_state * 1103515245 + 12345;
+    return (d_state >> 8) % bound;
+  }
+};/* class Random */
+
+/**
+ * Builds n random binary terms of the given kinds over leaves, each
+ * over two earlier terms (duplicates included); returns them in nodes.
+ */
+static void buildDag(NodeManager* nm, const vector<Node>& leaves,
+                     const Kind* kinds, unsigned nkinds,
+                     size_t n, vector<Node>& nodes) {
+  Random rnd(42);
+  nodes = leaves;
+  nodes.reserve(n);
+  while(nodes.size() < n) {
+    TNode a = nodes[rnd(nodes.size())];
+    TNode b = nodes[rnd(nodes.size())];
+    nodes.push_back(nm->mkNode(kinds[rnd(nkinds)], a, b));
+  }
+}
+
+static void benchMkNode(Reporter& r, NodeManager* nm, vector<Node>& bools) {
+  const Kind kinds[] = { kind::AND, kind::OR, kind::XOR };
+  vector<Node> leaves;
+  for(unsigned i = 0; i < 256; ++i) {
+    leaves.push_back(nm->mkSkolem("b", nm->booleanType()));
+  }
+  {
+    Section s(r, "NodeManager::mkNode (new)", r.n());
+    buildDag(nm, leaves, kinds, 3, r.n(), bools);
+  }
+  // the same sequence of requests again: all of them are found in
+  // the pool
+  vector<Node> again;
+  {
+    Section s(r, "NodeManager::mkNode (existing)", r.n());
+    buildDag(nm, leaves, kinds, 3, r.n(), again);
+  }
+  if(again != bools) {
+    r.fail("mkNode() isn't hash-consing");
+  }
+}
+
+static void benchNodeBuilder(Reporter& r, NodeManager* nm,
+                             const vector<Node>& bools) {
+  // wide nodes, built a child at a time: exercises the builder's
+  // inline storage and its growth onto the heap
+  Random rnd(7);
+  size_t built = 0;
+  size_t n = r.n() / 16;
+  Section s(r, "NodeBuilder (2 to 32 children)", n);
+  for(size_t i = 0; i < n; ++i) {
+    unsigned nchildren = 2 + rnd(31);
+    NodeBuilder<> nb(nm, kind::AND);
+    for(unsigned j = 0; j < nchildren; ++j) {
+      nb << bools[rnd(bools.size())];
+    }
+    Node node = nb;
+    built += node.getNumChildren();
+  }
+  if(built == 0) {
+    r.fail("NodeBuilder built nothing");
+  }
+}
+
+static void benchAttributes(Reporter& r, SmtEngine& smt,
+                            vector<Node>& nodes) {
+  {
+    Section s(r, "Attribute<uint64_t> set", nodes.size());
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      nodes[i].setAttribute(BenchIntAttr(), i);
+    }
+  }
+  uint64_t sum = 0;
+  {
+    Section s(r, "Attribute<uint64_t> get", 10 * nodes.size());
+    for(unsigned round = 0; round < 10; ++round) {
+      for(size_t i = 0; i < nodes.size(); ++i) {
+        sum += nodes[i].getAttribute(BenchIntAttr());
+      }
+    }
+  }
+
+  // context-dependent values are set in a pushed context, so that
+  // the pop, which restores the CDAttrHash, can be timed as well
+  smt.push();
+  {
+    Section s(r, "CDAttribute<uint64_t> set", nodes.size());
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      nodes[i].setAttribute(BenchCDIntAttr(), i);
+    }
+  }
+  uint64_t cdsum = 0;
+  {
+    Section s(r, "CDAttribute<uint64_t> get", 10 * nodes.size());
+    for(unsigned round = 0; round < 10; ++round) {
+      for(size_t i = 0; i < nodes.size(); ++i) {
+        cdsum += nodes[i].getAttribute(BenchCDIntAttr());
+      }
+    }
+  }
+  {
+    Section s(r, "CDAttribute<uint64_t> pop", nodes.size());
+    smt.pop();
+  }
+
+  if(sum != cdsum) {
+    r.fail("attribute values were lost");
+  }
+}
+
+static void benchGetType(Reporter& r, NodeManager* nm) {
+  vector<Node> leaves;
+  for(unsigned i = 0; i < 256; ++i) {
+    leaves.push_back(nm->mkSkolem("x", nm->integerType()));
+  }
+  const Kind kinds[] = { kind::PLUS, kind::MULT, kind::MINUS };
+  vector<Node> terms;
+  buildDag(nm, leaves, kinds, 3, r.n(), terms);
+  {
+    Section s(r, "Node::getType() (checking)", terms.size());
+    for(size_t i = 0; i < terms.size(); ++i) {
+      terms[i].getType(true);
+    }
+  }
+  {
+    Section s(r, "Node::getType() (cached)", 10 * terms.size());
+    for(unsigned round = 0; round < 10; ++round) {
+      for(size_t i = 0; i < terms.size(); ++i) {
+        terms[i].getType(true);
+      }
+    }
+  }
+}
+
+/**
+ * Rewrites the terms, first with cold caches, then again.  (Normal
+ * forms of random nonlinear terms blow up; callers keep them linear.)
+ */
+static void benchRewrite(Reporter& r, const string& what,
+                         const vector<Node>& terms) {
+  size_t size = 0;
+  {
+    Section s(r, "Rewriter::rewrite() " + what + " (computing)", terms.size());
+    for(size_t i = 0; i < terms.size(); ++i) {
+      size += Rewriter::rewrite(terms[i]).getNumChildren();
+    }
+  }
+  {
+    Section s(r, "Rewriter::rewrite() " + what + " (cached)", 10 * terms.size());
+    for(unsigned round = 0; round < 10; ++round) {
+      for(size_t i = 0; i < terms.size(); ++i) {
+        Rewriter::rewrite(terms[i]);
+      }
+    }
+  }
+  if(size == 0) {
+    r.fail("rewriting " + what + " produced only leaves");
+  }
+}
+
+static void benchRewriteArith(Reporter& r, NodeManager* nm) {
+  Random rnd(13);
+  vector<Node> terms;
+  for(unsigned i = 0; i < 16; ++i) {
+    terms.push_back(nm->mkSkolem("x", nm->integerType()));
+  }
+  size_t n = min(r.n(), size_t(20000));
+  while(terms.size() < n) {
+    TNode a = terms[rnd(terms.size())];
+    TNode b = terms[rnd(terms.size())];
+    switch(rnd(3)) {
+    case 0: terms.push_back(nm->mkNode(kind::PLUS, a, b)); break;
+    case 1: terms.push_back(nm->mkNode(kind::MINUS, a, b)); break;
+    default:
+      terms.push_back(nm->mkNode(kind::MULT, nm->mkConst(Rational(rnd(7) + 2)), a));
+    }
+  }
+  benchRewrite(r, "arith", terms);
+}
+
+static void benchRewriteBV(Reporter& r, NodeManager* nm) {
+  Random rnd(17);
+  TypeNode bv32 = nm->mkBitVectorType(32);
+  vector<Node> terms;
+  for(unsigned i = 0; i < 16; ++i) {
+    terms.push_back(nm->mkSkolem("v", bv32));
+  }
+  const Kind kinds[] = {
+    kind::BITVECTOR_PLUS, kind::BITVECTOR_AND, kind::BITVECTOR_OR,
+    kind::BITVECTOR_XOR, kind::BITVECTOR_SUB
+  };
+  size_t n = min(r.n(), size_t(20000));
+  while(terms.size() < n) {
+    TNode a = terms[rnd(terms.size())];
+    if(rnd(8) == 0) {
+      // keep some constants in play, for the constant folding rules
+      terms.push_back(nm->mkNode(kind::BITVECTOR_AND, a,
+                                 nm->mkConst(BitVector(32, Integer(rnd(1 << 16))))));
+    } else {
+      TNode b = terms[rnd(terms.size())];
+      terms.push_back(nm->mkNode(kinds[rnd(5)], a, b));
+    }
+  }
+  benchRewrite(r, "bv", terms);
+}
+
+static void benchZombies(Reporter& r, NodeManager* nm) {
+  const Kind kinds[] = { kind::AND, kind::OR, kind::XOR };
+  vector<Node> leaves;
+  for(unsigned i = 0; i < 256; ++i) {
+    leaves.push_back(nm->mkSkolem("z", nm->booleanType()));
+  }
+  vector<Node> nodes;
+  buildDag(nm, leaves, kinds, 3, r.n(), nodes);
+  size_t before = nm->poolSize();
+  {
+    // dropping the last references zombifies the nodes; reclamation
+    // passes happen along the way, as --gc-zombie-threshold dictates
+    Section s(r, "zombie reclamation", before);
+    nodes.clear();
+    nm->reclaimAllZombies();
+  }
+  if(nm->poolSize() >= before) {
+    r.fail("no zombies were reclaimed");
+  }
+}
+
+int main(int argc, char* argv[]) {
+  Reporter r("expr_bench", 1000000, argc, argv);
+
+  for(unsigned run = 0; run < r.runs(); ++run) {
+    r.beginRun(run);
+    ExprManager em;
+    SmtEngine smt(&em);
+    smt.setOption("incremental", SExpr("true"));
+    smt::SmtScope smts(&smt);
+    NodeManager* nm = NodeManager::fromExprManager(&em);
+
+    vector<Node> bools;
+    benchMkNode(r, nm, bools);
+    benchNodeBuilder(r, nm, bools);
+    benchAttributes(r, smt, bools);
+    bools.clear();
+    benchGetType(r, nm);
+    benchRewriteArith(r, nm);
+    benchRewriteBV(r, nm);
+    benchZombies(r, nm);
+  }
+
+  return 0;
+}
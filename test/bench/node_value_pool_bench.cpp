@@ -0,0 +1,146 @@
+/*********************                                                        */
+/*! \file node_value_pool_bench.cpp
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Microbenchmark for the NodeValue hash-consing pool
+ **
+ ** Compares insert and lookup throughput of the open-addressing
+ ** NodeValueTable used by the NodeManager against the node-based
+ ** __gnu_cxx::hash_set it replaced.  A random DAG of N nodes (10M by
+ ** default) is built once; its NodeValues are then inserted into, and
+ ** looked up in, each structure.
+ **
+ ** Usage: node_value_pool_bench [N] [--format=text|csv|json] [--repeat=R]
+ **/
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <ext/hash_set>
+
+#include "expr/node_manager.h"
+#include "expr/node.h"
+
+#include "bench.h"
+
+using namespace std;
+using namespace CVC4;
+using namespace CVC4::bench;
+using namespace CVC4::expr;
+
+typedef __gnu_cxx::hash_set<NodeValue*,
+                            NodeValuePoolHashFunction,
+                            NodeValuePoolEq> HashSetPool;
+
+static void run(Reporter& r) {
+  size_t n = r.n();
+
+  NodeManager* nm = new NodeManager(NULL);
+  {
+    NodeManagerScope nms(nm);
+
+    // Build a random DAG over a few hundred Boolean leaves: each new
+    // node is an AND/OR/XOR of two earlier nodes.
+    srand(42);
+    vector<Node> nodes;
+    nodes.reserve(n);
+    for(unsigned i = 0; i < 256; ++i) {
+      nodes.push_back(nm->mkSkolem("b", nm->booleanType()));
+    }
+    const Kind kinds[] = { kind::AND, kind::OR, kind::XOR };
+    double t = now();
+    while(nodes.size() < n) {
+      TNode a = nodes[rand() % nodes.size()];
+      TNode b = nodes[rand() % nodes.size()];
+      nodes.push_back(nm->mkNode(kinds[rand() % 3], a, b));
+    }
+    r.report("NodeManager::mkNode (including duplicates)", n, now() - t);
+
+    vector<NodeValue*> nvs;
+    nvs.reserve(nodes.size());
+    for(vector<Node>::iterator i = nodes.begin(); i != nodes.end(); ++i) {
+      nvs.push_back((*i).d_nv);
+    }
+    // mkNode() hands back existing nodes for duplicates; keep each
+    // NodeValue once, in a scrambled order
+    sort(nvs.begin(), nvs.end());
+    nvs.erase(unique(nvs.begin(), nvs.end()), nvs.end());
+    random_shuffle(nvs.begin(), nvs.end());
+
+    {
+      HashSetPool pool;
+      t = now();
+      for(vector<NodeValue*>::iterator i = nvs.begin(); i != nvs.end(); ++i) {
+        pool.insert(*i);
+      }
+      r.report("hash_set insert", nvs.size(), now() - t);
+      size_t found = 0;
+      t = now();
+      for(vector<NodeValue*>::iterator i = nvs.begin(); i != nvs.end(); ++i) {
+        found += pool.find(*i) != pool.end();
+      }
+      r.report("hash_set lookup", nvs.size(), now() - t);
+      if(found != nvs.size()) {
+        r.fail("hash_set lost entries!");
+      }
+    }
+
+    {
+      NodeValuePool pool;
+      t = now();
+      for(vector<NodeValue*>::iterator i = nvs.begin(); i != nvs.end(); ++i) {
+        pool.insert(*i);
+      }
+      r.report("NodeValuePool insert", nvs.size(), now() - t);
+      size_t found = 0;
+      t = now();
+      for(vector<NodeValue*>::iterator i = nvs.begin(); i != nvs.end(); ++i) {
+        found += pool.lookup(*i) != NULL;
+      }
+      r.report("NodeValuePool lookup", nvs.size(), now() - t);
+      if(found != nvs.size()) {
+        r.fail("NodeValuePool lost entries!");
+      }
+      // as a batched builder would: prefetch the home slots of a
+      // batch of NodeValues, then look them up
+      static const size_t BATCH = 8;
+      found = 0;
+      t = now();
+      for(size_t i = 0; i < nvs.size(); i += BATCH) {
+        size_t end = min(i + BATCH, nvs.size());
+        for(size_t j = i; j < end; ++j) {
+          pool.prefetch(nvs[j]);
+        }
+        for(size_t j = i; j < end; ++j) {
+          found += pool.lookup(nvs[j]) != NULL;
+        }
+      }
+      r.report("NodeValuePool lookup (prefetched batches)", nvs.size(), now() - t);
+      if(found != nvs.size()) {
+        r.fail("NodeValuePool lost entries!");
+      }
+      t = now();
+      for(vector<NodeValue*>::iterator i = nvs.begin(); i != nvs.end(); ++i) {
+        pool.remove(*i);
+      }
+      r.report("NodeValuePool remove", nvs.size(), now() - t);
+    }
+  }
+  delete nm;
+}
+
+int main(int argc, char* argv[]) {
+  Reporter r("node_value_pool_bench", 10000000, argc, argv);
+  for(unsigned i = 0; i < r.runs(); ++i) {
+    r.beginRun(i);
+    run(r);
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+; COMMAND-LINE: --threads=2 --incremental-parallel --cube-and-conquer --cube-split-rlimit=1 --cubes=8
+; EXPECT: unsat
+;
+; The pigeonhole problem (5 pigeons, 4 holes), split into cubes right
+; away: every cube has to be refuted.
+(set-logic QF_UF)
+(declare-fun p11 () Bool)
+(declare-fun p12 () Bool)
+(declare-fun p13 () Bool)
+(declare-fun p14 () Bool)
+(declare-fun p21 () Bool)
+(declare-fun p22 () Bool)
+(declare-fun p23 () Bool)
+(declare-fun p24 () Bool)
+(declare-fun p31 () Bool)
+(declare-fun p32 () Bool)
+(declare-fun p33 () Bool)
+(declare-fun p34 () Bool)
+(declare-fun p41 () Bool)
+(declare-fun p42 () Bool)
+(declare-fun p43 () Bool)
+(declare-fun p44 () Bool)
+(declare-fun p51 () Bool)
+(declare-fun p52 () Bool)
+(declare-fun p53 () Bool)
+(declare-fun p54 () Bool)
+(assert (or p11 p12 p13 p14))
+(assert (or p21 p22 p23 p24))
+(assert (or p31 p32 p33 p34))
+(assert (or p41 p42 p43 p44))
+(assert (or p51 p52 p53 p54))
+(assert (or (not p11) (not p21)))
+(assert (or (not p11) (not p31)))
+(assert (or (not p11) (not p41)))
+(assert (or (not p11) (not p51)))
+(assert (or (not p21) (not p31)))
+(assert (or (not p21) (not p41)))
+(assert (or (not p21) (not p51)))
+(assert (or (not p31) (not p41)))
+(assert (or (not p31) (not p51)))
+(assert (or (not p41) (not p51)))
+(assert (or (not p12) (not p22)))
+(assert (or (not p12) (not p32)))
+(assert (or (not p12) (not p42)))
+(assert (or (not p12) (not p52)))
+(assert (or (not p22) (not p32)))
+(assert (or (not p22) (not p42)))
+(assert (or (not p22) (not p52)))
+(assert (or (not p32) (not p42)))
+(assert (or (not p32) (not p52)))
+(assert (or (not p42) (not p52)))
+(assert (or (not p13) (not p23)))
+(assert (or (not p13) (not p33)))
+(assert (or (not p13) (not p43)))
+(assert (or (not p13) (not p53)))
+(assert (or (not p23) (not p33)))
+(assert (or (not p23) (not p43)))
+(assert (or (not p23) (not p53)))
+(assert (or (not p33) (not p43)))
+(assert (or (not p33) (not p53)))
+(assert (or (not p43) (not p53)))
+(assert (or (not p14) (not p24)))
+(assert (or (not p14) (not p34)))
+(assert (or (not p14) (not p44)))
+(assert (or (not p14) (not p54)))
+(assert (or (not p24) (not p34)))
+(assert (or (not p24) (not p44)))
+(assert (or (not p24) (not p54)))
+(assert (or (not p34) (not p44)))
+(assert (or (not p34) (not p54)))
+(assert (or (not p44) (not p54)))
+(check-sat)
@@ -0,0 +1,22 @@
+; COMMAND-LINE: --incremental --check-models
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: (a b)
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: ((> x 10) b)
+; EXPECT: sat
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun a () Bool)
+(declare-fun b () Bool)
+(declare-fun c () Bool)
+(assert (=> a (> x 5)))
+(assert (=> b (< x 3)))
+(check-sat-assuming (a c))
+(check-sat-assuming (a b c))
+(get-unsat-assumptions)
+(check-sat-assuming ((not a) b))
+(check-sat-assuming ((> x 10) b))
+(get-unsat-assumptions)
+(check-sat)
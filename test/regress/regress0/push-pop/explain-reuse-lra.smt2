@@ -0,0 +1,59 @@
+; COMMAND-LINE: --incremental
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: sat
+;
+; Chains of bounds through either of two paths: the bounds between the
+; x's are propagated by arithmetic, and explained again after the
+; SAT solver backtracks, and after each pop.
+(set-logic QF_LRA)
+(declare-fun x0 () Real)
+(declare-fun x1 () Real)
+(declare-fun x2 () Real)
+(declare-fun x3 () Real)
+(declare-fun x4 () Real)
+(declare-fun x5 () Real)
+(declare-fun x6 () Real)
+(declare-fun y0 () Real)
+(declare-fun z0 () Real)
+(declare-fun y1 () Real)
+(declare-fun z1 () Real)
+(declare-fun y2 () Real)
+(declare-fun z2 () Real)
+(declare-fun y3 () Real)
+(declare-fun z3 () Real)
+(declare-fun y4 () Real)
+(declare-fun z4 () Real)
+(declare-fun y5 () Real)
+(declare-fun z5 () Real)
+(assert (or (and (<= x0 y0) (<= y0 x1)) (and (<= x0 z0) (<= z0 x1))))
+(assert (or (and (<= x1 y1) (<= y1 x2)) (and (<= x1 z1) (<= z1 x2))))
+(assert (or (and (<= x2 y2) (<= y2 x3)) (and (<= x2 z2) (<= z2 x3))))
+(assert (or (and (<= x3 y3) (<= y3 x4)) (and (<= x3 z3) (<= z3 x4))))
+(assert (or (and (<= x4 y4) (<= y4 x5)) (and (<= x4 z4) (<= z4 x5))))
+(assert (or (and (<= x5 y5) (<= y5 x6)) (and (<= x5 z5) (<= z5 x6))))
+(declare-fun b1 () Bool)
+(assert (= b1 (<= x0 x1)))
+(declare-fun b2 () Bool)
+(assert (= b2 (<= x0 x2)))
+(declare-fun b3 () Bool)
+(assert (= b3 (<= x0 x3)))
+(declare-fun b4 () Bool)
+(assert (= b4 (<= x0 x4)))
+(declare-fun b5 () Bool)
+(assert (= b5 (<= x0 x5)))
+(declare-fun b6 () Bool)
+(assert (= b6 (<= x0 x6)))
+(check-sat)
+(push 1)
+(assert (> x0 x6))
+(check-sat)
+(pop 1)
+(check-sat)
+(push 1)
+(assert (not b3))
+(check-sat)
+(pop 1)
+(check-sat)
@@ -0,0 +1,51 @@
+; COMMAND-LINE: --incremental
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: sat
+; EXPECT: unsat
+; EXPECT: unsat
+; EXPECT: sat
+;
+; Equality diamonds: the equalities between the x's are theory
+; propagations, explained again and again as the SAT solver backtracks
+; out of each diamond, before and after the pops that drop the
+; explanations kept at their level.
+(set-logic QF_UF)
+(declare-sort U 0)
+(declare-fun x0 () U)
+(declare-fun x1 () U)
+(declare-fun x2 () U)
+(declare-fun x3 () U)
+(declare-fun x4 () U)
+(declare-fun x5 () U)
+(declare-fun x6 () U)
+(declare-fun y0 () U)
+(declare-fun z0 () U)
+(declare-fun y1 () U)
+(declare-fun z1 () U)
+(declare-fun y2 () U)
+(declare-fun z2 () U)
+(declare-fun y3 () U)
+(declare-fun z3 () U)
+(declare-fun y4 () U)
+(declare-fun z4 () U)
+(declare-fun y5 () U)
+(declare-fun z5 () U)
+(assert (or (and (= x0 y0) (= y0 x1)) (and (= x0 z0) (= z0 x1))))
+(assert (or (and (= x1 y1) (= y1 x2)) (and (= x1 z1) (= z1 x2))))
+(assert (or (and (= x2 y2) (= y2 x3)) (and (= x2 z2) (= z2 x3))))
+(assert (or (and (= x3 y3) (= y3 x4)) (and (= x3 z3) (= z3 x4))))
+(assert (or (and (= x4 y4) (= y4 x5)) (and (= x4 z4) (= z4 x5))))
+(assert (or (and (= x5 y5) (= y5 x6)) (and (= x5 z5) (= z5 x6))))
+(check-sat)
+(push 1)
+(assert (not (= x0 x6)))
+(check-sat)
+(pop 1)
+(check-sat)
+(push 1)
+(assert (not (= x1 x4)))
+(check-sat)
+(pop 1)
+(check-sat-assuming ((not (= x0 x3))))
+(check-sat)
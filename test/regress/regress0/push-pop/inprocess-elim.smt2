@@ -0,0 +1,170 @@
+; COMMAND-LINE: --incremental --simplification=none --decision=internal --restart-int-base=2 --sat-inprocess --sat-inprocess-int=1 --sat-inprocess-elim
+; EXPECT: unsat
+; EXPECT: unsat
+; EXPECT: sat
+; EXPECT: (model
+; EXPECT: (define-fun g () Bool false)
+; EXPECT: (define-fun a () Bool false)
+; EXPECT: (define-fun b () Bool true)
+; EXPECT: (define-fun c () Bool true)
+; EXPECT: (define-fun p11 () Bool false)
+; EXPECT: (define-fun p12 () Bool false)
+; EXPECT: (define-fun p13 () Bool false)
+; EXPECT: (define-fun p14 () Bool false)
+; EXPECT: (define-fun p21 () Bool false)
+; EXPECT: (define-fun p22 () Bool false)
+; EXPECT: (define-fun p23 () Bool false)
+; EXPECT: (define-fun p24 () Bool false)
+; EXPECT: (define-fun p31 () Bool false)
+; EXPECT: (define-fun p32 () Bool false)
+; EXPECT: (define-fun p33 () Bool false)
+; EXPECT: (define-fun p34 () Bool false)
+; EXPECT: (define-fun p41 () Bool false)
+; EXPECT: (define-fun p42 () Bool false)
+; EXPECT: (define-fun p43 () Bool false)
+; EXPECT: (define-fun p44 () Bool false)
+; EXPECT: (define-fun p51 () Bool false)
+; EXPECT: (define-fun p52 () Bool false)
+; EXPECT: (define-fun p53 () Bool false)
+; EXPECT: (define-fun p54 () Bool false)
+; EXPECT: )
+; EXPECT: unsat
+; EXPECT: sat
+; EXPECT: (model
+; EXPECT: (define-fun g () Bool false)
+; EXPECT: (define-fun a () Bool true)
+; EXPECT: (define-fun b () Bool false)
+; EXPECT: (define-fun c () Bool true)
+; EXPECT: (define-fun p11 () Bool false)
+; EXPECT: (define-fun p12 () Bool false)
+; EXPECT: (define-fun p13 () Bool false)
+; EXPECT: (define-fun p14 () Bool false)
+; EXPECT: (define-fun p21 () Bool false)
+; EXPECT: (define-fun p22 () Bool false)
+; EXPECT: (define-fun p23 () Bool false)
+; EXPECT: (define-fun p24 () Bool false)
+; EXPECT: (define-fun p31 () Bool false)
+; EXPECT: (define-fun p32 () Bool false)
+; EXPECT: (define-fun p33 () Bool false)
+; EXPECT: (define-fun p34 () Bool false)
+; EXPECT: (define-fun p41 () Bool false)
+; EXPECT: (define-fun p42 () Bool false)
+; EXPECT: (define-fun p43 () Bool false)
+; EXPECT: (define-fun p44 () Bool false)
+; EXPECT: (define-fun p51 () Bool false)
+; EXPECT: (define-fun p52 () Bool false)
+; EXPECT: (define-fun p53 () Bool false)
+; EXPECT: (define-fun p54 () Bool false)
+; EXPECT: )
+;
+; g guards a pigeonhole problem (5 pigeons, 4 holes), so assuming it
+; gives enough conflicts for several inprocessing rounds, which can
+; eliminate the pigeon variables.  Those are mentioned again inside
+; the push, and the eliminations at level 1 are undone by the pop;
+; the models check the values of the eliminated variables.
+(set-logic QF_UF)
+(set-option :produce-models true)
+(declare-fun g () Bool)
+(declare-fun a () Bool)
+(declare-fun b () Bool)
+(declare-fun c () Bool)
+(declare-fun p11 () Bool)
+(declare-fun p12 () Bool)
+(declare-fun p13 () Bool)
+(declare-fun p14 () Bool)
+(declare-fun p21 () Bool)
+(declare-fun p22 () Bool)
+(declare-fun p23 () Bool)
+(declare-fun p24 () Bool)
+(declare-fun p31 () Bool)
+(declare-fun p32 () Bool)
+(declare-fun p33 () Bool)
+(declare-fun p34 () Bool)
+(declare-fun p41 () Bool)
+(declare-fun p42 () Bool)
+(declare-fun p43 () Bool)
+(declare-fun p44 () Bool)
+(declare-fun p51 () Bool)
+(declare-fun p52 () Bool)
+(declare-fun p53 () Bool)
+(declare-fun p54 () Bool)
+(assert (or a b))
+(assert (=> a c))
+(assert (=> b c))
+(assert (or (not g) p11 p12 p13 p14))
+(assert (or (not g) p21 p22 p23 p24))
+(assert (or (not g) p31 p32 p33 p34))
+(assert (or (not g) p41 p42 p43 p44))
+(assert (or (not g) p51 p52 p53 p54))
+(assert (or (not g) (not p11) (not p21)))
+(assert (or (not g) (not p11) (not p31)))
+(assert (or (not g) (not p11) (not p41)))
+(assert (or (not g) (not p11) (not p51)))
+(assert (or (not g) (not p21) (not p31)))
+(assert (or (not g) (not p21) (not p41)))
+(assert (or (not g) (not p21) (not p51)))
+(assert (or (not g) (not p31) (not p41)))
+(assert (or (not g) (not p31) (not p51)))
+(assert (or (not g) (not p41) (not p51)))
+(assert (or (not g) (not p12) (not p22)))
+(assert (or (not g) (not p12) (not p32)))
+(assert (or (not g) (not p12) (not p42)))
+(assert (or (not g) (not p12) (not p52)))
+(assert (or (not g) (not p22) (not p32)))
+(assert (or (not g) (not p22) (not p42)))
+(assert (or (not g) (not p22) (not p52)))
+(assert (or (not g) (not p32) (not p42)))
+(assert (or (not g) (not p32) (not p52)))
+(assert (or (not g) (not p42) (not p52)))
+(assert (or (not g) (not p13) (not p23)))
+(assert (or (not g) (not p13) (not p33)))
+(assert (or (not g) (not p13) (not p43)))
+(assert (or (not g) (not p13) (not p53)))
+(assert (or (not g) (not p23) (not p33)))
+(assert (or (not g) (not p23) (not p43)))
+(assert (or (not g) (not p23) (not p53)))
+(assert (or (not g) (not p33) (not p43)))
+(assert (or (not g) (not p33) (not p53)))
+(assert (or (not g) (not p43) (not p53)))
+(assert (or (not g) (not p14) (not p24)))
+(assert (or (not g) (not p14) (not p34)))
+(assert (or (not g) (not p14) (not p44)))
+(assert (or (not g) (not p14) (not p54)))
+(assert (or (not g) (not p24) (not p34)))
+(assert (or (not g) (not p24) (not p44)))
+(assert (or (not g) (not p24) (not p54)))
+(assert (or (not g) (not p34) (not p44)))
+(assert (or (not g) (not p34) (not p54)))
+(assert (or (not g) (not p44) (not p54)))
+(assert (or g (not p11)))
+(assert (or g (not p12)))
+(assert (or g (not p13)))
+(assert (or g (not p14)))
+(assert (or g (not p21)))
+(assert (or g (not p22)))
+(assert (or g (not p23)))
+(assert (or g (not p24)))
+(assert (or g (not p31)))
+(assert (or g (not p32)))
+(assert (or g (not p33)))
+(assert (or g (not p34)))
+(assert (or g (not p41)))
+(assert (or g (not p42)))
+(assert (or g (not p43)))
+(assert (or g (not p44)))
+(assert (or g (not p51)))
+(assert (or g (not p52)))
+(assert (or g (not p53)))
+(assert (or g (not p54)))
+(check-sat-assuming (g))
+(push 1)
+(assert (not a))
+(assert (or (not b) (not p11) (not p54)))
+(check-sat-assuming (g))
+(check-sat)
+(get-model)
+(pop 1)
+(assert (not b))
+(check-sat-assuming (g))
+(check-sat)
+(get-model)
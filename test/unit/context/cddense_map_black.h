@@ -0,0 +1,175 @@
+/*********************                                                        */
+/*! \file cddense_map_black.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Black box testing of CVC4::context::CDDenseMap<>.
+ **
+ ** Black box testing of CVC4::context::CDDenseMap<>.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <string>
+#include <vector>
+
+#include "context/cddense_map.h"
+
+using namespace std;
+using namespace CVC4;
+using namespace CVC4::context;
+
+struct IdentityIndex {
+  size_t operator()(unsigned i) const {
+    return i;
+  }
+};
+
+class CDDenseMapBlack : public CxxTest::TestSuite {
+
+  Context* d_context;
+
+public:
+
+  void setUp() {
+    d_context = new Context;
+  }
+
+  void tearDown() {
+    delete d_context;
+  }
+
+  void testSimpleSequence() {
+    CDDenseMap<unsigned, int, IdentityIndex> map(d_context);
+
+    TS_ASSERT(map.empty());
+    TS_ASSERT(!map.contains(3));
+
+    map.insert(3, 4);
+    TS_ASSERT(map.contains(3));
+    TS_ASSERT(map[3] == 4);
+    TS_ASSERT(map.size() == 1);
+
+    d_context->push();
+    TS_ASSERT(map.insert_safe(5, 6));
+    TS_ASSERT(!map.insert_safe(3, 5));
+    TS_ASSERT(map[3] == 4);
+    TS_ASSERT(map[5] == 6);
+
+    d_context->push();
+    map.insert(9, 10);
+    map.insert(1, 2);
+    TS_ASSERT(map.size() == 4);
+    d_context->pop();
+
+    TS_ASSERT(map.size() == 2);
+    TS_ASSERT(map.contains(5));
+    TS_ASSERT(!map.contains(9));
+    TS_ASSERT(!map.contains(1));
+    d_context->pop();
+
+    TS_ASSERT(map.size() == 1);
+    TS_ASSERT(map.contains(3));
+    TS_ASSERT(!map.contains(5));
+  }
+
+  void testSparseAndBacktrack() {
+    // indices far apart, across many pages, and reinserted after pops
+    CDDenseMap<unsigned, string, IdentityIndex> map(d_context);
+    map.insert(0, "zero");
+    map.insert(1000000, "million");
+    for(unsigned level = 1; level <= 5; ++level) {
+      d_context->push();
+      for(unsigned i = 0; i < 1000; ++i) {
+        map.insert(level * 100000 + i * 37, "x");
+      }
+      TS_ASSERT(map.size() == 2 + level * 1000);
+    }
+    for(unsigned level = 5; level > 0; --level) {
+      TS_ASSERT(map.contains(level * 100000 + 999 * 37));
+      d_context->pop();
+      TS_ASSERT(!map.contains(level * 100000 + 999 * 37));
+      TS_ASSERT(map.size() == 2 + (level - 1) * 1000);
+    }
+    TS_ASSERT(map[0] == "zero");
+    TS_ASSERT(map[1000000] == "million");
+
+    d_context->push();
+    map.insert(100000, "again");
+    TS_ASSERT(map[100000] == "again");
+    d_context->pop();
+    TS_ASSERT(!map.contains(100000));
+  }
+
+  void testInsertAtContextLevelZero() {
+    CDDenseMap<unsigned, int, IdentityIndex> map(d_context);
+    map.insert(1, 1);
+    d_context->push();
+    map.insert(2, 2);
+    map.insertAtContextLevelZero(3, 3);
+    map.insert(4, 4);
+    d_context->push();
+    map.insertAtContextLevelZero(5, 5);
+    d_context->pop();
+    TS_ASSERT(map.contains(5));
+    d_context->pop();
+
+    TS_ASSERT(map.size() == 3);
+    TS_ASSERT(map.contains(1));
+    TS_ASSERT(!map.contains(2));
+    TS_ASSERT(map.contains(3));
+    TS_ASSERT(!map.contains(4));
+    TS_ASSERT(map.contains(5));
+  }
+
+  void testIteration() {
+    CDDenseMap<unsigned, int, IdentityIndex> map(d_context);
+    map.insert(700, 1);
+    d_context->push();
+    map.insert(20, 2);
+    map.insert(3000, 3);
+    map.insertAtContextLevelZero(1, 26);
+
+    // elements are in insertion order, insertAtContextLevelZero() ones first
+    vector<unsigned> keys;
+    int sum = 0;
+    for(CDDenseMap<unsigned, int, IdentityIndex>::const_iterator
+          i = map.begin(); i != map.end(); ++i) {
+      keys.push_back((*i).first);
+      sum += (*i).second;
+    }
+    TS_ASSERT(keys.size() == 4);
+    TS_ASSERT(keys[0] == 1);
+    TS_ASSERT(keys[1] == 700);
+    TS_ASSERT(keys[2] == 20);
+    TS_ASSERT(keys[3] == 3000);
+    TS_ASSERT(sum == 32);
+
+    d_context->pop();
+    keys.clear();
+    for(CDDenseMap<unsigned, int, IdentityIndex>::const_iterator
+          i = map.begin(); i != map.end(); ++i) {
+      keys.push_back((*i).first);
+    }
+    TS_ASSERT(keys.size() == 2);
+    TS_ASSERT(keys[0] == 1);
+    TS_ASSERT(keys[1] == 700);
+  }
+
+  void testDestroyAtHigherLevel() {
+    d_context->push();
+    {
+      CDDenseMap<unsigned, string, IdentityIndex> map(d_context);
+      map.insert(7, "y");
+    }
+    // its entry on the undo trail went with it
+    d_context->pop();
+  }
+
+};/* class CDDenseMapBlack */
@@ -0,0 +1,169 @@
+/*********************                                                        */
+/*! \file cdflat_hashmap_black.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Black box testing of CVC4::context::CDFlatHashMap<>.
+ **
+ ** Black box testing of CVC4::context::CDFlatHashMap<>.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "context/cdflat_hashmap.h"
+#include "util/hash.h"
+
+using namespace std;
+using namespace CVC4;
+using namespace CVC4::context;
+
+class CDFlatHashMapBlack : public CxxTest::TestSuite {
+
+  Context* d_context;
+
+public:
+
+  void setUp() {
+    d_context = new Context;
+  }
+
+  void tearDown() {
+    delete d_context;
+  }
+
+  void testSimpleSequence() {
+    CDFlatHashMap<int, int> map(d_context);
+
+    TS_ASSERT(map.empty());
+    TS_ASSERT(map.find(3) == map.end());
+    TS_ASSERT(!map.contains(3));
+
+    map.insert(3, 4);
+    TS_ASSERT(map.contains(3));
+    TS_ASSERT(map[3] == 4);
+    TS_ASSERT((*map.find(3)).second == 4);
+    TS_ASSERT(map.size() == 1);
+
+    d_context->push();
+    TS_ASSERT(map.insert_safe(5, 6));
+    TS_ASSERT(!map.insert_safe(3, 5));
+    TS_ASSERT(map[3] == 4);
+    TS_ASSERT(map[5] == 6);
+
+    d_context->push();
+    map.insert(9, 10);
+    map.insert(1, 2);
+    TS_ASSERT(map.size() == 4);
+    d_context->pop();
+
+    TS_ASSERT(map.size() == 2);
+    TS_ASSERT(map.contains(5));
+    TS_ASSERT(!map.contains(9));
+    TS_ASSERT(!map.contains(1));
+    d_context->pop();
+
+    TS_ASSERT(map.size() == 1);
+    TS_ASSERT(map.contains(3));
+    TS_ASSERT(!map.contains(5));
+  }
+
+  void testGrowAndBacktrack() {
+    // enough to rehash several times, and to collide
+    CDFlatHashMap<unsigned, unsigned> map(d_context);
+    for(unsigned i = 0; i < 100; ++i) {
+      map.insert(i * 1024, i);
+    }
+    for(unsigned level = 1; level <= 10; ++level) {
+      d_context->push();
+      for(unsigned i = 0; i < 1000; ++i) {
+        map.insert(level * 100000 + i * 64, i);
+      }
+      TS_ASSERT(map.size() == 100 + level * 1000);
+    }
+    for(unsigned level = 10; level > 0; --level) {
+      TS_ASSERT(map.contains(level * 100000 + 999 * 64));
+      d_context->pop();
+      TS_ASSERT(!map.contains(level * 100000 + 999 * 64));
+      TS_ASSERT(map.size() == 100 + (level - 1) * 1000);
+      // the deleted slots don't hide the remaining elements
+      for(unsigned i = 0; i < 100; ++i) {
+        TS_ASSERT(map[i * 1024] == i);
+      }
+    }
+  }
+
+  void testInsertAtContextLevelZero() {
+    CDFlatHashMap<int, int> map(d_context);
+    map.insert(1, 1);
+    d_context->push();
+    map.insert(2, 2);
+    map.insertAtContextLevelZero(3, 3);
+    map.insert(4, 4);
+    d_context->push();
+    map.insertAtContextLevelZero(5, 5);
+    d_context->pop();
+    TS_ASSERT(map.contains(5));
+    d_context->pop();
+
+    TS_ASSERT(map.size() == 3);
+    TS_ASSERT(map.contains(1));
+    TS_ASSERT(!map.contains(2));
+    TS_ASSERT(map.contains(3));
+    TS_ASSERT(!map.contains(4));
+    TS_ASSERT(map.contains(5));
+  }
+
+  void testIteration() {
+    CDFlatHashMap<string, int, StringHashFunction> map(d_context);
+    map.insert("a", 1);
+    d_context->push();
+    map.insert("b", 2);
+    map.insert("c", 3);
+    map.insertAtContextLevelZero("z", 26);
+
+    // keys are in insertion order, insertAtContextLevelZero() ones first
+    vector<string> keys(map.key_begin(), map.key_end());
+    TS_ASSERT(keys.size() == 4);
+    TS_ASSERT(keys[0] == "z");
+    TS_ASSERT(keys[1] == "a");
+    TS_ASSERT(keys[2] == "b");
+    TS_ASSERT(keys[3] == "c");
+
+    set<string> seen;
+    int sum = 0;
+    for(CDFlatHashMap<string, int, StringHashFunction>::const_iterator
+          i = map.begin(); i != map.end(); ++i) {
+      seen.insert((*i).first);
+      sum += (*i).second;
+    }
+    TS_ASSERT(seen.size() == 4);
+    TS_ASSERT(sum == 32);
+
+    d_context->pop();
+    keys.assign(map.key_begin(), map.key_end());
+    TS_ASSERT(keys.size() == 2);
+    TS_ASSERT(keys[0] == "z");
+    TS_ASSERT(keys[1] == "a");
+  }
+
+  void testDestroyAtHigherLevel() {
+    d_context->push();
+    {
+      CDFlatHashMap<string, string, StringHashFunction> map(d_context);
+      map.insert("x", "y");
+    }
+    // its entry on the undo trail went with it
+    d_context->pop();
+  }
+
+};/* class CDFlatHashMapBlack */
@@ -16,6 +16,7 @@
 
 #include <cxxtest/TestSuite.h>
 #include <cstring>
+#include <stdint.h>
 
 //Used in some of the tests
 #include <vector>
@@ -90,6 +91,50 @@ public:
     d_cmm->pop();
   }
 
+  void testOversize() {
+    d_cmm->push();
+    size_t big = 3 * ContextMemoryManager::getMaxAllocationSize();
+    char* p = (char*)d_cmm->newData(big);
+    memset(p, 'x', big);
+    char* q = (char*)d_cmm->newData(16);
+    TS_ASSERT( q < p || q >= p + big );
+    TS_ASSERT_EQUALS( d_cmm->getStatistics().d_oversizeAllocations, 1u );
+    d_cmm->pop();
+  }
+
+  void testChunkSizeAndStatistics() {
+    d_cmm->setChunkSize(65536);
+    TS_ASSERT_EQUALS( d_cmm->getChunkSize(), 65536u );
+    uint64_t chunks = d_cmm->getStatistics().d_chunksAllocated;
+    for(unsigned p = 0; p < 3; ++p) {
+      d_cmm->push();
+      for(unsigned i = 0; i < 10; ++i) {
+        // 10 chunks' worth of 32 KB allocations
+        d_cmm->newData(32768);
+        d_cmm->newData(32768);
+      }
+      d_cmm->pop();
+    }
+    const ContextMemoryManager::Statistics& stats = d_cmm->getStatistics();
+    // the chunks allocated in the first round are reused afterward
+    TS_ASSERT_LESS_THAN_EQUALS( stats.d_chunksAllocated - chunks, 11u );
+    TS_ASSERT_LESS_THAN_EQUALS( 20u, stats.d_chunksRecycled );
+    TS_ASSERT_EQUALS( stats.d_levelsPopped, 3u );
+    TS_ASSERT_EQUALS( stats.d_maxBytesPerLevel, 20u * 32768 );
+    TS_ASSERT_LESS_THAN_EQUALS( stats.d_peakBytes, stats.d_bytesInUse + 20u * 32768 );
+    TS_ASSERT_LESS_THAN_EQUALS( stats.d_bytesInUse + 20u * 32768, stats.d_peakBytes );
+  }
+
+  void testHugePages() {
+    d_cmm->setHugePages(true);
+    // rounded up to the huge page size
+    TS_ASSERT_EQUALS( d_cmm->getChunkSize() % (2 * 1024 * 1024), 0u );
+    d_cmm->push();
+    char* p = (char*)d_cmm->newData(d_cmm->getChunkSize());
+    p[0] = p[d_cmm->getChunkSize() - 1] = 'x';
+    d_cmm->pop();
+  }
+
   void tearDown() {
     delete d_cmm;
   }
@@ -0,0 +1,180 @@
+/*********************                                                        */
+/*! \file context_snapshot_black.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Black box testing of CVC4::context::ContextSnapshot.
+ **
+ ** Black box testing of CVC4::context::ContextSnapshot, and of forking
+ ** context-dependent objects from one.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <string>
+
+#include "context/context.h"
+#include "context/cdo.h"
+#include "context/cdlist.h"
+#include "context/cdhashmap.h"
+#include "util/hash.h"
+
+using namespace std;
+using namespace CVC4;
+using namespace CVC4::context;
+
+class ContextSnapshotBlack : public CxxTest::TestSuite {
+
+  Context* d_context;
+
+public:
+
+  void setUp() {
+    d_context = new Context;
+  }
+
+  void tearDown() {
+    delete d_context;
+  }
+
+  void testCDO() {
+    CDO<int> a(d_context, 1);
+    CDO<string> b(d_context, "zero");
+    d_context->push();
+    a = 2;
+    b = "one";
+
+    ContextSnapshot snapshot(d_context);
+    TS_ASSERT(snapshot.getLevel() == 1);
+    TS_ASSERT(snapshot.size() >= 2);
+
+    // changes to the originals after the snapshot aren't seen
+    a = 3;
+    d_context->pop();
+    TS_ASSERT(a.get() == 1);
+    TS_ASSERT(b.get() == "zero");
+
+    Context worker;
+    CDO<int> wa(&worker, snapshot, a);
+    CDO<string> wb(&worker, snapshot, b);
+    TS_ASSERT(wa.get() == 2);
+    TS_ASSERT(wb.get() == "one");
+
+    // and the forks' changes aren't seen by the originals; the
+    // snapshot's values are the forks' level-zero values
+    worker.push();
+    wa = 4;
+    wb = "four";
+    TS_ASSERT(a.get() == 1);
+    TS_ASSERT(b.get() == "zero");
+    worker.pop();
+    TS_ASSERT(wa.get() == 2);
+    TS_ASSERT(wb.get() == "one");
+  }
+
+  void testCDList() {
+    CDList<string> list(d_context);
+    list.push_back("a");
+    d_context->push();
+    list.push_back("b");
+    list.push_back("c");
+
+    ContextSnapshot snapshot(d_context);
+
+    // the original pops below the snapshot and reuses the space
+    d_context->pop();
+    list.push_back("x");
+    TS_ASSERT(list.size() == 2);
+    TS_ASSERT(list[1] == "x");
+
+    Context worker;
+    CDList<string> fork(&worker, snapshot, list);
+    TS_ASSERT(fork.size() == 3);
+    TS_ASSERT(fork[0] == "a");
+    TS_ASSERT(fork[1] == "b");
+    TS_ASSERT(fork[2] == "c");
+
+    worker.push();
+    fork.push_back("d");
+    TS_ASSERT(fork.size() == 4);
+    TS_ASSERT(list.size() == 2);
+    TS_ASSERT(list[1] == "x");
+    worker.pop();
+    TS_ASSERT(fork.size() == 3);
+    TS_ASSERT(fork[2] == "c");
+
+    // the elements the fork was given can't be popped
+    fork.push_back("e");
+    TS_ASSERT(fork.size() == 4);
+    TS_ASSERT(fork[3] == "e");
+  }
+
+  void testSharing() {
+    CDList<int> list(d_context);
+    for(int i = 0; i < 100; ++i) {
+      list.push_back(i);
+    }
+
+    ContextSnapshot* snapshot = new ContextSnapshot(d_context);
+    Context worker1, worker2;
+    CDList<int> fork1(&worker1, *snapshot, list);
+    CDList<int> fork2(&worker2, *snapshot, list);
+    // forks can outlive the snapshot
+    delete snapshot;
+
+    // until they change, the forks share their elements
+    TS_ASSERT(&fork1[0] == &fork2[0]);
+    worker1.push();
+    fork1.push_back(100);
+    TS_ASSERT(&fork1[0] != &fork2[0]);
+    TS_ASSERT(fork1.size() == 101);
+    TS_ASSERT(fork2.size() == 100);
+    for(int i = 0; i < 100; ++i) {
+      TS_ASSERT(fork1[i] == i);
+      TS_ASSERT(fork2[i] == i);
+    }
+
+    // a snapshot of an unchanged fork shares its elements, too
+    ContextSnapshot snapshot2(&worker2);
+    Context worker3;
+    CDList<int> fork3(&worker3, snapshot2, fork2);
+    TS_ASSERT(&fork3[0] == &fork2[0]);
+    TS_ASSERT(fork3.size() == 100);
+  }
+
+  void testCDHashMap() {
+    CDHashMap<string, int, StringHashFunction> map(d_context);
+    map.insert("a", 1);
+    d_context->push();
+    map.insert("b", 2);
+    map.insert("a", 10);
+
+    ContextSnapshot snapshot(d_context);
+    map.insert("c", 3);
+    d_context->pop();
+    TS_ASSERT(map.size() == 1);
+
+    Context worker;
+    CDHashMap<string, int, StringHashFunction> fork(&worker, snapshot, map);
+    TS_ASSERT(fork.size() == 2);
+    TS_ASSERT(fork["a"] == 10);
+    TS_ASSERT(fork["b"] == 2);
+    TS_ASSERT(fork.find("c") == fork.end());
+
+    worker.push();
+    fork.insert("d", 4);
+    fork.insert("a", 20);
+    TS_ASSERT(map.find("d") == map.end());
+    TS_ASSERT(map["a"] == 1);
+    worker.pop();
+    TS_ASSERT(fork.size() == 2);
+    TS_ASSERT(fork["a"] == 10);
+  }
+
+};/* class ContextSnapshotBlack */
@@ -16,6 +16,9 @@
 
 #include <cxxtest/TestSuite.h>
 
+#include <sstream>
+#include <string>
+
 #include "context/context.h"
 #include "context/cdo.h"
 #include "util/cvc4_assert.h"
@@ -24,6 +27,43 @@ using namespace std;
 using namespace CVC4;
 using namespace CVC4::context;
 
+/**
+ * A context-dependent int that backtracks through save() and
+ * restore(), rather than the undo trail.
+ */
+class SavedInt : public ContextObj {
+  int d_value;
+
+  SavedInt(const SavedInt& other) :
+    ContextObj(other),
+    d_value(other.d_value) {
+  }
+
+  ContextObj* save(ContextMemoryManager* pCMM) {
+    return new(pCMM) SavedInt(*this);
+  }
+
+  void restore(ContextObj* pContextObj) {
+    d_value = static_cast<SavedInt*>(pContextObj)->d_value;
+  }
+
+public:
+  SavedInt(Context* context) :
+    ContextObj(context),
+    d_value(0) {
+  }
+
+  ~SavedInt() throw(AssertionException) { destroy(); }
+
+  SavedInt& operator=(int value) {
+    makeCurrent();
+    d_value = value;
+    return *this;
+  }
+
+  operator int() const { return d_value; }
+};/* class SavedInt */
+
 class ContextWhite : public CxxTest::TestSuite {
 private:
 
@@ -51,7 +91,7 @@ public:
     TS_ASSERT(s->d_level == 0);
     TS_ASSERT(s->d_pContextObjList == NULL);
 
-    CDO<int> a(d_context);
+    SavedInt a(d_context);
 
     TS_ASSERT(s->d_pContext == d_context);
     TS_ASSERT(s->d_pCMM == d_context->d_pCMM);
@@ -63,7 +103,7 @@ public:
     TS_ASSERT(a.d_pContextObjNext == NULL);
     TS_ASSERT(a.d_ppContextObjPrev == &s->d_pContextObjList);
 
-    CDO<int> b(d_context);
+    SavedInt b(d_context);
 
     TS_ASSERT(s->d_pContext == d_context);
     TS_ASSERT(s->d_pCMM == d_context->d_pCMM);
@@ -142,7 +182,7 @@ public:
     TS_ASSERT(u != t);
     TS_ASSERT(u != s);
 
-    CDO<int> c(d_context);
+    SavedInt c(d_context);
     c = 4;
 
     TS_ASSERT(c.d_pScope == u);
@@ -189,4 +229,120 @@ public:
     TS_ASSERT(c.d_pContextObjNext == &b);
     TS_ASSERT(c.d_ppContextObjPrev == &s->d_pContextObjList);
   }
+
+  void testTrail() {
+    Scope* s = d_context->getTopScope();
+    CDO<int> a(d_context);
+    CDO<string> b(d_context, "zero");
+
+    // changes at level 0 are never undone, so they aren't logged
+    TS_ASSERT(d_context->getTrailSize() == 0);
+
+    d_context->push();
+    Scope* t = d_context->getTopScope();
+    TS_ASSERT(t->d_trailMark == 0);
+    a = 1;
+    a = 2;
+    b = "one";
+    // the level and the old value of each
+    TS_ASSERT(d_context->getTrailSize() == 4);
+    // nothing is linked to the top scope
+    TS_ASSERT(t->d_pContextObjList == NULL);
+    TS_ASSERT(a.d_trailLevel == 1);
+
+    d_context->push();
+    TS_ASSERT(d_context->getTopScope()->d_trailMark == 4);
+    b = "two";
+    TS_ASSERT(d_context->getTrailSize() == 6);
+    d_context->pop();
+
+    TS_ASSERT(d_context->getTrailSize() == 4);
+    TS_ASSERT(a.get() == 2);
+    TS_ASSERT(b.get() == "one");
+    d_context->pop();
+
+    TS_ASSERT(d_context->getTrailSize() == 0);
+    TS_ASSERT(a.get() == 0);
+    TS_ASSERT(a.d_trailLevel == 0);
+    TS_ASSERT(b.get() == "zero");
+    TS_ASSERT(s->d_pContextObjList == &b);
+  }
+
+  void testUntrail() {
+    CDO<int> a(d_context, 1);
+    d_context->push();
+    a = 2;
+    {
+      CDO<string> b(d_context, "one");
+      a = 3;
+      b = "two";
+      TS_ASSERT(d_context->getTrailSize() == 4);
+    }
+    // b's entries are discarded with it
+    d_context->pop();
+    TS_ASSERT(a.get() == 1);
+    TS_ASSERT(d_context->getTrailSize() == 0);
+  }
+
+  void testUntrailAcrossScopes() {
+    CDO<int> a(d_context, 1);
+    CDO<string>* b = new(true) CDO<string>(d_context, "zero");
+    d_context->push();
+    *b = "one";
+    d_context->push();
+    a = 2;
+    d_context->push();
+    *b = "three";
+    TS_ASSERT(d_context->getTrailSize() == 6);
+    b->deleteSelf();
+    // b's entries, at levels 1 and 3, are found by following its
+    // logged levels; a's, at level 2, are left alone
+    for(size_t i = 0; i < 6; ++i) {
+      bool discarded = d_context->d_trail.d_entries[i].d_undo == &UndoTrail::undoNothing;
+      TS_ASSERT(discarded == (i != 2 && i != 3));
+    }
+    d_context->popto(0);
+    TS_ASSERT(a.get() == 1);
+    TS_ASSERT(d_context->getTrailSize() == 0);
+  }
+
+  void testProfile() {
+    TS_ASSERT(d_context->getProfiler() == NULL);
+    ContextProfiler* profiler = d_context->startProfiling();
+    TS_ASSERT(d_context->getProfiler() == profiler);
+
+    SavedInt a(d_context);
+    CDO<string> b(d_context, "zero");
+    d_context->push();
+    a = 1;
+    a = 2;
+    b = "one";
+    d_context->push();
+    b = "two";
+    d_context->pop();
+    d_context->pop();
+
+    ContextProfiler::Counts ca = profiler->getTotals(typeid(SavedInt));
+    TS_ASSERT(ca.d_saves == 1);
+    TS_ASSERT(ca.d_restores == 1);
+    TS_ASSERT(ca.d_trailEntries == 0);
+    TS_ASSERT(ca.d_bytes >= sizeof(SavedInt));
+
+    // one save, of two entries (the level and the value), per level
+    ContextProfiler::Counts cb = profiler->getTotals(typeid(CDO<string>));
+    TS_ASSERT(cb.d_saves == 2);
+    TS_ASSERT(cb.d_restores == 2);
+    TS_ASSERT(cb.d_trailEntries == 4);
+    TS_ASSERT(cb.d_bytes >= 2 * sizeof(string));
+
+    TS_ASSERT(profiler->getPops(1) == 1);
+    TS_ASSERT(profiler->getPops(2) == 1);
+
+    stringstream ss;
+    profiler->dumpFolded(ss, "test");
+    string folded = ss.str();
+    TS_ASSERT(folded.find("test;level 1;SavedInt;save 1\n") != string::npos);
+    TS_ASSERT(folded.find("test;level 2;CVC4::context::CDO<") != string::npos);
+    TS_ASSERT(folded.find(">;restore 1\n") != string::npos);
+  }
 };
@@ -59,6 +59,10 @@ typedef Attribute<Test5, bool> TestFlag5;
 typedef CDAttribute<Test1, bool> TestFlag1cd;
 typedef CDAttribute<Test2, bool> TestFlag2cd;
 
+typedef DenseAttribute<Test1, Node> TestDenseNode1;
+typedef DenseAttribute<Test2, Node> TestDenseNode2;
+typedef DenseAttribute<Test1, bool> TestDenseFlag;
+
 class AttributeWhite : public CxxTest::TestSuite {
 
   ExprManager* d_em;
@@ -145,8 +149,64 @@ public:
 //    TS_ASSERT_DIFFERS(theory::PostRewriteCache::s_id, theory::PostRewriteCacheTop::s_id);
 //    TS_ASSERT_DIFFERS(theory::PreRewriteCacheTop::s_id, theory::PostRewriteCacheTop::s_id);
 
-    lastId = attr::LastAttributeId<TypeNode, false>::getId();
+    lastId = attr::LastDenseAttributeId<TypeNode>::getId();
     TS_ASSERT_LESS_THAN(TypeAttr::s_id, lastId);
+
+    lastId = attr::LastDenseAttributeId<Node>::getId();
+    TS_ASSERT_LESS_THAN(TestDenseNode1::s_id, lastId);
+    TS_ASSERT_LESS_THAN(TestDenseNode2::s_id, lastId);
+    TS_ASSERT_DIFFERS(TestDenseNode1::s_id, TestDenseNode2::s_id);
+  }
+
+  void testDenseAttributes() {
+    Node a = d_nm->mkVar(*d_booleanType);
+    Node b = d_nm->mkVar(*d_booleanType);
+    Node c = d_nm->mkVar(*d_booleanType);
+
+    TS_ASSERT(! a.hasAttribute(TestDenseNode1()));
+    TS_ASSERT(a.getAttribute(TestDenseNode1()).isNull());
+    TS_ASSERT(! a.getAttribute(TestDenseFlag()));
+
+    a.setAttribute(TestDenseNode1(), b);
+    a.setAttribute(TestDenseNode2(), c);
+    b.setAttribute(TestDenseNode1(), Node::null());
+    c.setAttribute(TestDenseFlag(), true);
+
+    TS_ASSERT(a.hasAttribute(TestDenseNode1()));
+    TS_ASSERT_EQUALS(a.getAttribute(TestDenseNode1()), b);
+    TS_ASSERT_EQUALS(a.getAttribute(TestDenseNode2()), c);
+    // a null value is still a value
+    Node v = a;
+    TS_ASSERT(b.getAttribute(TestDenseNode1(), v));
+    TS_ASSERT(v.isNull());
+    TS_ASSERT(! c.hasAttribute(TestDenseNode1()));
+    TS_ASSERT(c.getAttribute(TestDenseFlag()));
+    TS_ASSERT(! b.getAttribute(TestDenseFlag()));
+
+    c.setAttribute(TestDenseFlag(), false);
+    TS_ASSERT(! c.getAttribute(TestDenseFlag()));
+
+    // dense attributes go away with their node
+    uint64_t id;
+    {
+      Node d = d_nm->mkNode(kind::AND, a, b);
+      id = d.getId();
+      d.setAttribute(TestDenseNode1(), a);
+      TS_ASSERT(d_nm->d_attrManager->d_denseNodes.find(TestDenseNode1::s_id, d.d_nv) != NULL);
+    }
+    d_nm->reclaimAllZombies();
+    NodeValue nv(0);
+    nv.d_id = id;
+    TS_ASSERT(d_nm->d_attrManager->d_denseNodes.find(TestDenseNode1::s_id, &nv) == NULL);
+
+    // and can be dropped wholesale
+    AttributeUniqueId aid = AttributeManager::getAttributeId(TestDenseNode2());
+    TS_ASSERT_EQUALS(aid.getTableId(), AttrTableDenseNode);
+    std::vector<const AttributeUniqueId*> ids;
+    ids.push_back(&aid);
+    d_nm->deleteAttributes(ids);
+    TS_ASSERT(! a.hasAttribute(TestDenseNode2()));
+    TS_ASSERT(a.hasAttribute(TestDenseNode1()));
   }
 
   void testCDAttributes() {
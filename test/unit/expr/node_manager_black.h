@@ -317,4 +317,35 @@ public:
 #endif
   }
 
+  void testCheckTypes() {
+    TypeNode intType = d_nodeManager->integerType();
+    Node x = d_nodeManager->mkSkolem("x", intType);
+    Node y = d_nodeManager->mkSkolem("y", intType);
+    Node sum = d_nodeManager->mkNode(PLUS, x, y);
+    // sum is shared by both roots, and under a deep chain in the second
+    Node t = sum;
+    for(unsigned i = 0; i < 100000; ++i) {
+      t = d_nodeManager->mkNode(UMINUS, t);
+    }
+    std::vector<Node> roots;
+    roots.push_back(d_nodeManager->mkNode(LEQ, sum, x));
+    roots.push_back(d_nodeManager->mkNode(GT, t, sum));
+
+    TS_ASSERT( !d_nodeManager->getAttribute(sum, TypeCheckedAttr()) );
+    d_nodeManager->checkTypes(roots);
+    TS_ASSERT( d_nodeManager->getAttribute(roots[0], TypeCheckedAttr()) );
+    TS_ASSERT( d_nodeManager->getAttribute(roots[1], TypeCheckedAttr()) );
+    TS_ASSERT( d_nodeManager->getAttribute(sum, TypeCheckedAttr()) );
+    TS_ASSERT( d_nodeManager->getAttribute(t[0], TypeCheckedAttr()) );
+    TS_ASSERT_EQUALS( roots[1].getType(), d_nodeManager->booleanType() );
+    TS_ASSERT_EQUALS( t.getType(), intType );
+
+    // an ill-typed root anywhere in the batch is reported (by mkNode()
+    // already, if type checking is early)
+    Node p = d_nodeManager->mkSkolem("p", d_nodeManager->booleanType());
+    TS_ASSERT_THROWS( roots.push_back(d_nodeManager->mkNode(AND, p, d_nodeManager->mkNode(PLUS, x, p)));
+                      d_nodeManager->checkTypes(roots),
+                      TypeCheckingExceptionPrivate );
+  }
+
 };
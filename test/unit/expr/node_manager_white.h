@@ -17,6 +17,7 @@
 #include <cxxtest/TestSuite.h>
 
 #include <string>
+#include <vector>
 
 #include "expr/node_manager.h"
 
@@ -50,6 +51,162 @@ public:
     TS_ASSERT_EQUALS(n.getId(), m.getId());
   }
 
+  void testConcurrentPool() {
+    Node a = d_nm->mkSkolem("a", d_nm->booleanType());
+    Node b = d_nm->mkSkolem("b", d_nm->booleanType());
+    Node ab = d_nm->mkNode(kind::AND, a, b);
+    size_t before = d_nm->poolSize();
+
+    d_nm->setConcurrent(true);
+    Node ab2 = d_nm->mkNode(kind::AND, a, b);
+    Node ba = d_nm->mkNode(kind::AND, b, a);
+    TS_ASSERT_EQUALS(ab.getId(), ab2.getId());
+    TS_ASSERT_DIFFERS(ab.getId(), ba.getId());
+    TS_ASSERT_EQUALS(d_nm->poolSize(), before + 1);
+    // lookups and inserts don't leave their pins behind
+    TS_ASSERT_EQUALS(ab.d_nv->getRefCount(), 2u);
+    TS_ASSERT_EQUALS(ba.d_nv->getRefCount(), 1u);
+    d_nm->setConcurrent(false);
+  }
+
+  void testConcurrentLostInsert() {
+    Node a = d_nm->mkSkolem("a", d_nm->booleanType());
+    Node b = d_nm->mkSkolem("b", d_nm->booleanType());
+    Node ab = d_nm->mkNode(kind::AND, a, b);
+    d_nm->setConcurrent(true);
+    size_t pooled = d_nm->poolSize();
+    uint64_t live = d_nm->d_nvAllocator.d_classes[2].d_live;
+    unsigned rcA = a.d_nv->getRefCount();
+
+    // build AND(a, b) again, as a thread that lost the race to the
+    // pool would have, and insert it
+    NodeValue* nv = d_nm->d_nvAllocator.allocate(2);
+    nv->d_nchildren = 2;
+    nv->d_kind = NodeValue::kindToDKind(kind::AND);
+    nv->d_id = d_nm->newNodeId();
+    nv->d_rc = d_nm->initialRefCount();
+    nv->d_children[0] = a.d_nv;
+    nv->d_children[1] = b.d_nv;
+    a.d_nv->inc();
+    b.d_nv->inc();
+    TS_ASSERT_EQUALS(a.d_nv->getRefCount(), rcA + 1);
+
+    // ours is freed (and lets go of its children); the pooled one
+    // comes back pinned
+    NodeValue* winner = d_nm->poolInsert(nv);
+    TS_ASSERT_EQUALS(winner, ab.d_nv);
+    TS_ASSERT_EQUALS(ab.d_nv->getRefCount(), 2u);
+    d_nm->unpin(winner);
+    TS_ASSERT_EQUALS(ab.d_nv->getRefCount(), 1u);
+    TS_ASSERT_EQUALS(a.d_nv->getRefCount(), rcA);
+    TS_ASSERT_EQUALS(d_nm->poolSize(), pooled);
+    TS_ASSERT_EQUALS(d_nm->d_nvAllocator.d_classes[2].d_live, live);
+    d_nm->setConcurrent(false);
+  }
+
+  void testConcurrentReclaim() {
+    Node a = d_nm->mkSkolem("a", d_nm->booleanType());
+    d_nm->setConcurrent(true);
+    d_nm->reclaimAllZombies();
+    size_t pooled = d_nm->poolSize();
+    {
+      Node na = d_nm->mkNode(kind::NOT, a);
+    }
+    TS_ASSERT(d_nm->zombieCount() > 0);
+    // revived by a lookup before the reclamation: not freed
+    Node na = d_nm->mkNode(kind::NOT, a);
+    d_nm->reclaimAllZombies();
+    TS_ASSERT_EQUALS(d_nm->poolSize(), pooled + 1);
+    TS_ASSERT_EQUALS(d_nm->mkNode(kind::NOT, a), na);
+    na = Node::null();
+    d_nm->reclaimAllZombies();
+    TS_ASSERT_EQUALS(d_nm->poolSize(), pooled);
+    TS_ASSERT_EQUALS(d_nm->zombieCount(), 0u);
+    d_nm->setConcurrent(false);
+  }
+
+  void testConcurrentTypeCheck() {
+    Node a = d_nm->mkSkolem("a", d_nm->booleanType());
+    Node b = d_nm->mkSkolem("b", d_nm->booleanType());
+    Node n = d_nm->mkNode(kind::AND, a, d_nm->mkNode(kind::NOT, b));
+    size_t tables = d_nm->d_markTables.size();
+    d_nm->setConcurrent(true);
+    TS_ASSERT_EQUALS(n.getType(true), d_nm->booleanType());
+    // the shared mark tables are left alone
+    TS_ASSERT_EQUALS(d_nm->d_markTables.size(), tables);
+    TS_ASSERT_EQUALS(d_nm->d_markTablesInUse, 0u);
+    d_nm->setConcurrent(false);
+  }
+
+  void testPoolGrowsIncrementally() {
+    Node a = d_nm->mkSkolem("a", d_nm->booleanType());
+    std::vector<Node> nodes;
+    Node n = a;
+    // enough nodes that every shard grows (and migrates) a few times
+    for(unsigned i = 0; i < 20000; ++i) {
+      n = d_nm->mkNode(kind::NOT, n);
+      nodes.push_back(n);
+    }
+    n = a;
+    for(unsigned i = 0; i < 20000; ++i) {
+      n = d_nm->mkNode(kind::NOT, n);
+      TS_ASSERT_EQUALS(n.getId(), nodes[i].getId());
+    }
+    size_t before = d_nm->poolSize();
+    // drop every other node, so removals hit both old and new tables
+    for(unsigned i = 0; i < nodes.size(); i += 2) {
+      d_nm->d_nodeValuePool.remove(nodes[i].d_nv);
+    }
+    TS_ASSERT_EQUALS(d_nm->poolSize(), before - 10000);
+    for(unsigned i = 1; i < nodes.size(); i += 2) {
+      TS_ASSERT_EQUALS(d_nm->d_nodeValuePool.lookup(nodes[i].d_nv), nodes[i].d_nv);
+    }
+    // put them back so the NodeManager can tear down cleanly
+    for(unsigned i = 0; i < nodes.size(); i += 2) {
+      d_nm->d_nodeValuePool.insert(nodes[i].d_nv);
+    }
+    TS_ASSERT_EQUALS(d_nm->poolSize(), before);
+  }
+
+  void testNodeValueAllocatorRecycles() {
+    Node a = d_nm->mkSkolem("a", d_nm->booleanType());
+    Node b = d_nm->mkSkolem("b", d_nm->booleanType());
+    NodeValueAllocator& alloc = d_nm->d_nvAllocator;
+    uint64_t live = alloc.d_classes[2].d_live;
+    {
+      Node ab = d_nm->mkNode(kind::AND, a, b);
+      TS_ASSERT_EQUALS(alloc.d_classes[2].d_live, live + 1);
+    }
+    d_nm->reclaimAllZombies();
+    TS_ASSERT_EQUALS(alloc.d_classes[2].d_live, live);
+    uint64_t capacity = alloc.d_classes[2].d_capacity;
+    Node ba = d_nm->mkNode(kind::AND, b, a);
+    // the freed block is reused rather than carving a new one
+    TS_ASSERT_EQUALS(alloc.d_classes[2].d_capacity, capacity);
+  }
+
+  void testZombieReclaimBudget() {
+    Node a = d_nm->mkSkolem("a", d_nm->booleanType());
+    d_nm->reclaimAllZombies();
+    {
+      ZombieReclamationDeferral defer(d_nm);
+      Node n = a;
+      for(unsigned i = 0; i < 100; ++i) {
+        n = d_nm->mkNode(kind::NOT, n);
+      }
+    }
+    // only the head of the chain is a zombie; each bounded pass frees
+    // it and zombifies its child
+    TS_ASSERT_EQUALS(d_nm->d_zombies.size(), 1u);
+    size_t before = d_nm->poolSize();
+    d_nm->reclaimZombies(1);
+    TS_ASSERT_EQUALS(d_nm->poolSize(), before - 1);
+    TS_ASSERT_EQUALS(d_nm->d_zombies.size(), 1u);
+    d_nm->reclaimAllZombies();
+    TS_ASSERT_EQUALS(d_nm->poolSize(), before - 100);
+    TS_ASSERT(d_nm->d_zombies.empty());
+  }
+
   void testOversizedNodeBuilder() {
     NodeBuilder<> nb;
 
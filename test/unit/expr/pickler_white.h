@@ -0,0 +1,118 @@
+/*********************                                                        */
+/*! \file pickler_white.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief White box testing of CVC4::expr::pickle::Pickler.
+ **
+ ** White box testing of CVC4::expr::pickle::Pickler.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include "expr/expr_manager.h"
+#include "expr/expr_manager_scope.h"
+#include "expr/pickler.h"
+#include "expr/pickle_data.h"
+#include "expr/variable_type_map.h"
+#include "util/bitvector.h"
+#include "util/rational.h"
+
+using namespace CVC4;
+using namespace CVC4::expr::pickle;
+using namespace std;
+
+class PicklerWhite : public CxxTest::TestSuite {
+  ExprManager* d_em;
+
+public:
+
+  void setUp() {
+    d_em = new ExprManager;
+  }
+
+  void tearDown() {
+    delete d_em;
+  }
+
+  void testRoundTrip() {
+    Expr x = d_em->mkVar("x", d_em->integerType());
+    Expr b = d_em->mkVar("b", d_em->mkBitVectorType(8));
+    Expr e = d_em->mkExpr(kind::AND,
+               d_em->mkExpr(kind::LEQ, x, d_em->mkConst(Rational(-12345, 7))),
+               d_em->mkExpr(kind::EQUAL,
+                 d_em->mkExpr(d_em->mkConst(BitVectorExtract(7, 4)), b),
+                 d_em->mkConst(BitVector(4, 9u))),
+               d_em->mkConst(true));
+
+    Pickler pickler(d_em);
+    Pickle p;
+    pickler.toPickle(e, p);
+    TS_ASSERT_EQUALS( p.d_data->begin()[0], PICKLE_VERSION );
+    TS_ASSERT_EQUALS( pickler.fromPickle(p), e );
+    TS_ASSERT( p.d_data->empty() );
+  }
+
+  void testSharing() {
+    // a term whose tree is 2^40 nodes, but whose DAG is 41
+    Expr t = d_em->mkVar("x", d_em->integerType());
+    for(unsigned i = 0; i < 40; ++i) {
+      t = d_em->mkExpr(kind::PLUS, t, t);
+    }
+
+    Pickler pickler(d_em);
+    Pickle p;
+    pickler.toPickle(t, p);
+    // header and child count for each PLUS, and a back-reference for
+    // its second child, one to two bytes each
+    TS_ASSERT_LESS_THAN( p.d_data->size(), 41u * 6 + 16 );
+    Pickle copy(p);
+    TS_ASSERT_EQUALS( pickler.fromPickle(copy), t );
+  }
+
+  void testDeep() {
+    Expr t = d_em->mkVar("p", d_em->booleanType());
+    for(unsigned i = 0; i < 100000; ++i) {
+      t = d_em->mkExpr(kind::NOT, t);
+    }
+
+    Pickler pickler(d_em);
+    Pickle p;
+    pickler.toPickle(t, p);
+    TS_ASSERT_EQUALS( pickler.fromPickle(p), t );
+  }
+
+  void testMapped() {
+    ExprManager em2;
+    Expr x = d_em->mkVar("x", d_em->integerType());
+    Expr y = d_em->mkVar("y", d_em->integerType());
+    Expr e = d_em->mkExpr(kind::DISTINCT, x, y);
+
+    ExprManagerMapCollection vmap;
+    Expr e2 = e.exportTo(&em2, vmap);
+
+    // pickles carry the first ExprManager's variables, as in the
+    // portfolio's lemma channels
+    MapPickler secondPickler(&em2, vmap.d_from, vmap.d_to);
+    Pickle p;
+    secondPickler.toPickle(e2, p);
+    Pickler firstPickler(d_em);
+    TS_ASSERT_EQUALS( firstPickler.fromPickle(p), e );
+
+    firstPickler.toPickle(e, p);
+    TS_ASSERT_EQUALS( secondPickler.fromPickle(p), e2 );
+
+    // an unmapped variable can't be pickled
+    Expr z = em2.mkVar("z", em2.integerType());
+    TS_ASSERT_THROWS( secondPickler.toPickle(em2.mkExpr(kind::PLUS, e2[0], z), p),
+                      PicklingException );
+    TS_ASSERT( p.d_data->empty() );
+  }
+
+};/* class PicklerWhite */
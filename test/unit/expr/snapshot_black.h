@@ -0,0 +1,230 @@
+/*********************                                                        */
+/*! \file snapshot_black.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Black box testing of CVC4::expr::pickle::Snapshot.
+ **
+ ** Black box testing of CVC4::expr::pickle::Snapshot.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "expr/command.h"
+#include "expr/expr_manager.h"
+#include "expr/snapshot.h"
+#include "smt/smt_engine.h"
+#include "util/bitvector.h"
+#include "util/rational.h"
+
+using namespace CVC4;
+using namespace CVC4::expr::pickle;
+using namespace std;
+
+class SnapshotBlack : public CxxTest::TestSuite {
+  ExprManager* d_from;
+  ExprManager* d_to;
+  char* d_filename;
+
+  /** Snapshot commands in d_from and load the result into d_to. */
+  CommandSequence* roundTrip(const CommandSequence& commands,
+                             Snapshot*& snapshot) {
+    ofstream out(d_filename, ios::binary);
+    Snapshot::write(out, d_from, commands, language::input::LANG_SMTLIB_V2);
+    out.close();
+    snapshot = new Snapshot(d_filename);
+    TS_ASSERT_EQUALS( snapshot->getInputLanguage(),
+                      language::input::LANG_SMTLIB_V2 );
+    return snapshot->load(d_to);
+  }
+
+  static string print(const CommandSequence& commands) {
+    stringstream ss;
+    for(CommandSequence::const_iterator i = commands.begin();
+        i != commands.end();
+        ++i) {
+      ss << *i << endl;
+    }
+    return ss.str();
+  }
+
+public:
+
+  void setUp() {
+    d_from = new ExprManager;
+    d_to = new ExprManager;
+    d_filename = strdup("/tmp/snapshot.XXXXXX");
+    int fd = mkstemp(d_filename);
+    TS_ASSERT( fd != -1 );
+    close(fd);
+  }
+
+  void tearDown() {
+    remove(d_filename);
+    free(d_filename);
+    delete d_to;
+    delete d_from;
+  }
+
+  void testRoundTrip() {
+    Type u = d_from->mkSort("U");
+    Type bv8 = d_from->mkBitVectorType(8);
+    Expr x = d_from->mkVar("x", d_from->integerType());
+    Expr b = d_from->mkVar("b", bv8);
+    Expr f = d_from->mkVar("f", d_from->mkFunctionType(u, u));
+    Expr a = d_from->mkVar("a", u);
+    Expr y = d_from->mkBoundVar("y", d_from->integerType());
+    Expr g = d_from->mkVar("g", d_from->mkFunctionType(d_from->integerType(),
+                                                       d_from->integerType()));
+    Expr gDef = d_from->mkExpr(kind::PLUS, y, d_from->mkConst(Rational(-7, 3)));
+    // shared subterm (f a) occurs twice
+    Expr fa = d_from->mkExpr(kind::APPLY_UF, f, a);
+    Expr lo = d_from->mkConst(BitVector(8, 5u));
+    Expr extract = d_from->mkConst(BitVectorExtract(3, 0));
+
+    CommandSequence commands;
+    commands.addCommand(new SetBenchmarkLogicCommand("ALL_SUPPORTED"));
+    commands.addCommand(new SetInfoCommand("status", SExpr("sat")));
+    commands.addCommand(new DeclareTypeCommand("U", 0, u));
+    commands.addCommand(new DeclareFunctionCommand("x", x, x.getType()));
+    commands.addCommand(new DeclareFunctionCommand("b", b, b.getType()));
+    commands.addCommand(new DeclareFunctionCommand("f", f, f.getType()));
+    commands.addCommand(new DeclareFunctionCommand("a", a, a.getType()));
+    commands.addCommand(new DefineFunctionCommand("g", g, vector<Expr>(1, y), gDef));
+    commands.addCommand(new AssertCommand(d_from->mkExpr(kind::EQUAL, d_from->mkExpr(kind::APPLY_UF, f, fa), fa)));
+    commands.addCommand(new AssertCommand(d_from->mkExpr(kind::BITVECTOR_ULT, lo, b)));
+    commands.addCommand(new AssertCommand(d_from->mkExpr(kind::EQUAL, d_from->mkExpr(extract, b), d_from->mkConst(BitVector(4, 2u)))));
+    commands.addCommand(new AssertCommand(d_from->mkExpr(kind::GT, d_from->mkExpr(kind::APPLY_UF, g, x), x), false));
+    commands.addCommand(new CheckSatCommand());
+
+    Snapshot* snapshot = NULL;
+    CommandSequence* loaded = roundTrip(commands, snapshot);
+
+    TS_ASSERT_EQUALS( print(*loaded), print(commands) );
+
+    // the loaded terms are typed, and shared
+    AssertCommand* assertion = dynamic_cast<AssertCommand*>(*(loaded->begin() + 8));
+    TS_ASSERT( assertion != NULL );
+    Expr e = assertion->getExpr();
+    TS_ASSERT_EQUALS( e.getExprManager(), d_to );
+    TS_ASSERT_EQUALS( e.getType(), d_to->booleanType() );
+    TS_ASSERT_EQUALS( e[0][0], e[1] );
+    TS_ASSERT( !dynamic_cast<AssertCommand*>(*(loaded->begin() + 11))->inUnsatCore() );
+
+    // the declarations name what the commands use
+    DeclareFunctionCommand* decl = dynamic_cast<DeclareFunctionCommand*>(*(loaded->begin() + 6));
+    TS_ASSERT( decl != NULL );
+    TS_ASSERT_EQUALS( decl->getSymbol(), "a" );
+    TS_ASSERT_EQUALS( decl->getFunction(), e[1][0] );
+    DeclareTypeCommand* sort = dynamic_cast<DeclareTypeCommand*>(*(loaded->begin() + 2));
+    TS_ASSERT( sort != NULL );
+    TS_ASSERT_EQUALS( sort->getType(), decl->getFunction().getType() );
+
+    delete loaded;
+    delete snapshot;
+  }
+
+  void testDeclarationsFollowScopes() {
+    Expr p = d_from->mkVar("p", d_from->booleanType());
+    Expr q = d_from->mkVar("q", d_from->booleanType());
+    CommandSequence commands;
+    commands.addCommand(new PushCommand());
+    commands.addCommand(new DeclareFunctionCommand("q", q, q.getType()));
+    commands.addCommand(new AssertCommand(q));
+    commands.addCommand(new PopCommand());
+    commands.addCommand(new DeclareFunctionCommand("p", p, p.getType()));
+    commands.addCommand(new AssertCommand(p));
+    commands.addCommand(new CheckSatCommand());
+    commands.addCommand(new GetModelCommand());
+    ofstream file(d_filename, ios::binary);
+    Snapshot::write(file, d_from, commands, language::input::LANG_SMTLIB_V2);
+    file.close();
+
+    // replayed a command at a time, q is declared inside the push,
+    // so it is gone from the model once popped
+    SmtEngine smt(d_to);
+    smt.setOption("incremental", true);
+    smt.setOption("produce-models", true);
+    smt.setOption("output-language", SExpr("smt2"));
+    Snapshot snapshot(d_filename);
+    snapshot.start(d_to);
+    stringstream out;
+    Command* c;
+    while((c = snapshot.nextCommand()) != NULL) {
+      c->invoke(&smt, out);
+      TS_ASSERT( c->ok() );
+      delete c;
+    }
+    TS_ASSERT( out.str().find("(define-fun p ") != string::npos );
+    TS_ASSERT( out.str().find("(define-fun q ") == string::npos );
+  }
+
+  void testRejectsGarbage() {
+    ofstream out(d_filename, ios::binary);
+    out << "(assert true)" << endl;
+    out.close();
+    TS_ASSERT_THROWS( Snapshot s(d_filename), PicklingException );
+  }
+
+  void testRejectsTruncated() {
+    CommandSequence commands;
+    Expr p = d_from->mkVar("p", d_from->booleanType());
+    commands.addCommand(new DeclareFunctionCommand("p", p, p.getType()));
+    commands.addCommand(new AssertCommand(p));
+    stringstream ss;
+    Snapshot::write(ss, d_from, commands, language::input::LANG_SMTLIB_V2);
+    string s = ss.str();
+    ofstream out(d_filename, ios::binary);
+    out << s.substr(0, s.size() - 8);
+    out.close();
+    TS_ASSERT_THROWS( Snapshot s(d_filename), PicklingException );
+  }
+
+  void testRejectsCorrupt() {
+    CommandSequence commands;
+    Expr x = d_from->mkVar("x", d_from->mkBitVectorType(8));
+    Expr f = d_from->mkVar("f", d_from->mkFunctionType(x.getType(), x.getType()));
+    commands.addCommand(new DeclareFunctionCommand("x", x, x.getType()));
+    commands.addCommand(new DeclareFunctionCommand("f", f, f.getType()));
+    commands.addCommand(new AssertCommand(d_from->mkExpr(kind::DISTINCT, d_from->mkExpr(kind::APPLY_UF, f, x), d_from->mkConst(BitVector(8, 5u)))));
+    commands.addCommand(new CheckSatCommand());
+    stringstream ss;
+    Snapshot::write(ss, d_from, commands, language::input::LANG_SMTLIB_V2);
+    const string s = ss.str();
+
+    // the header ends with the node, command, and end offsets; the
+    // loader must refuse an out-of-range word anywhere after the
+    // string table, rather than crash
+    const uint32_t* header = reinterpret_cast<const uint32_t*>(s.data());
+    size_t headerWords = 8 / sizeof(uint32_t) + 12;
+    uint32_t nodes = header[headerWords - 3];
+    uint32_t end = header[headerWords - 1];
+    TS_ASSERT_EQUALS( end * sizeof(uint32_t), s.size() );
+    for(uint32_t i = nodes; i < end; ++i) {
+      string corrupt = s;
+      reinterpret_cast<uint32_t*>(&corrupt[0])[i] = 0xfffffffe;
+      ofstream out(d_filename, ios::binary);
+      out << corrupt;
+      out.close();
+      Snapshot snapshot(d_filename);
+      try {
+        delete snapshot.load(d_to);
+      } catch(PicklingException&) {
+      }
+    }
+  }
+
+};/* class SnapshotBlack */
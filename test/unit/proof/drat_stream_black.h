@@ -0,0 +1,222 @@
+/*********************                                                        */
+/*! \file drat_stream_black.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Black box testing of CVC4::DratStream.
+ **
+ ** Black box testing of CVC4::DratStream, and of the stream of a
+ ** search through the SmtEngine.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "expr/expr_manager.h"
+#include "options/options.h"
+#include "proof/drat_stream.h"
+#include "proof/options.h"
+#include "smt/smt_engine.h"
+#include "util/result.h"
+
+using namespace CVC4;
+using namespace CVC4::kind;
+using namespace std;
+
+class DratStreamBlack : public CxxTest::TestSuite {
+
+  stringstream d_out;
+  DratStream* d_drat;
+
+  /** The clauses a checker has, each with its literals sorted */
+  vector< vector<unsigned> > d_live;
+
+  /** Is the clause implied by unit propagation over d_live? */
+  bool rup(const vector<unsigned>& clause) {
+    // literals are 2 * (var + 1) + sign, so p ^ 1 is the negation of p
+    vector<bool> assigned;
+    for(size_t i = 0; i < clause.size(); ++i) {
+      assign(assigned, clause[i] ^ 1);
+    }
+    for(bool changed = true; changed;) {
+      changed = false;
+      for(size_t i = 0; i < d_live.size(); ++i) {
+        unsigned open = 0, unit = 0;
+        bool sat = false;
+        for(size_t j = 0; j < d_live[i].size() && !sat; ++j) {
+          unsigned p = d_live[i][j];
+          if(isTrue(assigned, p)) {
+            sat = true;
+          } else if(!isTrue(assigned, p ^ 1)) {
+            ++open;
+            unit = p;
+          }
+        }
+        if(!sat && open == 0) {
+          return true;
+        } else if(!sat && open == 1) {
+          assign(assigned, unit);
+          changed = true;
+        }
+      }
+    }
+    return false;
+  }
+
+  static bool isTrue(const vector<bool>& assigned, unsigned p) {
+    return p < assigned.size() && assigned[p];
+  }
+
+  static void assign(vector<bool>& assigned, unsigned p) {
+    if(assigned.size() <= p) {
+      assigned.resize(p + 1, false);
+    }
+    assigned[p] = true;
+  }
+
+  /**
+   * Decodes the records of d_out from pos on, checking each addition
+   * by unit propagation and each deletion against d_live, and returns
+   * the number of empty clauses added.
+   */
+  unsigned check(size_t& pos) {
+    const string s = d_out.str();
+    unsigned empties = 0;
+    while(pos < s.size()) {
+      char kind = s[pos++];
+      vector<unsigned> clause;
+      for(;;) {
+        unsigned lit = 0;
+        unsigned shift = 0;
+        unsigned char byte;
+        do {
+          TS_ASSERT( pos < s.size() );
+          byte = s[pos++];
+          lit |= unsigned(byte & 0x7f) << shift;
+          shift += 7;
+        } while(byte & 0x80);
+        if(lit == 0) {
+          break;
+        }
+        clause.push_back(lit);
+      }
+      sort(clause.begin(), clause.end());
+      switch(kind) {
+      case DratStream::ADD:
+        TS_ASSERT( rup(clause) );
+        empties += clause.empty();
+        d_live.push_back(clause);
+        break;
+      case DratStream::INPUT:
+      case DratStream::THEORY_LEMMA:
+        d_live.push_back(clause);
+        break;
+      case DratStream::DELETE: {
+        vector< vector<unsigned> >::iterator i = find(d_live.begin(), d_live.end(), clause);
+        TS_ASSERT( i != d_live.end() );
+        if(i != d_live.end()) {
+          d_live.erase(i);
+        }
+        break;
+      }
+      default:
+        TS_FAIL( "unknown DRAT record" );
+        return empties;
+      }
+    }
+    return empties;
+  }
+
+  bool emptyIsLive() {
+    return find(d_live.begin(), d_live.end(), vector<unsigned>()) != d_live.end();
+  }
+
+public:
+
+  void setUp() {
+    d_out.str("");
+    d_live.clear();
+    d_drat = new DratStream(&d_out);
+  }
+
+  void tearDown() {
+    delete d_drat;
+  }
+
+  void testRecords() {
+    ::Minisat::vec< ::Minisat::Lit> lits;
+    lits.push(::Minisat::mkLit(0, false));
+    lits.push(::Minisat::mkLit(1, true));
+    d_drat->write(DratStream::ADD, lits);
+    d_drat->write(DratStream::DELETE, ::Minisat::mkLit(2, false));
+    d_drat->writeEmpty(DratStream::ADD);
+    d_drat->flush();
+
+    // 2 * (var + 1) + sign
+    const char expected[] = { 'a', 2, 5, 0, 'd', 6, 0, 'a', 0 };
+    TS_ASSERT_EQUALS( d_out.str(), string(expected, sizeof(expected)) );
+    TS_ASSERT_EQUALS( d_drat->getRecords(), 3u );
+  }
+
+  void testVarint() {
+    // 2 * (100 + 1) + 1 = 203 = 0x4b | 0x80, then 1
+    d_drat->write(DratStream::THEORY_LEMMA, ::Minisat::mkLit(100, true));
+    // 2 * (8191 + 1) = 16384 = three bytes
+    d_drat->write(DratStream::INPUT, ::Minisat::mkLit(8191, false));
+
+    const char expected[] = { 't', char(0xcb), 1, 0,
+                              'i', char(0x80), char(0x80), 1, 0 };
+    TS_ASSERT_EQUALS( d_out.str(), string(expected, sizeof(expected)) );
+  }
+
+  void testSolve() {
+    Options opts;
+    opts.set(options::dratFile, &d_out);
+    ExprManager em(opts);
+    SmtEngine smt(&em);
+    size_t pos = 0;
+
+    // a, b and c can't all differ from each other
+    Expr a = em.mkVar("a", em.booleanType());
+    Expr b = em.mkVar("b", em.booleanType());
+    Expr c = em.mkVar("c", em.booleanType());
+    smt.assertFormula(em.mkExpr(OR, a, b));
+    smt.assertFormula(em.mkExpr(OR, a, c));
+    smt.assertFormula(em.mkExpr(OR, b, c));
+    smt.push();
+    smt.assertFormula(em.mkExpr(OR, a.notExpr(), b.notExpr()));
+    smt.assertFormula(em.mkExpr(OR, a.notExpr(), c.notExpr()));
+    smt.assertFormula(em.mkExpr(OR, b.notExpr(), c.notExpr()));
+    TS_ASSERT_EQUALS( smt.checkSat().isSat(), Result::UNSAT );
+    TS_ASSERT_EQUALS( check(pos), 1u );
+    TS_ASSERT( emptyIsLive() );
+
+    // the pop lifts the unsat answer, with the clauses of its level
+    smt.pop();
+    TS_ASSERT_EQUALS( smt.checkSat().isSat(), Result::SAT );
+    TS_ASSERT_EQUALS( check(pos), 0u );
+    TS_ASSERT( !emptyIsLive() );
+
+    smt.push();
+    smt.assertFormula(a.notExpr());
+    smt.assertFormula(b.notExpr());
+    TS_ASSERT_EQUALS( smt.checkSat().isSat(), Result::UNSAT );
+    TS_ASSERT_EQUALS( check(pos), 1u );
+    TS_ASSERT( emptyIsLive() );
+    smt.pop();
+    TS_ASSERT_EQUALS( smt.checkSat().isSat(), Result::SAT );
+    check(pos);
+    TS_ASSERT( !emptyIsLive() );
+  }
+
+};/* class DratStreamBlack */
@@ -48,11 +48,13 @@ using namespace std;
 class FakeSatSolver : public SatSolver {
   SatVariable d_nextVar;
   bool d_addClauseCalled;
+  unsigned d_numClauses;
 
 public:
   FakeSatSolver() :
     d_nextVar(0),
-    d_addClauseCalled(false) {
+    d_addClauseCalled(false),
+    d_numClauses(0) {
   }
 
   SatVariable newVar(bool theoryAtom, bool preRegister, bool canErase) {
@@ -69,6 +71,7 @@ public:
 
   void addClause(SatClause& c, bool lemma, uint64_t) {
     d_addClauseCalled = true;
+    ++d_numClauses;
   }
 
   void reset() {
@@ -79,6 +82,10 @@ public:
     return d_addClauseCalled;
   }
 
+  unsigned numClauses() const {
+    return d_numClauses;
+  }
+
   unsigned getAssertionLevel() const {
     return 0;
   }
@@ -294,4 +301,40 @@ public:
     TS_ASSERT( d_satSolver->addClauseCalled() );
     TS_ASSERT( d_cnfStream->hasLiteral(a_and_b) );
   }
+
+  void testPolarity() {
+    NodeManagerScope nms(d_nodeManager);
+    d_smt->setOption("cnf-polarity", SExpr(true));
+    Context context;
+    TseitinCnfStream tseitin(d_satSolver, new theory::TheoryRegistrar(d_theoryEngine), &context);
+    CnfStream& cnfStream = tseitin;
+    Node a = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node b = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node c = d_nodeManager->mkVar(d_nodeManager->booleanType());
+    Node a_and_b = d_nodeManager->mkNode(kind::AND, a, b);
+
+    // a_and_b occurs positively: (a_and_b | c), and a_and_b implies a and b
+    cnfStream.convertAndAssert( d_nodeManager->mkNode(kind::OR, a_and_b, c), false, false, RULE_INVALID, Node::null() );
+    TS_ASSERT_EQUALS( d_satSolver->numClauses(), 3u );
+
+    // a_and_b occurs positively again: just (a_and_b | ~c)
+    cnfStream.convertAndAssert( d_nodeManager->mkNode(kind::OR, a_and_b, c.notNode()), false, false, RULE_INVALID, Node::null() );
+    TS_ASSERT_EQUALS( d_satSolver->numClauses(), 4u );
+
+    // and now negatively: (~a_and_b | c), and a and b imply a_and_b
+    cnfStream.convertAndAssert( d_nodeManager->mkNode(kind::OR, a_and_b.notNode(), c), false, false, RULE_INVALID, Node::null() );
+    TS_ASSERT_EQUALS( d_satSolver->numClauses(), 6u );
+
+    // it's fully defined now
+    cnfStream.ensureLiteral(a_and_b);
+    TS_ASSERT_EQUALS( d_satSolver->numClauses(), 6u );
+
+    // a literal that's ensured gets both halves, even if it had one
+    Node a_or_b = d_nodeManager->mkNode(kind::OR, a, b);
+    cnfStream.convertAndAssert( d_nodeManager->mkNode(kind::OR, a_or_b.notNode(), c), false, false, RULE_INVALID, Node::null() );
+    TS_ASSERT_EQUALS( d_satSolver->numClauses(), 9u );
+    cnfStream.ensureLiteral(a_or_b);
+    TS_ASSERT_EQUALS( d_satSolver->numClauses(), 10u );
+    TS_ASSERT( cnfStream.hasLiteral(a_or_b) );
+  }
 };
@@ -0,0 +1,179 @@
+/*********************                                                        */
+/*! \file node_visitor_black.h
+ ** \verbatim
+ ** Original author: Morgan Deters
+ ** Major contributors: none
+ ** Minor contributors (to current version): none
+ ** This file is part of the CVC4 project.
+ ** Copyright (c) 2009-2014  New York University and The University of Iowa
+ ** See the file COPYING in the top-level source directory for licensing
+ ** information.\endverbatim
+ **
+ ** \brief Black box testing of the DAG iterators in util/node_visitor.h
+ **
+ ** Black box testing of NodeMarks, PreorderNodeIterator and
+ ** PostorderNodeIterator.
+ **/
+
+#include <cxxtest/TestSuite.h>
+
+#include <vector>
+
+#include "expr/node.h"
+#include "expr/node_manager.h"
+#include "util/node_visitor.h"
+
+using namespace CVC4;
+using namespace CVC4::kind;
+using namespace std;
+
+class NodeVisitorBlack : public CxxTest::TestSuite {
+
+  NodeManager* d_nm;
+  NodeManagerScope* d_scope;
+
+  Node a, b, c;
+
+public:
+
+  void setUp() {
+    d_nm = new NodeManager(NULL);
+    d_scope = new NodeManagerScope(d_nm);
+    a = d_nm->mkSkolem("a", d_nm->booleanType());
+    b = d_nm->mkSkolem("b", d_nm->booleanType());
+    c = d_nm->mkSkolem("c", d_nm->booleanType());
+  }
+
+  void tearDown() {
+    a = b = c = Node::null();
+    delete d_scope;
+    delete d_nm;
+  }
+
+  void testMarks() {
+    NodeMarks marks;
+    TS_ASSERT( !marks.isMarked(a) );
+    TS_ASSERT( marks.mark(a) );
+    TS_ASSERT( marks.isMarked(a) );
+    TS_ASSERT( !marks.mark(a) );
+    TS_ASSERT( !marks.isMarked(b) );
+    {
+      // nested marks are independent of the outer ones
+      NodeMarks inner;
+      TS_ASSERT( !inner.isMarked(a) );
+      TS_ASSERT( inner.mark(b) );
+    }
+    TS_ASSERT( marks.isMarked(a) );
+    TS_ASSERT( !marks.isMarked(b) );
+    marks.clear();
+    TS_ASSERT( !marks.isMarked(a) );
+  }
+
+  void testFreshMarks() {
+    {
+      NodeMarks marks;
+      marks.mark(a);
+    }
+    NodeMarks marks;
+    TS_ASSERT( !marks.isMarked(a) );
+  }
+
+  void testMarksOverManyEpochs() {
+    NodeMarks outer;
+    TS_ASSERT( outer.mark(a) );
+    for(unsigned i = 0; i < 1000; ++i) {
+      // unused pages are freed as the epochs go by; live marks stay
+      NodeMarks inner;
+      TS_ASSERT( !inner.isMarked(a) );
+      if(i % 300 == 0) {
+        TS_ASSERT( inner.mark(a) );
+        TS_ASSERT( inner.isMarked(a) );
+      }
+      {
+        NodeMarks deeper;
+        NodeMarks deepest;
+        TS_ASSERT( deepest.mark(b) );
+      }
+    }
+    TS_ASSERT( outer.isMarked(a) );
+    TS_ASSERT( !outer.isMarked(b) );
+    outer.clear();
+    TS_ASSERT( !outer.isMarked(a) );
+    TS_ASSERT( outer.mark(a) );
+  }
+
+  void testPreorder() {
+    Node ab = d_nm->mkNode(AND, a, b);
+    Node n = d_nm->mkNode(OR, ab, d_nm->mkNode(NOT, ab), c);
+
+    vector<TNode> order;
+    NodeMarks marks;
+    for(PreorderNodeIterator i(n, marks); !i.done(); ++i) {
+      order.push_back(*i);
+    }
+    // ab is shared, but visited once
+    TS_ASSERT_EQUALS( order.size(), 6u );
+    TS_ASSERT_EQUALS( order[0], n );
+    TS_ASSERT_EQUALS( order[1], ab );
+    TS_ASSERT_EQUALS( order[2], a );
+    TS_ASSERT_EQUALS( order[3], b );
+    TS_ASSERT_EQUALS( order[4], n[1] );
+    TS_ASSERT_EQUALS( order[5], c );
+
+    // everything is marked now
+    PreorderNodeIterator again(ab, marks);
+    TS_ASSERT( again.done() );
+  }
+
+  void testSkipChildren() {
+    Node ab = d_nm->mkNode(AND, a, b);
+    Node n = d_nm->mkNode(OR, ab, c);
+
+    vector<TNode> order;
+    NodeMarks marks;
+    for(PreorderNodeIterator i(n, marks); !i.done(); ++i) {
+      order.push_back(*i);
+      if(i->getKind() == AND) {
+        i.skipChildren();
+      }
+    }
+    TS_ASSERT_EQUALS( order.size(), 3u );
+    TS_ASSERT( !marks.isMarked(a) );
+  }
+
+  void testPostorder() {
+    Node ab = d_nm->mkNode(AND, a, b);
+    Node n = d_nm->mkNode(OR, ab, d_nm->mkNode(NOT, ab), c);
+
+    vector<TNode> order;
+    NodeMarks marks;
+    for(PostorderNodeIterator i(n, marks); !i.done(); ++i) {
+      order.push_back(*i);
+    }
+    TS_ASSERT_EQUALS( order.size(), 6u );
+    TS_ASSERT_EQUALS( order[0], a );
+    TS_ASSERT_EQUALS( order[1], b );
+    TS_ASSERT_EQUALS( order[2], ab );
+    TS_ASSERT_EQUALS( order[3], n[1] );
+    TS_ASSERT_EQUALS( order[4], c );
+    TS_ASSERT_EQUALS( order[5], n );
+  }
+
+  void testDeep() {
+    // deep enough to overflow the stack if the iterators recursed
+    Node n = a;
+    for(unsigned i = 0; i < 200000; ++i) {
+      n = d_nm->mkNode(NOT, n);
+    }
+
+    unsigned count = 0;
+    NodeMarks marks;
+    for(PostorderNodeIterator i(n, marks); !i.done(); ++i) {
+      if(count++ == 0) {
+        TS_ASSERT_EQUALS( *i, a );
+      }
+    }
+    TS_ASSERT_EQUALS( count, 200001u );
+  }
+
+};/* class NodeVisitorBlack */